@@ -46,12 +46,8 @@ void QWaylandClientExtension::initialize()
         return;
     }
     const QtWaylandClient::QWaylandDisplay *display = d->waylandIntegration->display();
-    const auto globals = display->globals();
-    auto global =
-            std::find_if(globals.cbegin(), globals.cend(), [this](const RegistryGlobal &global) {
-                return global.interface == QLatin1String(extensionInterface()->name);
-            });
-    if (global != globals.cend()) {
+    const auto global = display->registryGlobal(QLatin1String(extensionInterface()->name));
+    if (global) {
         bind(global->registry, global->id, global->version);
         d->active = true;
         emit activeChanged();
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "qwaylandbuffer_p.h"
+#include "qwaylandeventthread_p.h"
 
 #include <QDebug>
 
@@ -16,6 +17,9 @@ QWaylandBuffer::QWaylandBuffer()
 
 QWaylandBuffer::~QWaylandBuffer()
 {
+    // The release listener may be running on the queue's thread right now, wait for it to
+    // finish. Once the proxy is destroyed it will not be called for this buffer again.
+    QMutexLocker lock(mEventQueue ? mEventQueue->dispatchMutex() : nullptr);
     if (mBuffer)
         wl_buffer_destroy(mBuffer);
 }
@@ -37,9 +41,23 @@ void QWaylandBuffer::release(void *data, wl_buffer *)
 
 void QWaylandBuffer::setDeleteOnRelease(bool deleteOnRelease)
 {
+    QMutexLocker lock(mEventQueue ? mEventQueue->dispatchMutex() : nullptr);
     mDeleteOnRelease = deleteOnRelease;
 }
 
+void QWaylandBuffer::setEventQueue(const std::shared_ptr<QWaylandEventQueue> &queue)
+{
+    if (mEventQueue == queue || !mBuffer)
+        return;
+
+    // Only buffers that are deleted by their owner can move to another queue, a buffer
+    // deleting itself on release would drop the queue's last reference from its own thread.
+    Q_ASSERT(!mDeleteOnRelease);
+
+    wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(mBuffer), queue ? queue->queue() : nullptr);
+    mEventQueue = queue;
+}
+
 const wl_buffer_listener QWaylandBuffer::listener = {
     QWaylandBuffer::release
 };
@@ -23,10 +23,15 @@
 #include <QtWaylandClient/private/wayland-wayland-client-protocol.h>
 #include <QtCore/private/qglobal_p.h>
 
+#include <atomic>
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
 namespace QtWaylandClient {
 
+class QWaylandEventQueue;
+
 class Q_WAYLANDCLIENT_EXPORT QWaylandBuffer {
 public:
     QWaylandBuffer();
@@ -44,14 +49,23 @@ public:
     bool committed() const { return mCommitted; }
 
     void setDeleteOnRelease(bool deleteOnRelease);
+    bool deleteOnRelease() const { return mDeleteOnRelease; }
+
+    // Routes wl_buffer.release to the given queue instead of the default one.
+    // The queue is kept alive for as long as the buffer exists, and the buffer may then be
+    // deleted from any thread: its destructor serializes with the queue's dispatch.
+    void setEventQueue(const std::shared_ptr<QWaylandEventQueue> &queue);
 
 protected:
     struct wl_buffer *mBuffer = nullptr;
 
 private:
-    bool mBusy = false;
-    bool mCommitted = false;
+    // Written from whichever thread dispatches the release event, which holds the
+    // queue's dispatch mutex while doing so
+    std::atomic_bool mBusy = false;
+    std::atomic_bool mCommitted = false;
     bool mDeleteOnRelease = false;
+    std::shared_ptr<QWaylandEventQueue> mEventQueue;
 
     static void release(void *data, wl_buffer *);
     static const wl_buffer_listener listener;
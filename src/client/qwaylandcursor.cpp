@@ -12,38 +12,426 @@
 #include <qpa/qplatformtheme.h>
 
 #include <QtGui/QImageReader>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QtEndian>
 #include <QDebug>
 
 #include <wayland-cursor.h>
 
 #include <algorithm>
+#include <numeric>
 
 QT_BEGIN_NAMESPACE
 
 namespace QtWaylandClient {
 
-std::unique_ptr<QWaylandCursorTheme> QWaylandCursorTheme::create(QWaylandShm *shm, int size, const QString &themeName)
+using namespace Qt::StringLiterals;
+
+namespace {
+
+// Header of the files in the cursor cache, followed by imageCount CacheImage entries
+// and the pixel data in WL_SHM_FORMAT_ARGB8888 they point at
+struct CacheHeader {
+    char magic[8];
+    quint32 version;
+    quint32 imageCount;
+    qint64 sourceModified;
+    qint64 sourceSize;
+};
+
+struct CacheImage {
+    quint32 nominalSize;
+    quint32 width;
+    quint32 height;
+    quint32 xhot;
+    quint32 yhot;
+    quint32 delay;
+    quint32 offset;
+};
+
+static constexpr char cacheMagic[8] = "QtWlCur";
+static constexpr quint32 cacheVersion = 1;
+
+// Layout of Xcursor files, see Xcursor(3)
+static constexpr quint32 xcursorMagic = 0x72756358; // "Xcur"
+static constexpr quint32 xcursorImageType = 0xfffd0002;
+static constexpr quint32 xcursorMaxImageSize = 0x7fff;
+
+static bool readXcursorImages(const uchar *data, qsizetype size, QList<CacheImage> *images,
+                              QList<const uchar *> *pixels)
 {
-    QByteArray nameBytes = themeName.toLocal8Bit();
-    struct ::wl_cursor_theme *theme = wl_cursor_theme_load(nameBytes.constData(), size, shm->object());
+    const auto read32 = [&](qsizetype offset, quint32 *value) {
+        if (offset < 0 || offset + 4 > size)
+            return false;
+        *value = qFromLittleEndian<quint32>(data + offset);
+        return true;
+    };
+
+    quint32 magic, headerSize, tocCount;
+    if (!read32(0, &magic) || magic != xcursorMagic || !read32(4, &headerSize)
+        || !read32(12, &tocCount)) {
+        return false;
+    }
+
+    for (quint32 i = 0; i < tocCount; ++i) {
+        const qsizetype entry = qsizetype(headerSize) + qsizetype(i) * 12;
+        quint32 type, nominalSize, position;
+        if (!read32(entry, &type) || !read32(entry + 4, &nominalSize) || !read32(entry + 8, &position))
+            return false;
+        if (type != xcursorImageType)
+            continue;
+
+        CacheImage image = {};
+        quint32 chunkType, chunkSubtype;
+        if (!read32(position + 4, &chunkType) || !read32(position + 8, &chunkSubtype)
+            || chunkType != type || chunkSubtype != nominalSize
+            || !read32(position + 16, &image.width) || !read32(position + 20, &image.height)
+            || !read32(position + 24, &image.xhot) || !read32(position + 28, &image.yhot)
+            || !read32(position + 32, &image.delay)) {
+            return false;
+        }
+        if (image.width == 0 || image.height == 0 || image.width > xcursorMaxImageSize
+            || image.height > xcursorMaxImageSize || image.xhot > image.width
+            || image.yhot > image.height) {
+            return false;
+        }
+        const qsizetype pixelOffset = qsizetype(position) + 36;
+        if (pixelOffset + qsizetype(image.width) * image.height * 4 > size)
+            return false;
+
+        image.nominalSize = nominalSize;
+        images->append(image);
+        pixels->append(data + pixelOffset);
+    }
+    return !images->isEmpty();
+}
+
+// Decodes an Xcursor file into the layout of the cache, with the images of each nominal
+// size next to each other in the order of their animation
+static QByteArray decodeXcursor(const QString &fileName, const QFileInfo &info)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    const uchar *data = file.map(0, file.size());
+    if (!data)
+        return {};
+
+    QList<CacheImage> images;
+    QList<const uchar *> pixels;
+    if (!readXcursorImages(data, file.size(), &images, &pixels))
+        return {};
+
+    QList<qsizetype> order(images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](qsizetype lhs, qsizetype rhs) {
+        return images[lhs].nominalSize < images[rhs].nominalSize;
+    });
+
+    quint32 offset = sizeof(CacheHeader) + images.size() * sizeof(CacheImage);
+    QByteArray result(offset, Qt::Uninitialized);
+
+    CacheHeader header = {};
+    memcpy(header.magic, cacheMagic, sizeof(header.magic));
+    header.version = cacheVersion;
+    header.imageCount = images.size();
+    header.sourceModified = info.lastModified().toMSecsSinceEpoch();
+    header.sourceSize = info.size();
+    memcpy(result.data(), &header, sizeof(header));
+
+    auto *table = reinterpret_cast<CacheImage *>(result.data() + sizeof(CacheHeader));
+    for (qsizetype i : order) {
+        CacheImage image = images[i];
+        const quint32 bytes = image.width * image.height * 4;
+        image.offset = offset;
+        *table++ = image;
+        // Xcursor pixels are premultiplied ARGB in little endian, the same as ARGB8888
+        result.append(reinterpret_cast<const char *>(pixels[i]), bytes);
+        offset += bytes;
+    }
+    return result;
+}
+
+static QStringList cursorSearchPaths()
+{
+    static const QStringList paths = [] {
+        const QString home = QDir::homePath();
+        QStringList result;
+        if (qEnvironmentVariableIsSet("XCURSOR_PATH")) {
+            const QStringList entries = qEnvironmentVariable("XCURSOR_PATH").split(u':', Qt::SkipEmptyParts);
+            for (QString entry : entries) {
+                if (entry.startsWith(u'~'))
+                    entry.replace(0, 1, home);
+                result.append(entry);
+            }
+            return result;
+        }
+
+        QString dataHome = qEnvironmentVariable("XDG_DATA_HOME");
+        if (dataHome.isEmpty())
+            dataHome = home + "/.local/share"_L1;
+        result.append(dataHome + "/icons"_L1);
+        result.append(home + "/.icons"_L1);
+        QString dataDirs = qEnvironmentVariable("XDG_DATA_DIRS");
+        if (dataDirs.isEmpty())
+            dataDirs = "/usr/local/share:/usr/share"_L1;
+        for (const QString &dir : dataDirs.split(u':', Qt::SkipEmptyParts))
+            result.append(dir + "/icons"_L1);
+        result.append("/usr/share/pixmaps"_L1);
+        return result;
+    }();
+    return paths;
+}
+
+static QStringList inheritedThemes(const QString &indexFile)
+{
+    QFile file(indexFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return {};
+
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (!line.startsWith("Inherits"))
+            continue;
+        const qsizetype equals = line.indexOf('=');
+        if (equals < 0 || !line.left(equals).trimmed().endsWith("Inherits"))
+            continue;
+
+        QStringList themes;
+        for (const QByteArray &theme : line.mid(equals + 1).split(',')) {
+            for (const QByteArray &part : theme.split(';')) {
+                if (!part.trimmed().isEmpty())
+                    themes.append(QString::fromLocal8Bit(part.trimmed()));
+            }
+        }
+        return themes;
+    }
+    return {};
+}
+
+static QString findCursorFileInTheme(const QString &themeName, const QString &cursorName,
+                                     QStringList *visited)
+{
+    if (themeName.isEmpty() || themeName.contains(u'/') || visited->contains(themeName))
+        return {};
+    visited->append(themeName);
+
+    const QStringList paths = cursorSearchPaths();
+    for (const QString &path : paths) {
+        const QString file = path + u'/' + themeName + "/cursors/"_L1 + cursorName;
+        if (QFileInfo(file).isFile())
+            return file;
+    }
+
+    for (const QString &path : paths) {
+        const QString indexFile = path + u'/' + themeName + "/index.theme"_L1;
+        if (!QFileInfo::exists(indexFile))
+            continue;
+        for (const QString &inherited : inheritedThemes(indexFile)) {
+            const QString file = findCursorFileInTheme(inherited, cursorName, visited);
+            if (!file.isEmpty())
+                return file;
+        }
+    }
+    return {};
+}
+
+} // namespace
+
+QWaylandCursorCache::Pool::~Pool()
+{
+    if (pool)
+        wl_shm_pool_destroy(pool);
+}
+
+QWaylandCursorCache::~QWaylandCursorCache()
+{
+    qDeleteAll(m_pools);
+}
+
+QString QWaylandCursorCache::findCursorFile(const QString &themeName, const char *cursorName)
+{
+    QStringList visited;
+    return findCursorFileInTheme(themeName, QString::fromLatin1(cursorName), &visited);
+}
 
-    if (!theme) {
-        qCWarning(lcQpaWayland) << "Could not load cursor theme" << themeName << "size" << size;
+QWaylandCursorCache::Pool *QWaylandCursorCache::pool(const QString &xcursorFile)
+{
+    auto it = m_pools.constFind(xcursorFile);
+    if (it != m_pools.constEnd())
+        return *it;
+
+    // Failures are remembered too, so a broken file is only looked at once
+    Pool *&pool = m_pools[xcursorFile];
+
+    const QFileInfo source(xcursorFile);
+    const QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtimeDir.isEmpty() || !source.isFile())
+        return nullptr;
+
+    const QString cacheDir = runtimeDir + "/qtwayland-cursors"_L1;
+    if (!QFileInfo(cacheDir).isDir()
+        && !QDir().mkdir(cacheDir, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner)) {
         return nullptr;
     }
+    const QString cacheFile = cacheDir + u'/'
+            + QString::fromLatin1(QCryptographicHash::hash(xcursorFile.toUtf8(), QCryptographicHash::Sha1).toHex());
+
+    const auto validCache = [&](QFile &file) -> QList<Image> {
+        const qint64 size = file.size();
+        if (size < qint64(sizeof(CacheHeader)))
+            return {};
+        const uchar *data = file.map(0, size);
+        if (!data)
+            return {};
+
+        CacheHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, cacheMagic, sizeof(header.magic)) != 0
+            || header.version != cacheVersion
+            || header.sourceModified != source.lastModified().toMSecsSinceEpoch()
+            || header.sourceSize != source.size()
+            || qint64(sizeof(CacheHeader) + header.imageCount * sizeof(CacheImage)) > size) {
+            return {};
+        }
+
+        QList<Image> images;
+        images.reserve(header.imageCount);
+        for (quint32 i = 0; i < header.imageCount; ++i) {
+            CacheImage image;
+            memcpy(&image, data + sizeof(CacheHeader) + i * sizeof(CacheImage), sizeof(image));
+            if (image.width == 0 || image.height == 0 || image.width > xcursorMaxImageSize
+                || image.height > xcursorMaxImageSize
+                || qint64(image.offset) + qint64(image.width) * image.height * 4 > size) {
+                return {};
+            }
+            images.append(Image{ image.nominalSize, QSize(image.width, image.height),
+                                 QPoint(image.xhot, image.yhot), image.delay, image.offset });
+        }
+        file.unmap(const_cast<uchar *>(data));
+        return images;
+    };
+
+    // The compositor maps pools read-write, so the file is opened that way even though
+    // nobody writes to it once it is in place
+    QFile file(cacheFile);
+    QList<Image> images;
+    if (file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly))
+        images = validCache(file);
+
+    if (images.isEmpty()) {
+        file.close();
+        const QByteArray decoded = decodeXcursor(xcursorFile, source);
+        if (decoded.isEmpty()) {
+            qCWarning(lcQpaWayland) << "Could not read cursor file" << xcursorFile;
+            return nullptr;
+        }
+
+        // Written aside and renamed into place, so other processes never see partial files
+        QSaveFile writer(cacheFile);
+        writer.setDirectWriteFallback(false);
+        if (!writer.open(QIODevice::WriteOnly) || writer.write(decoded) != decoded.size()
+            || !writer.setPermissions(QFile::ReadOwner | QFile::WriteOwner) || !writer.commit()) {
+            qCWarning(lcQpaWayland) << "Could not write cursor cache" << cacheFile;
+            return nullptr;
+        }
+
+        if (file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly))
+            images = validCache(file);
+        if (images.isEmpty())
+            return nullptr;
+    }
 
-    return std::unique_ptr<QWaylandCursorTheme>{new QWaylandCursorTheme(theme)};
+    pool = new Pool;
+    pool->pool = wl_shm_create_pool(m_shm->object(), file.handle(), int(file.size()));
+    pool->images = std::move(images);
+    return pool;
+}
+
+std::unique_ptr<QWaylandCursorTheme> QWaylandCursorTheme::create(QWaylandCursorCache *cache, QWaylandShm *shm,
+                                                                 int size, const QString &themeName)
+{
+    // Nothing is loaded until the cursors are asked for
+    return std::unique_ptr<QWaylandCursorTheme>{new QWaylandCursorTheme(cache, shm, size, themeName)};
 }
 
 QWaylandCursorTheme::~QWaylandCursorTheme()
 {
-    wl_cursor_theme_destroy(m_theme);
+    for (struct ::wl_buffer *buffer : std::as_const(m_buffers))
+        wl_buffer_destroy(buffer);
+    if (m_fallbackTheme)
+        wl_cursor_theme_destroy(m_fallbackTheme);
 }
 
-wl_cursor *QWaylandCursorTheme::requestCursor(WaylandCursor shape)
+bool QWaylandCursorTheme::loadFromCache(Cursor *cursor, const char *name)
 {
-    if (struct wl_cursor *cursor = m_cursors[shape])
-        return cursor;
+    const QString file = QWaylandCursorCache::findCursorFile(m_name, name);
+    if (file.isEmpty())
+        return false;
+    const QWaylandCursorCache::Pool *pool = m_cache->pool(file);
+    if (!pool)
+        return false;
+
+    // The nominal size closest to the one asked for, the larger one on ties
+    const auto distance = [this](quint32 nominalSize) {
+        return qAbs(qint64(nominalSize) - m_size);
+    };
+    quint32 bestSize = 0;
+    for (const QWaylandCursorCache::Image &image : pool->images) {
+        if (bestSize == 0 || distance(image.nominalSize) <= distance(bestSize))
+            bestSize = image.nominalSize;
+    }
+
+    for (const QWaylandCursorCache::Image &image : pool->images) {
+        if (image.nominalSize != bestSize)
+            continue;
+        struct ::wl_buffer *buffer = wl_shm_pool_create_buffer(pool->pool, image.offset,
+                                                              image.size.width(), image.size.height(),
+                                                              image.size.width() * 4,
+                                                              WL_SHM_FORMAT_ARGB8888);
+        m_buffers.append(buffer);
+        cursor->frames.append(Image{ image.size, image.hotspot, image.delay, buffer });
+        cursor->totalDelay += image.delay;
+    }
+    return !cursor->frames.isEmpty();
+}
+
+bool QWaylandCursorTheme::loadFromFallbackTheme(Cursor *cursor, const char *name)
+{
+    if (!m_fallbackThemeLoaded) {
+        m_fallbackThemeLoaded = true;
+        m_fallbackTheme = wl_cursor_theme_load(m_name.toLocal8Bit().constData(), m_size, m_shm->object());
+        if (!m_fallbackTheme)
+            qCWarning(lcQpaWayland) << "Could not load cursor theme" << m_name << "size" << m_size;
+    }
+    if (!m_fallbackTheme)
+        return false;
+
+    struct ::wl_cursor *waylandCursor = wl_cursor_theme_get_cursor(m_fallbackTheme, name);
+    if (!waylandCursor)
+        return false;
+
+    for (uint i = 0; i < waylandCursor->image_count; ++i) {
+        ::wl_cursor_image *image = waylandCursor->images[i];
+        cursor->frames.append(Image{ QSize(image->width, image->height),
+                                     QPoint(image->hotspot_x, image->hotspot_y), image->delay,
+                                     wl_cursor_image_get_buffer(image) });
+        cursor->totalDelay += image->delay;
+    }
+    return !cursor->frames.isEmpty();
+}
+
+QWaylandCursorTheme::Cursor *QWaylandCursorTheme::requestCursor(WaylandCursor shape)
+{
+    Cursor *cursor = &m_cursors[shape];
+    if (cursor->loaded)
+        return cursor->frames.isEmpty() ? nullptr : cursor;
 
     static Q_CONSTEXPR struct ShapeAndName {
         WaylandCursor shape;
@@ -174,40 +562,64 @@ wl_cursor *QWaylandCursorTheme::requestCursor(WaylandCursor shape)
     Q_ASSERT(std::is_sorted(std::begin(cursorNamesMap), std::end(cursorNamesMap), byShape));
     const auto p = std::equal_range(std::begin(cursorNamesMap), std::end(cursorNamesMap),
                                     ShapeAndName{shape, ""}, byShape);
+    // Only the files of the shape that is asked for are read, and libwayland-cursor, which
+    // loads whole themes at once, only gets involved if none of them is usable
+    cursor->loaded = true;
     for (auto it = p.first; it != p.second; ++it) {
-        if (wl_cursor *cursor = wl_cursor_theme_get_cursor(m_theme, it->name)) {
-            m_cursors[shape] = cursor;
+        if (loadFromCache(cursor, it->name))
+            return cursor;
+    }
+    for (auto it = p.first; it != p.second; ++it) {
+        if (loadFromFallbackTheme(cursor, it->name))
             return cursor;
-        }
     }
 
     // Fallback to arrow cursor
-    if (shape != ArrowCursor)
-        return requestCursor(ArrowCursor);
+    if (shape != ArrowCursor) {
+        if (Cursor *arrow = requestCursor(ArrowCursor)) {
+            *cursor = *arrow;
+            return cursor;
+        }
+    }
 
     // Give up
     return nullptr;
 }
 
-::wl_cursor *QWaylandCursorTheme::cursor(Qt::CursorShape shape)
+const QWaylandCursorTheme::Image *QWaylandCursorTheme::image(Qt::CursorShape shape, uint time, uint *duration)
 {
-    struct wl_cursor *waylandCursor = nullptr;
+    Cursor *cursor = nullptr;
 
     if (shape < Qt::BitmapCursor) {
-        waylandCursor = requestCursor(WaylandCursor(shape));
+        cursor = requestCursor(WaylandCursor(shape));
     } else if (shape == Qt::BitmapCursor) {
-        qCWarning(lcQpaWayland) << "cannot create a wl_cursor_image for a CursorShape";
+        qCWarning(lcQpaWayland) << "cannot create a cursor image for a CursorShape";
         return nullptr;
     } else {
         //TODO: Custom cursor logic (for resize arrows)
     }
 
-    if (!waylandCursor) {
+    if (!cursor) {
         qCWarning(lcQpaWayland) << "Could not find cursor for shape" << shape;
         return nullptr;
     }
 
-    return waylandCursor;
+    if (duration)
+        *duration = 0;
+    if (cursor->frames.size() == 1 || cursor->totalDelay == 0)
+        return &cursor->frames.first();
+
+    // Same as wl_cursor_frame_and_duration()
+    uint t = time % cursor->totalDelay;
+    for (const Image &frame : std::as_const(cursor->frames)) {
+        if (t < frame.delay) {
+            if (duration)
+                *duration = frame.delay - t;
+            return &frame;
+        }
+        t -= frame.delay;
+    }
+    return &cursor->frames.last();
 }
 
 QWaylandCursorShape::QWaylandCursorShape(::wp_cursor_shape_device_v1 *object)
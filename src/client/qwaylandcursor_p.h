@@ -16,6 +16,8 @@
 //
 
 #include <qpa/qplatformcursor.h>
+#include <QtCore/QHash>
+#include <QtCore/QList>
 #include <QtCore/QMap>
 #include <QtWaylandClient/qtwaylandclientglobal.h>
 #include <QtWaylandClient/private/qwayland-cursor-shape-v1.h>
@@ -25,9 +27,9 @@
 
 #include <memory>
 
-struct wl_cursor;
-struct wl_cursor_image;
+struct wl_buffer;
 struct wl_cursor_theme;
+struct wl_shm_pool;
 
 QT_BEGIN_NAMESPACE
 
@@ -38,12 +40,57 @@ class QWaylandDisplay;
 class QWaylandScreen;
 class QWaylandShm;
 
+// Xcursor files decoded once per user into files in XDG_RUNTIME_DIR, which hold the images
+// of all nominal sizes of a cursor and are handed to the compositor as wl_shm pools as they
+// are, so every process maps the same pages instead of decoding its own copy per size.
+class Q_WAYLANDCLIENT_EXPORT QWaylandCursorCache
+{
+public:
+    struct Image {
+        quint32 nominalSize;
+        QSize size;
+        QPoint hotspot;
+        uint delay;
+        quint32 offset;
+    };
+
+    struct Pool {
+        ~Pool();
+        struct ::wl_shm_pool *pool = nullptr;
+        QList<Image> images;
+    };
+
+    explicit QWaylandCursorCache(QWaylandShm *shm) : m_shm(shm) {}
+    ~QWaylandCursorCache();
+
+    // The pool for the given Xcursor file, decoding it into the cache first if needed.
+    // nullptr if the file can't be read or there is no runtime directory to cache it in.
+    Pool *pool(const QString &xcursorFile);
+
+    static QString findCursorFile(const QString &themeName, const char *cursorName);
+
+private:
+    QWaylandShm *m_shm = nullptr;
+    QHash<QString, Pool *> m_pools;
+};
+
 class Q_WAYLANDCLIENT_EXPORT QWaylandCursorTheme
 {
 public:
-    static std::unique_ptr<QWaylandCursorTheme> create(QWaylandShm *shm, int size, const QString &themeName);
+    struct Image {
+        QSize size;
+        QPoint hotspot;
+        uint delay;
+        struct ::wl_buffer *buffer;
+    };
+
+    static std::unique_ptr<QWaylandCursorTheme> create(QWaylandCursorCache *cache, QWaylandShm *shm,
+                                                       int size, const QString &themeName);
     ~QWaylandCursorTheme();
-    ::wl_cursor *cursor(Qt::CursorShape shape);
+
+    // The frame of the cursor for shape that is shown time ms into its animation, and
+    // in duration how long it stays, which is 0 if the cursor is not animated
+    const Image *image(Qt::CursorShape shape, uint time = 0, uint *duration = nullptr);
 
 protected:
     enum WaylandCursor {
@@ -82,10 +129,28 @@ protected:
         NumWaylandCursors
     };
 
-    explicit QWaylandCursorTheme(struct ::wl_cursor_theme *theme) : m_theme(theme) {}
-    struct ::wl_cursor *requestCursor(WaylandCursor shape);
-    struct ::wl_cursor_theme *m_theme = nullptr;
-    wl_cursor *m_cursors[NumWaylandCursors] = {};
+    struct Cursor {
+        QList<Image> frames;
+        uint totalDelay = 0;
+        bool loaded = false;
+    };
+
+    QWaylandCursorTheme(QWaylandCursorCache *cache, QWaylandShm *shm, int size, const QString &name)
+        : m_cache(cache), m_shm(shm), m_size(size), m_name(name)
+    {}
+    Cursor *requestCursor(WaylandCursor shape);
+    bool loadFromCache(Cursor *cursor, const char *name);
+    bool loadFromFallbackTheme(Cursor *cursor, const char *name);
+
+    QWaylandCursorCache *m_cache = nullptr;
+    QWaylandShm *m_shm = nullptr;
+    int m_size = 0;
+    QString m_name;
+    Cursor m_cursors[NumWaylandCursors];
+    QList<struct ::wl_buffer *> m_buffers;
+    // libwayland-cursor, loaded only for cursors that can't be served from the cache
+    struct ::wl_cursor_theme *m_fallbackTheme = nullptr;
+    bool m_fallbackThemeLoaded = false;
 };
 
 class Q_WAYLANDCLIENT_EXPORT QWaylandCursorShape : public QtWayland::wp_cursor_shape_device_v1
@@ -12,6 +12,9 @@
 #include "qwaylandscreen_p.h"
 #include "qwaylandcursor_p.h"
 #include "qwaylandinputdevice_p.h"
+#if QT_CONFIG(xkbcommon)
+#include "qwaylandkeymapcache_p.h"
+#endif
 #if QT_CONFIG(clipboard)
 #include "qwaylandclipboard_p.h"
 #include "qwaylanddatacontrolv1_p.h"
@@ -44,6 +47,8 @@
 #endif
 
 #include "qwaylandcolormanagement_p.h"
+#include "qwaylandeventthread_p.h"
+#include "qwaylandpresentationtime_p.h"
 
 #include <QtWaylandClient/private/qwayland-text-input-unstable-v1.h>
 #include <QtWaylandClient/private/qwayland-text-input-unstable-v2.h>
@@ -56,6 +61,7 @@
 #include <QtWaylandClient/private/qwayland-xdg-system-bell-v1.h>
 #include <QtWaylandClient/private/qwayland-xdg-toplevel-drag-v1.h>
 #include <QtWaylandClient/private/qwayland-wlr-data-control-unstable-v1.h>
+#include <QtWaylandClient/private/qwayland-linux-explicit-synchronization-unstable-v1.h>
 
 #include <QtCore/private/qcore_unix_p.h>
 
@@ -67,200 +73,17 @@
 
 #include <errno.h>
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
 #include <tuple> // for std::tie
 
 QT_BEGIN_NAMESPACE
 
 namespace QtWaylandClient {
 
-class EventThread : public QThread
-{
-    Q_OBJECT
-public:
-    enum OperatingMode {
-        EmitToDispatch, // Emit the signal, allow dispatching in a differnt thread.
-        SelfDispatch, // Dispatch the events inside this thread.
-    };
-
-    EventThread(struct wl_display * wl, struct wl_event_queue * ev_queue,
-                OperatingMode mode)
-        : m_fd(wl_display_get_fd(wl))
-        , m_pipefd{ -1, -1 }
-        , m_wldisplay(wl)
-        , m_wlevqueue(ev_queue)
-        , m_mode(mode)
-        , m_reading(true)
-        , m_quitting(false)
-    {
-        setObjectName(QStringLiteral("WaylandEventThread"));
-    }
-
-    void readAndDispatchEvents()
-    {
-        /*
-         * Dispatch pending events and flush the requests at least once. If the event thread
-         * is not reading, try to call _prepare_read() to allow the event thread to poll().
-         * If that fails, re-try dispatch & flush again until _prepare_read() is successful.
-         *
-         * This allow any call to readAndDispatchEvents() to start event thread's polling,
-         * not only the one issued from event thread's waitForReading(), which means functions
-         * called from dispatch_pending() can safely spin an event loop.
-         */
-        if (m_quitting)
-            return;
-
-        for (;;) {
-            if (dispatchQueuePending() < 0) {
-                Q_EMIT waylandError();
-                m_quitting = true;
-                return;
-            }
-
-            wl_display_flush(m_wldisplay);
-
-            // We have to check if event thread is reading every time we dispatch
-            // something, as that may recursively call this function.
-            if (m_reading.loadAcquire())
-                break;
-
-            if (prepareReadQueue() == 0) {
-                QMutexLocker l(&m_mutex);
-                m_reading.storeRelease(true);
-                m_cond.wakeOne();
-                break;
-            }
-        }
-    }
-
-    void stop()
-    {
-        // We have to both write to the pipe and set the flag, as the thread may be
-        // either in the poll() or waiting for _prepare_read().
-        if (m_pipefd[1] != -1 && write(m_pipefd[1], "\0", 1) == -1)
-            qWarning("Failed to write to the pipe: %s.", strerror(errno));
-
-        {
-            QMutexLocker l(&m_mutex);
-            m_quitting = true;
-            m_cond.wakeOne();
-        }
-
-        wait();
-    }
-
-Q_SIGNALS:
-    void needReadAndDispatch();
-    void waylandError();
-
-protected:
-    void run() override
-    {
-        // we use this pipe to make the loop exit otherwise if we simply used a flag on the loop condition, if stop() gets
-        // called while poll() is blocking the thread will never quit since there are no wayland messages coming anymore.
-        struct Pipe
-        {
-            Pipe(int *fds)
-                : fds(fds)
-            {
-                if (qt_safe_pipe(fds) != 0)
-                    qWarning("Pipe creation failed. Quitting may hang.");
-            }
-            ~Pipe()
-            {
-                if (fds[0] != -1) {
-                    close(fds[0]);
-                    close(fds[1]);
-                }
-            }
-
-            int *fds;
-        } pipe(m_pipefd);
-
-        // Make the main thread call wl_prepare_read(), dispatch the pending messages and flush the
-        // outbound ones. Wait until it's done before proceeding, unless we're told to quit.
-        while (waitForReading()) {
-            if (!m_reading.loadRelaxed())
-                break;
-
-            pollfd fds[2] = { { m_fd, POLLIN, 0 }, { m_pipefd[0], POLLIN, 0 } };
-            poll(fds, 2, -1);
-
-            if (fds[1].revents & POLLIN) {
-                // we don't really care to read the byte that was written here since we're closing down
-                wl_display_cancel_read(m_wldisplay);
-                break;
-            }
-
-            if (fds[0].revents & POLLIN)
-                wl_display_read_events(m_wldisplay);
-                // The poll was succesfull and the event thread did the wl_display_read_events(). On the next iteration of the loop
-                // the event sent to the main thread will cause it to dispatch the messages just read, unless the loop exits in which
-                // case we don't care anymore about them.
-            else
-                wl_display_cancel_read(m_wldisplay);
-        }
-    }
-
-private:
-    bool waitForReading()
-    {
-        Q_ASSERT(QThread::currentThread() == this);
-
-        m_reading.storeRelease(false);
-
-        if (m_mode == SelfDispatch) {
-            readAndDispatchEvents();
-        } else {
-            Q_EMIT needReadAndDispatch();
-
-            QMutexLocker lock(&m_mutex);
-            // m_reading might be set from our emit or some other invocation of
-            // readAndDispatchEvents().
-            while (!m_reading.loadRelaxed() && !m_quitting)
-                m_cond.wait(&m_mutex);
-        }
-
-        return !m_quitting;
-    }
-
-    int dispatchQueuePending()
-    {
-        if (m_wlevqueue)
-            return wl_display_dispatch_queue_pending(m_wldisplay, m_wlevqueue);
-        else
-            return wl_display_dispatch_pending(m_wldisplay);
-    }
-
-    int prepareReadQueue()
-    {
-        if (m_wlevqueue)
-            return wl_display_prepare_read_queue(m_wldisplay, m_wlevqueue);
-        else
-            return wl_display_prepare_read(m_wldisplay);
-    }
-
-    int m_fd;
-    int m_pipefd[2];
-    wl_display *m_wldisplay;
-    wl_event_queue *m_wlevqueue;
-    OperatingMode m_mode;
-
-    /* Concurrency note when operating in EmitToDispatch mode:
-     * m_reading is set to false inside event thread's waitForReading(), and is
-     * set to true inside main thread's readAndDispatchEvents().
-     * The lock is not taken when setting m_reading to false, as the main thread
-     * is not actively waiting for it to turn false. However, the lock is taken
-     * inside readAndDispatchEvents() before setting m_reading to true,
-     * as the event thread is actively waiting for it under the wait condition.
-     */
-
-    QAtomicInteger<bool> m_reading;
-    bool m_quitting;
-    QMutex m_mutex;
-    QWaitCondition m_cond;
-};
-
 Q_LOGGING_CATEGORY(lcQpaWayland, "qt.qpa.wayland"); // for general (uncategorized) Wayland platform logging
+Q_LOGGING_CATEGORY(lcQpaWaylandStartup, "qt.qpa.wayland.startup");
 
 struct wl_surface *QWaylandDisplay::createSurface(void *handle)
 {
@@ -279,6 +102,45 @@ struct ::wl_region *QWaylandDisplay::createRegion(const QRegion &qregion)
     return region;
 }
 
+/*!
+    \internal
+
+    Returns a wl_region with the contents of \a qregion, owned by the display.
+
+    The compositor copies the region when it is used in a request, so the same object can be
+    passed to any number of set_opaque_region/set_input_region calls. Windows tend to switch
+    between a handful of masks, so this avoids resending every rectangle of complex masks on
+    each change. The caller must not destroy the returned region.
+*/
+struct ::wl_region *QWaylandDisplay::cachedRegion(const QRegion &qregion)
+{
+    static constexpr qsizetype MaxCachedRegions = 16;
+
+    QMutexLocker lock(&mRegionCacheMutex);
+    for (qsizetype i = mRegionCache.size() - 1; i >= 0; --i) {
+        if (mRegionCache.at(i).region == qregion) {
+            if (i != mRegionCache.size() - 1)
+                mRegionCache.move(i, mRegionCache.size() - 1);
+            return mRegionCache.last().object;
+        }
+    }
+
+    if (mRegionCache.size() >= MaxCachedRegions)
+        wl_region_destroy(mRegionCache.takeFirst().object);
+
+    struct ::wl_region *region = createRegion(qregion);
+    mRegionCache.append({ qregion, region });
+    return region;
+}
+
+void QWaylandDisplay::clearRegionCache()
+{
+    QMutexLocker lock(&mRegionCacheMutex);
+    for (const CachedRegion &cached : std::as_const(mRegionCache))
+        wl_region_destroy(cached.object);
+    mRegionCache.clear();
+}
+
 ::wl_subsurface *QWaylandDisplay::createSubSurface(QWaylandWindow *window, QWaylandWindow *parent)
 {
     if (!mGlobals.subCompositor) {
@@ -324,8 +186,10 @@ QWaylandDisplay::QWaylandDisplay(QWaylandIntegration *waylandIntegration)
 {
     qRegisterMetaType<uint32_t>("uint32_t");
 
+    mStartupTimer.start();
     mDisplay = wl_display_connect(nullptr);
     if (mDisplay) {
+        traceStartup("connected to the compositor");
         setupConnection();
     } else {
         qErrnoWarning(errno, "Failed to create wl_display");
@@ -333,6 +197,7 @@ QWaylandDisplay::QWaylandDisplay(QWaylandIntegration *waylandIntegration)
 
     mWaylandTryReconnect = qEnvironmentVariableIsSet("QT_WAYLAND_RECONNECT");
     mPreferWlrDataControl = qEnvironmentVariableIntValue("QT_WAYLAND_USE_DATA_CONTROL") > 0;
+    mPerWindowEventQueues = qEnvironmentVariableIntValue("QT_WAYLAND_PER_WINDOW_EVENT_QUEUES") > 0;
 }
 
 void QWaylandDisplay::setupConnection()
@@ -349,6 +214,15 @@ void QWaylandDisplay::setupConnection()
         checkTextInputProtocol();
 }
 
+#if QT_CONFIG(xkbcommon)
+QWaylandKeymapCache *QWaylandDisplay::keymapCache()
+{
+    if (!mKeymapCache)
+        mKeymapCache = std::make_unique<QWaylandKeymapCache>();
+    return mKeymapCache.get();
+}
+#endif
+
 QWaylandDisplay::~QWaylandDisplay(void)
 {
     if (m_eventThread)
@@ -369,11 +243,14 @@ QWaylandDisplay::~QWaylandDisplay(void)
 
 #if QT_CONFIG(cursor)
     mCursorThemes.clear();
+    mCursorCache.reset();
 #endif
 
     if (m_frameEventQueue)
         wl_event_queue_destroy(m_frameEventQueue);
 
+    clearRegionCache();
+
     // Reset the globals manually since they need to be destroyed before the wl_display
     mGlobals = {};
 
@@ -391,14 +268,30 @@ bool QWaylandDisplay::initialize()
     if (!isInitialized())
         return false;
 
+    /*
+     * Startup takes two round trips, however many globals there are: one to get the globals,
+     * binding them as they are announced, and one as a barrier for the initial events of
+     * everything bound in the first one (outputs, qt_hardware_integration, color manager
+     * features...). Nothing may do a round trip of its own while this is in progress, see
+     * requestInitialEvents().
+     */
+    mStartupPhase = StartupPhase::Registry;
+    mInitialEventsRequested = false;
     forceRoundTrip();
+    traceStartup("received the globals");
 
-    emit connected();
-
-    if (!mWaitingScreens.isEmpty()) {
+    mStartupPhase = StartupPhase::InitialEvents;
+    if (mInitialEventsRequested || !mWaitingScreens.isEmpty()) {
         // Give wl_output.done and zxdg_output_v1.done events a chance to arrive
         forceRoundTrip();
+        traceStartup("received the initial events");
     }
+    mStartupPhase = StartupPhase::Done;
+
+    // Windows are only (re)created from here on, once everything above is known
+    emit connected();
+    traceStartup("initialized");
+
     if (mWaylandInputContextRequested)
         mTextInputManagerIndex = INT_MAX;
 
@@ -435,8 +328,10 @@ void QWaylandDisplay::reconnect()
     }
 
     mCursorThemes.clear();
+    mCursorCache.reset();
     mCursor.reset();
 
+    clearRegionCache();
     mGlobals = GlobalHolder();
 
     mWaylandIntegration->reset();
@@ -448,6 +343,8 @@ void QWaylandDisplay::reconnect()
         emit globalRemoved(global);
     }
     mRegistryGlobals.clear();
+    mRegistryGlobalIndex.clear();
+    mRegistryGlobalIds.clear();
 
     mLastInputSerial = 0;
     mLastInputWindow.clear();
@@ -479,9 +376,11 @@ void QWaylandDisplay::reconnect()
 
     if (object())
         wl_registry_destroy(object());
+    mStartupTimer.start();
     mDisplay = wl_display_connect(nullptr);
     if (!mDisplay)
         _exit(1);
+    traceStartup("reconnected to the compositor");
 
     connect(
             this, &QWaylandDisplay::connected, this,
@@ -521,6 +420,9 @@ void QWaylandDisplay::reconnect()
 void QWaylandDisplay::flushRequests()
 {
     m_eventThread->readAndDispatchEvents();
+    // Touch frames are only merged with the ones that were read at the same time
+    for (QWaylandInputDevice *device : std::as_const(mInputDevices))
+        device->flushDeferredTouchFrame();
     QWindowSystemInterface::flushWindowSystemEvents();
 }
 
@@ -639,265 +541,400 @@ struct WithDestructor : public T
     }
 };
 
-void QWaylandDisplay::registry_global(uint32_t id, const QString &interface, uint32_t version)
-{
-    struct ::wl_registry *registry = object();
+static constexpr uint32_t AnyVersion = std::numeric_limits<uint32_t>::max();
 
-    static QStringList interfaceBlacklist = qEnvironmentVariable("QT_WAYLAND_DISABLED_INTERFACES").split(u',');
-    if (interfaceBlacklist.contains(interface)) {
-        return;
-    }
+/*!
+    \internal
 
-    if (interface == QLatin1String(QtWayland::wl_output::interface()->name)) {
-        mWaitingScreens << mWaylandIntegration->createPlatformScreen(this, version, id);
-    } else if (interface == QLatin1String(QtWayland::wl_compositor::interface()->name)) {
-        mGlobals.compositor.reset(
-                new WithDestructor<QtWayland::wl_compositor, wl_compositor_destroy>(
-                        registry, id, qMin((int)version, 6)));
-    } else if (interface == QLatin1String(QWaylandShm::interface()->name)) {
-        mGlobals.shm.reset(new QWaylandShm(this, version, id));
-    } else if (interface == QLatin1String(QWaylandInputDevice::interface()->name)) {
-        QWaylandInputDevice *inputDevice = mWaylandIntegration->createInputDevice(this, version, id);
-        mInputDevices.append(inputDevice);
+    Returns how to bind the global \a interface, or \nullptr if the display does not bind it
+    itself. The table is sorted by interface name so the lookup is a binary search, instead of
+    comparing the name against every supported protocol for every announced global.
+
+    Each entry caps the version it binds, the bind function gets the lower of that and the
+    advertised version.
+*/
+const QWaylandDisplay::GlobalBinding *QWaylandDisplay::findGlobalBinding(std::string_view interface)
+{
+    static constexpr GlobalBinding bindings[] = {
+        { "org_kde_kwin_appmenu_manager", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.appMenuManager.reset(new QWaylandAppMenuManager(registry, id, version));
+          } },
+        { "qt_hardware_integration", AnyVersion,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t) {
+              bool disableHardwareIntegration = qEnvironmentVariableIntValue("QT_WAYLAND_DISABLE_HW_INTEGRATION");
+              if (!disableHardwareIntegration) {
+                  display->mGlobals.hardwareIntegration.reset(new QWaylandHardwareIntegration(registry, id));
+                  // we need to receive the events sent by qt_hardware_integration before
+                  // creating windows
+                  display->requestInitialEvents();
+              }
+          } },
+        { "qt_text_input_method_manager_v1", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &interface, uint32_t version) {
+              if (!display->mTextInputManagerList.contains(interface)
+                  || display->mTextInputManagerList.indexOf(interface) >= display->mTextInputManagerIndex)
+                  return;
+
+              qCDebug(lcQpaWayland) << "text input: register qt_text_input_method_manager_v1";
+              if (display->mTextInputManagerIndex < INT_MAX) {
+                  display->mGlobals.textInputManagerv1.reset();
+                  display->mGlobals.textInputManagerv2.reset();
+                  display->mGlobals.textInputManagerv3.reset();
+                  for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices))
+                      inputDevice->setTextInput(nullptr);
+              }
+
+              display->mGlobals.textInputMethodManager.reset(
+                      new WithDestructor<QtWayland::qt_text_input_method_manager_v1,
+                                         qt_text_input_method_manager_v1_destroy>(registry, id, version));
+              for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices))
+                  inputDevice->setTextInputMethod(new QWaylandTextInputMethod(
+                          display,
+                          display->mGlobals.textInputMethodManager->get_text_input_method(
+                                  inputDevice->wl_seat())));
+              display->mWaylandIntegration->reconfigureInputContext();
+              display->mTextInputManagerIndex = display->mTextInputManagerList.indexOf(interface);
+          } },
+        { "qt_windowmanager", AnyVersion,
+          [](QWaylandDisplay *display, ::wl_registry *, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.windowManagerIntegration.reset(
+                      new QWaylandWindowManagerIntegration(display, id, version));
+          } },
+        { "wl_compositor", 6,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.compositor.reset(
+                      new WithDestructor<QtWayland::wl_compositor, wl_compositor_destroy>(
+                              registry, id, int(version)));
+          } },
 #if QT_CONFIG(wayland_datadevice)
-    } else if (interface == QLatin1String(QWaylandDataDeviceManager::interface()->name)) {
-        mGlobals.dndSelectionHandler.reset(new QWaylandDataDeviceManager(this, version, id));
+        { "wl_data_device_manager", 3,
+          [](QWaylandDisplay *display, ::wl_registry *, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.dndSelectionHandler.reset(new QWaylandDataDeviceManager(display, version, id));
+          } },
 #endif
-    } else if (interface == QLatin1String(QtWayland::wl_subcompositor::interface()->name)) {
-        mGlobals.subCompositor.reset(
-                new WithDestructor<QtWayland::wl_subcompositor, wl_subcompositor_destroy>(registry,
-                                                                                          id, 1));
-#if QT_CONFIG(tabletevent)
-    } else if (interface == QLatin1String(QWaylandTabletManagerV2::interface()->name)) {
-        mGlobals.tabletManager.reset(new QWaylandTabletManagerV2(this, id, qMin(1, int(version))));
-        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-            inputDevice->setTabletSeat(
-                    new QWaylandTabletSeatV2(mGlobals.tabletManager.get(), inputDevice));
+        { "wl_output", AnyVersion,
+          [](QWaylandDisplay *display, ::wl_registry *, uint32_t id, const QString &, uint32_t version) {
+              display->mWaitingScreens << display->mWaylandIntegration->createPlatformScreen(display, version, id);
+          } },
+        { "wl_seat", 9,
+          [](QWaylandDisplay *display, ::wl_registry *, uint32_t id, const QString &, uint32_t version) {
+              QWaylandInputDevice *inputDevice = display->mWaylandIntegration->createInputDevice(display, version, id);
+              display->mInputDevices.append(inputDevice);
+          } },
+        { "wl_shm", 2,
+          [](QWaylandDisplay *display, ::wl_registry *, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.shm.reset(new QWaylandShm(display, version, id));
+          } },
+        { "wl_subcompositor", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.subCompositor.reset(
+                      new WithDestructor<QtWayland::wl_subcompositor, wl_subcompositor_destroy>(
+                              registry, id, version));
+          } },
+        { "wp_cursor_shape_manager_v1", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.cursorShapeManager.reset(
+                      new WithDestructor<QtWayland::wp_cursor_shape_manager_v1,
+                                         wp_cursor_shape_manager_v1_destroy>(registry, id, version));
+          } },
+        { "wp_fractional_scale_manager_v1", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.fractionalScaleManager.reset(
+                      new WithDestructor<QtWayland::wp_fractional_scale_manager_v1,
+                                         wp_fractional_scale_manager_v1_destroy>(registry, id, version));
+          } },
+        { "wp_presentation", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.presentation.reset(new QWaylandPresentation(registry, id, version));
+          } },
+        { "wp_viewporter", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.viewporter.reset(
+                      new WithDestructor<QtWayland::wp_viewporter, wp_viewporter_destroy>(
+                              registry, id, version));
+          } },
+        { "xdg_system_bell_v1", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.systemBell.reset(
+                      new WithDestructor<QtWayland::xdg_system_bell_v1, xdg_system_bell_v1_destroy>(
+                              registry, id, version));
+          } },
+        { "xdg_toplevel_drag_manager_v1", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.xdgToplevelDragManager.reset(
+                      new WithDestructor<QtWayland::xdg_toplevel_drag_manager_v1,
+                                         xdg_toplevel_drag_manager_v1_destroy>(registry, id, version));
+          } },
+        { "xx_color_manager_v4", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.colorManager = std::make_unique<ColorManager>(registry, id, version);
+              // we need to receive the features the compositor supports
+              display->requestInitialEvents();
+          } },
+#if QT_CONFIG(clipboard)
+        { "zwlr_data_control_manager_v1", 2,
+          [](QWaylandDisplay *display, ::wl_registry *, uint32_t id, const QString &, uint32_t version) {
+              if (!display->mPreferWlrDataControl)
+                  return;
+              display->mGlobals.dataControlManager.reset(new QWaylandDataControlManagerV1(display, id, version));
+              for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices))
+                  inputDevice->setDataControlDevice(display->mGlobals.dataControlManager->createDevice(inputDevice));
+          } },
 #endif
-    } else if (interface == QLatin1String(QWaylandPointerGestures::interface()->name)) {
-        mGlobals.pointerGestures.reset(new QWaylandPointerGestures(this, id, 1));
+        { "zwp_linux_explicit_synchronization_v1", 2,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.explicitSynchronization.reset(
+                      new WithDestructor<QtWayland::zwp_linux_explicit_synchronization_v1,
+                                         zwp_linux_explicit_synchronization_v1_destroy>(registry, id, version));
+          } },
+        { "zwp_pointer_gestures_v1", 1,
+          [](QWaylandDisplay *display, ::wl_registry *, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.pointerGestures.reset(new QWaylandPointerGestures(display, id, version));
+          } },
 #if QT_CONFIG(wayland_client_primary_selection)
-    } else if (interface == QLatin1String(QWaylandPrimarySelectionDeviceManagerV1::interface()->name)) {
-        mGlobals.primarySelectionManager.reset(
-                new QWaylandPrimarySelectionDeviceManagerV1(this, id, 1));
-        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-            inputDevice->setPrimarySelectionDevice(
-                    mGlobals.primarySelectionManager->createDevice(inputDevice));
+        { "zwp_primary_selection_device_manager_v1", 1,
+          [](QWaylandDisplay *display, ::wl_registry *, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.primarySelectionManager.reset(
+                      new QWaylandPrimarySelectionDeviceManagerV1(display, id, version));
+              for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices))
+                  inputDevice->setPrimarySelectionDevice(
+                          display->mGlobals.primarySelectionManager->createDevice(inputDevice));
+          } },
 #endif
-    } else if (interface == QLatin1String(QtWayland::qt_text_input_method_manager_v1::interface()->name)
-            && (mTextInputManagerList.contains(interface) && mTextInputManagerList.indexOf(interface) < mTextInputManagerIndex)) {
-        qCDebug(lcQpaWayland) << "text input: register qt_text_input_method_manager_v1";
-        if (mTextInputManagerIndex < INT_MAX) {
-            mGlobals.textInputManagerv1.reset();
-            mGlobals.textInputManagerv2.reset();
-            mGlobals.textInputManagerv3.reset();
-            for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-                inputDevice->setTextInput(nullptr);
-        }
-
-        mGlobals.textInputMethodManager.reset(
-                new WithDestructor<QtWayland::qt_text_input_method_manager_v1,
-                                   qt_text_input_method_manager_v1_destroy>(registry, id, 1));
-        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-            inputDevice->setTextInputMethod(new QWaylandTextInputMethod(
-                    this,
-                    mGlobals.textInputMethodManager->get_text_input_method(
-                            inputDevice->wl_seat())));
-        mWaylandIntegration->reconfigureInputContext();
-        mTextInputManagerIndex = mTextInputManagerList.indexOf(interface);
-    } else if (interface == QLatin1String(QtWayland::zwp_text_input_manager_v1::interface()->name)
-               && (mTextInputManagerList.contains(interface) && mTextInputManagerList.indexOf(interface) < mTextInputManagerIndex)) {
-        qCDebug(lcQpaWayland) << "text input: register zwp_text_input_v1";
-        if (mTextInputManagerIndex < INT_MAX) {
-            mGlobals.textInputMethodManager.reset();
-            mGlobals.textInputManagerv2.reset();
-            mGlobals.textInputManagerv3.reset();
-            for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-                inputDevice->setTextInputMethod(nullptr);
-        }
+#if QT_CONFIG(tabletevent)
+        { "zwp_tablet_manager_v2", 1,
+          [](QWaylandDisplay *display, ::wl_registry *, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.tabletManager.reset(new QWaylandTabletManagerV2(display, id, version));
+              for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices))
+                  inputDevice->setTabletSeat(
+                          new QWaylandTabletSeatV2(display->mGlobals.tabletManager.get(), inputDevice));
+          } },
+#endif
+        { "zwp_text_input_manager_v1", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &interface, uint32_t version) {
+              if (!display->mTextInputManagerList.contains(interface)
+                  || display->mTextInputManagerList.indexOf(interface) >= display->mTextInputManagerIndex)
+                  return;
+
+              qCDebug(lcQpaWayland) << "text input: register zwp_text_input_v1";
+              if (display->mTextInputManagerIndex < INT_MAX) {
+                  display->mGlobals.textInputMethodManager.reset();
+                  display->mGlobals.textInputManagerv2.reset();
+                  display->mGlobals.textInputManagerv3.reset();
+                  for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices))
+                      inputDevice->setTextInputMethod(nullptr);
+              }
+
+              display->mGlobals.textInputManagerv1.reset(
+                      new WithDestructor<QtWayland::zwp_text_input_manager_v1,
+                                         zwp_text_input_manager_v1_destroy>(registry, id, version));
+              for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices)) {
+                  auto textInput = new QWaylandTextInputv1(
+                          display, display->mGlobals.textInputManagerv1->create_text_input());
+                  textInput->setSeat(inputDevice->wl_seat());
+                  inputDevice->setTextInput(textInput);
+              }
+
+              display->mWaylandIntegration->reconfigureInputContext();
+              display->mTextInputManagerIndex = display->mTextInputManagerList.indexOf(interface);
+          } },
+        { "zwp_text_input_manager_v2", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &interface, uint32_t version) {
+              if (!display->mTextInputManagerList.contains(interface)
+                  || display->mTextInputManagerList.indexOf(interface) >= display->mTextInputManagerIndex)
+                  return;
+
+              qCDebug(lcQpaWayland) << "text input: register zwp_text_input_v2";
+              if (display->mTextInputManagerIndex < INT_MAX) {
+                  display->mGlobals.textInputMethodManager.reset();
+                  display->mGlobals.textInputManagerv1.reset();
+                  display->mGlobals.textInputManagerv3.reset();
+                  for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices))
+                      inputDevice->setTextInputMethod(nullptr);
+              }
+
+              display->mGlobals.textInputManagerv2.reset(
+                      new WithDestructor<QtWayland::zwp_text_input_manager_v2,
+                                         zwp_text_input_manager_v2_destroy>(registry, id, version));
+              for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices))
+                  inputDevice->setTextInput(new QWaylandTextInputv2(
+                          display, display->mGlobals.textInputManagerv2->get_text_input(inputDevice->wl_seat())));
+              display->mWaylandIntegration->reconfigureInputContext();
+              display->mTextInputManagerIndex = display->mTextInputManagerList.indexOf(interface);
+          } },
+        { "zwp_text_input_manager_v3", 1,
+          [](QWaylandDisplay *display, ::wl_registry *registry, uint32_t id, const QString &interface, uint32_t version) {
+              if (!display->mTextInputManagerList.contains(interface)
+                  || display->mTextInputManagerList.indexOf(interface) >= display->mTextInputManagerIndex)
+                  return;
+
+              qCDebug(lcQpaWayland) << "text input: register zwp_text_input_v3";
+              if (display->mTextInputManagerIndex < INT_MAX) {
+                  display->mGlobals.textInputMethodManager.reset();
+                  display->mGlobals.textInputManagerv2.reset();
+                  for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices))
+                      inputDevice->setTextInputMethod(nullptr);
+              }
+              display->mGlobals.textInputManagerv3.reset(
+                      new WithDestructor<QtWayland::zwp_text_input_manager_v3,
+                                         zwp_text_input_manager_v3_destroy>(registry, id, version));
+              for (QWaylandInputDevice *inputDevice : std::as_const(display->mInputDevices))
+                  inputDevice->setTextInput(new QWaylandTextInputv3(
+                          display, display->mGlobals.textInputManagerv3->get_text_input(inputDevice->wl_seat())));
+
+              display->mWaylandIntegration->reconfigureInputContext();
+              display->mTextInputManagerIndex = display->mTextInputManagerList.indexOf(interface);
+          } },
+        { "zxdg_output_manager_v1", 3,
+          [](QWaylandDisplay *display, ::wl_registry *, uint32_t id, const QString &, uint32_t version) {
+              display->mGlobals.xdgOutputManager.reset(new QWaylandXdgOutputManagerV1(display, id, version));
+              for (auto *screen : std::as_const(display->mWaitingScreens))
+                  screen->initXdgOutput(display->xdgOutputManager());
+          } },
+    };
 
-        mGlobals.textInputManagerv1.reset(
-                new WithDestructor<QtWayland::zwp_text_input_manager_v1,
-                                   zwp_text_input_manager_v1_destroy>(registry, id, 1));
-        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices)) {
-            auto textInput =
-                    new QWaylandTextInputv1(this, mGlobals.textInputManagerv1->create_text_input());
-            textInput->setSeat(inputDevice->wl_seat());
-            inputDevice->setTextInput(textInput);
+    static_assert([] {
+        for (size_t i = 1; i < std::size(bindings); ++i) {
+            if (!(bindings[i - 1].interface < bindings[i].interface))
+                return false;
         }
+        return true;
+    }(), "The global bindings must be sorted by interface name");
 
-        mWaylandIntegration->reconfigureInputContext();
-        mTextInputManagerIndex = mTextInputManagerList.indexOf(interface);
-    } else if (interface == QLatin1String(QtWayland::zwp_text_input_manager_v2::interface()->name)
-            && (mTextInputManagerList.contains(interface) && mTextInputManagerList.indexOf(interface) < mTextInputManagerIndex)) {
-        qCDebug(lcQpaWayland) << "text input: register zwp_text_input_v2";
-        if (mTextInputManagerIndex < INT_MAX) {
-            mGlobals.textInputMethodManager.reset();
-            mGlobals.textInputManagerv1.reset();
-            mGlobals.textInputManagerv3.reset();
-            for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-                inputDevice->setTextInputMethod(nullptr);
-        }
+    const auto it = std::lower_bound(std::begin(bindings), std::end(bindings), interface,
+                                     [](const GlobalBinding &binding, std::string_view name) {
+                                         return binding.interface < name;
+                                     });
+    if (it == std::end(bindings) || it->interface != interface)
+        return nullptr;
+    return it;
+}
 
-        mGlobals.textInputManagerv2.reset(
-                new WithDestructor<QtWayland::zwp_text_input_manager_v2,
-                                   zwp_text_input_manager_v2_destroy>(registry, id, 1));
-        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-            inputDevice->setTextInput(new QWaylandTextInputv2(
-                    this, mGlobals.textInputManagerv2->get_text_input(inputDevice->wl_seat())));
-        mWaylandIntegration->reconfigureInputContext();
-        mTextInputManagerIndex = mTextInputManagerList.indexOf(interface);
-    } else if (interface == QLatin1String(QtWayland::zwp_text_input_manager_v3::interface()->name)
-            && (mTextInputManagerList.contains(interface) && mTextInputManagerList.indexOf(interface) < mTextInputManagerIndex)) {
-        qCDebug(lcQpaWayland) << "text input: register zwp_text_input_v3";
-        if (mTextInputManagerIndex < INT_MAX) {
-            mGlobals.textInputMethodManager.reset();
-            mGlobals.textInputManagerv2.reset();
-            for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-                inputDevice->setTextInputMethod(nullptr);
-        }
-        mGlobals.textInputManagerv3.reset(
-                new WithDestructor<QtWayland::zwp_text_input_manager_v3,
-                                   zwp_text_input_manager_v3_destroy>(registry, id, 1));
-        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-            inputDevice->setTextInput(new QWaylandTextInputv3(
-                    this, mGlobals.textInputManagerv3->get_text_input(inputDevice->wl_seat())));
+void QWaylandDisplay::registry_global(uint32_t id, const QString &interface, uint32_t version)
+{
+    struct ::wl_registry *registry = object();
 
-        mWaylandIntegration->reconfigureInputContext();
-        mTextInputManagerIndex = mTextInputManagerList.indexOf(interface);
-    }else if (interface == QLatin1String(QWaylandHardwareIntegration::interface()->name)) {
-        bool disableHardwareIntegration = qEnvironmentVariableIntValue("QT_WAYLAND_DISABLE_HW_INTEGRATION");
-        if (!disableHardwareIntegration) {
-            mGlobals.hardwareIntegration.reset(new QWaylandHardwareIntegration(registry, id));
-            // make a roundtrip here since we need to receive the events sent by
-            // qt_hardware_integration before creating windows
-            forceRoundTrip();
-        }
-    } else if (interface == QLatin1String(QWaylandXdgOutputManagerV1::interface()->name)) {
-        mGlobals.xdgOutputManager.reset(new QWaylandXdgOutputManagerV1(this, id, version));
-        for (auto *screen : std::as_const(mWaitingScreens))
-            screen->initXdgOutput(xdgOutputManager());
-    } else if (interface == QLatin1String(QtWayland::wp_fractional_scale_manager_v1::interface()->name)) {
-        mGlobals.fractionalScaleManager.reset(
-                new WithDestructor<QtWayland::wp_fractional_scale_manager_v1,
-                                   wp_fractional_scale_manager_v1_destroy>(registry, id, 1));
-    } else if (interface == QLatin1String("wp_viewporter")) {
-        mGlobals.viewporter.reset(
-                new WithDestructor<QtWayland::wp_viewporter, wp_viewporter_destroy>(
-                        registry, id, qMin(1u, version)));
-    } else if (interface == QLatin1String(QtWayland::wp_cursor_shape_manager_v1::interface()->name)) {
-        mGlobals.cursorShapeManager.reset(new WithDestructor<QtWayland::wp_cursor_shape_manager_v1,
-                                                             wp_cursor_shape_manager_v1_destroy>(
-                registry, id, std::min(1u, version)));
-    } else if (
-            interface == QLatin1String(QtWayland::xdg_toplevel_drag_manager_v1::interface()->name)) {
-        mGlobals.xdgToplevelDragManager.reset(
-                new WithDestructor<QtWayland::xdg_toplevel_drag_manager_v1,
-                                   xdg_toplevel_drag_manager_v1_destroy>(registry, id, 1));
-    } else if (interface == QLatin1String(QtWayland::qt_windowmanager::interface()->name)) {
-        mGlobals.windowManagerIntegration.reset(
-                new QWaylandWindowManagerIntegration(this, id, version));
-    } else if (interface == QLatin1String(QtWayland::xdg_system_bell_v1::interface()->name)) {
-        mGlobals.systemBell.reset(new WithDestructor<QtWayland::xdg_system_bell_v1, xdg_system_bell_v1_destroy>(registry, id, 1));
-    } else if (
-            interface == QLatin1String(QtWayland::org_kde_kwin_appmenu_manager::interface()->name)) {
-        mGlobals.appMenuManager.reset(new QWaylandAppMenuManager(registry, id, 1));
-#if QT_CONFIG(clipboard)
-    } else if (mPreferWlrDataControl && interface == QLatin1String(QWaylandDataControlManagerV1::interface()->name)) {
-        mGlobals.dataControlManager.reset(new QWaylandDataControlManagerV1(this, id, 2));
-        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices)) {
-            inputDevice->setDataControlDevice(mGlobals.dataControlManager->createDevice(inputDevice));
-        }
-#endif
-    } else if (interface == QLatin1String(QtWayland::xx_color_manager_v4::interface()->name)) {
-        mGlobals.colorManager = std::make_unique<ColorManager>(registry, id, 1);
-        // we need a roundtrip to receive the features the compositor supports
-        forceRoundTrip();
+    static QStringList interfaceBlacklist = qEnvironmentVariable("QT_WAYLAND_DISABLED_INTERFACES").split(u',');
+    if (interfaceBlacklist.contains(interface)) {
+        return;
     }
 
+    const QByteArray name = interface.toLatin1();
+    if (const GlobalBinding *binding = findGlobalBinding(std::string_view(name.constData(), name.size())))
+        binding->bind(this, registry, id, interface, std::min(version, binding->maxVersion));
+
+    mRegistryGlobalIndex.insert(id, mRegistryGlobals.size());
+    mRegistryGlobalIds[interface].append(id);
     mRegistryGlobals.append(RegistryGlobal(id, interface, version, registry));
     emit globalAdded(mRegistryGlobals.back());
 
     const auto copy = mRegistryListeners; // be prepared for listeners unregistering on notification
     for (Listener l : copy)
         (*l.listener)(l.data, registry, id, interface, version);
+
+    const auto interfaceListeners = mInterfaceListeners.value(interface);
+    for (Listener l : interfaceListeners)
+        (*l.listener)(l.data, registry, id, interface, version);
 }
 
 void QWaylandDisplay::registry_global_remove(uint32_t id)
 {
-    for (int i = 0, ie = mRegistryGlobals.size(); i != ie; ++i) {
-        RegistryGlobal &global = mRegistryGlobals[i];
-        if (global.id == id) {
-            if (global.interface == QLatin1String(QtWayland::wl_output::interface()->name)) {
-                for (auto *screen : mWaitingScreens) {
-                    if (screen->outputId() == id) {
-                        mWaitingScreens.removeOne(screen);
-                        delete screen;
-                        break;
-                    }
-                }
+    const auto index = mRegistryGlobalIndex.constFind(id);
+    if (index == mRegistryGlobalIndex.cend())
+        return;
 
-                for (QWaylandScreen *screen : std::as_const(mScreens)) {
-                    if (screen->outputId() == id) {
-                        mScreens.removeOne(screen);
-                        // If this is the last screen, we have to add a fake screen, or Qt will break.
-                        ensureScreen();
-                        QWindowSystemInterface::handleScreenRemoved(screen);
-                        break;
-                    }
-                }
-            }
-            if (global.interface == QLatin1String(QtWayland::zwp_text_input_manager_v1::interface()->name)) {
-                mGlobals.textInputManagerv1.reset();
-                for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-                    inputDevice->setTextInput(nullptr);
-                mWaylandIntegration->reconfigureInputContext();
-            }
-            if (global.interface == QLatin1String(QtWayland::zwp_text_input_manager_v2::interface()->name)) {
-                mGlobals.textInputManagerv2.reset();
-                for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-                    inputDevice->setTextInput(nullptr);
-                mWaylandIntegration->reconfigureInputContext();
-            }
-            if (global.interface == QLatin1String(QtWayland::zwp_text_input_manager_v3::interface()->name)) {
-                mGlobals.textInputManagerv3.reset();
-                for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-                    inputDevice->setTextInput(nullptr);
-                mWaylandIntegration->reconfigureInputContext();
+    const RegistryGlobal global = mRegistryGlobals.at(*index);
+    if (global.interface == QLatin1String(QtWayland::wl_output::interface()->name)) {
+        for (auto *screen : mWaitingScreens) {
+            if (screen->outputId() == id) {
+                mWaitingScreens.removeOne(screen);
+                delete screen;
+                break;
             }
-            if (global.interface == QLatin1String(QtWayland::qt_text_input_method_manager_v1::interface()->name)) {
-                mGlobals.textInputMethodManager.reset();
-                for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-                    inputDevice->setTextInputMethod(nullptr);
-                mWaylandIntegration->reconfigureInputContext();
+        }
+
+        for (QWaylandScreen *screen : std::as_const(mScreens)) {
+            if (screen->outputId() == id) {
+                mScreens.removeOne(screen);
+                // If this is the last screen, we have to add a fake screen, or Qt will break.
+                ensureScreen();
+                QWindowSystemInterface::handleScreenRemoved(screen);
+                break;
             }
+        }
+    }
+    if (global.interface == QLatin1String(QtWayland::zwp_text_input_manager_v1::interface()->name)) {
+        mGlobals.textInputManagerv1.reset();
+        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
+            inputDevice->setTextInput(nullptr);
+        mWaylandIntegration->reconfigureInputContext();
+    }
+    if (global.interface == QLatin1String(QtWayland::zwp_text_input_manager_v2::interface()->name)) {
+        mGlobals.textInputManagerv2.reset();
+        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
+            inputDevice->setTextInput(nullptr);
+        mWaylandIntegration->reconfigureInputContext();
+    }
+    if (global.interface == QLatin1String(QtWayland::zwp_text_input_manager_v3::interface()->name)) {
+        mGlobals.textInputManagerv3.reset();
+        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
+            inputDevice->setTextInput(nullptr);
+        mWaylandIntegration->reconfigureInputContext();
+    }
+    if (global.interface == QLatin1String(QtWayland::qt_text_input_method_manager_v1::interface()->name)) {
+        mGlobals.textInputMethodManager.reset();
+        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
+            inputDevice->setTextInputMethod(nullptr);
+        mWaylandIntegration->reconfigureInputContext();
+    }
 #if QT_CONFIG(wayland_client_primary_selection)
-            if (global.interface == QLatin1String(QtWayland::zwp_primary_selection_device_manager_v1::interface()->name)) {
-                mGlobals.primarySelectionManager.reset();
-                for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-                    inputDevice->setPrimarySelectionDevice(nullptr);
-            }
+    if (global.interface == QLatin1String(QtWayland::zwp_primary_selection_device_manager_v1::interface()->name)) {
+        mGlobals.primarySelectionManager.reset();
+        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
+            inputDevice->setPrimarySelectionDevice(nullptr);
+    }
 #endif
 #if QT_CONFIG(clipboard)
-            if (global.interface == QLatin1String(QtWayland::zwlr_data_control_manager_v1::interface()->name)) {
-                mGlobals.dataControlManager.reset();
-                for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
-                    inputDevice->setDataControlDevice(nullptr);
-            }
+    if (global.interface == QLatin1String(QtWayland::zwlr_data_control_manager_v1::interface()->name)) {
+        mGlobals.dataControlManager.reset();
+        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
+            inputDevice->setDataControlDevice(nullptr);
+    }
 #endif
-            emit globalRemoved(mRegistryGlobals.takeAt(i));
-            break;
-        }
+
+    emit globalRemoved(takeRegistryGlobal(mRegistryGlobalIndex.value(id)));
+}
+
+// Removes the global at index i, keeping the lookup tables in sync
+QWaylandDisplay::RegistryGlobal QWaylandDisplay::takeRegistryGlobal(qsizetype i)
+{
+    RegistryGlobal global = mRegistryGlobals.takeAt(i);
+    mRegistryGlobalIndex.remove(global.id);
+    for (qsizetype j = i; j < mRegistryGlobals.size(); ++j)
+        mRegistryGlobalIndex[mRegistryGlobals.at(j).id] = j;
+
+    auto ids = mRegistryGlobalIds.find(global.interface);
+    if (ids != mRegistryGlobalIds.end()) {
+        ids->removeOne(global.id);
+        if (ids->isEmpty())
+            mRegistryGlobalIds.erase(ids);
     }
+    return global;
 }
 
 bool QWaylandDisplay::hasRegistryGlobal(QStringView interfaceName) const
 {
-    for (const RegistryGlobal &global : mRegistryGlobals)
-        if (global.interface == interfaceName)
-            return true;
+    return mRegistryGlobalIds.contains(interfaceName.toString());
+}
 
-    return false;
+// Returns the first announced global of the given interface, if any
+std::optional<QWaylandDisplay::RegistryGlobal> QWaylandDisplay::registryGlobal(QStringView interfaceName) const
+{
+    const auto ids = mRegistryGlobalIds.constFind(interfaceName.toString());
+    if (ids == mRegistryGlobalIds.cend() || ids->isEmpty())
+        return std::nullopt;
+    return mRegistryGlobals.at(mRegistryGlobalIndex.value(ids->first()));
 }
 
 void QWaylandDisplay::addRegistryListener(RegistryListener listener, void *data)
@@ -909,12 +946,37 @@ void QWaylandDisplay::addRegistryListener(RegistryListener listener, void *data)
                       mRegistryGlobals[i].interface, mRegistryGlobals[i].version);
 }
 
+/*!
+    \internal
+
+    Like addRegistryListener(), but \a listener is only called for globals of the given
+    \a interfaceName. This is what shell and buffer integrations should use to bind their
+    globals, so they are not called for, and compare names against, every other global.
+*/
+void QWaylandDisplay::addRegistryListener(const QString &interfaceName, RegistryListener listener, void *data)
+{
+    Listener l = { listener, data };
+    mInterfaceListeners[interfaceName].append(l);
+    const QList<uint32_t> ids = mRegistryGlobalIds.value(interfaceName);
+    for (uint32_t id : ids) {
+        const RegistryGlobal &global = mRegistryGlobals.at(mRegistryGlobalIndex.value(id));
+        (*l.listener)(l.data, global.registry, global.id, global.interface, global.version);
+    }
+}
+
 void QWaylandDisplay::removeListener(RegistryListener listener, void *data)
 {
-    auto iter = std::remove_if(mRegistryListeners.begin(), mRegistryListeners.end(), [=](Listener l){
+    auto matches = [=](Listener l) {
         return (l.listener == listener && l.data == data);
-    });
-    mRegistryListeners.erase(iter, mRegistryListeners.end());
+    };
+    mRegistryListeners.removeIf(matches);
+    for (auto it = mInterfaceListeners.begin(); it != mInterfaceListeners.end();) {
+        it->removeIf(matches);
+        if (it->isEmpty())
+            it = mInterfaceListeners.erase(it);
+        else
+            ++it;
+    }
 }
 
 void QWaylandDisplay::forceRoundTrip()
@@ -922,6 +984,35 @@ void QWaylandDisplay::forceRoundTrip()
      wl_display_roundtrip(mDisplay);
 }
 
+// Called for globals whose initial events have to arrive before they are used
+void QWaylandDisplay::requestInitialEvents()
+{
+    switch (mStartupPhase) {
+    case StartupPhase::Connecting:
+    case StartupPhase::Registry:
+        // Covered by the barrier in initialize()
+        mInitialEventsRequested = true;
+        break;
+    case StartupPhase::InitialEvents:
+    case StartupPhase::Done:
+        // Announced late, e.g. hot-plugged, nothing else is waiting for the events
+        forceRoundTrip();
+        break;
+    }
+}
+
+// Enable qt.qpa.wayland.startup to see where the time before the first window goes
+void QWaylandDisplay::traceStartup(const char *step)
+{
+    if (!mStartupTimer.isValid())
+        return;
+
+    qCDebug(lcQpaWaylandStartup, "%s after %.3f ms (%lld globals)", step,
+            mStartupTimer.nsecsElapsed() / 1e6, qlonglong(mRegistryGlobals.size()));
+    if (mStartupPhase == StartupPhase::Done)
+        mStartupTimer.invalidate();
+}
+
 bool QWaylandDisplay::supportsWindowDecoration() const
 {
     static bool disabled = qgetenv("QT_WAYLAND_DISABLE_WINDOWDECORATION").toInt();
@@ -1094,7 +1185,12 @@ QWaylandCursorTheme *QWaylandDisplay::loadCursorTheme(const QString &name, int p
     if (result.found)
         return result.theme();
 
-    if (auto theme = QWaylandCursorTheme::create(shm(), pixelSize, name))
+    // There is one pool per cursor file holding the images of all its sizes, so the
+    // cache is shared by the themes of all sizes
+    if (!mCursorCache)
+        mCursorCache = std::make_unique<QWaylandCursorCache>(shm());
+
+    if (auto theme = QWaylandCursorTheme::create(mCursorCache.get(), shm(), pixelSize, name))
         return mCursorThemes.insert(result.position, {name, pixelSize, std::move(theme)})->theme.get();
 
     return nullptr;
@@ -1106,5 +1202,4 @@ QWaylandCursorTheme *QWaylandDisplay::loadCursorTheme(const QString &name, int p
 
 QT_END_NAMESPACE
 
-#include "qwaylanddisplay.moc"
 #include "moc_qwaylanddisplay_p.cpp"
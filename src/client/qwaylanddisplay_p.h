@@ -16,10 +16,12 @@
 // We mean it.
 //
 
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
 #include <QtCore/QRect>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QMutex>
 #include <QtCore/QReadWriteLock>
 
@@ -36,6 +38,9 @@
 #include <QtGui/private/qxkbcommon_p.h>
 #endif
 
+#include <optional>
+#include <string_view>
+
 struct wl_cursor_image;
 struct wp_viewport;
 
@@ -58,6 +63,7 @@ namespace QtWayland {
     class wp_viewporter;
     class xdg_system_bell_v1;
     class xdg_toplevel_drag_manager_v1;
+    class zwp_linux_explicit_synchronization_v1;
 }
 
 namespace QtWaylandClient {
@@ -82,14 +88,19 @@ class QWaylandPrimarySelectionDeviceManagerV1;
 class QWaylandTabletManagerV2;
 #endif
 class QWaylandPointerGestures;
+class QWaylandPresentation;
 class QWaylandWindow;
 class QWaylandIntegration;
 class QWaylandHardwareIntegration;
 class QWaylandSurface;
 class QWaylandShellIntegration;
 class QWaylandCursor;
+class QWaylandCursorCache;
 class QWaylandCursorTheme;
 class EventThread;
+#if QT_CONFIG(xkbcommon)
+class QWaylandKeymapCache;
+#endif
 class ColorManager;
 
 typedef void (*RegistryListener)(void *data,
@@ -109,6 +120,7 @@ public:
 
 #if QT_CONFIG(xkbcommon)
     struct xkb_context *xkbContext() const { return mXkbContext.get(); }
+    QWaylandKeymapCache *keymapCache();
 #endif
 
     QList<QWaylandScreen *> screens() const { return mScreens; }
@@ -120,6 +132,7 @@ public:
 
     struct wl_surface *createSurface(void *handle);
     struct ::wl_region *createRegion(const QRegion &qregion);
+    struct ::wl_region *cachedRegion(const QRegion &qregion);
     struct ::wl_subsurface *createSubSurface(QWaylandWindow *window, QWaylandWindow *parent);
     struct ::wp_viewport *createViewport(QWaylandWindow *window);
 
@@ -205,6 +218,10 @@ public:
     {
         return mGlobals.viewporter.get();
     }
+    QtWayland::zwp_linux_explicit_synchronization_v1 *explicitSynchronization() const
+    {
+        return mGlobals.explicitSynchronization.get();
+    }
     QtWayland::wp_cursor_shape_manager_v1 *cursorShapeManager() const
     {
         return mGlobals.cursorShapeManager.get();
@@ -225,6 +242,10 @@ public:
     {
         return mGlobals.colorManager.get();
     }
+    QWaylandPresentation *presentation() const
+    {
+        return mGlobals.presentation.get();
+    }
 
     struct RegistryGlobal {
         uint32_t id;
@@ -239,10 +260,12 @@ public:
         return mRegistryGlobals;
     }
     bool hasRegistryGlobal(QStringView interfaceName) const;
+    std::optional<RegistryGlobal> registryGlobal(QStringView interfaceName) const;
 
     /* wl_registry_add_listener does not add but rather sets a listener, so this function is used
      * to enable many listeners at once. */
     void addRegistryListener(RegistryListener listener, void *data);
+    void addRegistryListener(const QString &interfaceName, RegistryListener listener, void *data);
     void removeListener(RegistryListener listener, void *data);
 
     QWaylandShm *shm() const
@@ -266,6 +289,7 @@ public:
     void handleWindowDestroyed(QWaylandWindow *window);
 
     wl_event_queue *frameEventQueue() { return m_frameEventQueue; };
+    bool usesPerWindowEventQueues() const { return mPerWindowEventQueues; }
 
     bool isKeyboardAvailable() const;
     bool isWaylandInputContextRequested() const;
@@ -289,6 +313,18 @@ private:
     void requestWaylandSync();
 
     void checkTextInputProtocol();
+    RegistryGlobal takeRegistryGlobal(qsizetype i);
+
+    struct GlobalBinding {
+        std::string_view interface;
+        uint32_t maxVersion;
+        void (*bind)(QWaylandDisplay *display, struct ::wl_registry *registry, uint32_t id,
+                     const QString &interface, uint32_t version);
+    };
+    static const GlobalBinding *findGlobalBinding(std::string_view interface);
+    void requestInitialEvents();
+    void traceStartup(const char *step);
+    void clearRegionCache();
 
     struct Listener {
         Listener() = default;
@@ -308,6 +344,7 @@ private:
     QPlatformPlaceholderScreen *mPlaceholderScreen = nullptr;
     QList<QWaylandInputDevice *> mInputDevices;
     QList<Listener> mRegistryListeners;
+    QHash<QString, QList<Listener>> mInterfaceListeners;
     QWaylandIntegration *mWaylandIntegration = nullptr;
 #if QT_CONFIG(cursor)
     struct WaylandCursorTheme {
@@ -316,6 +353,7 @@ private:
         std::unique_ptr<QWaylandCursorTheme> theme;
     };
     std::vector<WaylandCursorTheme> mCursorThemes;
+    std::unique_ptr<QWaylandCursorCache> mCursorCache;
 
     struct FindExistingCursorThemeResult {
         std::vector<WaylandCursorTheme>::const_iterator position;
@@ -358,14 +396,18 @@ private:
         std::unique_ptr<QtWayland::wp_cursor_shape_manager_v1> cursorShapeManager;
         std::unique_ptr<QtWayland::xdg_system_bell_v1> systemBell;
         std::unique_ptr<QtWayland::xdg_toplevel_drag_manager_v1> xdgToplevelDragManager;
+        std::unique_ptr<QtWayland::zwp_linux_explicit_synchronization_v1> explicitSynchronization;
         std::unique_ptr<QWaylandWindowManagerIntegration> windowManagerIntegration;
         std::unique_ptr<QWaylandAppMenuManager> appMenuManager;
         std::unique_ptr<ColorManager> colorManager;
+        std::unique_ptr<QWaylandPresentation> presentation;
     } mGlobals;
 
     int mFd = -1;
     int mWritableNotificationFd = -1;
     QList<RegistryGlobal> mRegistryGlobals;
+    QHash<uint32_t, qsizetype> mRegistryGlobalIndex; // global id -> index in mRegistryGlobals
+    QHash<QString, QList<uint32_t>> mRegistryGlobalIds; // interface -> global ids, in announcement order
     uint32_t mLastInputSerial = 0;
     QWaylandInputDevice *mLastInputDevice = nullptr;
     QPointer<QWaylandWindow> mLastInputWindow;
@@ -373,8 +415,28 @@ private:
     QList<QWaylandWindow *> mActiveWindows;
     struct wl_callback *mSyncCallback = nullptr;
     static const wl_callback_listener syncCallbackListener;
+
+    struct CachedRegion {
+        QRegion region;
+        struct ::wl_region *object;
+    };
+    // Most recently used last
+    QList<CachedRegion> mRegionCache;
+    QMutex mRegionCacheMutex;
+
     bool mWaylandTryReconnect = false;
     bool mPreferWlrDataControl = false;
+    bool mPerWindowEventQueues = false;
+
+    enum class StartupPhase {
+        Connecting,
+        Registry,
+        InitialEvents,
+        Done
+    };
+    StartupPhase mStartupPhase = StartupPhase::Connecting;
+    bool mInitialEventsRequested = false;
+    QElapsedTimer mStartupTimer;
 
     bool mWaylandInputContextRequested = [] () {
         const auto requested = QPlatformInputContextFactory::requested();
@@ -388,6 +450,8 @@ private:
 
 #if QT_CONFIG(xkbcommon)
     QXkbCommon::ScopedXKBContext mXkbContext;
+    // Outlives reconnects, the compositor is likely to send the same keymaps again
+    std::unique_ptr<QWaylandKeymapCache> mKeymapCache;
 #endif
 
     friend class QWaylandIntegration;
@@ -0,0 +1,209 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qwaylandeventthread_p.h"
+
+#include <QtCore/private/qcore_unix_p.h>
+
+#include <wayland-client-core.h>
+
+#include <errno.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWaylandClient {
+
+EventThread::EventThread(struct wl_display *wl, struct wl_event_queue *ev_queue,
+                         OperatingMode mode, QRecursiveMutex *dispatchMutex)
+    : m_fd(wl_display_get_fd(wl))
+    , m_pipefd{ -1, -1 }
+    , m_wldisplay(wl)
+    , m_wlevqueue(ev_queue)
+    , m_mode(mode)
+    , m_dispatchMutex(dispatchMutex)
+    , m_reading(true)
+    , m_quitting(false)
+{
+    setObjectName(QStringLiteral("WaylandEventThread"));
+}
+
+void EventThread::readAndDispatchEvents()
+{
+    /*
+     * Dispatch pending events and flush the requests at least once. If the event thread
+     * is not reading, try to call _prepare_read() to allow the event thread to poll().
+     * If that fails, re-try dispatch & flush again until _prepare_read() is successful.
+     *
+     * This allow any call to readAndDispatchEvents() to start event thread's polling,
+     * not only the one issued from event thread's waitForReading(), which means functions
+     * called from dispatch_pending() can safely spin an event loop.
+     */
+    if (m_quitting)
+        return;
+
+    for (;;) {
+        if (dispatchQueuePending() < 0) {
+            Q_EMIT waylandError();
+            QMutexLocker l(&m_mutex);
+            m_quitting = true;
+            m_dispatchedCond.wakeAll();
+            return;
+        }
+
+        {
+            QMutexLocker l(&m_mutex);
+            m_dispatchCount.fetchAndAddRelease(1);
+            m_dispatchedCond.wakeAll();
+        }
+
+        wl_display_flush(m_wldisplay);
+
+        // We have to check if event thread is reading every time we dispatch
+        // something, as that may recursively call this function.
+        if (m_reading.loadAcquire())
+            break;
+
+        if (prepareReadQueue() == 0) {
+            QMutexLocker l(&m_mutex);
+            m_reading.storeRelease(true);
+            m_cond.wakeOne();
+            break;
+        }
+    }
+}
+
+void EventThread::stop()
+{
+    // We have to both write to the pipe and set the flag, as the thread may be
+    // either in the poll() or waiting for _prepare_read().
+    if (m_pipefd[1] != -1 && write(m_pipefd[1], "\0", 1) == -1)
+        qWarning("Failed to write to the pipe: %s.", strerror(errno));
+
+    {
+        QMutexLocker l(&m_mutex);
+        m_quitting = true;
+        m_cond.wakeOne();
+        m_dispatchedCond.wakeAll();
+    }
+
+    wait();
+}
+
+bool EventThread::waitForDispatch(quint64 lastSeenCount, QDeadlineTimer deadline)
+{
+    Q_ASSERT(QThread::currentThread() != this);
+
+    QMutexLocker lock(&m_mutex);
+    while (m_dispatchCount.loadRelaxed() == lastSeenCount && !m_quitting) {
+        if (!m_dispatchedCond.wait(&m_mutex, deadline))
+            break;
+    }
+    return m_dispatchCount.loadRelaxed() != lastSeenCount;
+}
+
+void EventThread::run()
+{
+    // we use this pipe to make the loop exit otherwise if we simply used a flag on the loop condition, if stop() gets
+    // called while poll() is blocking the thread will never quit since there are no wayland messages coming anymore.
+    struct Pipe
+    {
+        Pipe(int *fds)
+            : fds(fds)
+        {
+            if (qt_safe_pipe(fds) != 0)
+                qWarning("Pipe creation failed. Quitting may hang.");
+        }
+        ~Pipe()
+        {
+            if (fds[0] != -1) {
+                close(fds[0]);
+                close(fds[1]);
+            }
+        }
+
+        int *fds;
+    } pipe(m_pipefd);
+
+    // Make the main thread call wl_prepare_read(), dispatch the pending messages and flush the
+    // outbound ones. Wait until it's done before proceeding, unless we're told to quit.
+    while (waitForReading()) {
+        if (!m_reading.loadRelaxed())
+            break;
+
+        pollfd fds[2] = { { m_fd, POLLIN, 0 }, { m_pipefd[0], POLLIN, 0 } };
+        poll(fds, 2, -1);
+
+        if (fds[1].revents & POLLIN) {
+            // we don't really care to read the byte that was written here since we're closing down
+            wl_display_cancel_read(m_wldisplay);
+            break;
+        }
+
+        if (fds[0].revents & POLLIN)
+            wl_display_read_events(m_wldisplay);
+            // The poll was succesfull and the event thread did the wl_display_read_events(). On the next iteration of the loop
+            // the event sent to the main thread will cause it to dispatch the messages just read, unless the loop exits in which
+            // case we don't care anymore about them.
+        else
+            wl_display_cancel_read(m_wldisplay);
+    }
+}
+
+bool EventThread::waitForReading()
+{
+    Q_ASSERT(QThread::currentThread() == this);
+
+    m_reading.storeRelease(false);
+
+    if (m_mode == SelfDispatch) {
+        readAndDispatchEvents();
+    } else {
+        Q_EMIT needReadAndDispatch();
+
+        QMutexLocker lock(&m_mutex);
+        // m_reading might be set from our emit or some other invocation of
+        // readAndDispatchEvents().
+        while (!m_reading.loadRelaxed() && !m_quitting)
+            m_cond.wait(&m_mutex);
+    }
+
+    return !m_quitting;
+}
+
+int EventThread::dispatchQueuePending()
+{
+    QMutexLocker dispatchLock(m_dispatchMutex);
+    if (m_wlevqueue)
+        return wl_display_dispatch_queue_pending(m_wldisplay, m_wlevqueue);
+    else
+        return wl_display_dispatch_pending(m_wldisplay);
+}
+
+int EventThread::prepareReadQueue()
+{
+    if (m_wlevqueue)
+        return wl_display_prepare_read_queue(m_wldisplay, m_wlevqueue);
+    else
+        return wl_display_prepare_read(m_wldisplay);
+}
+
+QWaylandEventQueue::QWaylandEventQueue(struct wl_display *display)
+    : mQueue(wl_display_create_queue(display))
+    , mThread(new EventThread(display, mQueue, EventThread::SelfDispatch, &mDispatchMutex))
+{
+    mThread->setObjectName(QStringLiteral("WaylandWindowEventThread"));
+    mThread->start();
+}
+
+QWaylandEventQueue::~QWaylandEventQueue()
+{
+    mThread->stop();
+    mThread.reset();
+    wl_event_queue_destroy(mQueue);
+}
+
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qwaylandeventthread_p.cpp"
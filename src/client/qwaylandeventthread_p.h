@@ -0,0 +1,131 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QWAYLANDEVENTTHREAD_P_H
+#define QWAYLANDEVENTTHREAD_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandClient/qtwaylandclientglobal.h>
+
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QRecursiveMutex>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+#include <memory>
+
+struct wl_display;
+struct wl_event_queue;
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWaylandClient {
+
+class EventThread : public QThread
+{
+    Q_OBJECT
+public:
+    enum OperatingMode {
+        EmitToDispatch, // Emit the signal, allow dispatching in a differnt thread.
+        SelfDispatch, // Dispatch the events inside this thread.
+    };
+
+    EventThread(struct wl_display *wl, struct wl_event_queue *ev_queue, OperatingMode mode,
+                QRecursiveMutex *dispatchMutex = nullptr);
+
+    void readAndDispatchEvents();
+    void stop();
+
+    // Number of completed dispatch rounds, used by threads waiting for events on m_wlevqueue
+    quint64 dispatchCount() const { return m_dispatchCount.loadAcquire(); }
+    bool waitForDispatch(quint64 lastSeenCount, QDeadlineTimer deadline = QDeadlineTimer::Forever);
+
+Q_SIGNALS:
+    void needReadAndDispatch();
+    void waylandError();
+
+protected:
+    void run() override;
+
+private:
+    bool waitForReading();
+    int dispatchQueuePending();
+    int prepareReadQueue();
+
+    int m_fd;
+    int m_pipefd[2];
+    wl_display *m_wldisplay;
+    wl_event_queue *m_wlevqueue;
+    OperatingMode m_mode;
+    // Held while listeners run, so that other threads can destroy proxies on m_wlevqueue
+    // without racing with a listener that is using their user data.
+    QRecursiveMutex *m_dispatchMutex;
+
+    /* Concurrency note when operating in EmitToDispatch mode:
+     * m_reading is set to false inside event thread's waitForReading(), and is
+     * set to true inside main thread's readAndDispatchEvents().
+     * The lock is not taken when setting m_reading to false, as the main thread
+     * is not actively waiting for it to turn false. However, the lock is taken
+     * inside readAndDispatchEvents() before setting m_reading to true,
+     * as the event thread is actively waiting for it under the wait condition.
+     */
+
+    QAtomicInteger<bool> m_reading;
+    bool m_quitting;
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+
+    QAtomicInteger<quint64> m_dispatchCount = 0;
+    QWaitCondition m_dispatchedCond;
+};
+
+/*
+ * A private event queue served by its own SelfDispatch thread.
+ *
+ * Used to give a window its own stream of frame callbacks and buffer releases so that a
+ * window that stalls (e.g. blocked in waitForFrameSync()) does not hold back the others.
+ * Objects whose events go to the queue keep a reference to it, so the queue outlives
+ * every proxy that was moved onto it. Listeners run with dispatchMutex() held; a thread
+ * that destroys such a proxy must hold it too, so that the listener is either done with
+ * the proxy's user data or will never be called for it.
+ */
+class QWaylandEventQueue
+{
+public:
+    explicit QWaylandEventQueue(struct wl_display *display);
+    ~QWaylandEventQueue();
+
+    struct wl_event_queue *queue() const { return mQueue; }
+
+    quint64 dispatchCount() const { return mThread->dispatchCount(); }
+    bool waitForDispatch(quint64 lastSeenCount, QDeadlineTimer deadline = QDeadlineTimer::Forever)
+    {
+        return mThread->waitForDispatch(lastSeenCount, deadline);
+    }
+
+    QRecursiveMutex *dispatchMutex() { return &mDispatchMutex; }
+
+private:
+    Q_DISABLE_COPY_MOVE(QWaylandEventQueue)
+
+    struct wl_event_queue *mQueue = nullptr;
+    QRecursiveMutex mDispatchMutex;
+    std::unique_ptr<EventThread> mThread;
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDEVENTTHREAD_P_H
@@ -34,6 +34,10 @@
 #include "qwaylandinputmethodcontext_p.h"
 #include "qwaylandcallback_p.h"
 #include "qwaylandcursorsurface_p.h"
+#include "qwaylandlatencytrace_p.h"
+#if QT_CONFIG(xkbcommon)
+#include "qwaylandkeymapcache_p.h"
+#endif
 
 #include <QtGui/private/qpixmap_raster_p.h>
 #include <QtGui/private/qguiapplication_p.h>
@@ -46,10 +50,6 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 
-#if QT_CONFIG(cursor)
-#include <wayland-cursor.h>
-#endif
-
 #include <QtGui/QGuiApplication>
 #include <QtGui/QPointingDevice>
 
@@ -82,6 +82,10 @@ QWaylandInputDevice::Keyboard::Keyboard(QWaylandInputDevice *p)
                   mRepeatKey.code, mRepeatKey.nativeVirtualKey, this->mNativeModifiers,
                   mRepeatKey.text, true);
     });
+#if QT_CONFIG(xkbcommon)
+    connect(p->mQDisplay->keymapCache(), &QWaylandKeymapCache::compiled,
+            this, &Keyboard::applyCompiledKeymap);
+#endif
 }
 
 #if QT_CONFIG(xkbcommon)
@@ -194,8 +198,8 @@ void QWaylandInputDevice::Pointer::updateCursorTheme()
     if (!mCursor.theme)
         return; // A warning has already been printed in loadCursorTheme
 
-    if (auto *arrow = mCursor.theme->cursor(Qt::ArrowCursor)) {
-        int arrowPixelSize = qMax(arrow->images[0]->width, arrow->images[0]->height); // Not all cursor themes are square
+    if (const auto *arrow = mCursor.theme->image(Qt::ArrowCursor)) {
+        int arrowPixelSize = qMax(arrow->size.width(), arrow->size.height()); // Not all cursor themes are square
         while (scale > 1 && arrowPixelSize / scale < cursorSize.width())
             --scale;
     } else {
@@ -247,19 +251,16 @@ void QWaylandInputDevice::Pointer::updateCursor()
     // Set from shape using theme
     uint time = seat()->mCursor.animationTimer.elapsed();
 
-    if (struct ::wl_cursor *waylandCursor = mCursor.theme->cursor(shape)) {
-        uint duration = 0;
-        int frame = wl_cursor_frame_and_duration(waylandCursor, time, &duration);
-        ::wl_cursor_image *image = waylandCursor->images[frame];
-
-        struct wl_buffer *buffer = wl_cursor_image_get_buffer(image);
+    uint duration = 0;
+    if (const auto *image = mCursor.theme->image(shape, time, &duration)) {
+        struct wl_buffer *buffer = image->buffer;
         if (!buffer) {
             qCWarning(lcQpaWayland) << "Could not find buffer for cursor" << shape;
             return;
         }
         int bufferScale = mCursor.themeBufferScale;
-        QPoint hotspot = QPoint(image->hotspot_x, image->hotspot_y) / bufferScale;
-        QSize size = QSize(image->width, image->height) / bufferScale;
+        QPoint hotspot = image->hotspot / bufferScale;
+        QSize size = image->size / bufferScale;
         bool animated = duration > 0;
         if (animated) {
             mCursor.gotFrameCallback = false;
@@ -477,6 +478,12 @@ void QWaylandInputDevice::handleEndDrag()
         mPointer->releaseButtons();
 }
 
+void QWaylandInputDevice::flushDeferredTouchFrame()
+{
+    if (mTouch)
+        mTouch->flushDeferredFrame();
+}
+
 void QWaylandInputDevice::handleStartDrag()
 {
     if (mPointer)
@@ -743,6 +750,11 @@ void QWaylandInputDevice::Pointer::pointer_motion(uint32_t time, wl_fixed_t surf
         return;
     }
 
+    const quint64 traceFlow = QWaylandLatencyTrace::motionFlow(time);
+    QWaylandLatencyTrace::Slice traceSlice("wl_pointer.motion");
+    traceSlice.addFlow(traceFlow, QWaylandLatencyTrace::FlowStep);
+    window->traceInputDispatched(traceFlow);
+
     QPointF pos(wl_fixed_to_double(surface_x), wl_fixed_to_double(surface_y));
     QPointF global = window->mapToGlobalF(pos);
 
@@ -795,6 +807,11 @@ void QWaylandInputDevice::Pointer::pointer_button(uint32_t serial, uint32_t time
         return;
     }
 
+    const quint64 traceFlow = QWaylandLatencyTrace::buttonFlow(serial);
+    QWaylandLatencyTrace::Slice traceSlice("wl_pointer.button");
+    traceSlice.addFlow(traceFlow, QWaylandLatencyTrace::FlowStep);
+    window->traceInputDispatched(traceFlow);
+
     Qt::MouseButton qt_button;
 
     // translate from kernel (input.h) 'button' to corresponding Qt:MouseButton.
@@ -1166,6 +1183,9 @@ void QWaylandInputDevice::Pointer::flushScrollEvent()
 
 void QWaylandInputDevice::Pointer::flushFrameEvent()
 {
+    // Keep the order touch and pointer events were sent in
+    mParent->flushDeferredTouchFrame();
+
     if (auto *event = mFrameData.event) {
         if (auto window = event->surface) {
             window->handleMouse(mParent, *event);
@@ -1208,24 +1228,68 @@ void QWaylandInputDevice::Keyboard::keyboard_keymap(uint32_t format, int32_t fd,
         return;
     }
 
-    mXkbKeymap.reset(xkb_keymap_new_from_string(mParent->mQDisplay->xkbContext(), map_str,
-                                                XKB_KEYMAP_FORMAT_TEXT_V1,
-                                                XKB_KEYMAP_COMPILE_NO_FLAGS));
-    QXkbCommon::verifyHasLatinLayout(mXkbKeymap.get());
-
+    const QByteArray text(map_str, qstrnlen(map_str, size));
     munmap(map_str, size);
     close(fd);
 
-    if (mXkbKeymap)
-        mXkbState.reset(xkb_state_new(mXkbKeymap.get()));
+    // Compiling complex keymaps takes tens of milliseconds, so it's done on a worker thread
+    // and the key events that arrive meanwhile wait for it
+    auto *cache = mParent->mQDisplay->keymapCache();
+    mKeymapKey = QWaylandKeymapCache::keyFor(text);
+    cache->compile(mKeymapKey, text);
+    if (cache->isCompiling(mKeymapKey))
+        mKeymapPending = true;
     else
-        mXkbState.reset(nullptr);
+        applyCompiledKeymap(mKeymapKey);
 #else
     Q_UNUSED(fd);
     Q_UNUSED(size);
 #endif
 }
 
+#if QT_CONFIG(xkbcommon)
+void QWaylandInputDevice::Keyboard::applyCompiledKeymap(const QByteArray &key)
+{
+    if (key != mKeymapKey)
+        return;
+
+    mKeymapPending = false;
+    mXkbKeymap = mParent->mQDisplay->keymapCache()->keymap(key);
+    if (mXkbKeymap)
+        mXkbState.reset(xkb_state_new(mXkbKeymap.get()));
+    else
+        mXkbState.reset(nullptr);
+
+    // Another keymap may arrive while these are replayed, which buffers the rest again
+    const QList<PendingEvent> events = std::exchange(mPendingEvents, {});
+    for (qsizetype i = 0; i < events.size(); ++i) {
+        if (mKeymapPending) {
+            mPendingEvents.append(events.mid(i));
+            break;
+        }
+        const PendingEvent &event = events.at(i);
+        switch (event.type) {
+        case PendingEvent::Enter:
+            // The surface may have been destroyed meanwhile
+            if (event.surface)
+                handleEnter(event.surface);
+            break;
+        case PendingEvent::Leave:
+            if (event.surface)
+                handleLeave(event.surface);
+            break;
+        case PendingEvent::Key:
+            keyboard_key(event.serial, event.time, event.key, event.state);
+            break;
+        case PendingEvent::Modifiers:
+            keyboard_modifiers(event.serial, event.modsDepressed, event.modsLatched,
+                               event.modsLocked, event.group);
+            break;
+        }
+    }
+}
+#endif
+
 void QWaylandInputDevice::Keyboard::keyboard_enter(uint32_t serial, struct wl_surface *surface, struct wl_array *keys)
 {
     Q_UNUSED(serial);
@@ -1241,12 +1305,25 @@ void QWaylandInputDevice::Keyboard::keyboard_enter(uint32_t serial, struct wl_su
     if (!window)
         return;
 
+#if QT_CONFIG(xkbcommon)
+    // Keys buffered for the keymap have to go to the surface that had focus when they arrived
+    if (mKeymapPending) {
+        mPendingEvents.append({ PendingEvent::Enter, serial, 0, 0, 0, 0, 0, 0, 0, window->waylandSurface() });
+        return;
+    }
+#endif
+
+    handleEnter(window->waylandSurface());
+}
+
+void QWaylandInputDevice::Keyboard::handleEnter(QWaylandSurface *surface)
+{
     if (mFocus) {
         qCWarning(lcQpaWayland()) << "Unexpected wl_keyboard.enter event. Keyboard already has focus";
         disconnect(mFocus, &QWaylandSurface::destroyed, this, &Keyboard::handleFocusDestroyed);
     }
 
-    mFocus = window->waylandSurface();
+    mFocus = surface;
     connect(mFocus, &QWaylandSurface::destroyed, this, &Keyboard::handleFocusDestroyed);
 
     mParent->mQDisplay->handleKeyboardFocusChanged(mParent);
@@ -1265,7 +1342,19 @@ void QWaylandInputDevice::Keyboard::keyboard_leave(uint32_t serial, struct wl_su
     if (!window)
         return;
 
-    if (window->waylandSurface() != mFocus) {
+#if QT_CONFIG(xkbcommon)
+    if (mKeymapPending) {
+        mPendingEvents.append({ PendingEvent::Leave, serial, 0, 0, 0, 0, 0, 0, 0, window->waylandSurface() });
+        return;
+    }
+#endif
+
+    handleLeave(window->waylandSurface());
+}
+
+void QWaylandInputDevice::Keyboard::handleLeave(QWaylandSurface *surface)
+{
+    if (surface != mFocus) {
         qCWarning(lcQpaWayland) << "Ignoring unexpected wl_keyboard.leave event."
                                 << "wl_surface argument does not match the current focus"
                                 << "This is most likely a compositor bug";
@@ -1280,6 +1369,9 @@ void QWaylandInputDevice::Keyboard::handleKey(ulong timestamp, QEvent::Type type
                                               quint32 nativeVirtualKey, quint32 nativeModifiers,
                                               const QString &text, bool autorepeat, ushort count)
 {
+    // Keep the order touch and key events were sent in
+    mParent->flushDeferredTouchFrame();
+
     QPlatformInputContext *inputContext = QGuiApplicationPrivate::platformIntegration()->inputContext();
     bool filtered = false;
 
@@ -1314,6 +1406,13 @@ void QWaylandInputDevice::Keyboard::keyboard_key(uint32_t serial, uint32_t time,
         return;
     }
 
+#if QT_CONFIG(xkbcommon)
+    if (mKeymapPending) {
+        mPendingEvents.append({ PendingEvent::Key, serial, time, key, state, 0, 0, 0, 0, nullptr });
+        return;
+    }
+#endif
+
     auto *window = focusWindow();
     if (!window) {
         // We destroyed the keyboard focus surface, but the server didn't get the message yet...
@@ -1323,6 +1422,11 @@ void QWaylandInputDevice::Keyboard::keyboard_key(uint32_t serial, uint32_t time,
 
     mParent->mSerial = serial;
 
+    const quint64 traceFlow = QWaylandLatencyTrace::keyFlow(serial);
+    QWaylandLatencyTrace::Slice traceSlice("wl_keyboard.key");
+    traceSlice.addFlow(traceFlow, QWaylandLatencyTrace::FlowStep);
+    window->traceInputDispatched(traceFlow);
+
     const bool isDown = state != WL_KEYBOARD_KEY_STATE_RELEASED;
     if (isDown)
         mParent->mQDisplay->setLastInputDevice(mParent, serial, window);
@@ -1386,6 +1490,11 @@ void QWaylandInputDevice::Keyboard::keyboard_modifiers(uint32_t serial,
 {
     Q_UNUSED(serial);
 #if QT_CONFIG(xkbcommon)
+    if (mKeymapPending) {
+        mPendingEvents.append({ PendingEvent::Modifiers, serial, 0, 0, 0, mods_depressed, mods_latched, mods_locked, group, nullptr });
+        return;
+    }
+
     if (mXkbState)
         xkb_state_update_mask(mXkbState.get(),
                               mods_depressed, mods_latched, mods_locked,
@@ -1457,6 +1566,8 @@ void QWaylandInputDevice::Touch::touch_motion(uint32_t time, int32_t id, wl_fixe
 void QWaylandInputDevice::Touch::touch_cancel()
 {
     mPendingTouchPoints.clear();
+    mFrameDeferred = false;
+    mDeferredTouchPoints.clear();
 
     mFocus = nullptr;
     QWindowSystemInterface::handleTouchCancelEvent(nullptr, mParent->mTouchDevice);
@@ -1528,7 +1639,15 @@ void QWaylandInputDevice::Touch::releasePoints()
 
 void QWaylandInputDevice::Touch::touch_frame()
 {
-    // TODO: early return if no events?
+    bool changed = false;
+    bool motionOnly = true;
+    for (const auto &tp : std::as_const(mPendingTouchPoints)) {
+        changed |= tp.state != QEventPoint::Stationary;
+        motionOnly &= tp.state == QEventPoint::Updated || tp.state == QEventPoint::Stationary;
+    }
+    // Nothing to tell, e.g. the frame we generate after the last touch_up
+    if (!changed)
+        return;
 
     QWindow *window = mFocus ? mFocus->window() : nullptr;
 
@@ -1548,7 +1667,12 @@ void QWaylandInputDevice::Touch::touch_frame()
             return;
     }
 
-    QWindowSystemInterface::handleTouchEvent(window, mParent->mTime, mParent->mTouchDevice, mPendingTouchPoints, mParent->modifiers());
+    if (motionOnly && window) {
+        deferFrame(window);
+    } else {
+        flushDeferredFrame();
+        QWindowSystemInterface::handleTouchEvent(window, mParent->mTime, mParent->mTouchDevice, mPendingTouchPoints, mParent->modifiers());
+    }
 
     // Prepare state for next frame
     const auto prevTouchPoints = mPendingTouchPoints;
@@ -1561,7 +1685,58 @@ void QWaylandInputDevice::Touch::touch_frame()
             mPendingTouchPoints.append(tp);
         }
     }
+}
 
+// When a client falls behind, it reads several frames at once. Pushing a QTouchEvent for
+// each of them only makes it fall further behind, so frames that only move points are merged
+// with the ones that were read together with them, and the application gets one event with
+// the full point set at their latest positions. QWaylandDisplay::flushRequests() delivers the
+// merged frame as soon as the events that were read have been dispatched, so a client that
+// keeps up gets every frame without delay. Any other input event delivers it first, to keep
+// the order the compositor sent them in.
+void QWaylandInputDevice::Touch::deferFrame(QWindow *window)
+{
+    if (mFrameDeferred && mDeferredWindow != window)
+        flushDeferredFrame();
+
+    if (mFrameDeferred) {
+        // Points that moved in the deferred frame still moved
+        for (auto &tp : mPendingTouchPoints) {
+            if (tp.state != QEventPoint::Stationary)
+                continue;
+            for (const auto &deferred : std::as_const(mDeferredTouchPoints)) {
+                if (deferred.id == tp.id) {
+                    tp.state = deferred.state;
+                    break;
+                }
+            }
+        }
+    } else {
+        // For events dispatched outside of flushRequests(), e.g. during a roundtrip
+        QWaylandInputDevice *device = mParent;
+        QMetaObject::invokeMethod(device, [device] {
+            if (device->mTouch)
+                device->mTouch->flushDeferredFrame();
+        }, Qt::QueuedConnection);
+    }
+
+    mFrameDeferred = true;
+    mDeferredWindow = window;
+    mDeferredTime = mParent->mTime;
+    mDeferredTouchPoints = mPendingTouchPoints;
+}
+
+void QWaylandInputDevice::Touch::flushDeferredFrame()
+{
+    if (!mFrameDeferred)
+        return;
+    mFrameDeferred = false;
+    if (mDeferredWindow) {
+        QWindowSystemInterface::handleTouchEvent(mDeferredWindow, mDeferredTime,
+                                                 mParent->mTouchDevice, mDeferredTouchPoints,
+                                                 mParent->modifiers());
+    }
+    mDeferredTouchPoints.clear();
 }
 
 }
@@ -101,6 +101,9 @@ public:
     void handleStartDrag();
     void handleEndDrag();
 
+    // Delivers the touch frame merged from the motion-only frames dispatched so far
+    void flushDeferredTouchFrame();
+
 #if QT_CONFIG(wayland_datadevice)
     void setDataDevice(QWaylandDataDevice *device);
     QWaylandDataDevice *dataDevice() const;
@@ -283,7 +286,10 @@ private Q_SLOTS:
 private:
 #if QT_CONFIG(xkbcommon)
     bool createDefaultKeymap();
+    void applyCompiledKeymap(const QByteArray &key);
 #endif
+    void handleEnter(QWaylandSurface *surface);
+    void handleLeave(QWaylandSurface *surface);
     void handleKey(ulong timestamp, QEvent::Type type, int key, Qt::KeyboardModifiers modifiers,
                    quint32 nativeScanCode, quint32 nativeVirtualKey, quint32 nativeModifiers,
                    const QString &text, bool autorepeat = false, ushort count = 1);
@@ -291,6 +297,28 @@ private:
 #if QT_CONFIG(xkbcommon)
     QXkbCommon::ScopedXKBKeymap mXkbKeymap;
     QXkbCommon::ScopedXKBState mXkbState;
+
+    // Focus, key and modifier events that arrive while the keymap is compiled, in their order
+    struct PendingEvent {
+        enum Type : quint8 {
+            Enter,
+            Leave,
+            Key,
+            Modifiers
+        } type;
+        uint32_t serial;
+        uint32_t time;
+        uint32_t key;
+        uint32_t state;
+        uint32_t modsDepressed;
+        uint32_t modsLatched;
+        uint32_t modsLocked;
+        uint32_t group;
+        QPointer<QWaylandSurface> surface;
+    };
+    QByteArray mKeymapKey;
+    bool mKeymapPending = false;
+    QList<PendingEvent> mPendingEvents;
 #endif
     friend class QWaylandInputDevice;
 };
@@ -412,12 +440,22 @@ public:
 
     bool allTouchPointsReleased();
     void releasePoints();
+    void flushDeferredFrame();
 
     struct ::wl_touch *wl_touch() { return QtWayland::wl_touch::object(); }
 
     QWaylandInputDevice *mParent = nullptr;
     QPointer<QWaylandWindow> mFocus;
     QList<QWindowSystemInterface::TouchPoint> mPendingTouchPoints;
+
+private:
+    void deferFrame(QWindow *window);
+
+    // A frame that only moved points, held until the events read with it are dispatched
+    bool mFrameDeferred = false;
+    QPointer<QWindow> mDeferredWindow;
+    ulong mDeferredTime = 0;
+    QList<QWindowSystemInterface::TouchPoint> mDeferredTouchPoints;
 };
 
 class QWaylandPointerEvent
@@ -0,0 +1,101 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qwaylandkeymapcache_p.h"
+#include "qwaylanddisplay_p.h"
+
+#include <QtCore/QCryptographicHash>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWaylandClient {
+
+// Compositors rarely send more than one or two different keymaps, this only bounds
+// the memory held by one that keeps changing it
+static constexpr qsizetype maxCachedKeymaps = 8;
+
+QWaylandKeymapCache::QWaylandKeymapCache(QObject *parent)
+    : QObject(parent)
+{
+    // Keymaps arrive one at a time, there is nothing to gain from compiling them in parallel
+    m_workers.setMaxThreadCount(1);
+    m_workers.setObjectName(QStringLiteral("QWaylandKeymapCache"));
+}
+
+QWaylandKeymapCache::~QWaylandKeymapCache()
+{
+    // The jobs post their results to this object
+    m_workers.waitForDone();
+}
+
+QByteArray QWaylandKeymapCache::keyFor(QByteArrayView text)
+{
+    return QCryptographicHash::hash(text, QCryptographicHash::Sha256);
+}
+
+void QWaylandKeymapCache::compile(const QByteArray &key, const QByteArray &text)
+{
+    if (m_entries.contains(key))
+        return;
+
+    m_entries.insert(key, Entry());
+    m_order.append(key);
+
+    m_workers.start([this, key, text] {
+        // xkb_context is not thread-safe, so each job compiles in a context of its own, which
+        // the keymap keeps alive. Nothing else refers to it once the keymap is handed over.
+        struct xkb_keymap *keymap = nullptr;
+        if (struct xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_FLAGS)) {
+            keymap = xkb_keymap_new_from_string(context, text.constData(),
+                                                XKB_KEYMAP_FORMAT_TEXT_V1,
+                                                XKB_KEYMAP_COMPILE_NO_FLAGS);
+            xkb_context_unref(context);
+        }
+        if (keymap)
+            QXkbCommon::verifyHasLatinLayout(keymap);
+
+        QMetaObject::invokeMethod(this, [this, key, keymap] {
+            finishCompile(key, keymap);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void QWaylandKeymapCache::finishCompile(const QByteArray &key, struct xkb_keymap *keymap)
+{
+    Entry &entry = m_entries[key];
+    entry.keymap.reset(keymap);
+    entry.compiling = false;
+    if (!keymap)
+        qCWarning(lcQpaWayland, "failed to compile keymap");
+
+    for (auto it = m_order.begin(); m_order.size() > maxCachedKeymaps && it != m_order.end();) {
+        if (*it != key && !m_entries.value(*it).compiling) {
+            m_entries.remove(*it);
+            it = m_order.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    emit compiled(key);
+}
+
+bool QWaylandKeymapCache::isCompiling(const QByteArray &key) const
+{
+    const auto it = m_entries.constFind(key);
+    return it != m_entries.constEnd() && it->compiling;
+}
+
+QXkbCommon::ScopedXKBKeymap QWaylandKeymapCache::keymap(const QByteArray &key) const
+{
+    const auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd() || !it->keymap)
+        return nullptr;
+    return QXkbCommon::ScopedXKBKeymap(xkb_keymap_ref(it->keymap.get()));
+}
+
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qwaylandkeymapcache_p.cpp"
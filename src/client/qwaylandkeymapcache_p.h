@@ -0,0 +1,67 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QWAYLANDKEYMAPCACHE_P_H
+#define QWAYLANDKEYMAPCACHE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandClient/qtwaylandclientglobal.h>
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QThreadPool>
+#include <QtGui/private/qxkbcommon_p.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWaylandClient {
+
+// Compiles the keymaps sent with wl_keyboard.keymap on a worker thread and keeps them by the
+// hash of their text. It is owned by the display, so seats sharing a keymap and reconnects
+// to the same compositor don't compile it again.
+class Q_WAYLANDCLIENT_EXPORT QWaylandKeymapCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QWaylandKeymapCache(QObject *parent = nullptr);
+    ~QWaylandKeymapCache() override;
+
+    static QByteArray keyFor(QByteArrayView text);
+
+    // Starts compiling text unless the keymap for key is already compiled or being compiled
+    void compile(const QByteArray &key, const QByteArray &text);
+    bool isCompiling(const QByteArray &key) const;
+    // A new reference to the keymap, or nullptr if it is still compiling or failed to compile
+    QXkbCommon::ScopedXKBKeymap keymap(const QByteArray &key) const;
+
+Q_SIGNALS:
+    void compiled(const QByteArray &key);
+
+private:
+    void finishCompile(const QByteArray &key, struct xkb_keymap *keymap);
+
+    struct Entry {
+        QXkbCommon::ScopedXKBKeymap keymap;
+        bool compiling = true;
+    };
+    QHash<QByteArray, Entry> m_entries;
+    QList<QByteArray> m_order;
+    QThreadPool m_workers;
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDKEYMAPCACHE_P_H
@@ -15,6 +15,7 @@
 #include <QtGui/private/qguiapplication_p.h>
 #include <QtGui/QScreen>
 #include <QtWaylandClient/private/qwaylandclientbufferintegration_p.h>
+#include <QtWaylandClient/private/qwayland-linux-explicit-synchronization-unstable-v1.h>
 #if QT_CONFIG(vulkan)
 #include <QtWaylandClient/private/qwaylandvulkanwindow_p.h>
 #endif
@@ -40,6 +41,13 @@ void *QWaylandNativeInterface::nativeResourceForIntegration(const QByteArray &re
     }
     if (lowerCaseResource == "server_buffer_integration")
         return m_integration->serverBufferIntegration();
+    // For clients attaching dmabufs they render themselves, e.g. to a subsurface for video.
+    // EGL windows attach their buffers in eglSwapBuffers and leave this to the EGL implementation.
+    if (lowerCaseResource == "zwp_linux_explicit_synchronization_v1") {
+        if (auto *explicitSynchronization = m_integration->display()->explicitSynchronization())
+            return explicitSynchronization->object();
+        return nullptr;
+    }
 
     if (lowerCaseResource == "egldisplay" && m_integration->clientBufferIntegration())
         return m_integration->clientBufferIntegration()->nativeResource(QWaylandClientBufferIntegration::EglDisplay);
@@ -0,0 +1,135 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qwaylandpresentationtime_p.h"
+#include "qwaylandwindow_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWaylandClient {
+
+QWaylandPresentation::QWaylandPresentation(struct ::wl_registry *registry, uint32_t id, int version)
+    : QtWayland::wp_presentation(registry, id, version)
+{
+}
+
+QWaylandPresentation::~QWaylandPresentation()
+{
+    destroy();
+}
+
+qint64 QWaylandPresentation::currentTime() const
+{
+    timespec ts;
+    if (clock_gettime(mClockId.load(std::memory_order_relaxed), &ts) != 0)
+        return 0;
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Must be called before the wl_surface.commit the feedback is meant for
+void QWaylandPresentation::requestFeedback(QWaylandWindow *window, struct ::wl_surface *surface)
+{
+    new QWaylandPresentationFeedback(window, feedback(surface));
+}
+
+void QWaylandPresentation::wp_presentation_clock_id(uint32_t clk_id)
+{
+    mClockId.store(clockid_t(clk_id), std::memory_order_relaxed);
+}
+
+QWaylandPresentationFeedback::QWaylandPresentationFeedback(QWaylandWindow *window,
+                                                           struct ::wp_presentation_feedback *object)
+    : QtWayland::wp_presentation_feedback(object)
+    , mWindow(window)
+{
+}
+
+QWaylandPresentationFeedback::~QWaylandPresentationFeedback()
+{
+    // The object is destroyed by the compositor after presented or discarded
+    wp_presentation_feedback_destroy(object());
+}
+
+void QWaylandPresentationFeedback::wp_presentation_feedback_presented(
+        uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec, uint32_t refresh,
+        uint32_t seq_hi, uint32_t seq_lo, uint32_t flags)
+{
+    Q_UNUSED(flags);
+    if (mWindow) {
+        const quint64 seconds = (quint64(tv_sec_hi) << 32) | tv_sec_lo;
+        const quint64 sequence = (quint64(seq_hi) << 32) | seq_lo;
+        mWindow->handlePresented(qint64(seconds) * 1000000000 + tv_nsec, refresh, sequence);
+    }
+    delete this;
+}
+
+void QWaylandPresentationFeedback::wp_presentation_feedback_discarded()
+{
+    delete this;
+}
+
+void QWaylandPresentationTiming::presented(qint64 timestamp, qint64 refresh, quint64 sequence)
+{
+    const qint64 last = mLastPresentation.load(std::memory_order_relaxed);
+    const qint64 delta = timestamp - last;
+    // Ignore gaps where nothing was presented for a while, they say nothing about the
+    // rate the output can present at.
+    if (last && delta > 0 && delta < 250000000) {
+        qint64 interval = delta;
+        if (sequence && mLastSequence && sequence > mLastSequence)
+            interval = delta / qint64(sequence - mLastSequence);
+        const qint64 measured = mMeasuredInterval.load(std::memory_order_relaxed);
+        mMeasuredInterval.store(measured ? (measured * 7 + interval) / 8 : interval,
+                                std::memory_order_relaxed);
+    }
+
+    mLastSequence = sequence;
+    mRefresh.store(refresh, std::memory_order_relaxed);
+    mLastPresentation.store(timestamp, std::memory_order_release);
+}
+
+void QWaylandPresentationTiming::rendered(qint64 duration)
+{
+    if (duration <= 0)
+        return;
+    // React quickly to frames getting slower, slowly to them getting faster
+    const qint64 renderTime = mRenderTime.load(std::memory_order_relaxed);
+    mRenderTime.store(duration > renderTime ? duration : (renderTime * 7 + duration) / 8,
+                      std::memory_order_relaxed);
+}
+
+qint64 QWaylandPresentationTiming::refreshInterval() const
+{
+    const qint64 refresh = mRefresh.load(std::memory_order_relaxed);
+    return refresh > 0 ? refresh : mMeasuredInterval.load(std::memory_order_relaxed);
+}
+
+qint64 QWaylandPresentationTiming::predictNextPresentationTime(qint64 now) const
+{
+    const qint64 last = lastPresentationTime();
+    const qint64 interval = refreshInterval();
+    if (!last || interval <= 0)
+        return 0;
+
+    if (now <= last)
+        return last + interval;
+    return last + ((now - last) / interval + 1) * interval;
+}
+
+// How long to hold back an update request so that the frame is committed just in time to
+// be presented at the next refresh, leaving the compositor half of the interval to compose
+// it. 0 when the update should be delivered right away.
+qint64 QWaylandPresentationTiming::updateDelay(qint64 now) const
+{
+    const qint64 next = predictNextPresentationTime(now);
+    if (!next)
+        return 0;
+
+    const qint64 interval = refreshInterval();
+    const qint64 start = next - interval / 2 - mRenderTime.load(std::memory_order_relaxed);
+    return qBound<qint64>(0, start - now, interval);
+}
+
+}
+
+QT_END_NAMESPACE
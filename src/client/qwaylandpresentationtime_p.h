@@ -0,0 +1,100 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QWAYLANDPRESENTATIONTIME_P_H
+#define QWAYLANDPRESENTATIONTIME_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandClient/private/qwayland-presentation-time.h>
+#include <QtWaylandClient/qtwaylandclientglobal.h>
+
+#include <QtCore/QPointer>
+
+#include <atomic>
+
+#include <time.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWaylandClient {
+
+class QWaylandWindow;
+
+class QWaylandPresentation : public QtWayland::wp_presentation
+{
+public:
+    QWaylandPresentation(struct ::wl_registry *registry, uint32_t id, int version);
+    ~QWaylandPresentation() override;
+
+    // The clock the presentation timestamps are in, CLOCK_MONOTONIC until told otherwise
+    clockid_t clockId() const { return mClockId; }
+    qint64 currentTime() const;
+
+    void requestFeedback(QWaylandWindow *window, struct ::wl_surface *surface);
+
+protected:
+    void wp_presentation_clock_id(uint32_t clk_id) override;
+
+private:
+    std::atomic<clockid_t> mClockId = CLOCK_MONOTONIC;
+};
+
+class QWaylandPresentationFeedback : public QtWayland::wp_presentation_feedback
+{
+public:
+    QWaylandPresentationFeedback(QWaylandWindow *window, struct ::wp_presentation_feedback *object);
+    ~QWaylandPresentationFeedback() override;
+
+protected:
+    void wp_presentation_feedback_presented(uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                            uint32_t tv_nsec, uint32_t refresh, uint32_t seq_hi,
+                                            uint32_t seq_lo, uint32_t flags) override;
+    void wp_presentation_feedback_discarded() override;
+
+private:
+    QPointer<QWaylandWindow> mWindow;
+};
+
+/*
+ * Presentation statistics for a window, fed by wp_presentation_feedback and by the time
+ * the window takes to render a frame, which may be measured on a render thread. Used to
+ * deliver update requests just in time for the next presentation. All times are in
+ * nanoseconds in the presentation clock.
+ */
+class QWaylandPresentationTiming
+{
+public:
+    void presented(qint64 timestamp, qint64 refresh, quint64 sequence);
+    void rendered(qint64 duration);
+
+    qint64 lastPresentationTime() const { return mLastPresentation.load(std::memory_order_acquire); }
+    qint64 refreshInterval() const;
+    qint64 predictNextPresentationTime(qint64 now) const;
+    qint64 updateDelay(qint64 now) const;
+
+private:
+    std::atomic<qint64> mLastPresentation = 0;
+    std::atomic<qint64> mRefresh = 0;
+    // Smoothed interval between consecutive presentations, used when the output has no
+    // constant refresh rate (refresh == 0 in the presented event), e.g. variable refresh
+    std::atomic<qint64> mMeasuredInterval = 0;
+    // Smoothed time from delivering an update request to committing the frame
+    std::atomic<qint64> mRenderTime = 0;
+    quint64 mLastSequence = 0;
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDPRESENTATIONTIME_P_H
@@ -39,14 +39,29 @@ QWaylandScreen::QWaylandScreen(QWaylandDisplay *waylandDisplay, int version, uin
     if (version < WL_OUTPUT_DONE_SINCE_VERSION) {
         qCWarning(lcQpaWayland) << "wl_output done event not supported by compositor,"
                                 << "QScreen may not work correctly";
-        mWaylandDisplay->forceRoundTrip(); // Give the compositor a chance to send geometry etc.
-        mProcessedEvents |= OutputDoneEvent; // Fake the done event
-        maybeInitialize();
+        // Give the compositor a chance to send geometry etc. before faking the done event.
+        // This is answered together with the other initial events, without a round trip of its own.
+        mOutputSyncCallback = wl_display_sync(waylandDisplay->wl_display());
+        wl_callback_add_listener(mOutputSyncCallback, &outputSyncCallbackListener, this);
     }
 }
 
+const wl_callback_listener QWaylandScreen::outputSyncCallbackListener = {
+    [](void *data, struct wl_callback *callback, uint32_t time) {
+        Q_UNUSED(time);
+        wl_callback_destroy(callback);
+        QWaylandScreen *screen = static_cast<QWaylandScreen *>(data);
+        screen->mOutputSyncCallback = nullptr;
+        screen->mProcessedEvents |= OutputDoneEvent; // Fake the done event
+        if (!screen->mInitialized)
+            screen->maybeInitialize();
+    }
+};
+
 QWaylandScreen::~QWaylandScreen()
 {
+    if (mOutputSyncCallback)
+        wl_callback_destroy(mOutputSyncCallback);
     if (zxdg_output_v1::isInitialized())
         zxdg_output_v1::destroy();
     if (wl_output::version() >= WL_OUTPUT_RELEASE_SINCE_VERSION)
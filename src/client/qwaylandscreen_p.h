@@ -131,6 +131,9 @@ protected:
     Qt::ScreenOrientation m_orientation = Qt::PrimaryOrientation;
     uint mProcessedEvents = 0;
     bool mInitialized = false;
+
+    struct wl_callback *mOutputSyncCallback = nullptr;
+    static const wl_callback_listener outputSyncCallbackListener;
 };
 
 }
@@ -6,6 +6,8 @@
 #include "qwaylanddisplay_p.h"
 #include "qwaylandscreen_p.h"
 #include "qwaylandabstractdecoration_p.h"
+#include "qwaylandeventthread_p.h"
+#include "qwaylandlatencytrace_p.h"
 
 #include <QtCore/qdebug.h>
 #include <QtCore/qstandardpaths.h>
@@ -47,6 +49,56 @@ QT_BEGIN_NAMESPACE
 
 namespace QtWaylandClient {
 
+void copyImageRegion(QImage *target, const QImage &source, const QRegion &region, const QPoint &sourceOffset)
+{
+    const qreal dpr = target->devicePixelRatio();
+    if (source.format() != target->format() || source.devicePixelRatio() != dpr
+        || source.depth() % 8 != 0 || dpr != qRound(dpr)) {
+        QPainter painter(target);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        const qreal sourceDpr = source.devicePixelRatio();
+        for (const QRect &rect : region) {
+            const QRectF sourceRect(QPointF(rect.topLeft() + sourceOffset) * sourceDpr,
+                                    QSizeF(rect.size()) * sourceDpr);
+            painter.drawImage(rect, source, sourceRect);
+        }
+        return;
+    }
+
+    // Going through the raster paint engine costs far more than the copy itself
+    const int scale = qRound(dpr);
+    const int bytesPerPixel = source.depth() / 8;
+    const QRect targetBounds = target->rect();
+    const QRect sourceBounds = source.rect();
+    const qsizetype targetStride = target->bytesPerLine();
+    const qsizetype sourceStride = source.bytesPerLine();
+    uchar *targetBits = target->bits();
+    const uchar *sourceBits = source.constBits();
+
+    for (const QRect &rect : region) {
+        QRect targetRect(rect.topLeft() * scale, rect.size() * scale);
+        targetRect &= targetBounds;
+        targetRect &= sourceBounds.translated(-sourceOffset * scale);
+        if (targetRect.isEmpty())
+            continue;
+        const QPoint sourcePos = targetRect.topLeft() + sourceOffset * scale;
+
+        const qsizetype rowBytes = qsizetype(targetRect.width()) * bytesPerPixel;
+        uchar *dst = targetBits + targetRect.y() * targetStride + targetRect.x() * bytesPerPixel;
+        const uchar *src = sourceBits + sourcePos.y() * sourceStride + sourcePos.x() * bytesPerPixel;
+        if (targetRect.width() == target->width() && targetStride == sourceStride
+            && rowBytes == targetStride) {
+            memcpy(dst, src, rowBytes * targetRect.height());
+            continue;
+        }
+        for (int row = 0; row < targetRect.height(); ++row) {
+            memcpy(dst, src, rowBytes);
+            dst += targetStride;
+            src += sourceStride;
+        }
+    }
+}
+
 QWaylandShmBuffer::QWaylandShmBuffer(QWaylandDisplay *display,
                      const QSize &size, QImage::Format format, qreal scale)
     : mDirtyRegion(QRect(QPoint(0, 0), size / scale))
@@ -149,6 +201,7 @@ QWaylandShmBackingStore::QWaylandShmBackingStore(QWindow *window, QWaylandDispla
         // contents from the back buffer
         mBuffers.clear();
         mFrontBuffer = nullptr;
+        deleteChildBuffers();
         // recreateBackBufferIfNeeded always resets mBackBuffer
         if (mRequestedSize.isValid() && waylandWindow())
             recreateBackBufferIfNeeded();
@@ -165,6 +218,7 @@ QWaylandShmBackingStore::~QWaylandShmBackingStore()
 //        waylandWindow()->attach(0);
 
     qDeleteAll(mBuffers);
+    deleteChildBuffers();
 }
 
 QPaintDevice *QWaylandShmBackingStore::paintDevice()
@@ -185,6 +239,7 @@ void QWaylandShmBackingStore::updateDirtyStates(const QRegion &region)
 void QWaylandShmBackingStore::beginPaint(const QRegion &region)
 {
     mPainting = true;
+    mPaintTraceStart = QWaylandLatencyTrace::isEnabled() ? QWaylandLatencyTrace::now() : 0;
     waylandWindow()->setBackingStore(this);
     const bool bufferWasRecreated = recreateBackBufferIfNeeded();
 
@@ -206,6 +261,8 @@ void QWaylandShmBackingStore::beginPaint(const QRegion &region)
 void QWaylandShmBackingStore::endPaint()
 {
     mPainting = false;
+    if (mPaintTraceStart)
+        QWaylandLatencyTrace::slice("paint", mPaintTraceStart, QWaylandLatencyTrace::now());
     if (mPendingFlush)
         flush(window(), mPendingRegion, QPoint());
 }
@@ -220,13 +277,7 @@ void QWaylandShmBackingStore::flush(QWindow *window, const QRegion &region, cons
     // called instead. The default implementation from QPlatformBackingStore is sufficient
     // however so no need to reimplement that.
     if (window != this->window()) {
-        auto waylandWindow = static_cast<QWaylandWindow *>(window->handle());
-        auto newBuffer = new QWaylandShmBuffer(mDisplay, window->size(), mBackBuffer->image()->format(), mBackBuffer->scale());
-        newBuffer->setDeleteOnRelease(true);
-        QRect sourceRect(window->position(), window->size());
-        QPainter painter(newBuffer->image());
-        painter.drawImage(QPoint(0, 0), *mBackBuffer->image(), sourceRect);
-        waylandWindow->safeCommit(newBuffer, region);
+        flushChildWindow(window, region);
         return;
     }
 
@@ -248,6 +299,78 @@ void QWaylandShmBackingStore::flush(QWindow *window, const QRegion &region, cons
     waylandWindow()->safeCommit(mFrontBuffer, region.translated(margins.left(), margins.top()));
 }
 
+/*
+    Native child windows have no backing store of their own, their content is in the one of
+    their top-level window. Each child gets a few buffers of its own that are reused, and like
+    those of the top-level, every buffer tracks what it misses of the latest content, so only
+    that is copied into it.
+*/
+void QWaylandShmBackingStore::flushChildWindow(QWindow *window, const QRegion &region)
+{
+    static const int MAX_CHILD_BUFFERS = 3;
+
+    auto waylandWindow = static_cast<QWaylandWindow *>(window->handle());
+    const QImage *sourceImage = contentSurface();
+    const int scale = mBackBuffer->scale();
+    const QSize size = window->size() * scale;
+    const QImage::Format format = sourceImage->format();
+
+    for (auto i = mChildBuffers.size() - 1; i >= 0; --i) {
+        if (!mChildBuffers[i].window)
+            qDeleteAll(mChildBuffers.takeAt(i).buffers);
+    }
+    QList<QWaylandShmBuffer *> *childBuffers = nullptr;
+    for (ChildWindowBuffers &child : mChildBuffers) {
+        if (child.window == window)
+            childBuffers = &child.buffers;
+    }
+    if (!childBuffers)
+        childBuffers = &mChildBuffers.emplaceBack(ChildWindowBuffers{ window, {} }).buffers;
+    QList<QWaylandShmBuffer *> &buffers = *childBuffers;
+
+    for (auto i = buffers.size() - 1; i >= 0; --i) {
+        QWaylandShmBuffer *buffer = buffers[i];
+        if (buffer->size() != size || buffer->scale() != scale || buffer->image()->format() != format)
+            delete buffers.takeAt(i);
+    }
+
+    QWaylandShmBuffer *buffer = nullptr;
+    for (QWaylandShmBuffer *candidate : std::as_const(buffers)) {
+        if (!candidate->busy()) {
+            buffer = candidate;
+            break;
+        }
+    }
+    if (!buffer) {
+        buffer = new QWaylandShmBuffer(mDisplay, size, format, scale);
+        if (buffers.size() < MAX_CHILD_BUFFERS) {
+            buffers.append(buffer);
+        } else {
+            // The compositor holds on to all of them, don't grow the pool any further
+            buffer->setDeleteOnRelease(true);
+        }
+    }
+
+    const QRect windowRect(QPoint(), window->size());
+    const QRegion copyRegion = (buffer->dirtyRegion() + region) & windowRect;
+    for (QWaylandShmBuffer *other : std::as_const(buffers)) {
+        if (other != buffer)
+            other->dirtyRegion() += region & windowRect;
+    }
+    buffer->dirtyRegion() = QRegion();
+
+    copyImageRegion(buffer->image(), *sourceImage, copyRegion, window->position());
+
+    waylandWindow->safeCommit(buffer, region);
+}
+
+void QWaylandShmBackingStore::deleteChildBuffers()
+{
+    for (const ChildWindowBuffers &child : std::as_const(mChildBuffers))
+        qDeleteAll(child.buffers);
+    mChildBuffers.clear();
+}
+
 void QWaylandShmBackingStore::resize(const QSize &size, const QRegion &)
 {
     mRequestedSize = size;
@@ -307,11 +430,21 @@ bool QWaylandShmBackingStore::recreateBackBufferIfNeeded()
     // You can exercise the different codepaths with weston, switching between the gl and the
     // pixman renderer. With the gl renderer release events are sent early so we can effectively
     // run single buffered, while with the pixman renderer we have to use two.
+    // With a per-window event queue the releases are dispatched by the queue's thread, so wait
+    // for it rather than for the default queue, which may never see another event.
+    const auto eventQueue = waylandWindow()->eventQueue();
+    quint64 dispatchCount = eventQueue ? eventQueue->dispatchCount() : 0;
     QWaylandShmBuffer *buffer = getBuffer(sizeWithMargins, bufferWasRecreated);
     while (!buffer) {
         qCDebug(lcWaylandBackingstore, "QWaylandShmBackingStore: stalling waiting for a buffer to be released from the compositor...");
 
-        mDisplay->blockingReadEvents();
+        if (eventQueue) {
+            wl_display_flush(mDisplay->wl_display());
+            eventQueue->waitForDispatch(dispatchCount);
+            dispatchCount = eventQueue->dispatchCount();
+        } else {
+            mDisplay->blockingReadEvents();
+        }
         buffer = getBuffer(sizeWithMargins, bufferWasRecreated);
     }
 
@@ -321,18 +454,7 @@ bool QWaylandShmBackingStore::recreateBackBufferIfNeeded()
     // mBackBuffer may have been deleted here but if so it means its size was different so we wouldn't copy it anyway
     if (mBackBuffer != buffer && oldSizeInBytes == newSizeInBytes) {
         Q_ASSERT(mBackBuffer);
-        const QImage *sourceImage = mBackBuffer->image();
-        QImage *targetImage = buffer->image();
-
-        QPainter painter(targetImage);
-        painter.setCompositionMode(QPainter::CompositionMode_Source);
-
-        const qreal sourceDevicePixelRatio = sourceImage->devicePixelRatio();
-        for (const QRect &rect : buffer->dirtyRegion()) {
-            QRectF sourceRect(QPointF(rect.topLeft()) * sourceDevicePixelRatio,
-                              QSizeF(rect.size()) * sourceDevicePixelRatio);
-            painter.drawImage(rect, *sourceImage, sourceRect);
-        }
+        copyImageRegion(buffer->image(), *mBackBuffer->image(), buffer->dirtyRegion());
     }
 
     mBackBuffer = buffer;
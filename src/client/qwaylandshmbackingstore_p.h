@@ -21,6 +21,7 @@
 #include <QtGui/QImage>
 #include <qpa/qplatformwindow.h>
 #include <QMutex>
+#include <QtCore/QPointer>
 
 QT_BEGIN_NAMESPACE
 
@@ -30,6 +31,12 @@ class QWaylandDisplay;
 class QWaylandAbstractDecoration;
 class QWaylandWindow;
 
+// Copies region, in device independent pixels of target, from source at sourceOffset into
+// target. Images of the same format and device pixel ratio are copied row by row, anything
+// else is converted by QPainter.
+Q_WAYLANDCLIENT_EXPORT void copyImageRegion(QImage *target, const QImage &source, const QRegion &region,
+                                            const QPoint &sourceOffset = QPoint());
+
 class Q_WAYLANDCLIENT_EXPORT QWaylandShmBuffer : public QWaylandBuffer {
 public:
     QWaylandShmBuffer(QWaylandDisplay *display,
@@ -85,12 +92,21 @@ private:
     void updateDirtyStates(const QRegion &region);
     void updateDecorations();
     QWaylandShmBuffer *getBuffer(const QSize &size, bool &bufferWasRecreated);
+    void flushChildWindow(QWindow *window, const QRegion &region);
+    void deleteChildBuffers();
 
     QWaylandDisplay *mDisplay = nullptr;
     QList<QWaylandShmBuffer *> mBuffers;
     QWaylandShmBuffer *mFrontBuffer = nullptr;
     QWaylandShmBuffer *mBackBuffer = nullptr;
+    // Buffers of native child windows, which are flushed from the content of this one
+    struct ChildWindowBuffers {
+        QPointer<QWindow> window;
+        QList<QWaylandShmBuffer *> buffers;
+    };
+    QList<ChildWindowBuffers> mChildBuffers;
     bool mPainting = false;
+    qint64 mPaintTraceStart = 0;
     bool mPendingFlush = false;
     QRegion mPendingRegion;
     QMutex mMutex;
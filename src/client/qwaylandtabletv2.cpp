@@ -15,8 +15,6 @@
 #include <QtGui/qpa/qplatformtheme.h>
 #include <QtGui/qpa/qwindowsysteminterface_p.h>
 
-#include <wayland-cursor.h>
-
 QT_BEGIN_NAMESPACE
 
 namespace QtWaylandClient {
@@ -61,9 +59,8 @@ void QWaylandTabletToolV2::updateCursorTheme()
     if (!mCursor.theme)
         return; // A warning has already been printed in loadCursorTheme
 
-    if (auto *arrow = mCursor.theme->cursor(Qt::ArrowCursor)) {
-        int arrowPixelSize = qMax(arrow->images[0]->width,
-                                  arrow->images[0]->height); // Not all cursor themes are square
+    if (const auto *arrow = mCursor.theme->image(Qt::ArrowCursor)) {
+        int arrowPixelSize = qMax(arrow->size.width(), arrow->size.height()); // Not all cursor themes are square
         while (scale > 1 && arrowPixelSize / scale < cursorSize.width())
             --scale;
     } else {
@@ -115,19 +112,16 @@ void QWaylandTabletToolV2::updateCursor()
     // Set from shape using theme
     uint time = m_tabletSeat->seat()->mCursor.animationTimer.elapsed();
 
-    if (struct ::wl_cursor *waylandCursor = mCursor.theme->cursor(shape)) {
-        uint duration = 0;
-        int frame = wl_cursor_frame_and_duration(waylandCursor, time, &duration);
-        ::wl_cursor_image *image = waylandCursor->images[frame];
-
-        struct wl_buffer *buffer = wl_cursor_image_get_buffer(image);
+    uint duration = 0;
+    if (const auto *image = mCursor.theme->image(shape, time, &duration)) {
+        struct wl_buffer *buffer = image->buffer;
         if (!buffer) {
             qCWarning(lcQpaWayland) << "Could not find buffer for cursor" << shape;
             return;
         }
         int bufferScale = mCursor.themeBufferScale;
-        QPoint hotspot = QPoint(image->hotspot_x, image->hotspot_y) / bufferScale;
-        QSize size = QSize(image->width, image->height) / bufferScale;
+        QPoint hotspot = image->hotspot / bufferScale;
+        QSize size = image->size / bufferScale;
         bool animated = duration > 0;
         if (animated) {
             mCursor.gotFrameCallback = false;
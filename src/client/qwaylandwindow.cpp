@@ -20,6 +20,9 @@
 #include "qwaylandshellintegration_p.h"
 #include "qwaylandviewport_p.h"
 #include "qwaylandcolormanagement_p.h"
+#include "qwaylandeventthread_p.h"
+#include "qwaylandpresentationtime_p.h"
+#include "qwaylandlatencytrace_p.h"
 
 #include <QtCore/QFileInfo>
 #include <QtCore/QPointer>
@@ -34,6 +37,11 @@
 #include <QtCore/QDebug>
 #include <QtCore/QThread>
 #include <QtCore/private/qthread_p.h>
+#include <QtCore/private/qcore_unix_p.h>
+
+#ifdef Q_OS_LINUX
+#include <sys/eventfd.h>
+#endif
 
 #include <QtWaylandClient/private/qwayland-fractional-scale-v1.h>
 
@@ -45,6 +53,16 @@ namespace QtWaylandClient {
 
 Q_LOGGING_CATEGORY(lcWaylandBackingstore, "qt.qpa.wayland.backingstore")
 
+// With QT_WAYLAND_FRAME_PACING=1, update requests are held back to be delivered just in time
+// for the next presentation, when the compositor supports wp_presentation. This is opt-in,
+// as it delays rendering for applications that rely on getting updates right after the
+// frame callback, and depends on the compositor reporting presentation times accurately.
+static QWaylandPresentation *framePacingPresentation(QWaylandDisplay *display)
+{
+    static const bool enabled = qEnvironmentVariableIntValue("QT_WAYLAND_FRAME_PACING") > 0;
+    return enabled ? display->presentation() : nullptr;
+}
+
 QWaylandWindow *QWaylandWindow::mMouseGrab = nullptr;
 QWaylandWindow *QWaylandWindow::mTopPopup = nullptr;
 
@@ -53,6 +71,7 @@ QWaylandWindow::QWaylandWindow(QWindow *window, QWaylandDisplay *display)
     , mDisplay(display)
     , mSurfaceLock(QReadWriteLock::Recursive)
     , mShellIntegration(display->shellIntegration())
+    , mPresentationTiming(std::make_unique<QWaylandPresentationTiming>())
 {
     {
         bool ok;
@@ -61,6 +80,19 @@ QWaylandWindow::QWaylandWindow(QWindow *window, QWaylandDisplay *display)
             mFrameCallbackTimeout = frameCallbackTimeout;
     }
 
+#ifdef Q_OS_LINUX
+    mFrameReadyFd = mFrameReadyWriteFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#else
+    int pipefd[2];
+    if (qt_safe_pipe(pipefd, O_NONBLOCK) == 0) {
+        mFrameReadyFd = pipefd[0];
+        mFrameReadyWriteFd = pipefd[1];
+    }
+#endif
+    if (mFrameReadyFd == -1)
+        qCWarning(lcQpaWayland) << "Failed to create frame ready notifier, waiting for frame callbacks will spin";
+    signalFrameReady(); // no frame callback pending yet
+
     initializeWlSurface();
 
     setWindowIcon(window->icon());
@@ -86,6 +118,11 @@ QWaylandWindow::~QWaylandWindow()
     if (mMouseGrab == this) {
         mMouseGrab = nullptr;
     }
+
+    if (mFrameReadyWriteFd != mFrameReadyFd)
+        qt_safe_close(mFrameReadyWriteFd);
+    if (mFrameReadyFd != -1)
+        qt_safe_close(mFrameReadyFd);
 }
 
 void QWaylandWindow::ensureSize()
@@ -232,6 +269,12 @@ void QWaylandWindow::initializeWlSurface()
         connect(mSurface.data(), &QWaylandSurface::preferredBufferTransformChanged,
                 this, &QWaylandWindow::updateBufferTransform);
         mSurface->m_window = this;
+
+        // Frame callbacks and buffer releases for this window get their own queue and
+        // dispatch thread. Configure and input events stay on the default queue, so their
+        // relative ordering is unaffected.
+        if (!mEventQueue && mDisplay->usesPerWindowEventQueues())
+            mEventQueue = std::make_shared<QWaylandEventQueue>(mDisplay->wl_display());
     }
     emit wlSurfaceCreated();
 
@@ -313,11 +356,38 @@ void QWaylandWindow::endFrame()
     mInFrameRender = false;
 }
 
+void QWaylandWindow::traceInputDispatched(quint64 flow)
+{
+    if (!QWaylandLatencyTrace::isEnabled())
+        return;
+    QMutexLocker locker(&mTraceMutex);
+    // Bounded in case the window never gets the events, e.g. while it's hidden
+    if (mDispatchedInputFlows.size() >= 64)
+        mDispatchedInputFlows.removeFirst();
+    mDispatchedInputFlows.append(flow);
+}
+
+qint64 QWaylandWindow::latencyTraceStart() const
+{
+    return QWaylandLatencyTrace::isEnabled() ? QWaylandLatencyTrace::now() : 0;
+}
+
+void QWaylandWindow::traceCommitted(const char *name, qint64 start)
+{
+    if (!start)
+        return;
+    QMutexLocker locker(&mTraceMutex);
+    QWaylandLatencyTrace::slice(name, start, QWaylandLatencyTrace::now(),
+                                QWaylandLatencyTrace::FlowStep, mDeliveredInputFlows);
+    mDeliveredInputFlows.clear();
+}
+
 void QWaylandWindow::reset()
 {
     resetSurfaceRole();
 
     if (mSurface) {
+        std::shared_ptr<QWaylandEventQueue> eventQueue;
         {
             QWriteLocker lock(&mSurfaceLock);
             invalidateSurface();
@@ -326,7 +396,10 @@ void QWaylandWindow::reset()
             mFractionalScale.reset();
             mColorManagementSurface.reset();
             mPendingImageDescription.reset();
+            eventQueue = std::exchange(mEventQueue, nullptr);
         }
+        // Stops the queue's thread unless buffers still reference it, don't hold the lock for that
+        eventQueue.reset();
         emit wlSurfaceDestroyed();
     }
 
@@ -354,19 +427,19 @@ void QWaylandWindow::resetSurfaceRole()
     delete std::exchange(mShellSurface, nullptr);
     delete std::exchange(mSubSurfaceWindow, nullptr);
     emit surfaceRoleDestroyed();
-    {
-        QMutexLocker lock(&mFrameSyncMutex);
-        if (mFrameCallback) {
-            wl_callback_destroy(mFrameCallback);
-            mFrameCallback = nullptr;
-        }
-        mFrameCallbackElapsedTimer.invalidate();
-        mWaitingForFrameCallback = false;
-    }
-    if (mFrameCallbackCheckIntervalTimerId != -1) {
-        killTimer(mFrameCallbackCheckIntervalTimerId);
-        mFrameCallbackCheckIntervalTimerId = -1;
-    }
+    // A callback being dispatched concurrently loses the exchange in handleFrameCallback(), or
+    // finds that the wait it was requested for has ended
+    if (auto *callback = mFrameCallback.exchange(nullptr))
+        wl_callback_destroy(callback);
+    mFrameCallbackDeadline = 0;
+    quint64 state = mFrameCallbackState;
+    while (!mFrameCallbackState.compare_exchange_weak(state, (state & ~quint64(FrameCallbackAwaited)) + FrameCallbackGeneration)) { }
+    if (state & FrameCallbackAwaited)
+        signalFrameReady();
+    mFrameCallbackTimer.stop();
+    mFrameCallbackTimerArmed = false;
+    mFramePacingTimer.stop();
+    mUpdateDeliveredAt = 0;
     mInFrameRender = false;
     mFrameCallbackTimedOut = false;
     mWaitingToApplyConfigure = false;
@@ -528,9 +601,7 @@ void QWaylandWindow::updateInputRegion()
     if (mInputRegion.isEmpty() && !mTransparentInputRegion) {
         mSurface->set_input_region(nullptr);
     } else {
-        struct ::wl_region *region = mDisplay->createRegion(mInputRegion);
-        mSurface->set_input_region(region);
-        wl_region_destroy(region);
+        mSurface->set_input_region(mDisplay->cachedRegion(mInputRegion));
     }
 }
 
@@ -717,6 +788,10 @@ void QWaylandWindow::attach(QWaylandBuffer *buffer, int x, int y)
         Q_ASSERT(!buffer->committed());
         handleUpdate();
         buffer->setBusy(true);
+        // Buffers deleted on release may be freed from the queue's own thread, which must
+        // not drop the last reference to it, so those stay on the default queue.
+        if (mEventQueue && !buffer->deleteOnRelease())
+            buffer->setEventQueue(mEventQueue);
         if (mSurface->version() >= WL_SURFACE_OFFSET_SINCE_VERSION) {
             mSurface->offset(x, y);
             mSurface->attach(buffer->buffer(), 0, 0);
@@ -769,8 +844,10 @@ bool QWaylandWindow::allowsIndependentThreadedRendering() const
 void QWaylandWindow::commit(QWaylandBuffer *buffer, const QRegion &damage)
 {
     Q_ASSERT(isExposed());
+    const qint64 traceStart = latencyTraceStart();
     if (buffer->committed()) {
         mSurface->commit();
+        traceCommitted("wl_surface.commit", traceStart);
         qCDebug(lcWaylandBackingstore) << "Buffer already committed, not attaching.";
         return;
     }
@@ -796,6 +873,7 @@ void QWaylandWindow::commit(QWaylandBuffer *buffer, const QRegion &damage)
     Q_ASSERT(!buffer->committed());
     buffer->setCommitted();
     mSurface->commit();
+    traceCommitted("wl_surface.commit", traceStart);
 }
 
 void QWaylandWindow::commit()
@@ -815,18 +893,23 @@ const wl_callback_listener QWaylandWindow::callbackListener = {
 
 void QWaylandWindow::handleFrameCallback(wl_callback* callback)
 {
-    QMutexLocker locker(&mFrameSyncMutex);
-    if (!mFrameCallback) {
+    // Read while the callback is still current, so this is the wait it was requested for
+    quint64 state = mFrameCallbackState;
+    wl_callback *expected = callback;
+    if (!mFrameCallback.compare_exchange_strong(expected, nullptr)) {
         // This means the callback is already unset by QWaylandWindow::reset.
         // The wl_callback object will be destroyed there too.
         return;
     }
-    Q_ASSERT(callback == mFrameCallback);
     wl_callback_destroy(callback);
-    mFrameCallback = nullptr;
 
-    mWaitingForFrameCallback = false;
-    mFrameCallbackElapsedTimer.invalidate();
+    // reset() and a following handleUpdate() may have started a new wait in the meantime,
+    // which has a different generation
+    if (!(state & FrameCallbackAwaited)
+        || !mFrameCallbackState.compare_exchange_strong(state, state & ~quint64(FrameCallbackAwaited))) {
+        return;
+    }
+    signalFrameReady();
 
     // The rest can wait until we can run it on the correct thread
     if (mWaitingForUpdateDelivery.testAndSetAcquire(false, true)) {
@@ -834,7 +917,26 @@ void QWaylandWindow::handleFrameCallback(wl_callback* callback)
         // in the single-threaded case.
         QMetaObject::invokeMethod(this, &QWaylandWindow::doHandleFrameCallback, Qt::QueuedConnection);
     }
-    mFrameSyncWait.notify_all();
+}
+
+void QWaylandWindow::signalFrameReady()
+{
+    if (mFrameReadyWriteFd == -1)
+        return;
+#ifdef Q_OS_LINUX
+    const quint64 value = 1;
+    qt_safe_write(mFrameReadyWriteFd, &value, sizeof(value));
+#else
+    qt_safe_write(mFrameReadyWriteFd, "\0", 1);
+#endif
+}
+
+void QWaylandWindow::clearFrameReady()
+{
+    if (mFrameReadyFd == -1)
+        return;
+    char buf[64];
+    while (qt_safe_read(mFrameReadyFd, buf, sizeof(buf)) > 0) { }
 }
 
 void QWaylandWindow::doHandleFrameCallback()
@@ -844,26 +946,56 @@ void QWaylandWindow::doHandleFrameCallback()
     mFrameCallbackTimedOut = false;
     // Did setting mFrameCallbackTimedOut make the window exposed?
     updateExposure();
-    if (wasExposed && hasPendingUpdateRequest())
-        deliverUpdateRequest();
+    if (!wasExposed || !hasPendingUpdateRequest())
+        return;
 
+    if (auto *presentation = framePacingPresentation(mDisplay)) {
+        const qint64 delay = mPresentationTiming->updateDelay(presentation->currentTime());
+        if (delay > 0) {
+            mFramePacingTimer.start(std::chrono::ceil<std::chrono::milliseconds>(std::chrono::nanoseconds(delay)),
+                                    Qt::PreciseTimer, this);
+            return;
+        }
+    }
+    deliverUpdateRequest();
 }
 
 bool QWaylandWindow::waitForFrameSync(int timeout)
 {
-    QMutexLocker locker(&mFrameSyncMutex);
-
     QDeadlineTimer deadline(timeout);
-    while (mWaitingForFrameCallback && mFrameSyncWait.wait(&mFrameSyncMutex, deadline)) { }
+    while (isWaitingForFrameCallback()) {
+        if (deadline.hasExpired())
+            break;
+        if (mFrameReadyFd == -1) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        pollfd pfd = qt_make_pollfd(mFrameReadyFd, POLLIN);
+        if (qt_safe_poll(&pfd, 1, deadline) == 0)
+            break;
+    }
 
-    if (mWaitingForFrameCallback) {
+    const bool waiting = isWaitingForFrameCallback();
+    if (waiting) {
         qCDebug(lcWaylandBackingstore) << "Didn't receive frame callback in time, window should now be inexposed";
         mFrameCallbackTimedOut = true;
         mWaitingForUpdate = false;
         QMetaObject::invokeMethod(this, &QWaylandWindow::updateExposure, Qt::QueuedConnection);
     }
 
-    return !mWaitingForFrameCallback;
+    return !waiting;
+}
+
+std::shared_ptr<QWaylandEventQueue> QWaylandWindow::eventQueue() const
+{
+    QReadLocker locker(&mSurfaceLock);
+    return mEventQueue;
+}
+
+// Must be called with mSurfaceLock held
+wl_event_queue *QWaylandWindow::frameEventQueue() const
+{
+    return mEventQueue ? mEventQueue->queue() : mDisplay->frameEventQueue();
 }
 
 QMargins QWaylandWindow::frameMargins() const
@@ -1670,23 +1802,41 @@ void QWaylandWindow::setBackingStore(QPlatformBackingStore *store)
 
 void QWaylandWindow::timerEvent(QTimerEvent *event)
 {
-    if (event->timerId() != mFrameCallbackCheckIntervalTimerId)
+    if (event->timerId() == mFramePacingTimer.timerId()) {
+        mFramePacingTimer.stop();
+        if (isExposed() && hasPendingUpdateRequest())
+            deliverUpdateRequest();
         return;
+    }
 
-    {
-        QMutexLocker lock(&mFrameSyncMutex);
+    if (event->timerId() != mFrameCallbackTimer.timerId())
+        return;
 
-        bool callbackTimerExpired = mFrameCallbackElapsedTimer.hasExpired(mFrameCallbackTimeout);
-        if (!mFrameCallbackElapsedTimer.isValid() || callbackTimerExpired ) {
-            killTimer(mFrameCallbackCheckIntervalTimerId);
-            mFrameCallbackCheckIntervalTimerId = -1;
-        }
-        if (!mFrameCallbackElapsedTimer.isValid() || !callbackTimerExpired) {
-            return;
-        }
-        mFrameCallbackElapsedTimer.invalidate();
+    mFrameCallbackTimer.stop();
+    armFrameCallbackTimer();
+}
+
+// Runs on the main thread. The watchdog is a single shot timer for the current deadline, which
+// is re-armed with the remaining time if a new frame was requested in the meantime.
+void QWaylandWindow::armFrameCallbackTimer()
+{
+    // Clear the flag before reading the deadline so that a concurrent handleUpdate() either
+    // sees it cleared and queues another call, or has already stored its deadline.
+    mFrameCallbackTimerArmed = false;
+    const qint64 deadline = mFrameCallbackDeadline;
+    if (!deadline || !isWaitingForFrameCallback()) {
+        mFrameCallbackTimer.stop();
+        return;
+    }
+
+    const qint64 remaining = deadline - QDeadlineTimer::current().deadline();
+    if (remaining > 0) {
+        mFrameCallbackTimerArmed = true;
+        mFrameCallbackTimer.start(std::chrono::milliseconds(remaining), Qt::PreciseTimer, this);
+        return;
     }
 
+    mFrameCallbackDeadline = 0;
     qCDebug(lcWaylandBackingstore) << "Didn't receive frame callback in time, window should now be inexposed";
     mFrameCallbackTimedOut = true;
     mWaitingForUpdate = false;
@@ -1698,12 +1848,10 @@ void QWaylandWindow::requestUpdate()
     qCDebug(lcWaylandBackingstore) << "requestUpdate";
     Q_ASSERT(hasPendingUpdateRequest()); // should be set by QPA
 
-    // If we have a frame callback all is good and will be taken care of there
-    {
-        QMutexLocker locker(&mFrameSyncMutex);
-        if (mWaitingForFrameCallback)
-            return;
-    }
+    // If we have a frame callback all is good and will be taken care of there, and
+    // likewise when a paced update is about to be delivered
+    if (isWaitingForFrameCallback() || mFramePacingTimer.isActive())
+        return;
 
     // If we've already called deliverUpdateRequest(), but haven't seen any attach+commit/swap yet
     // This is a somewhat redundant behavior and might indicate a bug in the calling code, so log
@@ -1716,11 +1864,8 @@ void QWaylandWindow::requestUpdate()
     // so use invokeMethod to delay the delivery a bit.
     QMetaObject::invokeMethod(this, [this] {
         // Things might have changed in the meantime
-        {
-            QMutexLocker locker(&mFrameSyncMutex);
-            if (mWaitingForFrameCallback)
-                return;
-        }
+        if (isWaitingForFrameCallback())
+            return;
         if (hasPendingUpdateRequest())
             deliverUpdateRequest();
     }, Qt::QueuedConnection);
@@ -1738,36 +1883,67 @@ void QWaylandWindow::handleUpdate()
     if (!mSurface)
         return;
 
-    QMutexLocker locker(&mFrameSyncMutex);
-    if (mWaitingForFrameCallback)
-        return;
+    // Starts a new generation of waiting
+    quint64 state = mFrameCallbackState;
+    do {
+        if (state & FrameCallbackAwaited)
+            return;
+    } while (!mFrameCallbackState.compare_exchange_weak(state, state + FrameCallbackGeneration + FrameCallbackAwaited));
+    clearFrameReady();
+
+    // The predictions, and pacing, are about the update request that follows the frame
+    // callback, so feedback is only needed for the frames that get one.
+    if (auto *presentation = mDisplay->presentation()) {
+        presentation->requestFeedback(this, mSurface->object());
+        if (const qint64 deliveredAt = mUpdateDeliveredAt.exchange(0))
+            mPresentationTiming->rendered(presentation->currentTime() - deliveredAt);
+    }
 
     struct ::wl_surface *wrappedSurface = reinterpret_cast<struct ::wl_surface *>(wl_proxy_create_wrapper(mSurface->object()));
-    wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(wrappedSurface), mDisplay->frameEventQueue());
-    mFrameCallback = wl_surface_frame(wrappedSurface);
+    wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(wrappedSurface), frameEventQueue());
+    struct ::wl_callback *callback = wl_surface_frame(wrappedSurface);
     wl_proxy_wrapper_destroy(wrappedSurface);
-    wl_callback_add_listener(mFrameCallback, &QWaylandWindow::callbackListener, this);
-    mWaitingForFrameCallback = true;
+    mFrameCallback = callback;
+    wl_callback_add_listener(callback, &QWaylandWindow::callbackListener, this);
     mWaitingForUpdate = false;
 
-    // Start a timer for handling the case when the compositor stops sending frame callbacks.
+    // Arm the watchdog for the case when the compositor stops sending frame callbacks.
     if (mFrameCallbackTimeout > 0) {
-        QMetaObject::invokeMethod(this, [this] {
-            QMutexLocker locker(&mFrameSyncMutex);
-
-            if (mWaitingForFrameCallback) {
-                if (mFrameCallbackCheckIntervalTimerId < 0)
-                    mFrameCallbackCheckIntervalTimerId = startTimer(mFrameCallbackTimeout);
-                mFrameCallbackElapsedTimer.start();
-            }
-        }, Qt::QueuedConnection);
+        mFrameCallbackDeadline = QDeadlineTimer(mFrameCallbackTimeout, Qt::PreciseTimer).deadline();
+        if (!mFrameCallbackTimerArmed.exchange(true))
+            QMetaObject::invokeMethod(this, &QWaylandWindow::armFrameCallbackTimer, Qt::QueuedConnection);
     }
 }
 
+void QWaylandWindow::handlePresented(qint64 timestamp, qint64 refresh, quint64 sequence)
+{
+    mPresentationTiming->presented(timestamp, refresh, sequence);
+}
+
+qint64 QWaylandWindow::lastPresentationTime() const
+{
+    return mPresentationTiming->lastPresentationTime();
+}
+
+qint64 QWaylandWindow::presentationRefreshInterval() const
+{
+    return mPresentationTiming->refreshInterval();
+}
+
+// Can be called from the render thread, to start rendering just in time for the next refresh
+qint64 QWaylandWindow::predictedNextPresentationTime() const
+{
+    if (auto *presentation = mDisplay->presentation())
+        return mPresentationTiming->predictNextPresentationTime(presentation->currentTime());
+    return 0;
+}
+
 void QWaylandWindow::deliverUpdateRequest()
 {
     qCDebug(lcWaylandBackingstore) << "deliverUpdateRequest";
     mWaitingForUpdate = true;
+    if (auto *presentation = framePacingPresentation(mDisplay))
+        mUpdateDeliveredAt = presentation->currentTime();
     QPlatformWindow::deliverUpdateRequest();
 }
 
@@ -1816,9 +1992,7 @@ void QWaylandWindow::setOpaqueArea(const QRegion &opaqueArea)
 
     mOpaqueArea = translatedOpaqueArea;
 
-    struct ::wl_region *region = mDisplay->createRegion(translatedOpaqueArea);
-    mSurface->set_opaque_region(region);
-    wl_region_destroy(region);
+    mSurface->set_opaque_region(mDisplay->cachedRegion(translatedOpaqueArea));
 }
 
 void QWaylandWindow::requestXdgActivationToken(uint serial)
@@ -1871,6 +2045,20 @@ void QWaylandWindow::reinit()
 
 bool QWaylandWindow::windowEvent(QEvent *event)
 {
+    // Called right before the event reaches QWindow::event()
+    if (event->isInputEvent() && QWaylandLatencyTrace::isEnabled()) {
+        QMutexLocker locker(&mTraceMutex);
+        if (!mDispatchedInputFlows.isEmpty()) {
+            const qint64 now = QWaylandLatencyTrace::now();
+            QWaylandLatencyTrace::slice("QWindowSystemInterface delivery", now, now,
+                                        QWaylandLatencyTrace::FlowStep, mDispatchedInputFlows);
+            mDeliveredInputFlows += mDispatchedInputFlows;
+            mDispatchedInputFlows.clear();
+            if (mDeliveredInputFlows.size() > 64)
+                mDeliveredInputFlows.remove(0, mDeliveredInputFlows.size() - 64);
+        }
+    }
+
     if (event->type() == QEvent::ApplicationPaletteChange
         || event->type() == QEvent::ApplicationFontChange) {
         if (mWindowDecorationEnabled && window()->isVisible())
@@ -18,6 +18,7 @@
 #include <QtCore/QWaitCondition>
 #include <QtCore/QMutex>
 #include <QtCore/QReadWriteLock>
+#include <QtCore/QBasicTimer>
 
 #include <QtGui/QIcon>
 #include <QtGui/QEventPoint>
@@ -62,6 +63,8 @@ class QWaylandFractionalScale;
 class QWaylandViewport;
 class ColorManagementSurface;
 class ImageDescription;
+class QWaylandEventQueue;
+class QWaylandPresentationTiming;
 
 class Q_WAYLANDCLIENT_EXPORT QWaylandWindow : public QNativeInterface::Private::QWaylandWindow,
                                               public QPlatformWindow
@@ -123,6 +126,17 @@ public:
     void commit();
 
     bool waitForFrameSync(int timeout);
+    // Readable while no frame callback is pending, for render threads to poll() but not read()
+    int frameReadyFd() const { return mFrameReadyFd; }
+
+    // Presentation feedback, in nanoseconds of the wp_presentation clock. 0 when unknown.
+    void handlePresented(qint64 timestamp, qint64 refresh, quint64 sequence);
+    qint64 lastPresentationTime() const;
+    qint64 presentationRefreshInterval() const;
+    qint64 predictedNextPresentationTime() const;
+
+    std::shared_ptr<QWaylandEventQueue> eventQueue() const;
+    struct ::wl_event_queue *frameEventQueue() const;
 
     QMargins frameMargins() const override;
     QMargins clientSideMargins() const;
@@ -236,6 +250,12 @@ public:
     void beginFrame();
     void endFrame();
 
+    // Input-to-commit latency tracing, see QWaylandLatencyTrace. latencyTraceStart()
+    // returns 0 when tracing is disabled, which makes traceCommitted() a no-op.
+    void traceInputDispatched(quint64 flow);
+    qint64 latencyTraceStart() const;
+    void traceCommitted(const char *name, qint64 start);
+
     void closeChildPopups();
 
     // should be invoked whenever a property that potentially affects
@@ -273,6 +293,8 @@ protected:
     QScopedPointer<QWaylandSurface> mSurface;
     QScopedPointer<QWaylandFractionalScale> mFractionalScale;
     QScopedPointer<QWaylandViewport> mViewport;
+    // Only set when per-window event queues are enabled, protected by mSurfaceLock
+    std::shared_ptr<QWaylandEventQueue> mEventQueue;
 
     QWaylandShellIntegration *mShellIntegration = nullptr;
     QWaylandShellSurface *mShellSurface = nullptr;
@@ -302,14 +324,34 @@ protected:
 #endif
 
     bool mFrameCallbackTimedOut = false; // Whether the frame callback has timed out
-    int mFrameCallbackCheckIntervalTimerId = -1;
+    QBasicTimer mFrameCallbackTimer; // Single shot, fires at mFrameCallbackDeadline
+    QBasicTimer mFramePacingTimer; // Single shot, delivers an update request held back for pacing
+    std::atomic_bool mFrameCallbackTimerArmed = false;
     QAtomicInt mWaitingForUpdateDelivery = false;
 
-    bool mWaitingForFrameCallback = false; // Protected by mFrameSyncMutex
-    QElapsedTimer mFrameCallbackElapsedTimer; // Protected by mFrameSyncMutex
-    struct ::wl_callback *mFrameCallback = nullptr; // Protected by mFrameSyncMutex
-    QMutex mFrameSyncMutex;
-    QWaitCondition mFrameSyncWait;
+    // Frame callback state is shared between the main, render and event threads without locks.
+    // mFrameCallbackState holds whether a frame callback is awaited in its lowest bit, and the
+    // number of frames requested so far above it, so that ending a wait can't end a later one.
+    // mFrameCallback is owned by whoever exchanges it for null. mFrameReadyFd is readable
+    // whenever no frame callback is awaited.
+    enum : quint64 { FrameCallbackAwaited = 1, FrameCallbackGeneration = 2 };
+    bool isWaitingForFrameCallback() const { return mFrameCallbackState & FrameCallbackAwaited; }
+    std::atomic<quint64> mFrameCallbackState = 0;
+    std::atomic<qint64> mFrameCallbackDeadline = 0; // QDeadlineTimer::deadline(), 0 if none
+    std::atomic<struct ::wl_callback *> mFrameCallback = nullptr;
+    int mFrameReadyFd = -1;
+    int mFrameReadyWriteFd = -1;
+
+    std::unique_ptr<QWaylandPresentationTiming> mPresentationTiming;
+    // When the last update request was delivered, in the presentation clock. 0 when the
+    // frame it asked for was already committed, or when frames are not paced.
+    std::atomic<qint64> mUpdateDeliveredAt = 0;
+
+    // Traced input dispatched but not yet delivered to the window, and delivered but not
+    // yet committed. Commits can come from the render thread.
+    QMutex mTraceMutex;
+    QList<quint64> mDispatchedInputFlows;
+    QList<quint64> mDeliveredInputFlows;
 
     // True when we have called deliverRequestUpdate, but the client has not yet attached a new buffer
     bool mWaitingForUpdate = false;
@@ -383,6 +425,9 @@ private:
 
     static const wl_callback_listener callbackListener;
     void handleFrameCallback(struct ::wl_callback* callback);
+    void signalFrameReady();
+    void clearFrameReady();
+    void armFrameCallbackTimer();
     const QPlatformWindow *lastParent = nullptr;
 
     static QWaylandWindow *mMouseGrab;
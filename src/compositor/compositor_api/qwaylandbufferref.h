@@ -82,6 +82,7 @@ private:
     class QWaylandBufferRefPrivate *const d;
     friend class QWaylandBufferRefPrivate;
     friend class QWaylandSurfacePrivate;
+    friend class QWaylandQuickItemPrivate;
 
     friend Q_WAYLANDCOMPOSITOR_EXPORT
     bool operator==(const QWaylandBufferRef &lhs, const QWaylandBufferRef &rhs) noexcept;
@@ -17,6 +17,8 @@
 #include <QtWaylandCompositor/qwaylandsurfacegrabber.h>
 
 #include <QtWaylandCompositor/private/qwaylandkeyboard_p.h>
+#include <QtWaylandCompositor/private/qwaylandpointer_p.h>
+#include <QtWaylandCompositor/private/qwaylandtouch_p.h>
 #include <QtWaylandCompositor/private/qwaylandsurface_p.h>
 
 #if QT_CONFIG(wayland_datadevice)
@@ -343,7 +345,24 @@ void QWaylandCompositorPrivate::subcompositor_get_subsurface(wl_subcompositor::R
     Q_Q(QWaylandCompositor);
     QWaylandSurface *childSurface = QWaylandSurface::fromResource(surface);
     QWaylandSurface *parentSurface = QWaylandSurface::fromResource(parent);
-    QWaylandSurfacePrivate::get(childSurface)->initSubsurface(parentSurface, resource->client(), id, 1);
+    QWaylandSurfacePrivate *childPrivate = QWaylandSurfacePrivate::get(childSurface);
+
+    if (childSurface->role() || childPrivate->isSubsurface()) {
+        wl_resource_post_error(resource->handle, error_bad_surface,
+                               "wl_surface@%d already has a role", wl_resource_get_id(surface));
+        return;
+    }
+    for (QWaylandSurfacePrivate *ancestor = QWaylandSurfacePrivate::get(parentSurface); ancestor;
+         ancestor = ancestor->parentSurface()) {
+        if (ancestor == childPrivate) {
+            wl_resource_post_error(resource->handle, error_bad_parent,
+                                   "wl_surface@%d is the surface itself or one of its descendants",
+                                   wl_resource_get_id(parent));
+            return;
+        }
+    }
+
+    childPrivate->initSubsurface(parentSurface, resource->client(), id, 1);
     QWaylandSurfacePrivate::get(parentSurface)->subsurfaceChildren.append(childSurface);
     emit q->subsurfaceChanged(childSurface, parentSurface);
 }
@@ -393,6 +412,13 @@ void QWaylandCompositorPrivate::initializeHardwareIntegration()
 #endif
 }
 
+void QWaylandCompositorPrivate::setScanoutFormats(QWaylandSurface *surface, dev_t device,
+                                                  const QHash<uint32_t, QList<uint64_t>> &formats)
+{
+    for (auto *integration : std::as_const(client_buffer_integrations))
+        integration->setScanoutFormats(surface, device, formats);
+}
+
 void QWaylandCompositorPrivate::initializeSeats()
 {
     for (QWaylandSeat *seat : std::as_const(seats))
@@ -850,6 +876,12 @@ void QWaylandCompositor::processWaylandEvents()
     int ret = wl_event_loop_dispatch(d->loop, 0);
     if (ret)
         fprintf(stderr, "wl_event_loop_dispatch error: %d\n", ret);
+    for (QWaylandSeat *seat : std::as_const(d->seats)) {
+        if (QWaylandPointer *pointer = seat->pointer())
+            QWaylandPointerPrivate::get(pointer)->flushPendingMotion();
+        if (QWaylandTouch *touch = seat->touch())
+            QWaylandTouchPrivate::get(touch)->flushPendingFrames();
+    }
     wl_display_flush_clients(d->display);
 }
 
@@ -1058,6 +1090,10 @@ void QWaylandCompositor::grabSurface(QWaylandSurfaceGrabber *grabber, const QWay
  * list will empty. Additional formats may require conversion internally and can thus affect
  * performance.
  *
+ * The packed YUV format ShmFormat_YUYV is uploaded as is and converted to RGB on the GPU when
+ * WaylandQuickItem renders with OpenGL. Multi-planar YUV formats can't be offered through wl_shm,
+ * since a buffer is only guaranteed its stride times height bytes of the pool.
+ *
  * This property must be set before the compositor component is completed. Subsequent changes
  * will have no effect.
  *
@@ -1073,6 +1109,11 @@ void QWaylandCompositor::grabSurface(QWaylandSurfaceGrabber *grabber, const QWay
  * By default, only the required ShmFormat_ARGB8888 and ShmFormat_XRGB8888 are listed and this
  * list will empty.
  *
+ * The packed YUV format ShmFormat_YUYV is uploaded as is and converted to RGB on the GPU when
+ * QWaylandQuickItem renders with OpenGL. Otherwise, QWaylandBufferRef::image() converts it on
+ * the CPU. Multi-planar YUV formats can't be offered through wl_shm, since a buffer is only
+ * guaranteed its stride times height bytes of the pool.
+ *
  * This property must be set before the compositor is \l{create()}{created}. Subsequent changes
  * will have no effect.
  *
@@ -71,7 +71,8 @@ public:
         ShmFormat_XRGB2101010 = 0x30335258,
         ShmFormat_XBGR2101010 = 0x30334258,
         ShmFormat_ARGB2101010 = 0x30335241,
-        ShmFormat_ABGR2101010 = 0x30334241
+        ShmFormat_ABGR2101010 = 0x30334241,
+        ShmFormat_YUYV = 0x56595559
     };
     Q_ENUM(ShmFormat)
 
@@ -20,6 +20,8 @@
 #include <QtWaylandCompositor/QWaylandCompositor>
 #include <QtCore/private/qobject_p.h>
 #include <QtCore/QSet>
+#include <QtCore/QHash>
+#include <QtCore/QList>
 #include <QtCore/QElapsedTimer>
 
 #include <QtWaylandCompositor/private/qwayland-server-wayland.h>
@@ -28,6 +30,8 @@
 
 #include <vector>
 
+#include <sys/types.h>
+
 #if QT_CONFIG(xkbcommon)
 #include <QtGui/private/qxkbcommon_p.h>
 #endif
@@ -68,6 +72,10 @@ public:
     inline const QList<QtWayland::ClientBufferIntegration *> clientBufferIntegrations() const;
     inline QtWayland::ServerBufferIntegration *serverBufferIntegration() const;
 
+    // For hardware layer integrations, when they place a surface on a plane of the device
+    void setScanoutFormats(QWaylandSurface *surface, dev_t device,
+                           const QHash<uint32_t, QList<uint64_t>> &formats);
+
 #if QT_CONFIG(wayland_datadevice)
     QtWayland::DataDeviceManager *dataDeviceManager() const { return data_device_manager; }
 #endif
@@ -27,6 +27,10 @@
 #include <QtWaylandCompositor/qwaylandtextinputmanagerv3.h>
 #include <QtWaylandCompositor/qwaylandqttextinputmethodmanager.h>
 #include <QtWaylandCompositor/qwaylandidleinhibitv1.h>
+#include <QtWaylandCompositor/qwaylandpointerconstraintsv1.h>
+#include <QtWaylandCompositor/qwaylandrelativepointerv1.h>
+#include <QtWaylandCompositor/qwaylandcolormanagement.h>
+#include <QtWaylandCompositor/qwaylandlinuxexplicitsynchronizationv1.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -88,6 +92,13 @@ Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_ELEMENT(QWaylandTextInputManagerV3, T
                                                    1, 0)
 Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_ELEMENT(QWaylandQtTextInputMethodManager,
                                                    QtTextInputMethodManager, 1, 0)
+Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_ELEMENT(QWaylandRelativePointerManagerV1,
+                                                   RelativePointerManagerV1, 6, 10)
+Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_ELEMENT(QWaylandPointerConstraintsV1,
+                                                   PointerConstraintsV1, 6, 10)
+Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_ELEMENT(QWaylandColorManagement, ColorManagement, 6, 10)
+Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_ELEMENT(QWaylandLinuxExplicitSynchronizationV1,
+                                                   LinuxExplicitSynchronizationV1, 6, 10)
 
 QT_END_NAMESPACE
 
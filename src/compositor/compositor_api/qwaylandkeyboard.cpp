@@ -9,6 +9,8 @@
 #include <QtWaylandCompositor/QWaylandCompositor>
 #include <QtWaylandCompositor/QWaylandSeat>
 #include <QtWaylandCompositor/QWaylandClient>
+#include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+#include "qwaylandlatencytrace_p.h"
 
 #include <QtCore/QFile>
 #include <QtCore/QStandardPaths>
@@ -142,8 +144,16 @@ void QWaylandKeyboardPrivate::sendKeyEvent(uint code, uint32_t state)
     uint32_t time = compositor()->currentTimeMsecs();
     uint32_t serial = compositor()->nextSerial();
     uint key = toWaylandKey(code);
-    if (focusResource)
-        send_key(focusResource->handle, serial, time, key, state);
+    if (!focusResource)
+        return;
+
+    QWaylandLatencyTrace::Slice traceSlice("wl_keyboard.key");
+    if (QWaylandLatencyTrace::isEnabled() && focus) {
+        const quint64 flow = QWaylandLatencyTrace::keyFlow(serial);
+        traceSlice.addFlow(flow, QWaylandLatencyTrace::FlowStart);
+        QWaylandSurfacePrivate::get(focus)->traceInputSent(flow);
+    }
+    send_key(focusResource->handle, serial, time, key, state);
 }
 
 #if QT_CONFIG(xkbcommon)
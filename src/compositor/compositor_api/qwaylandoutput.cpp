@@ -921,6 +921,7 @@ void QWaylandOutput::sendFrameCallbacks()
                 d->surfaceViews[i].has_entered = true;
             }
             if (auto primaryView = surfacemapper.maybePrimaryView()) {
+                QWaylandSurfacePrivate::get(surfacemapper.surface)->tracePresented();
                 if (!QWaylandViewPrivate::get(primaryView)->independentFrameCallback)
                     surfacemapper.surface->sendFrameCallbacks();
             }
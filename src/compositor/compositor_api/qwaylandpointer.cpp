@@ -5,6 +5,11 @@
 #include "qwaylandpointer_p.h"
 #include <QtWaylandCompositor/QWaylandClient>
 #include <QtWaylandCompositor/QWaylandCompositor>
+#include <QtWaylandCompositor/private/qwaylandutils_p.h>
+#include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+#include "qwaylandlatencytrace_p.h"
+
+#include <QtGui/QWheelEvent>
 
 QT_BEGIN_NAMESPACE
 
@@ -22,22 +27,171 @@ uint QWaylandPointerPrivate::sendButton(Qt::MouseButton button, uint32_t state)
     if (!q->mouseFocus() || !q->mouseFocus()->surface())
         return 0;
 
-    wl_client *client = q->mouseFocus()->surface()->waylandClient();
+    flushPendingMotion();
+
+    QWaylandSurface *surface = q->mouseFocus()->surface();
+    wl_client *client = surface->waylandClient();
     uint32_t time = compositor()->currentTimeMsecs();
     uint32_t serial = compositor()->nextSerial();
+
+    QWaylandLatencyTrace::Slice traceSlice("wl_pointer.button");
+    if (QWaylandLatencyTrace::isEnabled()) {
+        const quint64 flow = QWaylandLatencyTrace::buttonFlow(serial);
+        traceSlice.addFlow(flow, QWaylandLatencyTrace::FlowStart);
+        QWaylandSurfacePrivate::get(surface)->traceInputSent(flow);
+    }
+
     for (auto resource : resourceMap().values(client))
         send_button(resource->handle, serial, time, q->toWaylandButton(button), state);
+    sendFrame(client);
     return serial;
 }
 
 void QWaylandPointerPrivate::sendMotion()
 {
     Q_ASSERT(enteredSurface);
-    uint32_t time = compositor()->currentTimeMsecs();
+    pendingMotionTime = compositor()->currentTimeMsecs();
+    motionPending = true;
+}
+
+void QWaylandPointerPrivate::flushPendingMotion()
+{
+    if (!motionPending)
+        return;
+    motionPending = false;
+    if (!enteredSurface)
+        return;
+
+    QWaylandLatencyTrace::Slice traceSlice("wl_pointer.motion");
+    if (QWaylandLatencyTrace::isEnabled()) {
+        const quint64 flow = QWaylandLatencyTrace::motionFlow(pendingMotionTime);
+        traceSlice.addFlow(flow, QWaylandLatencyTrace::FlowStart);
+        QWaylandSurfacePrivate::get(enteredSurface)->traceInputSent(flow);
+    }
+
     wl_fixed_t x = wl_fixed_from_double(localPosition.x());
     wl_fixed_t y = wl_fixed_from_double(localPosition.y());
-    for (auto resource : resourceMap().values(enteredSurface->waylandClient()))
-        wl_pointer_send_motion(resource->handle, time, x, y);
+    wl_client *client = enteredSurface->waylandClient();
+    for (auto resource : resourceMap().values(client))
+        wl_pointer_send_motion(resource->handle, pendingMotionTime, x, y);
+    sendFrame(client);
+}
+
+void QWaylandPointerPrivate::sendFrame(wl_client *client)
+{
+    for (auto resource : resourceMap().values(client)) {
+        if (resource->version() >= WL_POINTER_FRAME_SINCE_VERSION)
+            send_frame(resource->handle);
+    }
+    axisSourceSent = false;
+}
+
+void QWaylandPointerPrivate::sendAxis(Qt::Orientation orientation, qreal value, int value120, uint32_t source)
+{
+    flushPendingMotion();
+
+    const uint32_t axis = orientation == Qt::Horizontal ? WL_POINTER_AXIS_HORIZONTAL_SCROLL
+                                                        : WL_POINTER_AXIS_VERTICAL_SCROLL;
+    int discrete = 0;
+    if (value120) {
+        discreteRemainder[axis] += value120;
+        discrete = discreteRemainder[axis] / 120;
+        discreteRemainder[axis] -= discrete * 120;
+    }
+
+    uint32_t time = compositor()->currentTimeMsecs();
+    for (auto resource : resourceMap().values(enteredSurface->waylandClient())) {
+        const int version = resource->version();
+        if (!axisSourceSent && version >= WL_POINTER_AXIS_SOURCE_SINCE_VERSION)
+            send_axis_source(resource->handle, source);
+        if (version >= WL_POINTER_AXIS_VALUE120_SINCE_VERSION) {
+            if (value120)
+                send_axis_value120(resource->handle, axis, value120);
+        } else if (version >= WL_POINTER_AXIS_DISCRETE_SINCE_VERSION && discrete) {
+            send_axis_discrete(resource->handle, axis, discrete);
+        }
+        if (value != 0)
+            send_axis(resource->handle, time, axis, wl_fixed_from_double(value));
+        else if (source == WL_POINTER_AXIS_SOURCE_FINGER && version >= WL_POINTER_AXIS_STOP_SINCE_VERSION)
+            send_axis_stop(resource->handle, time, axis);
+    }
+    axisSourceSent = true;
+}
+
+#if QT_CONFIG(wheelevent)
+void QWaylandPointerPrivate::sendWheelEvent(const QWheelEvent *event)
+{
+    if (!enteredSurface)
+        return;
+
+    // Qt's deltas point away from the user for positive values, Wayland's towards
+    const QPoint angleDelta = -event->angleDelta();
+    const QPoint pixelDelta = -event->pixelDelta();
+    const bool stop = event->phase() == Qt::ScrollEnd;
+
+    if (!pixelDelta.isNull() || event->phase() != Qt::NoScrollPhase) {
+        // Touchpads and other smooth scrolling devices report surface pixels directly
+        const uint32_t source = event->phase() == Qt::ScrollMomentum ? WL_POINTER_AXIS_SOURCE_CONTINUOUS
+                                                                      : WL_POINTER_AXIS_SOURCE_FINGER;
+        const QPointF value = pixelDelta.isNull() ? QPointF(angleDelta) / 12 : QPointF(pixelDelta);
+        if (value.x() != 0 || (stop && source == WL_POINTER_AXIS_SOURCE_FINGER))
+            sendAxis(Qt::Horizontal, value.x(), 0, source);
+        if (value.y() != 0 || (stop && source == WL_POINTER_AXIS_SOURCE_FINGER))
+            sendAxis(Qt::Vertical, value.y(), 0, source);
+    } else {
+        // A wheel: 120 units of angleDelta are one detent, which scrolls 10 pixels
+        if (angleDelta.x() != 0)
+            sendAxis(Qt::Horizontal, angleDelta.x() / 12.0, angleDelta.x(), WL_POINTER_AXIS_SOURCE_WHEEL);
+        if (angleDelta.y() != 0)
+            sendAxis(Qt::Vertical, angleDelta.y() / 12.0, angleDelta.y(), WL_POINTER_AXIS_SOURCE_WHEEL);
+    }
+
+    sendFrame(enteredSurface->waylandClient());
+}
+#endif
+
+void QWaylandPointerPrivate::sendRelativeMotion(quint64 timestamp, const QPointF &delta, const QPointF &deltaUnaccelerated)
+{
+    if (!enteredSurface)
+        return;
+
+    wl_client *client = enteredSurface->waylandClient();
+    for (auto *relativePointer : std::as_const(relativePointers)) {
+        if (relativePointer->client() == client)
+            relativePointer->sendRelativeMotion(timestamp, delta, deltaUnaccelerated);
+    }
+}
+
+QWaylandPointer *QWaylandPointerPrivate::fromResource(wl_resource *resource)
+{
+    if (auto *d = QtWayland::fromResource<QWaylandPointerPrivate *>(resource))
+        return d->q_func();
+    return nullptr;
+}
+
+QWaylandPointerConstraintsV1Private::Constraint *QWaylandPointerPrivate::constraintFor(QWaylandSurface *surface) const
+{
+    for (auto *constraint : constraints) {
+        if (constraint->surface() == surface)
+            return constraint;
+    }
+    return nullptr;
+}
+
+QWaylandPointerConstraintsV1Private::Constraint *QWaylandPointerPrivate::activeConstraint() const
+{
+    if (!enteredSurface)
+        return nullptr;
+    auto *constraint = constraintFor(enteredSurface);
+    return constraint && constraint->isActive() ? constraint : nullptr;
+}
+
+void QWaylandPointerPrivate::handleKeyboardFocusChanged(QWaylandSurface *newFocus)
+{
+    // Focusing another surface ends a constraint, the pointer may then leave its surface
+    auto *constraint = activeConstraint();
+    if (constraint && newFocus != constraint->surface())
+        constraint->deactivate();
 }
 
 void QWaylandPointerPrivate::sendEnter(QWaylandSurface *surface)
@@ -53,17 +207,24 @@ void QWaylandPointerPrivate::sendEnter(QWaylandSurface *surface)
     wl_fixed_t y = wl_fixed_from_double(localPosition.y());
     for (auto resource : resourceMap().values(surface->waylandClient()))
         send_enter(resource->handle, enterSerial, surface->resource(), x, y);
+    sendFrame(surface->waylandClient());
 
     enteredSurface = surface;
     enteredSurfaceDestroyListener.listenForDestruction(surface->resource());
+    discreteRemainder[0] = discreteRemainder[1] = 0;
 }
 
 void QWaylandPointerPrivate::sendLeave()
 {
     Q_ASSERT(enteredSurface);
+    flushPendingMotion();
+    if (auto *constraint = constraintFor(enteredSurface))
+        constraint->deactivate();
     uint32_t serial = compositor()->nextSerial();
-    for (auto resource : resourceMap().values(enteredSurface->waylandClient()))
+    wl_client *client = enteredSurface->waylandClient();
+    for (auto resource : resourceMap().values(client))
         send_leave(resource->handle, serial, enteredSurface->resource());
+    sendFrame(client);
     localPosition = QPointF();
     enteredSurfaceDestroyListener.reset();
     enteredSurface = nullptr;
@@ -128,6 +289,9 @@ QWaylandPointer::QWaylandPointer(QWaylandSeat *seat, QObject *parent)
 {
     connect(&d_func()->enteredSurfaceDestroyListener, &QWaylandDestroyListener::fired, this, &QWaylandPointer::enteredSurfaceDestroyed);
     connect(seat, &QWaylandSeat::mouseFocusChanged, this, &QWaylandPointer::pointerFocusChanged);
+    connect(seat, &QWaylandSeat::keyboardFocusChanged, this, [this](QWaylandSurface *newFocus) {
+        d_func()->handleKeyboardFocusChanged(newFocus);
+    });
 }
 
 /*!
@@ -209,8 +373,23 @@ void QWaylandPointer::sendMouseMoveEvent(QWaylandView *view, const QPointF &loca
     Q_D(QWaylandPointer);
     if (view && (!view->surface() || view->surface()->isCursorSurface()))
         view = nullptr;
+
+    // An active constraint holds the pointer on its surface. Moves reported for other views
+    // become motion relative to the last position on the constrained one instead.
+    QPointF surfacePos = localPos;
+    QWaylandView *focus = d->seat->mouseFocus();
+    if (d->activeConstraint() && focus && focus->surface() == d->enteredSurface
+            && (!view || view->surface() != d->enteredSurface)) {
+        surfacePos = d->inputPosition + (outputSpacePos - d->spacePosition);
+        view = focus;
+    }
     d->seat->setMouseFocus(view);
-    d->localPosition = localPos;
+
+    // Focus changes don't count as motion
+    const bool sameSurface = view && view->surface() == d->enteredSurface;
+    const QPointF delta = surfacePos - d->inputPosition;
+    d->inputPosition = surfacePos;
+    d->localPosition = surfacePos;
     d->spacePosition = outputSpacePos;
 
     if (view) {
@@ -223,7 +402,31 @@ void QWaylandPointer::sendMouseMoveEvent(QWaylandView *view, const QPointF &loca
             d->localPosition.ry() -= 0.01;
 
         d->ensureEntered(view->surface());
-        d->sendMotion();
+
+        if (sameSurface && !d->explicitRelativeMotion && !delta.isNull()) {
+            const quint64 timestamp = quint64(d->compositor()->currentTimeMsecs()) * 1000;
+            d->sendRelativeMotion(timestamp, delta, delta);
+        }
+
+        bool locked = false;
+        if (auto *constraint = d->constraintFor(view->surface())) {
+            // Constraints are for the surface the user is working with, not one merely hovered
+            const QWaylandSurface *keyboardFocus = d->seat->keyboardFocus();
+            if ((!keyboardFocus || keyboardFocus == view->surface())
+                    && constraint->canActivate(d->localPosition)) {
+                constraint->activate(d->localPosition);
+            }
+            if (constraint->isActive()) {
+                using Type = QWaylandPointerConstraintsV1Private::Constraint::Type;
+                locked = constraint->type() == Type::Lock;
+                d->localPosition = locked ? constraint->lockPosition()
+                                          : constraint->confine(d->localPosition);
+            }
+        }
+
+        // A locked pointer doesn't move, clients only get relative motion
+        if (!locked)
+            d->sendMotion();
 
         if (view->output())
             setOutput(view->output());
@@ -239,12 +442,46 @@ void QWaylandPointer::sendMouseWheelEvent(Qt::Orientation orientation, int delta
     if (!d->enteredSurface)
         return;
 
-    uint32_t time = d->compositor()->currentTimeMsecs();
-    uint32_t axis = orientation == Qt::Horizontal ? WL_POINTER_AXIS_HORIZONTAL_SCROLL
-                                                  : WL_POINTER_AXIS_VERTICAL_SCROLL;
+    d->sendAxis(orientation, -delta / 12.0, -delta, WL_POINTER_AXIS_SOURCE_WHEEL);
+    d->sendFrame(d->enteredSurface->waylandClient());
+}
 
-    for (auto resource : d->resourceMap().values(d->enteredSurface->waylandClient()))
-        d->send_axis(resource->handle, time, axis, wl_fixed_from_int(-delta / 12));
+#if QT_CONFIG(wheelevent)
+/*!
+ * \since 6.10
+ *
+ * Sends the wheel \a event to the view that currently holds mouse focus, with both
+ * orientations in a single pointer frame.
+ *
+ * Unlike sendMouseWheelEvent(), this preserves the pixel deltas and scroll phase of
+ * touchpads and the high-resolution steps of wheels.
+ */
+void QWaylandPointer::sendWheelEvent(QWheelEvent *event)
+{
+    Q_D(QWaylandPointer);
+    d->sendWheelEvent(event);
+}
+#endif
+
+/*!
+ * \since 6.10
+ *
+ * Sends relative motion to the clients that requested it through
+ * QWaylandRelativePointerManagerV1, for the view that currently holds mouse focus.
+ * \a delta is the motion after pointer acceleration and \a deltaUnaccelerated the motion
+ * reported by the device, both in surface coordinates. \a timestamp is in microseconds.
+ *
+ * By default the relative motion is derived from the positions passed to
+ * sendMouseMoveEvent(), which means acceleration is already applied and motion stops at
+ * the edges of the output. Once this function has been called, that is no longer done and
+ * the compositor is expected to pass the motion of every input event here.
+ */
+void QWaylandPointer::sendRelativeMotionEvent(const QPointF &delta, const QPointF &deltaUnaccelerated,
+                                              quint64 timestamp)
+{
+    Q_D(QWaylandPointer);
+    d->explicitRelativeMotion = true;
+    d->sendRelativeMotion(timestamp, delta, deltaUnaccelerated);
 }
 
 /*!
@@ -294,6 +531,8 @@ void QWaylandPointer::addClient(QWaylandClient *client, uint32_t id, uint32_t ve
         d->send_enter(resource, d->enterSerial, d->enteredSurface->resource(),
                       wl_fixed_from_double(d->localPosition.x()),
                       wl_fixed_from_double(d->localPosition.y()));
+        if (wl_resource_get_version(resource) >= WL_POINTER_FRAME_SINCE_VERSION)
+            d->send_frame(resource);
     }
 }
 
@@ -368,6 +607,7 @@ void QWaylandPointer::enteredSurfaceDestroyed(void *data)
     Q_UNUSED(data);
     d->enteredSurfaceDestroyListener.reset();
     d->enteredSurface = nullptr;
+    d->motionPending = false;
 
     d->seat->setMouseFocus(nullptr);
 
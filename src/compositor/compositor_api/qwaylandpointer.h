@@ -16,6 +16,7 @@ class QWaylandSeat;
 class QWaylandView;
 class QWaylandOutput;
 class QWaylandClient;
+class QWheelEvent;
 
 class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandPointer : public QWaylandObject
 {
@@ -35,6 +36,11 @@ public:
     virtual uint sendMouseReleaseEvent(Qt::MouseButton button);
     virtual void sendMouseMoveEvent(QWaylandView *view, const QPointF &localPos, const QPointF &outputSpacePos);
     virtual void sendMouseWheelEvent(Qt::Orientation orientation, int delta);
+#if QT_CONFIG(wheelevent)
+    virtual void sendWheelEvent(QWheelEvent *event);
+#endif
+    void sendRelativeMotionEvent(const QPointF &delta, const QPointF &deltaUnaccelerated,
+                                 quint64 timestamp);
 
     QWaylandView *mouseFocus() const;
     QPointF currentLocalPosition() const;
@@ -29,6 +29,8 @@
 #include <QtWaylandCompositor/QWaylandView>
 #include <QtWaylandCompositor/QWaylandSurface>
 #include <QtWaylandCompositor/QWaylandSeat>
+#include <QtWaylandCompositor/private/qwaylandpointerconstraintsv1_p.h>
+#include <QtWaylandCompositor/private/qwaylandrelativepointerv1_p.h>
 
 #include <QtCore/qpointer.h>
 
@@ -37,6 +39,7 @@
 QT_BEGIN_NAMESPACE
 
 class QWaylandView;
+class QWheelEvent;
 
 class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandPointerPrivate : public QObjectPrivate
                                                  , public QtWaylandServer::wl_pointer
@@ -47,6 +50,24 @@ public:
 
     QWaylandCompositor *compositor() const { return seat->compositor(); }
 
+    static QWaylandPointerPrivate *get(QWaylandPointer *pointer) { return pointer->d_func(); }
+
+#if QT_CONFIG(wheelevent)
+    void sendWheelEvent(const QWheelEvent *event);
+#endif
+    void sendAxis(Qt::Orientation orientation, qreal value, int value120, uint32_t source);
+    void flushPendingMotion();
+
+    static QWaylandPointer *fromResource(wl_resource *resource);
+
+    QWaylandPointerConstraintsV1Private::Constraint *constraintFor(QWaylandSurface *surface) const;
+    QWaylandPointerConstraintsV1Private::Constraint *activeConstraint() const;
+    void handleKeyboardFocusChanged(QWaylandSurface *newFocus);
+    void sendRelativeMotion(quint64 timestamp, const QPointF &delta, const QPointF &deltaUnaccelerated);
+
+    QList<QWaylandRelativePointerManagerV1Private::RelativePointer *> relativePointers;
+    QList<QWaylandPointerConstraintsV1Private::Constraint *> constraints;
+
 protected:
     void pointer_set_cursor(Resource *resource, uint32_t serial, wl_resource *surface, int32_t hotspot_x, int32_t hotspot_y) override;
     void pointer_release(Resource *resource) override;
@@ -54,6 +75,7 @@ protected:
 private:
     uint sendButton(Qt::MouseButton button, uint32_t state);
     void sendMotion();
+    void sendFrame(wl_client *client);
     void sendEnter(QWaylandSurface *surface);
     void sendLeave();
     void ensureEntered(QWaylandSurface *surface);
@@ -65,10 +87,25 @@ private:
     QPointF localPosition;
     QPointF spacePosition;
 
+    // Position from the last move event, before any pointer constraint was applied
+    QPointF inputPosition;
+    // Set once the compositor passes relative motion itself, with sendRelativeMotionEvent()
+    bool explicitRelativeMotion = false;
+
     uint enterSerial = 0;
 
     int buttonCount = 0;
 
+    // Motion is held back until the compositor flushes its clients, or until another
+    // pointer event has to go out, so several moves per dispatch become one motion event.
+    bool motionPending = false;
+    uint32_t pendingMotionTime = 0;
+
+    // Remainders of value120 steps not yet sent as axis_discrete, indexed by wl_pointer axis
+    int discreteRemainder[2] = {0, 0};
+    // axis_source may be sent only once per frame, before its first axis event
+    bool axisSourceSent = false;
+
     QWaylandDestroyListener enteredSurfaceDestroyListener;
 
     static QWaylandSurfaceRole s_role;
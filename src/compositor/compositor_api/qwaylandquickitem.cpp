@@ -17,6 +17,7 @@
 #endif
 #include <QtWaylandCompositor/private/qwlclientbufferintegration_p.h>
 #include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+#include <QtWaylandCompositor/private/qwaylandpointer_p.h>
 
 #if QT_CONFIG(opengl)
 #  include <QtOpenGL/QOpenGLTexture>
@@ -32,6 +33,7 @@
 #include <QtQuick/qsgtexture.h>
 
 #include <QtCore/QFile>
+#include <QtCore/QHash>
 #include <QtCore/QMutexLocker>
 #include <QtCore/QMutex>
 
@@ -89,8 +91,8 @@ static const struct {
 
     // BufferFormatEgl_Y_U_V (GL_TEXTURE_2D)
     {
-        ":/qt-project.org/wayland/compositor/shaders/surface.vert.qsb",
-        ":/qt-project.org/wayland/compositor/shaders/surface_y_u_v.frag.qsb",
+        ":/qt-project.org/wayland/compositor/shaders/surface_yuv.vert",
+        ":/qt-project.org/wayland/compositor/shaders/surface_yuv.frag",
         3, false,
         QSGMaterial::Blending,
         {}
@@ -98,8 +100,8 @@ static const struct {
 
     // BufferFormatEgl_Y_UV (GL_TEXTURE_2D)
     {
-        ":/qt-project.org/wayland/compositor/shaders/surface.vert.qsb",
-        ":/qt-project.org/wayland/compositor/shaders/surface_y_uv.frag.qsb",
+        ":/qt-project.org/wayland/compositor/shaders/surface_yuv.vert",
+        ":/qt-project.org/wayland/compositor/shaders/surface_yuv.frag",
         2, false,
         QSGMaterial::Blending,
         {}
@@ -107,8 +109,8 @@ static const struct {
 
     // BufferFormatEgl_Y_XUXV (GL_TEXTURE_2D)
     {
-        ":/qt-project.org/wayland/compositor/shaders/surface.vert.qsb",
-        ":/qt-project.org/wayland/compositor/shaders/surface_y_xuxv.frag.qsb",
+        ":/qt-project.org/wayland/compositor/shaders/surface_yuv.vert",
+        ":/qt-project.org/wayland/compositor/shaders/surface_yuv.frag",
         2, false,
         QSGMaterial::Blending,
         {}
@@ -117,16 +119,158 @@ static const struct {
 
 QWaylandBufferMaterialShader::QWaylandBufferMaterialShader(QWaylandBufferRef::BufferFormatEgl format)
 {
-    Q_UNUSED(format);
-    setShaderFileName(VertexStage, QString::fromLatin1(bufferTypes[format].vertexShaderSourceFile));
+    auto vertexShaderSourceFile = QString::fromLatin1(bufferTypes[format].vertexShaderSourceFile);
     auto fragmentShaderSourceFile = QString::fromLatin1(bufferTypes[format].fragmentShaderSourceFile);
 
+    if (isYuvFormat(format)) {
+        setupYuvShader(vertexShaderSourceFile, fragmentShaderSourceFile, format);
+        return;
+    }
+
+    setShaderFileName(VertexStage, vertexShaderSourceFile);
     if (format == QWaylandBufferRef::BufferFormatEgl_EXTERNAL_OES)
         setupExternalOESShader(fragmentShaderSourceFile);
     else
         setShaderFileName(FragmentStage, fragmentShaderSourceFile);
 }
 
+bool QWaylandBufferMaterialShader::isYuvFormat(QWaylandBufferRef::BufferFormatEgl format)
+{
+    return format == QWaylandBufferRef::BufferFormatEgl_Y_U_V
+            || format == QWaylandBufferRef::BufferFormatEgl_Y_UV
+            || format == QWaylandBufferRef::BufferFormatEgl_Y_XUXV;
+}
+
+// The uniform block has to be declared identically in both stages for GLSL to link them,
+// which is why the YUV shaders come with their own vertex shader.
+void QWaylandBufferMaterialShader::setupYuvShader(const QString &vertexShaderFilename,
+                                                  const QString &fragmentShaderFilename,
+                                                  QWaylandBufferRef::BufferFormatEgl format)
+{
+#if QT_CONFIG(opengl)
+    QFile vertexShaderFile(vertexShaderFilename);
+    QFile fragmentShaderFile(fragmentShaderFilename);
+    if (!vertexShaderFile.open(QIODevice::ReadOnly) || !fragmentShaderFile.open(QIODevice::ReadOnly)) {
+        qCWarning(qLcWaylandCompositor) << "Cannot find YUV shader files:" << vertexShaderFilename
+                                        << fragmentShaderFilename;
+        return;
+    }
+    const int planeCount = bufferTypes[format].planeCount;
+    const QByteArray layout = format == QWaylandBufferRef::BufferFormatEgl_Y_U_V ? "#define Y_U_V\n"
+            : format == QWaylandBufferRef::BufferFormatEgl_Y_UV                 ? "#define Y_UV\n"
+                                                                                : "#define Y_XUXV\n";
+    const QByteArray VS = vertexShaderFile.readAll();
+    const QByteArray FS = layout + fragmentShaderFile.readAll();
+
+    static const char *VS_GLES_PREAMBLE = "";
+    static const char *VS_GL_PREAMBLE = "#version 120\n";
+    static const char *VS_GL_CORE_PREAMBLE =
+        "#version 150\n"
+        "#define attribute in\n"
+        "#define varying out\n";
+    static const char *FS_GLES_PREAMBLE =
+        "precision highp float;\n"
+        "#define fragColor gl_FragColor\n";
+    static const char *FS_GL_PREAMBLE =
+        "#version 120\n"
+        "#define fragColor gl_FragColor\n";
+    static const char *FS_GL_CORE_PREAMBLE =
+        "#version 150\n"
+        "#define varying in\n"
+        "#define texture2D texture\n"
+        "out vec4 fragColor;\n";
+
+    QShaderDescription::BlockVariable matrixBlockVar;
+    matrixBlockVar.name = "qt_Matrix";
+    matrixBlockVar.type = QShaderDescription::Mat4;
+    matrixBlockVar.offset = 0;
+    matrixBlockVar.size = 64;
+
+    QShaderDescription::BlockVariable opacityBlockVar;
+    opacityBlockVar.name = "qt_Opacity";
+    opacityBlockVar.type = QShaderDescription::Float;
+    opacityBlockVar.offset = 64;
+    opacityBlockVar.size = 4;
+
+    // std140 aligns the matrix to 16 bytes
+    QShaderDescription::BlockVariable yuvToRgbBlockVar;
+    yuvToRgbBlockVar.name = "yuvToRgb";
+    yuvToRgbBlockVar.type = QShaderDescription::Mat4;
+    yuvToRgbBlockVar.offset = yuvToRgbOffset;
+    yuvToRgbBlockVar.size = 64;
+
+    QShaderDescription::UniformBlock ubufStruct;
+    ubufStruct.blockName = "buf";
+    ubufStruct.structName = "ubuf";
+    ubufStruct.size = yuvToRgbOffset + 64;
+    ubufStruct.binding = 0;
+    ubufStruct.members = { matrixBlockVar, opacityBlockVar, yuvToRgbBlockVar };
+
+    QShaderDescription::InOutVariable texCoord;
+    texCoord.name = "v_texcoord";
+    texCoord.type = QShaderDescription::Vec2;
+    texCoord.location = 0;
+
+    QShaderDescription vertexDesc;
+    QShaderDescriptionPrivate *vertexDescData = QShaderDescriptionPrivate::get(&vertexDesc);
+
+    QShaderDescription::InOutVariable positionInput;
+    positionInput.name = "qt_VertexPosition";
+    positionInput.type = QShaderDescription::Vec2;
+    positionInput.location = 0;
+
+    QShaderDescription::InOutVariable texCoordInput;
+    texCoordInput.name = "qt_VertexTexCoord";
+    texCoordInput.type = QShaderDescription::Vec2;
+    texCoordInput.location = 1;
+
+    vertexDescData->inVars = { positionInput, texCoordInput };
+    vertexDescData->outVars = { texCoord };
+    vertexDescData->uniformBlocks = { ubufStruct };
+
+    QShaderDescription fragmentDesc;
+    QShaderDescriptionPrivate *fragmentDescData = QShaderDescriptionPrivate::get(&fragmentDesc);
+
+    QShaderDescription::InOutVariable fragColorOutput;
+    fragColorOutput.name = "fragColor";
+    fragColorOutput.type = QShaderDescription::Vec4;
+    fragColorOutput.location = 0;
+
+    fragmentDescData->inVars = { texCoord };
+    fragmentDescData->outVars = { fragColorOutput };
+    fragmentDescData->uniformBlocks = { ubufStruct };
+
+    for (int plane = 0; plane < planeCount; ++plane) {
+        QShaderDescription::InOutVariable sampler;
+        sampler.name = "tex" + QByteArray::number(plane);
+        sampler.type = QShaderDescription::Sampler2D;
+        sampler.binding = plane + 1;
+        fragmentDescData->combinedImageSamplers.append(sampler);
+    }
+
+    QShader vertexShaderPack;
+    vertexShaderPack.setStage(QShader::VertexStage);
+    vertexShaderPack.setDescription(vertexDesc);
+    vertexShaderPack.setShader(QShaderKey(QShader::GlslShader, QShaderVersion(100, QShaderVersion::GlslEs)), QShaderCode(VS_GLES_PREAMBLE + VS));
+    vertexShaderPack.setShader(QShaderKey(QShader::GlslShader, QShaderVersion(120)), QShaderCode(VS_GL_PREAMBLE + VS));
+    vertexShaderPack.setShader(QShaderKey(QShader::GlslShader, QShaderVersion(150)), QShaderCode(VS_GL_CORE_PREAMBLE + VS));
+
+    QShader fragmentShaderPack;
+    fragmentShaderPack.setStage(QShader::FragmentStage);
+    fragmentShaderPack.setDescription(fragmentDesc);
+    fragmentShaderPack.setShader(QShaderKey(QShader::GlslShader, QShaderVersion(100, QShaderVersion::GlslEs)), QShaderCode(FS_GLES_PREAMBLE + FS));
+    fragmentShaderPack.setShader(QShaderKey(QShader::GlslShader, QShaderVersion(120)), QShaderCode(FS_GL_PREAMBLE + FS));
+    fragmentShaderPack.setShader(QShaderKey(QShader::GlslShader, QShaderVersion(150)), QShaderCode(FS_GL_CORE_PREAMBLE + FS));
+
+    setShader(VertexStage, vertexShaderPack);
+    setShader(FragmentStage, fragmentShaderPack);
+#else
+    Q_UNUSED(vertexShaderFilename);
+    Q_UNUSED(fragmentShaderFilename);
+    Q_UNUSED(format);
+#endif
+}
+
 void QWaylandBufferMaterialShader::setupExternalOESShader(const QString &shaderFilename)
 {
 #if QT_CONFIG(opengl)
@@ -203,7 +347,8 @@ void QWaylandBufferMaterialShader::setupExternalOESShader(const QString &shaderF
 #endif
 }
 
-bool QWaylandBufferMaterialShader::updateUniformData(RenderState &state, QSGMaterial *, QSGMaterial *)
+bool QWaylandBufferMaterialShader::updateUniformData(RenderState &state, QSGMaterial *newMaterial,
+                                                     QSGMaterial *oldMaterial)
 {
     bool changed = false;
     QByteArray *buf = state.uniformData();
@@ -221,6 +366,19 @@ bool QWaylandBufferMaterialShader::updateUniformData(RenderState &state, QSGMate
         changed = true;
     }
 
+    // Materials of all color spaces share the shader, the conversion is only uploaded when it
+    // differs from the one of the previous material
+    auto *material = static_cast<QWaylandBufferMaterial *>(newMaterial);
+    if (isYuvFormat(material->m_format)) {
+        Q_ASSERT(buf->size() >= yuvToRgbOffset + 64);
+        auto *previous = static_cast<QWaylandBufferMaterial *>(oldMaterial);
+        if (!previous || previous->m_yuvConversion != material->m_yuvConversion) {
+            const QMatrix4x4 m = material->m_yuvConversion.toRgb();
+            memcpy(buf->data() + yuvToRgbOffset, m.constData(), 64);
+            changed = true;
+        }
+    }
+
     return changed;
 }
 
@@ -339,6 +497,8 @@ void QWaylandBufferMaterial::ensureTextures(int count)
 void QWaylandBufferMaterial::setBufferRef(QWaylandQuickItem *surfaceItem, const QWaylandBufferRef &ref)
 {
     m_bufferRef = ref;
+    if (QWaylandSurface *surface = surfaceItem->surface())
+        m_yuvConversion = QWaylandSurfacePrivate::get(surface)->yuvConversion;
     for (int plane = 0; plane < bufferTypes[ref.bufferFormatEgl()].planeCount; plane++) {
         if (auto texture = ref.toOpenGLTexture(plane)) {
             QQuickWindow::CreateTextureOptions opt;
@@ -368,6 +528,27 @@ void QWaylandBufferMaterial::setBufferRef(QWaylandQuickItem *surfaceItem, const
 
 QMutex *QWaylandQuickItemPrivate::mutex = nullptr;
 
+static QImage::Format formatWithoutAlpha(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return QImage::Format_RGB32;
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        return QImage::Format_RGBX8888;
+    case QImage::Format_A2BGR30_Premultiplied:
+        return QImage::Format_BGR30;
+    case QImage::Format_A2RGB30_Premultiplied:
+        return QImage::Format_RGB30;
+    case QImage::Format_RGBA64:
+    case QImage::Format_RGBA64_Premultiplied:
+        return QImage::Format_RGBX64;
+    default:
+        return format;
+    }
+}
+
 class QWaylandSurfaceTextureProvider : public QSGTextureProvider
 {
 public:
@@ -388,7 +569,12 @@ public:
         m_sgTex = nullptr;
         if (m_ref.hasBuffer()) {
             if (buffer.isSharedMemory()) {
-                m_sgTex = surfaceItem->window()->createTextureFromImage(buffer.image());
+                QImage image = buffer.image();
+                // Let the renderer treat surfaces that declare themselves opaque as such, so
+                // they go in the opaque pass instead of being blended.
+                if (surfaceItem->surface() && surfaceItem->surface()->isOpaque())
+                    image.reinterpretAsFormat(formatWithoutAlpha(image.format()));
+                m_sgTex = surfaceItem->window()->createTextureFromImage(image);
             } else {
 #if QT_CONFIG(opengl)
                 QQuickWindow::CreateTextureOptions opt;
@@ -501,6 +687,8 @@ QWaylandQuickItem::~QWaylandQuickItem()
     Q_D(QWaylandQuickItem);
     disconnect(this, &QQuickItem::windowChanged, this, &QWaylandQuickItem::updateWindow);
     disconnect(this, &QQuickItem::activeFocusChanged, this, &QWaylandQuickItem::updateFocus);
+    disconnect(d->afterRenderingConnection);
+    d->releaseRenderedBuffer();
     QMutexLocker locker(d->mutex);
     if (d->provider) {
         disconnect(d->texProviderConnection);
@@ -718,7 +906,9 @@ void QWaylandQuickItem::hoverLeaveEvent(QHoverEvent *event)
     Q_D(QWaylandQuickItem);
     if (d->shouldSendInputEvents()) {
         QWaylandSeat *seat = compositor()->seatFor(event);
-        seat->setMouseFocus(nullptr);
+        // A locked or confined pointer stays with its surface
+        if (!seat->pointer() || !QWaylandPointerPrivate::get(seat->pointer())->activeConstraint())
+            seat->setMouseFocus(nullptr);
     } else {
         event->ignore();
     }
@@ -738,11 +928,7 @@ void QWaylandQuickItem::wheelEvent(QWheelEvent *event)
         }
 
         QWaylandSeat *seat = compositor()->seatFor(event);
-        // TODO: fix this to send a single event, when diagonal scrolling is supported
-        if (event->angleDelta().x() != 0)
-            seat->sendMouseWheelEvent(Qt::Horizontal, event->angleDelta().x());
-        if (event->angleDelta().y() != 0)
-            seat->sendMouseWheelEvent(Qt::Vertical, event->angleDelta().y());
+        seat->sendFullWheelEvent(event);
     } else {
         event->ignore();
     }
@@ -1065,8 +1251,7 @@ void QWaylandQuickItem::handleSurfaceChanged()
         disconnect(d->oldSurface.data(), &QWaylandSurface::configure, this, &QWaylandQuickItem::updateBuffer);
         disconnect(d->oldSurface.data(), &QWaylandSurface::redraw, this, &QQuickItem::update);
         disconnect(d->oldSurface.data(), &QWaylandSurface::childAdded, this, &QWaylandQuickItem::handleSubsurfaceAdded);
-        disconnect(d->oldSurface.data(), &QWaylandSurface::subsurfacePlaceAbove, this, &QWaylandQuickItem::handlePlaceAbove);
-        disconnect(d->oldSurface.data(), &QWaylandSurface::subsurfacePlaceBelow, this, &QWaylandQuickItem::handlePlaceBelow);
+        disconnect(d->subsurfaceStackConnection);
 #if QT_CONFIG(draganddrop)
         disconnect(d->oldSurface.data(), &QWaylandSurface::dragStarted, this, &QWaylandQuickItem::handleDragStarted);
 #endif
@@ -1082,8 +1267,10 @@ void QWaylandQuickItem::handleSurfaceChanged()
         connect(newSurface, &QWaylandSurface::configure, this, &QWaylandQuickItem::updateBuffer);
         connect(newSurface, &QWaylandSurface::redraw, this, &QQuickItem::update);
         connect(newSurface, &QWaylandSurface::childAdded, this, &QWaylandQuickItem::handleSubsurfaceAdded);
-        connect(newSurface, &QWaylandSurface::subsurfacePlaceAbove, this, &QWaylandQuickItem::handlePlaceAbove);
-        connect(newSurface, &QWaylandSurface::subsurfacePlaceBelow, this, &QWaylandQuickItem::handlePlaceBelow);
+        // Restacking the items of subsurfaces is done by their parent, once per commit
+        d->subsurfaceStackConnection = connect(newSurface, &QWaylandSurface::redraw, this, [d] {
+            d->updateSubsurfaceStacking();
+        });
 #if QT_CONFIG(draganddrop)
         connect(newSurface, &QWaylandSurface::dragStarted, this, &QWaylandQuickItem::handleDragStarted);
 #endif
@@ -1103,6 +1290,8 @@ void QWaylandQuickItem::handleSurfaceChanged()
             if (!subsurface.isNull())
                 handleSubsurfaceAdded(subsurface.data());
         }
+        d->subsurfaceStackSerial = QWaylandSurfacePrivate::get(newSurface)->subsurfaceStackSerial - 1;
+        d->updateSubsurfaceStacking();
 
         updateSize();
     }
@@ -1385,13 +1574,20 @@ void QWaylandQuickItem::updateWindow()
     if (d->connectedWindow) {
         disconnect(d->connectedWindow, &QQuickWindow::beforeSynchronizing, this, &QWaylandQuickItem::beforeSync);
         disconnect(d->connectedWindow, &QQuickWindow::screenChanged, this, &QWaylandQuickItem::updateSize);
+        disconnect(d->afterRenderingConnection);
     }
 
     d->connectedWindow = newWindow;
+    // Only known again once the output of the new window has looked at the stacking order
+    d->occluded = false;
 
     if (d->connectedWindow) {
         connect(d->connectedWindow, &QQuickWindow::beforeSynchronizing, this, &QWaylandQuickItem::beforeSync, Qt::DirectConnection);
         connect(d->connectedWindow, &QQuickWindow::screenChanged, this, &QWaylandQuickItem::updateSize); // new screen may have new dpr
+        d->afterRenderingConnection = connect(d->connectedWindow, &QQuickWindow::afterRendering, this,
+                                              [renderedBuffer = d->renderedBuffer] {
+            renderedBuffer->createFence();
+        }, Qt::DirectConnection);
 
         if (compositor()) {
             QWaylandOutput *output = compositor()->outputFor(d->connectedWindow);
@@ -1475,21 +1671,30 @@ QSGNode *QWaylandQuickItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeDat
     if (d->view->isBufferLocked() && d->paintEnabled)
         return oldNode;
 
-    if (!bufferHasContent || !d->paintEnabled || !surface()) {
+    // Occluded items get their node back, with a fresh texture, once they are uncovered
+    if (!bufferHasContent || !d->paintEnabled || !surface() || d->occluded) {
+        d->syncRenderedBuffer(QWaylandBufferRef());
         delete oldNode;
         return nullptr;
     }
 
     QWaylandBufferRef ref = d->view->currentBuffer();
+    d->syncRenderedBuffer(ref);
     const bool invertY = ref.origin() == QWaylandSurface::OriginBottomLeft;
     const QRectF rect = invertY ? QRectF(0, height(), width(), -height())
                                 : QRectF(0, 0, width(), height());
 
-    if (ref.isSharedMemory()
+    bool paintByProvider = ref.isSharedMemory();
 #if QT_CONFIG(opengl)
-            || bufferTypes[ref.bufferFormatEgl()].canProvideTexture
+    if (!ref.isSharedMemory()) {
+        paintByProvider = bufferTypes[ref.bufferFormatEgl()].canProvideTexture;
+    } else if (ref.bufferFormatEgl() != QWaylandBufferRef::BufferFormatEgl_Null) {
+        // YUV shared memory buffers are converted by the materials when rendering with OpenGL
+        paintByProvider = window()->rendererInterface()->graphicsApi() != QSGRendererInterface::OpenGL;
+    }
 #endif
-    ) {
+
+    if (paintByProvider) {
 #if QT_CONFIG(opengl)
         if (oldNode && !d->paintByProvider) {
             // Need to re-create a node
@@ -1701,6 +1906,84 @@ qreal QWaylandQuickItemPrivate::scaleFactor() const
     return f;
 }
 
+/*
+    Brings the items of the subsurfaces of this item's surface into the stacking order the
+    surface committed, in one pass over the children instead of one search per request.
+*/
+void QWaylandQuickItemPrivate::updateSubsurfaceStacking()
+{
+    Q_Q(QWaylandQuickItem);
+    QWaylandSurface *surface = view->surface();
+    if (!surface)
+        return;
+
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(surface);
+    if (surfacePrivate->subsurfaceStackSerial == subsurfaceStackSerial)
+        return;
+    subsurfaceStackSerial = surfacePrivate->subsurfaceStackSerial;
+
+    QHash<QWaylandSurface *, QWaylandQuickItem *> items;
+    const auto children = q->childItems();
+    for (auto *child : children) {
+        auto *waylandItem = qobject_cast<QWaylandQuickItem *>(child);
+        if (waylandItem && waylandItem->surface())
+            items.insert(waylandItem->surface(), waylandItem);
+    }
+    if (items.isEmpty())
+        return;
+
+    QQuickItem *previous = nullptr;
+    bool below = true;
+    for (QWaylandSurfacePrivate *entry : std::as_const(surfacePrivate->subsurfaceStack)) {
+        if (entry == surfacePrivate) {
+            below = false;
+            continue;
+        }
+        QWaylandQuickItem *item = items.value(entry->q_func());
+        if (!item)
+            continue;
+        item->d_func()->belowParent = below;
+        item->setZ(below ? q->z() - 1.0 : q->z());
+        if (previous)
+            item->stackAfter(previous);
+        previous = item;
+    }
+}
+
+/*
+    Explicit synchronization: a client which asked for a release of its buffer gets a fence
+    for the last frame that sampled it. The fence is made right after each frame, and handed to
+    the buffer at the next sync, before switching to a new buffer can release the old one.
+*/
+void QWaylandQuickItemPrivate::syncRenderedBuffer(const QWaylandBufferRef &ref)
+{
+    QMutexLocker locker(&renderedBuffer->mutex);
+    QtWayland::SyncFence fence = std::move(renderedBuffer->fence);
+    if (auto *buffer = renderedBuffer->buffer.buffer(); buffer && fence.isValid())
+        buffer->setReleaseFence(std::move(fence));
+
+    // Shared memory is copied into textures, the client can reuse it right away
+    renderedBuffer->buffer = ref.isSharedMemory() ? QWaylandBufferRef() : ref;
+    renderedBuffer->wantsFence = renderedBuffer->buffer.buffer() && renderedBuffer->buffer.buffer()->wantsReleaseFence();
+}
+
+// Drops the buffer on the GUI thread, a frame still being rendered makes no fence for it
+void QWaylandQuickItemPrivate::releaseRenderedBuffer()
+{
+    QMutexLocker locker(&renderedBuffer->mutex);
+    renderedBuffer->buffer = QWaylandBufferRef();
+    renderedBuffer->fence = QtWayland::SyncFence();
+    renderedBuffer->wantsFence = false;
+}
+
+// Called on the render thread, with the context of the window current
+void QWaylandQuickItemPrivate::RenderedBuffer::createFence()
+{
+    QMutexLocker locker(&mutex);
+    if (wantsFence)
+        fence = buffer.buffer()->createReleaseFence();
+}
+
 QWaylandQuickItem *QWaylandQuickItemPrivate::findSibling(QWaylandSurface *surface) const
 {
     Q_Q(const QWaylandQuickItem);
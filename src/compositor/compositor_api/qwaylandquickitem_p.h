@@ -21,8 +21,12 @@
 
 #include <QtWaylandCompositor/QWaylandQuickItem>
 #include <QtWaylandCompositor/QWaylandOutput>
+#include <QtWaylandCompositor/private/qwaylandsurface_p.h>
 
 #include <QtCore/qpointer.h>
+#include <QtCore/QMutex>
+
+#include <memory>
 
 QT_BEGIN_NAMESPACE
 
@@ -41,6 +45,12 @@ public:
     void updateSampledImage(RenderState &state, int binding, QSGTexture **texture,
                             QSGMaterial *newMaterial, QSGMaterial *oldMaterial) override;
     void setupExternalOESShader(const QString &shaderFilename);
+    void setupYuvShader(const QString &vertexShaderFilename, const QString &fragmentShaderFilename,
+                        QWaylandBufferRef::BufferFormatEgl format);
+
+    static bool isYuvFormat(QWaylandBufferRef::BufferFormatEgl format);
+
+    static constexpr int yuvToRgbOffset = 80;
 };
 
 class QWaylandBufferMaterial : public QSGMaterial
@@ -68,6 +78,7 @@ private:
     QVarLengthArray<QOpenGLTexture*, 3> m_textures;
     QVarLengthArray<QSGTexture*, 3> m_scenegraphTextures;
     QWaylandBufferRef m_bufferRef;
+    QWaylandYuvConversion m_yuvConversion;
 };
 #endif // QT_CONFIG(opengl)
 
@@ -124,6 +135,9 @@ public:
     bool shouldSendInputEvents() const { return view->surface() && inputEventsEnabled; }
     qreal scaleFactor() const;
 
+    void updateSubsurfaceStacking();
+    void syncRenderedBuffer(const QWaylandBufferRef &ref);
+    void releaseRenderedBuffer();
     QWaylandQuickItem *findSibling(QWaylandSurface *surface) const;
     void placeAboveSibling(QWaylandQuickItem *sibling);
     void placeBelowSibling(QWaylandQuickItem *sibling);
@@ -139,6 +153,9 @@ public:
     QPointer<QWaylandSurface> oldSurface;
     mutable QWaylandSurfaceTextureProvider *provider = nullptr;
     QMetaObject::Connection texProviderConnection;
+    QMetaObject::Connection subsurfaceStackConnection;
+    QMetaObject::Connection afterRenderingConnection;
+    uint subsurfaceStackSerial = 0;
     bool paintEnabled = true;
     bool touchEventsEnabled = true;
     bool inputEventsEnabled = true;
@@ -146,12 +163,27 @@ public:
     bool newTexture = false;
     bool focusOnClick = true;
     bool belowParent = false;
+    // Completely covered by opaque surfaces in front of it, see QWaylandQuickOutput
+    bool occluded = false;
 #if QT_CONFIG(opengl)
     bool paintByProvider = false;
 #endif
     QPointF hoverPos;
     QMatrix4x4 lastMatrix;
 
+    // The buffer drawn by the frames since the last sync, and a fence for the last of them.
+    // Shared with the render thread, which makes the fence after each frame, also while the
+    // item is being destroyed on the GUI thread.
+    struct RenderedBuffer {
+        QMutex mutex;
+        QWaylandBufferRef buffer;
+        QtWayland::SyncFence fence;
+        bool wantsFence = false;
+
+        void createFence();
+    };
+    std::shared_ptr<RenderedBuffer> renderedBuffer = std::make_shared<RenderedBuffer>();
+
     QQuickWindow *connectedWindow = nullptr;
     QWaylandOutput *connectedOutput = nullptr;
     QWaylandSurface::Origin origin = QWaylandSurface::OriginTopLeft;
@@ -6,8 +6,16 @@
 #include "qwaylandquickcompositor.h"
 #include "qwaylandquickitem_p.h"
 
+#include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+
+#include <QtQuick/private/qquickwindow_p.h>
+
+#include <QtCore/qmath.h>
+
 QT_BEGIN_NAMESPACE
 
+static void updateWindowOcclusion(QQuickWindow *window);
+
 QWaylandQuickOutput::QWaylandQuickOutput()
 {
 }
@@ -32,6 +40,13 @@ void QWaylandQuickOutput::initialize()
 
     connect(quickWindow, &QQuickWindow::afterRendering,
             this, &QWaylandQuickOutput::doFrameCallbacks);
+
+    // Emitted on the GUI thread after polishing, right before the scene graph is synchronized
+    if (!qEnvironmentVariableIsSet("QT_WAYLAND_COMPOSITOR_NO_OCCLUSION_CULLING")) {
+        connect(quickWindow, &QQuickWindow::afterAnimating, this, [quickWindow] {
+            updateWindowOcclusion(quickWindow);
+        });
+    }
 }
 
 void QWaylandQuickOutput::classBegin()
@@ -119,6 +134,103 @@ QQuickItem *QWaylandQuickOutput::pickClickableItem(const QPointF &position)
     return clickableItemAtPosition(quickWindow->contentItem(), position);
 }
 
+static QRect innerAlignedRect(const QRectF &rect)
+{
+    const int left = qCeil(rect.left());
+    const int top = qCeil(rect.top());
+    const int right = qFloor(rect.right());
+    const int bottom = qFloor(rect.bottom());
+    if (right <= left || bottom <= top)
+        return QRect();
+    return QRect(left, top, right - left, bottom - top);
+}
+
+static void updateItemOcclusion(QWaylandQuickItem *item, QRegion *covered, const QRectF &clip,
+                                bool canOcclude, bool canBeCulled)
+{
+    auto *d = static_cast<QWaylandQuickItemPrivate *>(QQuickItemPrivate::get(item));
+
+    const QRect visibleRect = item->mapRectToScene(item->boundingRect()).intersected(clip).toAlignedRect();
+    const bool occluded = canBeCulled && (QRegion(visibleRect) - *covered).isEmpty();
+    if (occluded != d->occluded) {
+        d->occluded = occluded;
+        item->update();
+    }
+
+    // An occluded item has nothing to add to the covered area
+    if (!canOcclude || occluded || !d->paintEnabled || d->view->isBufferLocked())
+        return;
+
+    QWaylandSurface *surface = item->surface();
+    if (!surface || !surface->hasContent())
+        return;
+
+    const QRegion &opaqueRegion = QWaylandSurfacePrivate::get(surface)->opaqueRegion;
+    const QSize size = surface->destinationSize();
+    if (opaqueRegion.isEmpty() || size.isEmpty())
+        return;
+
+    const qreal sx = item->width() / size.width();
+    const qreal sy = item->height() / size.height();
+    for (const QRect &rect : opaqueRegion) {
+        const QRectF itemRect(rect.x() * sx, rect.y() * sy, rect.width() * sx, rect.height() * sy);
+        *covered += innerAlignedRect(item->mapRectToScene(itemRect).intersected(clip));
+    }
+}
+
+/*
+ * Walks the items front to back, accumulating the part of the scene that is covered by
+ * opaque surfaces. Items that are not surfaces never occlude anything.
+ */
+static void updateOcclusion(QQuickItem *item, QRegion *covered, QRectF clip,
+                            bool canOcclude, bool canBeCulled)
+{
+    if (!item->isVisible())
+        return;
+
+    QQuickItemPrivate *d = QQuickItemPrivate::get(item);
+    // Content that is also rendered offscreen, by a layer or a ShaderEffectSource, can end up
+    // anywhere in the scene, so it neither occludes nor gets culled.
+    if (d->extra.isAllocated()
+        && (d->extra->effectRefCount > 0 || (d->extra->layer && d->extra->layer->enabled()))) {
+        canOcclude = false;
+        canBeCulled = false;
+    }
+    if (item->opacity() < 1.0 || d->itemToWindowTransform().type() > QTransform::TxScale)
+        canOcclude = false;
+    if (item->clip())
+        clip = clip.intersected(item->mapRectToScene(item->clipRect()));
+
+    const QList<QQuickItem *> paintOrderItems = d->paintOrderChildItems();
+    auto it = paintOrderItems.crbegin();
+    for (; it != paintOrderItems.crend() && (*it)->z() >= 0; ++it)
+        updateOcclusion(*it, covered, clip, canOcclude, canBeCulled);
+
+    if (auto *waylandItem = qobject_cast<QWaylandQuickItem *>(item))
+        updateItemOcclusion(waylandItem, covered, clip, canOcclude, canBeCulled);
+
+    for (; it != paintOrderItems.crend(); ++it)
+        updateOcclusion(*it, covered, clip, canOcclude, canBeCulled);
+}
+
+/*
+ * Hides the items that are completely covered by opaque surfaces stacked in front of
+ * them, so that e.g. a stack of maximized windows only draws the topmost one. Partially
+ * covered items are drawn in full. Set QT_WAYLAND_COMPOSITOR_NO_OCCLUSION_CULLING to
+ * disable this.
+ *
+ * Anything that can change the result, surface commits included, marks items dirty, so
+ * the scene is only walked when some item is.
+ */
+static void updateWindowOcclusion(QQuickWindow *window)
+{
+    if (!QQuickWindowPrivate::get(window)->dirtyItemList)
+        return;
+
+    QRegion covered;
+    updateOcclusion(window->contentItem(), &covered, QRectF(QPointF(), window->size()), true, true);
+}
+
 /*!
  * \internal
  */
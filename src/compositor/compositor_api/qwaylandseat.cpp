@@ -16,6 +16,7 @@
 #include <QtWaylandCompositor/private/qwaylandseat_p.h>
 #include <QtWaylandCompositor/private/qwaylandcompositor_p.h>
 #include <QtWaylandCompositor/private/qwaylandkeyboard_p.h>
+#include <QtWaylandCompositor/private/qwaylandpointer_p.h>
 #if QT_CONFIG(wayland_datadevice)
 #include <QtWaylandCompositor/private/qwldatadevice_p.h>
 #endif
@@ -80,6 +81,11 @@ void QWaylandSeatPrivate::clientRequestedDataDevice(QtWayland::DataDeviceManager
 }
 #endif
 
+void QWaylandSeatPrivate::seat_release(wl_seat::Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
 void QWaylandSeatPrivate::seat_destroy_resource(wl_seat::Resource *)
 {
 //    cleanupDataDeviceForClient(resource->client(), true);
@@ -182,7 +188,8 @@ QWaylandSeat::~QWaylandSeat()
 void QWaylandSeat::initialize()
 {
     Q_D(QWaylandSeat);
-    d->init(d->compositor->display(), 4);
+    // Version 8 for wl_pointer.frame, axis_source and axis_value120
+    d->init(d->compositor->display(), 8);
 
     if (d->capabilities & QWaylandSeat::Pointer)
         d->pointer.reset(QWaylandCompositorPrivate::get(d->compositor)->callCreatePointerDevice(this));
@@ -434,6 +441,28 @@ void QWaylandSeat::sendFullTouchEvent(QWaylandSurface *surface, QTouchEvent *eve
     d->touch->sendFullTouchEvent(surface, event);
 }
 
+#if QT_CONFIG(wheelevent)
+/*!
+ * \since 6.10
+ *
+ * Sends the wheel \a event to the view that currently holds mouse focus.
+ *
+ * Unlike sendMouseWheelEvent(), this preserves the pixel deltas and scroll phase of
+ * touchpads and the high-resolution steps of wheels, and sends both orientations in
+ * a single pointer frame.
+ *
+ * \sa QWaylandPointer::sendWheelEvent()
+ */
+void QWaylandSeat::sendFullWheelEvent(QWheelEvent *event)
+{
+    Q_D(QWaylandSeat);
+    if (!d->pointer)
+        return;
+
+    d->pointer->sendWheelEvent(event);
+}
+#endif
+
 /*!
  * Sends the \a event to the keyboard device.
  *
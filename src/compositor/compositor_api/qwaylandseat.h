@@ -20,6 +20,7 @@ class QWaylandCompositor;
 class QWaylandSurface;
 class QKeyEvent;
 class QTouchEvent;
+class QWheelEvent;
 class QInputEvent;
 class QWaylandSeatPrivate;
 class QWaylandDrag;
@@ -64,6 +65,9 @@ public:
     void sendMouseReleaseEvent(Qt::MouseButton button);
     void sendMouseMoveEvent(QWaylandView *surface , const QPointF &localPos, const QPointF &outputSpacePos = QPointF());
     void sendMouseWheelEvent(Qt::Orientation orientation, int delta);
+#if QT_CONFIG(wheelevent)
+    void sendFullWheelEvent(QWheelEvent *event);
+#endif
 
     void sendKeyPressEvent(uint code);
     void sendKeyReleaseEvent(uint code);
@@ -75,6 +75,7 @@ protected:
     void seat_get_touch(wl_seat::Resource *resource,
                         uint32_t id) override;
 
+    void seat_release(wl_seat::Resource *resource) override;
     void seat_destroy_resource(wl_seat::Resource *resource) override;
 
 private:
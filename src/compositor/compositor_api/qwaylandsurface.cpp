@@ -24,6 +24,10 @@
 #include <QtWaylandCompositor/private/qwaylandview_p.h>
 #include <QtWaylandCompositor/private/qwaylandseat_p.h>
 #include <QtWaylandCompositor/private/qwaylandutils_p.h>
+#include "qwaylandlatencytrace_p.h"
+#if QT_CONFIG(opengl)
+#include "hardware_integration/qwltexturerecycler_p.h"
+#endif
 
 #include <QtCore/private/qobject_p.h>
 
@@ -31,6 +35,8 @@
 #include <QtGui/QScreen>
 
 #include <QtCore/QDebug>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QVarLengthArray>
 #include <QtCore/QtMath>
 
 QT_BEGIN_NAMESPACE
@@ -76,6 +82,37 @@ static QRegion infiniteRegion() {
                          QPoint(std::numeric_limits<int>::max(), std::numeric_limits<int>::max())));
 }
 
+QMatrix4x4 QWaylandYuvConversion::toRgb() const
+{
+    float kr = 0.299f;
+    float kb = 0.114f;
+    if (matrix == Bt709) {
+        kr = 0.2126f;
+        kb = 0.0722f;
+    } else if (matrix == Bt2020) {
+        kr = 0.2627f;
+        kb = 0.0593f;
+    }
+    const float kg = 1.0f - kr - kb;
+
+    // Luma and chroma are first brought to [0, 1] and [-0.5, 0.5], limited range spans 16-235
+    // and 16-240 of the 8-bit values
+    const float lumaScale = fullRange ? 1.0f : 255.0f / 219.0f;
+    const float lumaOffset = fullRange ? 0.0f : -16.0f / 219.0f;
+    const float chromaScale = fullRange ? 1.0f : 255.0f / 224.0f;
+    const float chromaOffset = fullRange ? -128.0f / 255.0f : -128.0f / 224.0f;
+
+    const float rv = 2.0f * (1.0f - kr);
+    const float gu = 2.0f * kb * (1.0f - kb) / kg;
+    const float gv = 2.0f * kr * (1.0f - kr) / kg;
+    const float bu = 2.0f * (1.0f - kb);
+
+    return QMatrix4x4(lumaScale, 0.0f, rv * chromaScale, lumaOffset + rv * chromaOffset,
+                      lumaScale, -gu * chromaScale, -gv * chromaScale, lumaOffset - (gu + gv) * chromaOffset,
+                      lumaScale, bu * chromaScale, 0.0f, lumaOffset + bu * chromaOffset,
+                      0.0f, 0.0f, 0.0f, 1.0f);
+}
+
 #ifndef QT_NO_DEBUG
 QList<QWaylandSurfacePrivate *> QWaylandSurfacePrivate::uninitializedSurfaces;
 #endif
@@ -100,6 +137,7 @@ QWaylandSurfacePrivate::~QWaylandSurfacePrivate()
     views.clear();
 
     bufferRef = QWaylandBufferRef();
+    discardDeferredCommits();
 
     for (QtWayland::FrameCallback *c : std::as_const(pendingFrameCallbacks))
         c->destroy();
@@ -111,6 +149,8 @@ void QWaylandSurfacePrivate::removeFrameCallback(QtWayland::FrameCallback *callb
 {
     pendingFrameCallbacks.removeOne(callback);
     frameCallbacks.removeOne(callback);
+    for (DeferredCommit &commit : deferredCommits)
+        commit.frameCallbacks.removeOne(callback);
 }
 
 void QWaylandSurfacePrivate::notifyViewsAboutDestruction()
@@ -126,6 +166,32 @@ void QWaylandSurfacePrivate::notifyViewsAboutDestruction()
     }
 }
 
+void QWaylandSurfacePrivate::traceInputSent(quint64 flow)
+{
+    // Bounded in case the client never commits, e.g. while it's hung
+    if (tracedInputFlows.size() >= 64)
+        tracedInputFlows.removeFirst();
+    tracedInputFlows.append(flow);
+}
+
+void QWaylandSurfacePrivate::tracePresented()
+{
+    if (committedInputFlows.isEmpty())
+        return;
+    QWaylandLatencyTrace::Slice traceSlice("present");
+    traceSlice.addFlows(committedInputFlows, QWaylandLatencyTrace::FlowEnd);
+    committedInputFlows.clear();
+}
+
+#if QT_CONFIG(opengl)
+qint64 QWaylandSurfacePrivate::textureMemory() const
+{
+    if (!bufferRef.hasBuffer())
+        return 0;
+    return QtWayland::QWaylandTextureRecycler::bufferMemory(bufferRef.wl_buffer());
+}
+#endif
+
 #ifndef QT_NO_DEBUG
 void QWaylandSurfacePrivate::addUninitializedSurface(QWaylandSurfacePrivate *surface)
 {
@@ -151,6 +217,20 @@ void QWaylandSurfacePrivate::surface_destroy_resource(Resource *)
 {
     Q_Q(QWaylandSurface);
     notifyViewsAboutDestruction();
+    discardDeferredCommits();
+
+    // The wl_subsurface of this surface and those of its children stay around, but inert
+    if (subsurface)
+        detachSubsurface();
+    const auto stack = std::exchange(subsurfaceStack, {});
+    pendingSubsurfaceStack.clear();
+    subsurfaceChildren.clear();
+    for (QWaylandSurfacePrivate *child : stack) {
+        if (child != this) {
+            child->subsurface->parentSurface = nullptr;
+            emit child->q_func()->parentChanged(nullptr, q);
+        }
+    }
 
     destroyed = true;
     emit q->surfaceDestroyed();
@@ -206,7 +286,32 @@ void QWaylandSurfacePrivate::surface_set_input_region(Resource *, struct wl_reso
     }
 }
 
-void QWaylandSurfacePrivate::surface_commit(Resource *)
+void QWaylandSurfacePrivate::surface_commit(Resource *resource)
+{
+    QWaylandLatencyTrace::Slice traceSlice("wl_surface.commit");
+    if (!tracedInputFlows.isEmpty()) {
+        traceSlice.addFlows(tracedInputFlows, QWaylandLatencyTrace::FlowStep);
+        committedInputFlows += tracedInputFlows;
+        tracedInputFlows.clear();
+    }
+
+    QtWayland::SyncFence acquireFence;
+    if (synchronization)
+        acquireFence = synchronization->applyState(pending.newlyAttached ? pending.buffer.buffer() : nullptr);
+
+    if (!deferredCommits.empty() || !acquireFence.isSignaled()) {
+        if (deferredCommits.size() >= MaxDeferredCommits) {
+            wl_resource_post_no_memory(resource->handle);
+            return;
+        }
+        deferCommit(std::move(acquireFence));
+        return;
+    }
+
+    applyCommit();
+}
+
+void QWaylandSurfacePrivate::applyCommit()
 {
     Q_Q(QWaylandSurface);
 
@@ -216,11 +321,14 @@ void QWaylandSurfacePrivate::surface_commit(Resource *)
     QSize oldDestinationSize = destinationSize;
     bool oldHasContent = hasContent;
     int oldBufferScale = bufferScale;
+    QColorSpace oldColorSpace = colorSpace;
 
     // Update all internal state
     if (pending.buffer.hasBuffer() || pending.newlyAttached)
         bufferRef = pending.buffer;
     bufferScale = pending.bufferScale;
+    colorSpace = pending.colorSpace;
+    yuvConversion = pending.yuvConversion;
     bufferSize = bufferRef.size();
     QSize surfaceSize = bufferSize / bufferScale;
     sourceGeometry = !pending.sourceGeometry.isValid() ? QRect(QPoint(), surfaceSize) : pending.sourceGeometry;
@@ -269,8 +377,10 @@ void QWaylandSurfacePrivate::surface_commit(Resource *)
     pendingFrameCallbacks.clear();
 
     // Notify buffers and views
-    if (auto *buffer = bufferRef.buffer())
+    if (auto *buffer = bufferRef.buffer()) {
+        buffer->setYuvConversion(yuvConversion);
         buffer->setCommitted(damage);
+    }
     for (auto *view : std::as_const(views))
         view->bufferCommitted(bufferRef, damage);
 
@@ -278,6 +388,8 @@ void QWaylandSurfacePrivate::surface_commit(Resource *)
     // i.e. we won't have inconsistensies such as mismatched surface size and buffer scale in
     // signal handlers.
 
+    applySubsurfaceState();
+
     emit q->damaged(damage);
 
     if (oldBufferSize != bufferSize)
@@ -295,12 +407,109 @@ void QWaylandSurfacePrivate::surface_commit(Resource *)
     if (oldHasContent != hasContent)
         emit q->hasContentChanged();
 
+    if (oldColorSpace != colorSpace)
+        emit q->colorSpaceChanged();
+
     if (!offsetForNextFrame.isNull())
         emit q->offsetForNextFrame(offsetForNextFrame);
 
     emit q->redraw();
 }
 
+void QWaylandSurfacePrivate::deferCommit(QtWayland::SyncFence &&acquireFence)
+{
+    deferredCommits.push_back({ pending, std::exchange(pendingFrameCallbacks, {}),
+                                takePendingSubsurfaceState(), std::move(acquireFence) });
+
+    // Clear per-commit state, the rest carries over to the next commit as usual
+    pending.buffer = QWaylandBufferRef();
+    pending.offset = QPoint();
+    pending.newlyAttached = false;
+    pending.bufferDamage = QRegion();
+    pending.surfaceDamage = QRegion();
+
+    if (!acquireFenceNotifier)
+        applyDeferredCommits();
+}
+
+/*
+    Waiting for the fences of the client on the GPU would stall the renderer on a slow client,
+    and on the CPU the compositor. Instead the previous buffer stays on screen until the fence
+    is readable, which sync files are once signaled. Fences that fail to poll count as signaled.
+*/
+void QWaylandSurfacePrivate::applyDeferredCommits()
+{
+    Q_Q(QWaylandSurface);
+    while (!deferredCommits.empty()) {
+        if (!deferredCommits.front().acquireFence.isSignaled()) {
+            auto *notifier = new QSocketNotifier(deferredCommits.front().acquireFence.fd(),
+                                                 QSocketNotifier::Read, q);
+            QObject::connect(notifier, &QSocketNotifier::activated, q, [this, notifier] {
+                // The fence is closed along with its commit
+                notifier->setEnabled(false);
+                notifier->deleteLater();
+                acquireFenceNotifier = nullptr;
+                applyDeferredCommits();
+            });
+            acquireFenceNotifier = notifier;
+            return;
+        }
+
+        DeferredCommit commit = std::move(deferredCommits.front());
+        deferredCommits.pop_front();
+
+        // Requests received since belong to later commits
+        PendingState next = std::exchange(pending, std::move(commit.state));
+        QList<QtWayland::FrameCallback *> nextFrameCallbacks = std::exchange(pendingFrameCallbacks, std::move(commit.frameCallbacks));
+        PendingSubsurfaceState nextSubsurfaceState = takePendingSubsurfaceState();
+        setPendingSubsurfaceState(std::move(commit.subsurfaceState));
+        applyCommit();
+        pending = std::move(next);
+        pendingFrameCallbacks = std::move(nextFrameCallbacks);
+        setPendingSubsurfaceState(std::move(nextSubsurfaceState));
+    }
+}
+
+QWaylandSurfacePrivate::PendingSubsurfaceState QWaylandSurfacePrivate::takePendingSubsurfaceState()
+{
+    // Later requests reorder the stack as requested so far, so it stays as it is
+    PendingSubsurfaceState state;
+    state.stack = pendingSubsurfaceStack;
+    state.stackPending = std::exchange(subsurfaceStackPending, false);
+    state.placements = std::exchange(pendingSubsurfacePlacements, {});
+    for (QWaylandSurfacePrivate *child : std::as_const(subsurfaceStack)) {
+        if (child != this && child->subsurface->pendingPosition)
+            state.positions.append({ child->q_func(), *std::exchange(child->subsurface->pendingPosition, std::nullopt) });
+    }
+    return state;
+}
+
+void QWaylandSurfacePrivate::setPendingSubsurfaceState(PendingSubsurfaceState &&state)
+{
+    pendingSubsurfaceStack = std::move(state.stack);
+    subsurfaceStackPending = state.stackPending;
+    pendingSubsurfacePlacements = std::move(state.placements);
+    for (const auto &[child, position] : std::as_const(state.positions)) {
+        // Surfaces which got another parent meanwhile start over with a new wl_subsurface
+        QWaylandSurfacePrivate *childPrivate = child ? get(child) : nullptr;
+        if (childPrivate && childPrivate->subsurface && childPrivate->subsurface->parentSurface == this)
+            childPrivate->subsurface->pendingPosition = position;
+    }
+}
+
+void QWaylandSurfacePrivate::discardDeferredCommits()
+{
+    if (acquireFenceNotifier) {
+        acquireFenceNotifier->setEnabled(false);
+        std::exchange(acquireFenceNotifier, nullptr)->deleteLater();
+    }
+    for (DeferredCommit &commit : deferredCommits) {
+        for (QtWayland::FrameCallback *c : std::as_const(commit.frameCallbacks))
+            c->destroy();
+    }
+    deferredCommits.clear();
+}
+
 void QWaylandSurfacePrivate::surface_set_buffer_transform(Resource *resource, int32_t orientation)
 {
     Q_UNUSED(resource);
@@ -854,6 +1063,29 @@ bool QWaylandSurface::isOpaque() const
     return d->isOpaque;
 }
 
+/*!
+ *  \qmlproperty colorSpace QtWayland.Compositor::WaylandSurface::colorSpace
+ *  \since 6.10
+ *
+ *  This property holds the color space of the surface contents, as described by the client
+ *  through ColorManagement. It is invalid when the client has not described it, in which
+ *  case the contents are assumed to be sRGB.
+ */
+
+/*!
+ *  \property QWaylandSurface::colorSpace
+ *  \since 6.10
+ *
+ *  This property holds the color space of the surface contents, as described by the client
+ *  through QWaylandColorManagement. It is invalid when the client has not described it, in
+ *  which case the contents are assumed to be sRGB.
+ */
+QColorSpace QWaylandSurface::colorSpace() const
+{
+    Q_D(const QWaylandSurface);
+    return d->colorSpace;
+}
+
 #if QT_CONFIG(im)
 QWaylandInputMethodControl *QWaylandSurface::inputMethodControl() const
 {
@@ -1031,33 +1263,144 @@ void QWaylandSurfacePrivate::derefView(QWaylandView *view)
 void QWaylandSurfacePrivate::initSubsurface(QWaylandSurface *parent, wl_client *client, int id, int version)
 {
     Q_Q(QWaylandSurface);
-    QWaylandSurface *oldParent = nullptr; // TODO: implement support for switching parents
+    // Surfaces switch parents by destroying their wl_subsurface and getting a new one,
+    // so there is never a parent yet
+    QWaylandSurface *oldParent = nullptr;
 
     subsurface = new Subsurface(this);
     subsurface->init(client, id, version);
     subsurface->parentSurface = parent->d_func();
+
+    // New subsurfaces start out on top of the stack of their parent, right away
+    QWaylandSurfacePrivate *parentPrivate = parent->d_func();
+    if (parentPrivate->subsurfaceStack.isEmpty())
+        parentPrivate->subsurfaceStack.append(parentPrivate);
+    if (parentPrivate->pendingSubsurfaceStack.isEmpty())
+        parentPrivate->pendingSubsurfaceStack.append(parentPrivate);
+    parentPrivate->subsurfaceStack.append(this);
+    parentPrivate->pendingSubsurfaceStack.append(this);
+    for (DeferredCommit &commit : parentPrivate->deferredCommits) {
+        if (commit.subsurfaceState.stackPending)
+            commit.subsurfaceState.stack.append(this);
+    }
+    ++parentPrivate->subsurfaceStackSerial;
+
     emit q->parentChanged(parent, oldParent);
     emit parent->childAdded(q);
 }
 
+void QWaylandSurfacePrivate::removeSubsurface(QWaylandSurfacePrivate *child)
+{
+    if (subsurfaceStack.removeOne(child))
+        ++subsurfaceStackSerial;
+    pendingSubsurfaceStack.removeOne(child);
+    for (DeferredCommit &commit : deferredCommits)
+        commit.subsurfaceState.stack.removeOne(child);
+    subsurfaceChildren.removeOne(child->q_func());
+}
+
+/*
+    Unlinks this surface from its wl_subsurface and its parent, when either the wl_subsurface
+    or the surface is destroyed. The surface is unmapped from the parent right away, rather
+    than at the parent's next commit, so the parent never refers to a surface that is gone.
+*/
+void QWaylandSurfacePrivate::detachSubsurface()
+{
+    Q_Q(QWaylandSurface);
+    Subsurface *oldSubsurface = std::exchange(subsurface, nullptr);
+    oldSubsurface->surface = nullptr;
+    if (QWaylandSurfacePrivate *parent = std::exchange(oldSubsurface->parentSurface, nullptr)) {
+        parent->removeSubsurface(this);
+        emit q->parentChanged(nullptr, parent->q_func());
+    }
+}
+
+/*
+    The position and stacking order of subsurfaces are state of their parent. They only
+    take effect at its commit, when the order requested since the last one is applied
+    as a whole, and views only restack once.
+*/
+void QWaylandSurfacePrivate::applySubsurfaceState()
+{
+    if (subsurfaceStack.isEmpty())
+        return;
+
+    if (subsurfaceStackPending) {
+        subsurfaceStackPending = false;
+        if (subsurfaceStack != pendingSubsurfaceStack) {
+            subsurfaceStack = pendingSubsurfaceStack;
+            ++subsurfaceStackSerial;
+        }
+    }
+
+    QVarLengthArray<QWaylandSurfacePrivate *, 16> moved;
+    for (QWaylandSurfacePrivate *child : std::as_const(subsurfaceStack)) {
+        if (child == this || !child->subsurface->pendingPosition)
+            continue;
+        const QPoint position = *std::exchange(child->subsurface->pendingPosition, std::nullopt);
+        if (position != child->subsurface->position) {
+            child->subsurface->position = position;
+            moved.append(child);
+        }
+    }
+
+    const auto placements = std::exchange(pendingSubsurfacePlacements, {});
+    for (const SubsurfacePlacement &placement : placements) {
+        if (!placement.child || !placement.sibling)
+            continue;
+        if (placement.above)
+            emit placement.child->subsurfacePlaceAbove(placement.sibling);
+        else
+            emit placement.child->subsurfacePlaceBelow(placement.sibling);
+    }
+    for (QWaylandSurfacePrivate *child : moved)
+        emit child->q_func()->subsurfacePositionChanged(child->subsurface->position);
+}
+
+void QWaylandSurfacePrivate::Subsurface::subsurface_destroy_resource(wl_subsurface::Resource *resource)
+{
+    Q_UNUSED(resource);
+    if (surface)
+        surface->detachSubsurface();
+    delete this;
+}
+
 void QWaylandSurfacePrivate::Subsurface::subsurface_set_position(wl_subsurface::Resource *resource, int32_t x, int32_t y)
 {
     Q_UNUSED(resource);
-    position = QPoint(x,y);
-    emit surface->q_func()->subsurfacePositionChanged(position);
+    pendingPosition = QPoint(x, y);
+}
+
+void QWaylandSurfacePrivate::Subsurface::place(wl_subsurface::Resource *resource, struct wl_resource *sibling, bool above)
+{
+    if (!parentSurface)
+        return;
 
+    QWaylandSurface *siblingSurface = QWaylandSurface::fromResource(sibling);
+    auto &stack = parentSurface->pendingSubsurfaceStack;
+    QWaylandSurfacePrivate *reference = siblingSurface ? QWaylandSurfacePrivate::get(siblingSurface) : nullptr;
+    if (!reference || reference == surface || !stack.contains(reference)) {
+        wl_resource_post_error(resource->handle, error_bad_surface,
+                               "%s: the reference surface is neither a sibling nor the parent",
+                               above ? "place_above" : "place_below");
+        return;
+    }
+
+    stack.removeOne(surface);
+    const qsizetype index = stack.indexOf(reference);
+    stack.insert(above ? index + 1 : index, surface);
+    parentSurface->subsurfaceStackPending = true;
+    parentSurface->pendingSubsurfacePlacements.append({ surface->q_func(), siblingSurface, above });
 }
 
 void QWaylandSurfacePrivate::Subsurface::subsurface_place_above(wl_subsurface::Resource *resource, struct wl_resource *sibling)
 {
-    Q_UNUSED(resource);
-    emit surface->q_func()->subsurfacePlaceAbove(QWaylandSurface::fromResource(sibling));
+    place(resource, sibling, true);
 }
 
 void QWaylandSurfacePrivate::Subsurface::subsurface_place_below(wl_subsurface::Resource *resource, struct wl_resource *sibling)
 {
-    Q_UNUSED(resource);
-    emit surface->q_func()->subsurfacePlaceBelow(QWaylandSurface::fromResource(sibling));
+    place(resource, sibling, false);
 }
 
 void QWaylandSurfacePrivate::Subsurface::subsurface_set_sync(wl_subsurface::Resource *resource)
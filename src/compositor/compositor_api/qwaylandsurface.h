@@ -12,6 +12,7 @@
 #include <QtWaylandCompositor/qwaylanddrag.h>
 
 #include <QtCore/QScopedPointer>
+#include <QtGui/QColorSpace>
 #include <QtGui/QImage>
 #include <QtGui/QWindow>
 #include <QtCore/QVariantMap>
@@ -53,6 +54,7 @@ class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandSurface : public QWaylandObject
     Q_PROPERTY(bool cursorSurface READ isCursorSurface WRITE markAsCursorSurface NOTIFY cursorSurfaceChanged)
     Q_PROPERTY(bool inhibitsIdle READ inhibitsIdle NOTIFY inhibitsIdleChanged REVISION(1, 14))
     Q_PROPERTY(bool isOpaque READ isOpaque NOTIFY isOpaqueChanged REVISION(6, 4))
+    Q_PROPERTY(QColorSpace colorSpace READ colorSpace NOTIFY colorSpaceChanged REVISION(6, 10))
     Q_MOC_INCLUDE("qwaylanddrag.h")
     Q_MOC_INCLUDE("qwaylandcompositor.h")
 
@@ -114,6 +116,7 @@ public:
 
     bool inhibitsIdle() const;
     bool isOpaque() const;
+    QColorSpace colorSpace() const;
 
 #if QT_CONFIG(im)
     QWaylandInputMethodControl *inputMethodControl() const;
@@ -147,6 +150,7 @@ Q_SIGNALS:
     void cursorSurfaceChanged();
     Q_REVISION(14) void inhibitsIdleChanged();
     Q_REVISION(6, 4) void isOpaqueChanged();
+    Q_REVISION(6, 10) void colorSpaceChanged();
 
     void configure(bool hasBuffer);
     void redraw();
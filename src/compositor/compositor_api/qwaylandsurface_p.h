@@ -33,14 +33,22 @@
 
 #include <QtCore/QTextStream>
 #include <QtCore/QMetaType>
+#include <QtGui/QMatrix4x4>
 
 #include <wayland-util.h>
 
 #include <QtWaylandCompositor/private/qwayland-server-wayland.h>
 #include <QtWaylandCompositor/private/qwaylandviewporter_p.h>
+#include <QtWaylandCompositor/private/qwaylandcolormanagement_p.h>
 #include <QtWaylandCompositor/private/qwaylandidleinhibitv1_p.h>
+#include <QtWaylandCompositor/private/qwaylandlinuxexplicitsynchronizationv1_p.h>
 
 #include <QtCore/qpointer.h>
+#include <QtCore/QSocketNotifier>
+
+#include <deque>
+#include <optional>
+#include <utility>
 
 QT_BEGIN_NAMESPACE
 
@@ -53,6 +61,28 @@ namespace QtWayland {
 class FrameCallback;
 }
 
+// How YUV buffers of a surface are converted to RGB, as described by the client through
+// color management. Defaults to BT.601 in limited range.
+struct Q_WAYLANDCOMPOSITOR_EXPORT QWaylandYuvConversion
+{
+    enum Matrix : quint8 {
+        Bt601,
+        Bt709,
+        Bt2020
+    };
+
+    Matrix matrix = Bt601;
+    bool fullRange = false;
+
+    // Maps (y, u, v, 1), as sampled from 8-bit textures, to RGB
+    QMatrix4x4 toRgb() const;
+
+    friend bool operator==(const QWaylandYuvConversion &a, const QWaylandYuvConversion &b)
+    { return a.matrix == b.matrix && a.fullRange == b.fullRange; }
+    friend bool operator!=(const QWaylandYuvConversion &a, const QWaylandYuvConversion &b)
+    { return !(a == b); }
+};
+
 class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandSurfacePrivate : public QObjectPrivate, public QtWaylandServer::wl_surface
 {
 public:
@@ -73,6 +103,15 @@ public:
 
     void notifyViewsAboutDestruction();
 
+    // Latency tracing, see QWaylandLatencyTrace
+    void traceInputSent(quint64 flow);
+    void tracePresented();
+
+#if QT_CONFIG(opengl)
+    // Approximate GPU memory held by the textures of the current buffer
+    qint64 textureMemory() const;
+#endif
+
 #ifndef QT_NO_DEBUG
     static void addUninitializedSurface(QWaylandSurfacePrivate *surface);
     static void removeUninitializedSurface(QWaylandSurfacePrivate *surface);
@@ -82,6 +121,15 @@ public:
     void initSubsurface(QWaylandSurface *parent, struct ::wl_client *client, int id, int version);
     bool isSubsurface() const { return subsurface; }
     QWaylandSurfacePrivate *parentSurface() const { return subsurface ? subsurface->parentSurface : nullptr; }
+    void removeSubsurface(QWaylandSurfacePrivate *child);
+    void detachSubsurface();
+    void applySubsurfaceState();
+
+    // Commits with an acquire fence which isn't signaled yet, and all commits after them,
+    // are applied in order once their fences are
+    void deferCommit(QtWayland::SyncFence &&acquireFence);
+    void applyDeferredCommits();
+    void discardDeferredCommits();
 
 protected:
     void surface_destroy_resource(Resource *resource) override;
@@ -99,6 +147,7 @@ protected:
     void surface_set_input_region(Resource *resource,
                                   struct wl_resource *region) override;
     void surface_commit(Resource *resource) override;
+    void applyCommit();
     void surface_set_buffer_transform(Resource *resource, int32_t transform) override;
     void surface_set_buffer_scale(Resource *resource, int32_t bufferScale) override;
 
@@ -113,8 +162,10 @@ public: //member variables
     QWaylandBufferRef bufferRef;
     QWaylandSurfaceRole *role = nullptr;
     QWaylandViewporterPrivate::Viewport *viewport = nullptr;
+    QWaylandColorManagementPrivate::SurfaceColorManagement *colorManagement = nullptr;
+    QWaylandLinuxExplicitSynchronizationV1Private::SurfaceSynchronization *synchronization = nullptr;
 
-    struct {
+    struct PendingState {
         QWaylandBufferRef buffer;
         QRegion surfaceDamage;
         QRegion bufferDamage;
@@ -125,6 +176,8 @@ public: //member variables
         QRectF sourceGeometry;
         QSize destinationSize;
         QRegion opaqueRegion;
+        QColorSpace colorSpace;
+        QWaylandYuvConversion yuvConversion;
     } pending;
 
     QPoint lastLocalMousePos;
@@ -135,8 +188,52 @@ public: //member variables
 
     QList<QPointer<QWaylandSurface>> subsurfaceChildren;
 
+    // Stacking order of this surface and its subsurfaces, bottom to top, as of the last commit
+    // and as requested for the next one. Both are empty as long as there are no subsurfaces.
+    // Views compare subsurfaceStackSerial to find out whether they need to restack.
+    QList<QWaylandSurfacePrivate *> subsurfaceStack;
+    QList<QWaylandSurfacePrivate *> pendingSubsurfaceStack;
+    bool subsurfaceStackPending = false;
+    uint subsurfaceStackSerial = 0;
+
+    // Requests applied at the next commit, still announced with the subsurfacePlaceAbove()
+    // and subsurfacePlaceBelow() signals of the child
+    struct SubsurfacePlacement {
+        QPointer<QWaylandSurface> child;
+        QPointer<QWaylandSurface> sibling;
+        bool above;
+    };
+    QList<SubsurfacePlacement> pendingSubsurfacePlacements;
+
+    // Subsurface requests of a commit that waits for its fence, along with the positions its
+    // children requested before. Children added or removed meanwhile are only added to or
+    // removed from the stack if the commit changes it.
+    struct PendingSubsurfaceState {
+        QList<QWaylandSurfacePrivate *> stack;
+        bool stackPending = false;
+        QList<SubsurfacePlacement> placements;
+        QList<std::pair<QPointer<QWaylandSurface>, QPoint>> positions;
+    };
+    PendingSubsurfaceState takePendingSubsurfaceState();
+    void setPendingSubsurfaceState(PendingSubsurfaceState &&state);
+
+    struct DeferredCommit {
+        PendingState state;
+        QList<QtWayland::FrameCallback *> frameCallbacks;
+        PendingSubsurfaceState subsurfaceState;
+        QtWayland::SyncFence acquireFence;
+    };
+    std::deque<DeferredCommit> deferredCommits;
+    // Each of them may hold on to a buffer, a client waiting on more is disconnected
+    static constexpr size_t MaxDeferredCommits = 32;
+    QPointer<QSocketNotifier> acquireFenceNotifier;
+
     QList<QWaylandIdleInhibitManagerV1Private::Inhibitor *> idleInhibitors;
 
+    // Input sent to the client since its last commit, and input committed but not yet presented
+    QList<quint64> tracedInputFlows;
+    QList<quint64> committedInputFlows;
+
     QRegion inputRegion;
     QRegion opaqueRegion;
 
@@ -144,6 +241,8 @@ public: //member variables
     QSize destinationSize;
     QSize bufferSize;
     int bufferScale = 1;
+    QColorSpace colorSpace;
+    QWaylandYuvConversion yuvConversion;
     bool isCursorSurface = false;
     bool destroyed = false;
     bool hasContent = false;
@@ -162,6 +261,7 @@ public: //member variables
         QWaylandSurfacePrivate *surfaceFromResource();
 
     protected:
+        void subsurface_destroy_resource(wl_subsurface::Resource *resource) override;
         void subsurface_set_position(wl_subsurface::Resource *resource, int32_t x, int32_t y) override;
         void subsurface_place_above(wl_subsurface::Resource *resource, struct wl_resource *sibling) override;
         void subsurface_place_below(wl_subsurface::Resource *resource, struct wl_resource *sibling) override;
@@ -171,8 +271,11 @@ public: //member variables
     private:
         friend class QWaylandSurfacePrivate;
         QWaylandSurfacePrivate *surface = nullptr;
+        void place(wl_subsurface::Resource *resource, struct wl_resource *sibling, bool above);
+
         QWaylandSurfacePrivate *parentSurface = nullptr;
         QPoint position;
+        std::optional<QPoint> pendingPosition;
     };
 
     Subsurface *subsurface = nullptr;
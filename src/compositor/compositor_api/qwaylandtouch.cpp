@@ -22,6 +22,12 @@ void QWaylandTouchPrivate::touch_release(Resource *resource)
     wl_resource_destroy(resource->handle);
 }
 
+void QWaylandTouchPrivate::touch_destroy_resource(Resource *resource)
+{
+    if (!resourceMap().contains(resource->client()))
+        discardPending(resource->client());
+}
+
 uint QWaylandTouchPrivate::sendDown(QWaylandSurface *surface, uint32_t time, int touch_id, const QPointF &position)
 {
     Q_Q(QWaylandTouch);
@@ -29,6 +35,7 @@ uint QWaylandTouchPrivate::sendDown(QWaylandSurface *surface, uint32_t time, int
     if (!focusResource)
         return 0;
 
+    flushPendingMotion(surface->client()->client());
     uint32_t serial = q->compositor()->nextSerial();
 
     wl_touch_send_down(focusResource->handle, serial, time, surface->resource(), touch_id,
@@ -43,6 +50,7 @@ uint QWaylandTouchPrivate::sendUp(QWaylandClient *client, uint32_t time, int tou
     if (!focusResource)
         return 0;
 
+    flushPendingMotion(client->client());
     uint32_t serial = compositor()->nextSerial();
 
     wl_touch_send_up(focusResource->handle, serial, time, touch_id);
@@ -51,13 +59,64 @@ uint QWaylandTouchPrivate::sendUp(QWaylandClient *client, uint32_t time, int tou
 
 void QWaylandTouchPrivate::sendMotion(QWaylandClient *client, uint32_t time, int touch_id, const QPointF &position)
 {
-    auto focusResource = resourceMap().value(client->client());
-
-    if (!focusResource)
+    if (!resourceMap().contains(client->client()))
         return;
 
-    wl_touch_send_motion(focusResource->handle, time, touch_id,
-                         wl_fixed_from_double(position.x()), wl_fixed_from_double(position.y()));
+    // Only the latest position of a point matters
+    for (PendingMotion &motion : pendingMotions) {
+        if (motion.client == client->client() && motion.touchId == touch_id) {
+            motion.time = time;
+            motion.position = position;
+            return;
+        }
+    }
+    pendingMotions.append({ client->client(), touch_id, time, position });
+}
+
+void QWaylandTouchPrivate::sendFrame(wl_client *client)
+{
+    flushPendingMotion(client);
+    pendingFrameClients.removeAll(client);
+    if (auto focusResource = resourceMap().value(client))
+        send_frame(focusResource->handle);
+}
+
+void QWaylandTouchPrivate::flushPendingMotion(wl_client *client)
+{
+    auto focusResource = resourceMap().value(client);
+    for (qsizetype i = 0; i < pendingMotions.size();) {
+        const PendingMotion &motion = pendingMotions.at(i);
+        if (motion.client != client) {
+            ++i;
+            continue;
+        }
+        if (focusResource) {
+            wl_touch_send_motion(focusResource->handle, motion.time, motion.touchId,
+                                 wl_fixed_from_double(motion.position.x()),
+                                 wl_fixed_from_double(motion.position.y()));
+        }
+        pendingMotions.remove(i);
+    }
+}
+
+void QWaylandTouchPrivate::flushPendingFrames()
+{
+    // Motion sent without a frame is flushed without one, the frame is up to the caller
+    while (!pendingMotions.isEmpty()) {
+        wl_client *client = pendingMotions.first().client;
+        if (pendingFrameClients.contains(client))
+            sendFrame(client);
+        else
+            flushPendingMotion(client);
+    }
+    while (!pendingFrameClients.isEmpty())
+        sendFrame(pendingFrameClients.first());
+}
+
+void QWaylandTouchPrivate::discardPending(wl_client *client)
+{
+    pendingMotions.removeIf([client](const PendingMotion &motion) { return motion.client == client; });
+    pendingFrameClients.removeAll(client);
 }
 
 int QWaylandTouchPrivate::toSequentialWaylandId(int touchId)
@@ -149,9 +208,7 @@ uint QWaylandTouch::sendTouchPointEvent(QWaylandSurface *surface, int id, const
 void QWaylandTouch::sendFrameEvent(QWaylandClient *client)
 {
     Q_D(QWaylandTouch);
-    auto focusResource = d->resourceMap().value(client->client());
-    if (focusResource)
-        d->send_frame(focusResource->handle);
+    d->sendFrame(client->client());
 }
 
 /*!
@@ -160,6 +217,8 @@ void QWaylandTouch::sendFrameEvent(QWaylandClient *client)
 void QWaylandTouch::sendCancelEvent(QWaylandClient *client)
 {
     Q_D(QWaylandTouch);
+    // The points are gone, there's no point in sending where they moved to
+    d->discardPending(client->client());
     auto focusResource = d->resourceMap().value(client->client());
     if (focusResource)
         d->send_cancel(focusResource->handle);
@@ -169,6 +228,11 @@ void QWaylandTouch::sendCancelEvent(QWaylandClient *client)
  * Sends all touch points in \a event to the specified \a surface,
  * followed by a touch frame event.
  *
+ * If the event only moves touch points, the frame is sent when the compositor
+ * returns to the event loop. Motion of the same points from further events
+ * handled before that replaces it, so clients get at most one frame of motion
+ * per event loop iteration.
+ *
  * \sa sendTouchPointEvent(), sendFrameEvent()
  */
 void QWaylandTouch::sendFullTouchEvent(QWaylandSurface *surface, QTouchEvent *event)
@@ -183,6 +247,7 @@ void QWaylandTouch::sendFullTouchEvent(QWaylandSurface *surface, QTouchEvent *ev
     if (points.isEmpty())
         return;
 
+    bool motionOnly = true;
     const int pointCount = points.size();
     for (int i = 0; i < pointCount; ++i) {
         const QTouchEvent::TouchPoint &tp(points.at(i));
@@ -191,8 +256,15 @@ void QWaylandTouch::sendFullTouchEvent(QWaylandSurface *surface, QTouchEvent *ev
         sendTouchPointEvent(surface, id, tp.position(), Qt::TouchPointState(tp.state()));
         if (tp.state() == QEventPoint::Released)
             d->ids[id] = -1;
+        if (tp.state() == QEventPoint::Pressed || tp.state() == QEventPoint::Released)
+            motionOnly = false;
     }
-    sendFrameEvent(surface->client());
+
+    wl_client *client = surface->client()->client();
+    if (!motionOnly)
+        d->sendFrame(client);
+    else if (d->resourceMap().contains(client) && !d->pendingFrameClients.contains(client))
+        d->pendingFrameClients.append(client);
 }
 
 /*!
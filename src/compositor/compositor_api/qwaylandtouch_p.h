@@ -37,18 +37,38 @@ class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandTouchPrivate : public QObjectPrivate, p
 public:
     explicit QWaylandTouchPrivate(QWaylandTouch *touch, QWaylandSeat *seat);
 
+    static QWaylandTouchPrivate *get(QWaylandTouch *touch) { return touch->d_func(); }
+
     QWaylandCompositor *compositor() const { return seat->compositor(); }
 
     uint sendDown(QWaylandSurface *surface, uint32_t time, int touch_id, const QPointF &position);
     void sendMotion(QWaylandClient *client, uint32_t time, int touch_id, const QPointF &position);
     uint sendUp(QWaylandClient *client, uint32_t time, int touch_id);
+    void sendFrame(wl_client *client);
+
+    // Motion is sent when the frame it belongs to is, or when going back to the event loop.
+    // Frames with only motion are held until then too, so that the motion of several
+    // input events handled in one event loop iteration reaches the client as one frame.
+    void flushPendingMotion(wl_client *client);
+    void flushPendingFrames();
 
 private:
     void touch_release(Resource *resource) override;
+    void touch_destroy_resource(Resource *resource) override;
     int toSequentialWaylandId(int touchId);
+    void discardPending(wl_client *client);
 
     QWaylandSeat *seat = nullptr;
     QVarLengthArray<int, 10> ids;
+
+    struct PendingMotion {
+        wl_client *client;
+        int touchId;
+        uint32_t time;
+        QPointF position;
+    };
+    QVarLengthArray<PendingMotion, 10> pendingMotions;
+    QVarLengthArray<wl_client *, 2> pendingFrameClients;
 };
 
 QT_END_NAMESPACE
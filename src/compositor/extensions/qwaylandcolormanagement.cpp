@@ -0,0 +1,575 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qwaylandcolormanagement_p.h"
+
+#include <QtWaylandCompositor/QWaylandCompositor>
+#include <QtWaylandCompositor/QWaylandSurface>
+#include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QWaylandColorManagement
+    \inmodule QtWaylandCompositor
+    \since 6.10
+    \brief Provides an extension for clients to describe the color space of their surfaces.
+    \sa QWaylandSurface::colorSpace
+
+    The QWaylandColorManagement extension lets clients tag their surfaces with an image
+    description: the primaries and the transfer function of the buffer contents. The compositor
+    takes them into account when drawing the surfaces, instead of the clients converting to sRGB
+    themselves.
+
+    QWaylandColorManagement corresponds to the Wayland interface, \c xx_color_manager_v4.
+    Surfaces are drawn without converting their colors, so only what sRGB outputs show as
+    intended is advertised: parametric image descriptions with named primaries and the sRGB,
+    gamma 2.2 and BT.709 transfer functions. Custom primaries, power transfer functions, HDR
+    transfer functions and ICC profiles are not supported. Outputs and surfaces are described
+    as sRGB.
+
+    The color space of a surface is available as QWaylandSurface::colorSpace. For YUV buffers,
+    the named primaries also select the matrix coefficients used to convert them to RGB.
+*/
+
+/*!
+    \qmltype ColorManagement
+    \nativetype QWaylandColorManagement
+    \inqmlmodule QtWayland.Compositor
+    \since 6.10
+    \brief Provides an extension for clients to describe the color space of their surfaces.
+    \sa WaylandSurface::colorSpace
+
+    The ColorManagement extension lets clients tag their surfaces with an image description:
+    the primaries and the transfer function of the buffer contents.
+
+    ColorManagement corresponds to the Wayland interface, \c xx_color_manager_v4.
+
+    To provide the functionality of the extension in a compositor, create an instance of the
+    ColorManagement component and add it to the list of extensions supported by the compositor:
+
+    \qml
+    import QtWayland.Compositor
+
+    WaylandCompositor {
+        ColorManagement {
+            // ...
+        }
+    }
+    \endqml
+*/
+
+/*!
+    Constructs a QWaylandColorManagement object.
+*/
+QWaylandColorManagement::QWaylandColorManagement()
+    : QWaylandCompositorExtensionTemplate<QWaylandColorManagement>(*new QWaylandColorManagementPrivate)
+{
+}
+
+/*!
+    Constructs a QWaylandColorManagement object for the provided \a compositor.
+*/
+QWaylandColorManagement::QWaylandColorManagement(QWaylandCompositor *compositor)
+    : QWaylandCompositorExtensionTemplate<QWaylandColorManagement>(compositor, *new QWaylandColorManagementPrivate)
+{
+}
+
+/*!
+    Destructs a QWaylandColorManagement object.
+*/
+QWaylandColorManagement::~QWaylandColorManagement() = default;
+
+/*!
+    Initializes the extension.
+*/
+void QWaylandColorManagement::initialize()
+{
+    Q_D(QWaylandColorManagement);
+
+    QWaylandCompositorExtensionTemplate::initialize();
+    auto *compositor = static_cast<QWaylandCompositor *>(extensionContainer());
+    if (!compositor) {
+        qWarning() << "Failed to find QWaylandCompositor when initializing QWaylandColorManagement";
+        return;
+    }
+    d->init(compositor->display(), 1);
+}
+
+/*!
+    Returns the Wayland interface for the QWaylandColorManagement.
+*/
+const wl_interface *QWaylandColorManagement::interface()
+{
+    return QWaylandColorManagementPrivate::interface();
+}
+
+namespace {
+
+using Manager = QtWaylandServer::xx_color_manager_v4;
+
+// Chromaticities of the named primaries, and their QColorSpace counterparts where Qt has one
+const struct {
+    Manager::primaries primaries;
+    QColorSpace::Primaries colorSpacePrimaries;
+    QPointF red;
+    QPointF green;
+    QPointF blue;
+    QPointF white;
+} namedPrimaries[] = {
+    { Manager::primaries_srgb, QColorSpace::Primaries::SRgb,
+      { 0.64, 0.33 }, { 0.30, 0.60 }, { 0.15, 0.06 }, { 0.3127, 0.3290 } },
+    { Manager::primaries_pal_m, QColorSpace::Primaries::Custom,
+      { 0.67, 0.33 }, { 0.21, 0.71 }, { 0.14, 0.08 }, { 0.310, 0.316 } },
+    { Manager::primaries_pal, QColorSpace::Primaries::Custom,
+      { 0.64, 0.33 }, { 0.29, 0.60 }, { 0.15, 0.06 }, { 0.3127, 0.3290 } },
+    { Manager::primaries_ntsc, QColorSpace::Primaries::Custom,
+      { 0.630, 0.340 }, { 0.310, 0.595 }, { 0.155, 0.070 }, { 0.3127, 0.3290 } },
+    { Manager::primaries_generic_film, QColorSpace::Primaries::Custom,
+      { 0.681, 0.319 }, { 0.243, 0.692 }, { 0.145, 0.049 }, { 0.310, 0.316 } },
+    { Manager::primaries_bt2020, QColorSpace::Primaries::Bt2020,
+      { 0.708, 0.292 }, { 0.170, 0.797 }, { 0.131, 0.046 }, { 0.3127, 0.3290 } },
+    { Manager::primaries_dci_p3, QColorSpace::Primaries::Custom,
+      { 0.680, 0.320 }, { 0.265, 0.690 }, { 0.150, 0.060 }, { 0.314, 0.351 } },
+    { Manager::primaries_display_p3, QColorSpace::Primaries::DciP3D65,
+      { 0.680, 0.320 }, { 0.265, 0.690 }, { 0.150, 0.060 }, { 0.3127, 0.3290 } },
+    { Manager::primaries_adobe_rgb, QColorSpace::Primaries::AdobeRgb,
+      { 0.64, 0.33 }, { 0.21, 0.71 }, { 0.15, 0.06 }, { 0.3127, 0.3290 } },
+};
+
+// Only the transfer functions that are shown close enough to intended on an sRGB output
+// without converting the surface. Linear, PQ and HLG contents would need to be re-encoded.
+const struct {
+    Manager::transfer_function transferFunction;
+    QColorSpace::TransferFunction colorSpaceTransferFunction;
+    float gamma;
+} namedTransferFunctions[] = {
+    // BT.709 and BT.2020 share the transfer function
+    { Manager::transfer_function_bt709, QColorSpace::TransferFunction::Bt2020, 0.0f },
+    { Manager::transfer_function_gamma22, QColorSpace::TransferFunction::Gamma, 2.2f },
+    { Manager::transfer_function_srgb, QColorSpace::TransferFunction::SRgb, 0.0f },
+};
+
+QWaylandYuvConversion::Matrix yuvMatrix(int primaries)
+{
+    switch (primaries) {
+    case Manager::primaries_pal_m:
+    case Manager::primaries_pal:
+    case Manager::primaries_ntsc:
+        return QWaylandYuvConversion::Bt601;
+    case Manager::primaries_bt2020:
+        return QWaylandYuvConversion::Bt2020;
+    default:
+        return QWaylandYuvConversion::Bt709;
+    }
+}
+
+// Sent in one go for descriptions made by the compositor, which are all named
+class ImageDescriptionInfo : public QtWaylandServer::xx_image_description_info_v4
+{
+public:
+    ImageDescriptionInfo(wl_client *client, quint32 id, quint32 version)
+        : QtWaylandServer::xx_image_description_info_v4(client, id, version)
+    {
+    }
+
+    static void send(const QWaylandColorManagementPrivate::Description &description,
+                     wl_client *client, quint32 id, quint32 version)
+    {
+        auto *info = new ImageDescriptionInfo(client, id, version);
+        for (const auto &named : namedPrimaries) {
+            if (named.primaries != description.primaries)
+                continue;
+            info->send_primaries_named(named.primaries);
+            info->send_primaries(qRound(named.red.x() * 10000), qRound(named.red.y() * 10000),
+                                 qRound(named.green.x() * 10000), qRound(named.green.y() * 10000),
+                                 qRound(named.blue.x() * 10000), qRound(named.blue.y() * 10000),
+                                 qRound(named.white.x() * 10000), qRound(named.white.y() * 10000));
+        }
+        for (const auto &named : namedTransferFunctions) {
+            if (named.colorSpaceTransferFunction == description.colorSpace.transferFunction()
+                && (named.gamma == 0 || qFuzzyCompare(named.gamma, description.colorSpace.gamma()))) {
+                info->send_tf_named(named.transferFunction);
+                break;
+            }
+        }
+        info->send_done();
+        wl_resource_destroy(info->resource()->handle);
+    }
+
+protected:
+    void xx_image_description_info_v4_destroy_resource(Resource *resource) override
+    {
+        Q_UNUSED(resource);
+        delete this;
+    }
+};
+
+} // namespace
+
+QWaylandColorManagementPrivate::Description QWaylandColorManagementPrivate::preferredDescription()
+{
+    return { QColorSpace(QColorSpace::SRgb), primaries_srgb };
+}
+
+QWaylandColorManagementPrivate::ImageDescription *QWaylandColorManagementPrivate::createImageDescription(
+        const Description &description, bool hasInformation, wl_client *client, quint32 id,
+        quint32 version)
+{
+    return new ImageDescription(description, hasInformation, client, id, version, m_nextIdentity++);
+}
+
+void QWaylandColorManagementPrivate::xx_color_manager_v4_bind_resource(Resource *resource)
+{
+    send_supported_intent(resource->handle, render_intent_perceptual);
+    send_supported_feature(resource->handle, feature_parametric);
+    for (const auto &named : namedTransferFunctions)
+        send_supported_tf_named(resource->handle, named.transferFunction);
+    for (const auto &named : namedPrimaries)
+        send_supported_primaries_named(resource->handle, named.primaries);
+}
+
+void QWaylandColorManagementPrivate::xx_color_manager_v4_destroy(Resource *resource)
+{
+    // Objects created from the manager are allowed to outlive it
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandColorManagementPrivate::xx_color_manager_v4_get_output(Resource *resource, uint32_t id, wl_resource *output)
+{
+    Q_UNUSED(output);
+    new OutputColorManagement(this, resource->client(), id, resource->version());
+}
+
+void QWaylandColorManagementPrivate::xx_color_manager_v4_get_surface(Resource *resource, uint32_t id, wl_resource *surfaceResource)
+{
+    auto *surface = QWaylandSurface::fromResource(surfaceResource);
+    if (!surface) {
+        qWarning() << "Couldn't find surface for color management";
+        return;
+    }
+
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(surface);
+    if (surfacePrivate->colorManagement) {
+        wl_resource_post_error(resource->handle, error_surface_exists,
+                               "color management surface already exists for surface");
+        return;
+    }
+
+    surfacePrivate->colorManagement = new SurfaceColorManagement(surface, resource->client(), id, resource->version());
+}
+
+void QWaylandColorManagementPrivate::xx_color_manager_v4_get_feedback_surface(Resource *resource, uint32_t id, wl_resource *surfaceResource)
+{
+    auto *surface = QWaylandSurface::fromResource(surfaceResource);
+    if (!surface) {
+        qWarning() << "Couldn't find surface for color management feedback";
+        return;
+    }
+    new FeedbackSurface(this, surface, resource->client(), id, resource->version());
+}
+
+void QWaylandColorManagementPrivate::xx_color_manager_v4_new_icc_creator(Resource *resource, uint32_t obj)
+{
+    Q_UNUSED(obj);
+    wl_resource_post_error(resource->handle, error_unsupported_feature,
+                           "ICC image descriptions are not supported");
+}
+
+void QWaylandColorManagementPrivate::xx_color_manager_v4_new_parametric_creator(Resource *resource, uint32_t obj)
+{
+    new ParametricCreator(this, resource->client(), obj, resource->version());
+}
+
+QWaylandColorManagementPrivate::ImageDescription::ImageDescription(const Description &description,
+                                                                   bool hasInformation,
+                                                                   wl_client *client, quint32 id,
+                                                                   quint32 version,
+                                                                   quint32 identity)
+    : QtWaylandServer::xx_image_description_v4(client, id, version)
+    , m_description(description)
+    , m_hasInformation(hasInformation)
+{
+    send_ready(identity);
+}
+
+QWaylandColorManagementPrivate::ImageDescription *QWaylandColorManagementPrivate::ImageDescription::fromResource(wl_resource *resource)
+{
+    auto *res = Resource::fromResource(resource);
+    return res ? static_cast<ImageDescription *>(res->xx_image_description_v4_object) : nullptr;
+}
+
+void QWaylandColorManagementPrivate::ImageDescription::xx_image_description_v4_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void QWaylandColorManagementPrivate::ImageDescription::xx_image_description_v4_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandColorManagementPrivate::ImageDescription::xx_image_description_v4_get_information(Resource *resource, uint32_t information)
+{
+    if (!m_hasInformation) {
+        wl_resource_post_error(resource->handle, error_no_information,
+                               "image description was not made by the compositor");
+        return;
+    }
+    ImageDescriptionInfo::send(m_description, resource->client(), information, resource->version());
+}
+
+QWaylandColorManagementPrivate::ParametricCreator::ParametricCreator(QWaylandColorManagementPrivate *manager,
+                                                                     wl_client *client, quint32 id,
+                                                                     quint32 version)
+    : QtWaylandServer::xx_image_description_creator_params_v4(client, id, version)
+    , m_manager(manager->q_func())
+{
+}
+
+void QWaylandColorManagementPrivate::ParametricCreator::xx_image_description_creator_params_v4_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void QWaylandColorManagementPrivate::ParametricCreator::xx_image_description_creator_params_v4_create(Resource *resource, uint32_t imageDescription)
+{
+    if (!m_hasTransferFunction || !m_hasPrimaries) {
+        wl_resource_post_error(resource->handle, error_incomplete_set,
+                               "primaries and transfer function are required");
+        return;
+    }
+
+    Description description;
+    description.primaries = m_namedPrimaries;
+    description.colorSpace = QColorSpace(m_white, m_red, m_green, m_blue, m_transferFunction, m_gamma);
+    for (const auto &named : namedPrimaries) {
+        if (named.primaries == m_namedPrimaries && named.colorSpacePrimaries != QColorSpace::Primaries::Custom)
+            description.colorSpace = QColorSpace(named.colorSpacePrimaries, m_transferFunction, m_gamma);
+    }
+    if (!description.colorSpace.isValid()) {
+        wl_resource_post_error(resource->handle, error_inconsistent_set,
+                               "primaries do not describe a valid color space");
+        return;
+    }
+
+    if (m_manager) {
+        QWaylandColorManagementPrivate::get(m_manager)->createImageDescription(description, false, resource->client(),
+                                                                               imageDescription, resource->version());
+    }
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandColorManagementPrivate::ParametricCreator::xx_image_description_creator_params_v4_set_tf_named(Resource *resource, uint32_t tf)
+{
+    if (m_hasTransferFunction) {
+        wl_resource_post_error(resource->handle, error_already_set, "transfer function already set");
+        return;
+    }
+    for (const auto &named : namedTransferFunctions) {
+        if (named.transferFunction == tf) {
+            m_transferFunction = named.colorSpaceTransferFunction;
+            m_gamma = named.gamma;
+            m_hasTransferFunction = true;
+            return;
+        }
+    }
+    wl_resource_post_error(resource->handle, error_invalid_tf, "unsupported transfer function %u", tf);
+}
+
+void QWaylandColorManagementPrivate::ParametricCreator::xx_image_description_creator_params_v4_set_tf_power(Resource *resource, uint32_t eexp)
+{
+    Q_UNUSED(eexp);
+    wl_resource_post_error(resource->handle, error_unsupported_feature,
+                           "power transfer functions are not supported");
+}
+
+void QWaylandColorManagementPrivate::ParametricCreator::xx_image_description_creator_params_v4_set_primaries_named(Resource *resource, uint32_t primaries)
+{
+    if (m_hasPrimaries) {
+        wl_resource_post_error(resource->handle, error_already_set, "primaries already set");
+        return;
+    }
+    for (const auto &named : namedPrimaries) {
+        if (named.primaries == primaries) {
+            m_namedPrimaries = named.primaries;
+            m_red = named.red;
+            m_green = named.green;
+            m_blue = named.blue;
+            m_white = named.white;
+            m_hasPrimaries = true;
+            return;
+        }
+    }
+    wl_resource_post_error(resource->handle, error_invalid_primaries, "unsupported primaries %u", primaries);
+}
+
+void QWaylandColorManagementPrivate::ParametricCreator::xx_image_description_creator_params_v4_set_primaries(Resource *resource, int32_t r_x, int32_t r_y, int32_t g_x, int32_t g_y, int32_t b_x, int32_t b_y, int32_t w_x, int32_t w_y)
+{
+    Q_UNUSED(r_x);
+    Q_UNUSED(r_y);
+    Q_UNUSED(g_x);
+    Q_UNUSED(g_y);
+    Q_UNUSED(b_x);
+    Q_UNUSED(b_y);
+    Q_UNUSED(w_x);
+    Q_UNUSED(w_y);
+    wl_resource_post_error(resource->handle, error_unsupported_feature,
+                           "custom primaries are not supported");
+}
+
+void QWaylandColorManagementPrivate::ParametricCreator::xx_image_description_creator_params_v4_set_luminances(Resource *resource, uint32_t min_lum, uint32_t max_lum, uint32_t reference_lum)
+{
+    Q_UNUSED(min_lum);
+    Q_UNUSED(max_lum);
+    Q_UNUSED(reference_lum);
+    wl_resource_post_error(resource->handle, error_unsupported_feature, "luminances are not supported");
+}
+
+void QWaylandColorManagementPrivate::ParametricCreator::xx_image_description_creator_params_v4_set_mastering_display_primaries(Resource *resource, int32_t r_x, int32_t r_y, int32_t g_x, int32_t g_y, int32_t b_x, int32_t b_y, int32_t w_x, int32_t w_y)
+{
+    Q_UNUSED(r_x);
+    Q_UNUSED(r_y);
+    Q_UNUSED(g_x);
+    Q_UNUSED(g_y);
+    Q_UNUSED(b_x);
+    Q_UNUSED(b_y);
+    Q_UNUSED(w_x);
+    Q_UNUSED(w_y);
+    wl_resource_post_error(resource->handle, error_unsupported_feature,
+                           "mastering display primaries are not supported");
+}
+
+QWaylandColorManagementPrivate::SurfaceColorManagement::SurfaceColorManagement(QWaylandSurface *surface,
+                                                                               wl_client *client,
+                                                                               quint32 id,
+                                                                               quint32 version)
+    : QtWaylandServer::xx_color_management_surface_v4(client, id, version)
+    , m_surface(surface)
+{
+    Q_ASSERT(surface);
+}
+
+QWaylandColorManagementPrivate::SurfaceColorManagement::~SurfaceColorManagement()
+{
+    if (m_surface) {
+        auto *surfacePrivate = QWaylandSurfacePrivate::get(m_surface);
+        Q_ASSERT(surfacePrivate->colorManagement == this);
+        surfacePrivate->colorManagement = nullptr;
+    }
+}
+
+void QWaylandColorManagementPrivate::SurfaceColorManagement::xx_color_management_surface_v4_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void QWaylandColorManagementPrivate::SurfaceColorManagement::xx_color_management_surface_v4_destroy(Resource *resource)
+{
+    xx_color_management_surface_v4_unset_image_description(resource);
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandColorManagementPrivate::SurfaceColorManagement::xx_color_management_surface_v4_set_image_description(Resource *resource, wl_resource *imageDescription, uint32_t renderIntent)
+{
+    if (renderIntent != render_intent_perceptual) {
+        wl_resource_post_error(resource->handle, error_render_intent,
+                               "unsupported render intent %u", renderIntent);
+        return;
+    }
+
+    auto *description = ImageDescription::fromResource(imageDescription);
+    if (!description) {
+        wl_resource_post_error(resource->handle, error_image_description, "invalid image description");
+        return;
+    }
+
+    if (!m_surface)
+        return;
+
+    // Double-buffered, applied with the next commit of the surface
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(m_surface);
+    surfacePrivate->pending.colorSpace = description->description().colorSpace;
+    surfacePrivate->pending.yuvConversion.matrix = yuvMatrix(description->description().primaries);
+}
+
+void QWaylandColorManagementPrivate::SurfaceColorManagement::xx_color_management_surface_v4_unset_image_description(Resource *resource)
+{
+    Q_UNUSED(resource);
+    if (!m_surface)
+        return;
+
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(m_surface);
+    surfacePrivate->pending.colorSpace = QColorSpace();
+    surfacePrivate->pending.yuvConversion = QWaylandYuvConversion();
+}
+
+QWaylandColorManagementPrivate::OutputColorManagement::OutputColorManagement(QWaylandColorManagementPrivate *manager,
+                                                                             wl_client *client,
+                                                                             quint32 id,
+                                                                             quint32 version)
+    : QtWaylandServer::xx_color_management_output_v4(client, id, version)
+    , m_manager(manager->q_func())
+{
+}
+
+void QWaylandColorManagementPrivate::OutputColorManagement::xx_color_management_output_v4_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void QWaylandColorManagementPrivate::OutputColorManagement::xx_color_management_output_v4_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandColorManagementPrivate::OutputColorManagement::xx_color_management_output_v4_get_image_description(Resource *resource, uint32_t imageDescription)
+{
+    if (!m_manager) {
+        qWarning() << "Color management output used after QWaylandColorManagement was destroyed";
+        return;
+    }
+    QWaylandColorManagementPrivate::get(m_manager)->createImageDescription(preferredDescription(), true, resource->client(),
+                                                                           imageDescription, resource->version());
+}
+
+QWaylandColorManagementPrivate::FeedbackSurface::FeedbackSurface(QWaylandColorManagementPrivate *manager,
+                                                                 QWaylandSurface *surface,
+                                                                 wl_client *client, quint32 id,
+                                                                 quint32 version)
+    : QtWaylandServer::xx_color_management_feedback_surface_v4(client, id, version)
+    , m_manager(manager->q_func())
+    , m_surface(surface)
+{
+}
+
+void QWaylandColorManagementPrivate::FeedbackSurface::xx_color_management_feedback_surface_v4_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void QWaylandColorManagementPrivate::FeedbackSurface::xx_color_management_feedback_surface_v4_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandColorManagementPrivate::FeedbackSurface::xx_color_management_feedback_surface_v4_get_preferred(Resource *resource, uint32_t imageDescription)
+{
+    if (!m_surface) {
+        wl_resource_post_error(resource->handle, error_inert, "surface was destroyed");
+        return;
+    }
+    if (!m_manager) {
+        qWarning() << "Color management feedback used after QWaylandColorManagement was destroyed";
+        return;
+    }
+    QWaylandColorManagementPrivate::get(m_manager)->createImageDescription(preferredDescription(), true, resource->client(),
+                                                                           imageDescription, resource->version());
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,30 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDCOLORMANAGEMENT_H
+#define QWAYLANDCOLORMANAGEMENT_H
+
+#include <QtWaylandCompositor/QWaylandCompositorExtension>
+
+QT_BEGIN_NAMESPACE
+
+class QWaylandColorManagementPrivate;
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandColorManagement
+        : public QWaylandCompositorExtensionTemplate<QWaylandColorManagement>
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QWaylandColorManagement)
+public:
+    QWaylandColorManagement();
+    explicit QWaylandColorManagement(QWaylandCompositor *compositor);
+    ~QWaylandColorManagement() override;
+
+    void initialize() override;
+
+    static const struct wl_interface *interface();
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDCOLORMANAGEMENT_H
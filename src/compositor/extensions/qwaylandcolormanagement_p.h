@@ -0,0 +1,171 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDCOLORMANAGEMENT_P_H
+#define QWAYLANDCOLORMANAGEMENT_P_H
+
+#include "qwaylandcolormanagement.h"
+
+#include <QtWaylandCompositor/private/qwaylandcompositorextension_p.h>
+#include <QtWaylandCompositor/private/qwayland-server-xx-color-management-v4.h>
+
+#include <QtCore/qpointer.h>
+#include <QtGui/qcolorspace.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QWaylandSurface;
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandColorManagementPrivate
+        : public QWaylandCompositorExtensionPrivate
+        , public QtWaylandServer::xx_color_manager_v4
+{
+    Q_DECLARE_PUBLIC(QWaylandColorManagement)
+public:
+    explicit QWaylandColorManagementPrivate() = default;
+
+    // What an image description stands for. Named primaries are kept as the protocol value,
+    // or -1, because they also tell the YUV matrix coefficients.
+    struct Description
+    {
+        QColorSpace colorSpace;
+        int primaries = -1;
+    };
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT ImageDescription
+            : public QtWaylandServer::xx_image_description_v4
+    {
+    public:
+        ImageDescription(const Description &description, bool hasInformation, wl_client *client,
+                         quint32 id, quint32 version, quint32 identity);
+
+        static ImageDescription *fromResource(wl_resource *resource);
+
+        const Description &description() const { return m_description; }
+
+    protected:
+        void xx_image_description_v4_destroy_resource(Resource *resource) override;
+        void xx_image_description_v4_destroy(Resource *resource) override;
+        void xx_image_description_v4_get_information(Resource *resource, uint32_t information) override;
+
+    private:
+        const Description m_description;
+        // Only descriptions made by the compositor may be inspected by clients
+        const bool m_hasInformation;
+    };
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT ParametricCreator
+            : public QtWaylandServer::xx_image_description_creator_params_v4
+    {
+    public:
+        ParametricCreator(QWaylandColorManagementPrivate *manager, wl_client *client, quint32 id,
+                          quint32 version);
+
+    protected:
+        void xx_image_description_creator_params_v4_destroy_resource(Resource *resource) override;
+        void xx_image_description_creator_params_v4_create(Resource *resource, uint32_t imageDescription) override;
+        void xx_image_description_creator_params_v4_set_tf_named(Resource *resource, uint32_t tf) override;
+        void xx_image_description_creator_params_v4_set_tf_power(Resource *resource, uint32_t eexp) override;
+        void xx_image_description_creator_params_v4_set_primaries_named(Resource *resource, uint32_t primaries) override;
+        void xx_image_description_creator_params_v4_set_primaries(Resource *resource, int32_t r_x, int32_t r_y, int32_t g_x, int32_t g_y, int32_t b_x, int32_t b_y, int32_t w_x, int32_t w_y) override;
+        void xx_image_description_creator_params_v4_set_luminances(Resource *resource, uint32_t min_lum, uint32_t max_lum, uint32_t reference_lum) override;
+        void xx_image_description_creator_params_v4_set_mastering_display_primaries(Resource *resource, int32_t r_x, int32_t r_y, int32_t g_x, int32_t g_y, int32_t b_x, int32_t b_y, int32_t w_x, int32_t w_y) override;
+
+    private:
+        QPointer<QWaylandColorManagement> m_manager;
+        bool m_hasTransferFunction = false;
+        QColorSpace::TransferFunction m_transferFunction = QColorSpace::TransferFunction::Custom;
+        float m_gamma = 0;
+        bool m_hasPrimaries = false;
+        int m_namedPrimaries = -1;
+        QPointF m_red;
+        QPointF m_green;
+        QPointF m_blue;
+        QPointF m_white;
+    };
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT SurfaceColorManagement
+            : public QtWaylandServer::xx_color_management_surface_v4
+    {
+    public:
+        SurfaceColorManagement(QWaylandSurface *surface, wl_client *client, quint32 id, quint32 version);
+        ~SurfaceColorManagement() override;
+
+    protected:
+        void xx_color_management_surface_v4_destroy_resource(Resource *resource) override;
+        void xx_color_management_surface_v4_destroy(Resource *resource) override;
+        void xx_color_management_surface_v4_set_image_description(Resource *resource, wl_resource *imageDescription, uint32_t renderIntent) override;
+        void xx_color_management_surface_v4_unset_image_description(Resource *resource) override;
+
+    private:
+        QPointer<QWaylandSurface> m_surface;
+    };
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT OutputColorManagement
+            : public QtWaylandServer::xx_color_management_output_v4
+    {
+    public:
+        OutputColorManagement(QWaylandColorManagementPrivate *manager, wl_client *client, quint32 id,
+                              quint32 version);
+
+    protected:
+        void xx_color_management_output_v4_destroy_resource(Resource *resource) override;
+        void xx_color_management_output_v4_destroy(Resource *resource) override;
+        void xx_color_management_output_v4_get_image_description(Resource *resource, uint32_t imageDescription) override;
+
+    private:
+        QPointer<QWaylandColorManagement> m_manager;
+    };
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT FeedbackSurface
+            : public QtWaylandServer::xx_color_management_feedback_surface_v4
+    {
+    public:
+        FeedbackSurface(QWaylandColorManagementPrivate *manager, QWaylandSurface *surface,
+                        wl_client *client, quint32 id, quint32 version);
+
+    protected:
+        void xx_color_management_feedback_surface_v4_destroy_resource(Resource *resource) override;
+        void xx_color_management_feedback_surface_v4_destroy(Resource *resource) override;
+        void xx_color_management_feedback_surface_v4_get_preferred(Resource *resource, uint32_t imageDescription) override;
+
+    private:
+        QPointer<QWaylandColorManagement> m_manager;
+        QPointer<QWaylandSurface> m_surface;
+    };
+
+    static QWaylandColorManagementPrivate *get(QWaylandColorManagement *manager) { return manager ? manager->d_func() : nullptr; }
+
+    // The description of outputs and the one preferred for surfaces, which is sRGB
+    static Description preferredDescription();
+
+    ImageDescription *createImageDescription(const Description &description, bool hasInformation,
+                                             wl_client *client, quint32 id, quint32 version);
+
+protected:
+    void xx_color_manager_v4_bind_resource(Resource *resource) override;
+    void xx_color_manager_v4_destroy(Resource *resource) override;
+    void xx_color_manager_v4_get_output(Resource *resource, uint32_t id, wl_resource *output) override;
+    void xx_color_manager_v4_get_surface(Resource *resource, uint32_t id, wl_resource *surface) override;
+    void xx_color_manager_v4_get_feedback_surface(Resource *resource, uint32_t id, wl_resource *surface) override;
+    void xx_color_manager_v4_new_icc_creator(Resource *resource, uint32_t obj) override;
+    void xx_color_manager_v4_new_parametric_creator(Resource *resource, uint32_t obj) override;
+
+private:
+    quint32 m_nextIdentity = 1;
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDCOLORMANAGEMENT_P_H
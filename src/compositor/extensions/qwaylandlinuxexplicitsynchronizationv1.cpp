@@ -0,0 +1,261 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qwaylandlinuxexplicitsynchronizationv1_p.h"
+
+#include <QtWaylandCompositor/QWaylandCompositor>
+#include <QtWaylandCompositor/QWaylandSurface>
+#include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+#include <QtWaylandCompositor/private/qwlclientbuffer_p.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QWaylandLinuxExplicitSynchronizationV1
+    \inmodule QtWaylandCompositor
+    \since 6.10
+    \brief Provides an extension for passing fences along with client buffers.
+
+    The QWaylandLinuxExplicitSynchronizationV1 extension lets clients attach an acquire fence
+    to a buffer they commit, which is signaled once the client has finished rendering into it.
+    The compositor keeps showing the previous buffer until the fence is signaled, and only
+    then applies the commit, instead of relying on implicit synchronization. In turn, clients
+    can ask for a release event per commit, which may carry a fence that is signaled once the
+    compositor has finished sampling the buffer. This lets clients reuse buffers earlier than
+    with \c wl_buffer.release.
+
+    QWaylandLinuxExplicitSynchronizationV1 corresponds to the Wayland interface,
+    \c zwp_linux_explicit_synchronization_v1. Acquire fences are supported for buffers
+    created with \c zwp_linux_dmabuf_v1, release events for all buffers.
+*/
+
+/*!
+    \qmltype LinuxExplicitSynchronizationV1
+    \nativetype QWaylandLinuxExplicitSynchronizationV1
+    \inqmlmodule QtWayland.Compositor
+    \since 6.10
+    \brief Provides an extension for passing fences along with client buffers.
+
+    The LinuxExplicitSynchronizationV1 extension lets clients attach an acquire fence to the
+    buffers they commit, and get a release fence back when the compositor is done with them.
+
+    LinuxExplicitSynchronizationV1 corresponds to the Wayland interface,
+    \c zwp_linux_explicit_synchronization_v1.
+
+    To provide the functionality of the extension in a compositor, create an instance of the
+    LinuxExplicitSynchronizationV1 component and add it to the list of extensions supported by
+    the compositor:
+
+    \qml
+    import QtWayland.Compositor
+
+    WaylandCompositor {
+        LinuxExplicitSynchronizationV1 {
+            // ...
+        }
+    }
+    \endqml
+*/
+
+/*!
+    Constructs a QWaylandLinuxExplicitSynchronizationV1 object.
+*/
+QWaylandLinuxExplicitSynchronizationV1::QWaylandLinuxExplicitSynchronizationV1()
+    : QWaylandCompositorExtensionTemplate<QWaylandLinuxExplicitSynchronizationV1>(*new QWaylandLinuxExplicitSynchronizationV1Private)
+{
+}
+
+/*!
+    Constructs a QWaylandLinuxExplicitSynchronizationV1 object for the provided \a compositor.
+*/
+QWaylandLinuxExplicitSynchronizationV1::QWaylandLinuxExplicitSynchronizationV1(QWaylandCompositor *compositor)
+    : QWaylandCompositorExtensionTemplate<QWaylandLinuxExplicitSynchronizationV1>(compositor, *new QWaylandLinuxExplicitSynchronizationV1Private)
+{
+}
+
+/*!
+    Destructs a QWaylandLinuxExplicitSynchronizationV1 object.
+*/
+QWaylandLinuxExplicitSynchronizationV1::~QWaylandLinuxExplicitSynchronizationV1() = default;
+
+/*!
+    Initializes the extension.
+*/
+void QWaylandLinuxExplicitSynchronizationV1::initialize()
+{
+    Q_D(QWaylandLinuxExplicitSynchronizationV1);
+
+    QWaylandCompositorExtensionTemplate::initialize();
+    auto *compositor = static_cast<QWaylandCompositor *>(extensionContainer());
+    if (!compositor) {
+        qWarning() << "Failed to find QWaylandCompositor when initializing QWaylandLinuxExplicitSynchronizationV1";
+        return;
+    }
+    d->init(compositor->display(), 2);
+}
+
+/*!
+    Returns the Wayland interface for the QWaylandLinuxExplicitSynchronizationV1.
+*/
+const wl_interface *QWaylandLinuxExplicitSynchronizationV1::interface()
+{
+    return QWaylandLinuxExplicitSynchronizationV1Private::interface();
+}
+
+void QWaylandLinuxExplicitSynchronizationV1Private::zwp_linux_explicit_synchronization_v1_destroy(Resource *resource)
+{
+    // Synchronization objects are allowed to outlive the factory
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandLinuxExplicitSynchronizationV1Private::zwp_linux_explicit_synchronization_v1_get_synchronization(Resource *resource, uint32_t id, wl_resource *surfaceResource)
+{
+    auto *surface = QWaylandSurface::fromResource(surfaceResource);
+    if (!surface) {
+        qWarning() << "Couldn't find surface for explicit synchronization";
+        return;
+    }
+
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(surface);
+    if (surfacePrivate->synchronization) {
+        wl_resource_post_error(resource->handle, error_synchronization_exists,
+                               "explicit synchronization already exists for surface");
+        return;
+    }
+
+    surfacePrivate->synchronization = new SurfaceSynchronization(surface, resource->client(), id, resource->version());
+}
+
+QWaylandLinuxExplicitSynchronizationV1Private::SurfaceSynchronization::SurfaceSynchronization(QWaylandSurface *surface,
+                                                                                              wl_client *client,
+                                                                                              quint32 id,
+                                                                                              quint32 version)
+    : QtWaylandServer::zwp_linux_surface_synchronization_v1(client, id, version)
+    , m_surface(surface)
+{
+    Q_ASSERT(surface);
+}
+
+QWaylandLinuxExplicitSynchronizationV1Private::SurfaceSynchronization::~SurfaceSynchronization()
+{
+    if (m_surface) {
+        auto *surfacePrivate = QWaylandSurfacePrivate::get(m_surface);
+        Q_ASSERT(surfacePrivate->synchronization == this);
+        surfacePrivate->synchronization = nullptr;
+    }
+}
+
+// Called while committing, before the pending state of the surface is cleared
+QtWayland::SyncFence QWaylandLinuxExplicitSynchronizationV1Private::SurfaceSynchronization::applyState(QtWayland::ClientBuffer *buffer)
+{
+    if (!m_acquireFence.isValid() && !m_release)
+        return QtWayland::SyncFence();
+
+    if (!QtWayland::ClientBuffer::hasContent(buffer)) {
+        wl_resource_post_error(resource()->handle, error_no_buffer,
+                               "fence or release requested without attaching a buffer");
+        m_acquireFence = QtWayland::SyncFence();
+        return QtWayland::SyncFence();
+    }
+
+    if (m_acquireFence.isValid() && !buffer->supportsAcquireFence()) {
+        wl_resource_post_error(resource()->handle, error_unsupported_buffer,
+                               "buffer does not support explicit synchronization");
+        m_acquireFence = QtWayland::SyncFence();
+        return QtWayland::SyncFence();
+    }
+
+    if (m_release)
+        buffer->setBufferRelease(std::exchange(m_release, nullptr));
+
+    return std::move(m_acquireFence);
+}
+
+void QWaylandLinuxExplicitSynchronizationV1Private::SurfaceSynchronization::zwp_linux_surface_synchronization_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void QWaylandLinuxExplicitSynchronizationV1Private::SurfaceSynchronization::zwp_linux_surface_synchronization_v1_destroy(Resource *resource)
+{
+    // A release requested since the last commit would never be sent otherwise, and nothing
+    // has used a buffer for that commit yet
+    if (m_release)
+        std::exchange(m_release, nullptr)->sendRelease(QtWayland::SyncFence());
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandLinuxExplicitSynchronizationV1Private::SurfaceSynchronization::zwp_linux_surface_synchronization_v1_set_acquire_fence(Resource *resource, int32_t fd)
+{
+    QtWayland::SyncFence fence(fd);
+
+    if (!m_surface) {
+        wl_resource_post_error(resource->handle, error_no_surface,
+                               "set_acquire_fence requested for destroyed surface");
+        return;
+    }
+
+    if (m_acquireFence.isValid()) {
+        wl_resource_post_error(resource->handle, error_duplicate_fence,
+                               "acquire fence already set for this commit");
+        return;
+    }
+
+    if (!fence.isSyncFile()) {
+        wl_resource_post_error(resource->handle, error_invalid_fence,
+                               "acquire fence is not a sync_file");
+        return;
+    }
+
+    m_acquireFence = std::move(fence);
+}
+
+void QWaylandLinuxExplicitSynchronizationV1Private::SurfaceSynchronization::zwp_linux_surface_synchronization_v1_get_release(Resource *resource, uint32_t release)
+{
+    if (!m_surface) {
+        wl_resource_post_error(resource->handle, error_no_surface,
+                               "get_release requested for destroyed surface");
+        return;
+    }
+
+    if (m_release) {
+        wl_resource_post_error(resource->handle, error_duplicate_release,
+                               "release already requested for this commit");
+        return;
+    }
+
+    m_release = new BufferRelease(resource->client(), release, resource->version());
+}
+
+QWaylandLinuxExplicitSynchronizationV1Private::BufferRelease::BufferRelease(wl_client *client, quint32 id,
+                                                                            quint32 version)
+    : QtWaylandServer::zwp_linux_buffer_release_v1(client, id, version)
+{
+}
+
+QWaylandLinuxExplicitSynchronizationV1Private::BufferRelease::~BufferRelease()
+{
+    if (m_buffer)
+        m_buffer->detachBufferRelease(this);
+}
+
+void QWaylandLinuxExplicitSynchronizationV1Private::BufferRelease::sendRelease(QtWayland::SyncFence &&fence)
+{
+    m_buffer = nullptr;
+    if (fence.isValid())
+        send_fenced_release(fence.fd());
+    else
+        send_immediate_release();
+    wl_resource_destroy(resource()->handle);
+}
+
+void QWaylandLinuxExplicitSynchronizationV1Private::BufferRelease::zwp_linux_buffer_release_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qwaylandlinuxexplicitsynchronizationv1.cpp"
@@ -0,0 +1,30 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDLINUXEXPLICITSYNCHRONIZATIONV1_H
+#define QWAYLANDLINUXEXPLICITSYNCHRONIZATIONV1_H
+
+#include <QtWaylandCompositor/QWaylandCompositorExtension>
+
+QT_BEGIN_NAMESPACE
+
+class QWaylandLinuxExplicitSynchronizationV1Private;
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandLinuxExplicitSynchronizationV1
+        : public QWaylandCompositorExtensionTemplate<QWaylandLinuxExplicitSynchronizationV1>
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QWaylandLinuxExplicitSynchronizationV1)
+public:
+    QWaylandLinuxExplicitSynchronizationV1();
+    explicit QWaylandLinuxExplicitSynchronizationV1(QWaylandCompositor *compositor);
+    ~QWaylandLinuxExplicitSynchronizationV1() override;
+
+    void initialize() override;
+
+    static const struct wl_interface *interface();
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDLINUXEXPLICITSYNCHRONIZATIONV1_H
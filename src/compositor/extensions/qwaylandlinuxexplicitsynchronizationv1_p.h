@@ -0,0 +1,91 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDLINUXEXPLICITSYNCHRONIZATIONV1_P_H
+#define QWAYLANDLINUXEXPLICITSYNCHRONIZATIONV1_P_H
+
+#include "qwaylandlinuxexplicitsynchronizationv1.h"
+
+#include <QtWaylandCompositor/private/qwaylandcompositorextension_p.h>
+#include <QtWaylandCompositor/private/qwayland-server-linux-explicit-synchronization-unstable-v1.h>
+#include <QtWaylandCompositor/private/qwlsyncfence_p.h>
+
+#include <QtCore/qpointer.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QWaylandSurface;
+
+namespace QtWayland {
+class ClientBuffer;
+}
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandLinuxExplicitSynchronizationV1Private
+        : public QWaylandCompositorExtensionPrivate
+        , public QtWaylandServer::zwp_linux_explicit_synchronization_v1
+{
+    Q_DECLARE_PUBLIC(QWaylandLinuxExplicitSynchronizationV1)
+public:
+    explicit QWaylandLinuxExplicitSynchronizationV1Private() = default;
+
+    // Sends exactly one event for the commit it was requested for, and destroys itself
+    class Q_WAYLANDCOMPOSITOR_EXPORT BufferRelease
+            : public QtWaylandServer::zwp_linux_buffer_release_v1
+    {
+    public:
+        BufferRelease(wl_client *client, quint32 id, quint32 version);
+        ~BufferRelease() override;
+
+        void setBuffer(QtWayland::ClientBuffer *buffer) { m_buffer = buffer; }
+        // With an invalid fence the buffer may be reused right away
+        void sendRelease(QtWayland::SyncFence &&fence);
+
+    protected:
+        void zwp_linux_buffer_release_v1_destroy_resource(Resource *resource) override;
+
+    private:
+        QtWayland::ClientBuffer *m_buffer = nullptr;
+    };
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT SurfaceSynchronization
+            : public QtWaylandServer::zwp_linux_surface_synchronization_v1
+    {
+    public:
+        SurfaceSynchronization(QWaylandSurface *surface, wl_client *client, quint32 id, quint32 version);
+        ~SurfaceSynchronization() override;
+
+        // Hands the release requested since the last commit to the buffer attached with this
+        // commit, which is null if none was, and returns the fence to wait for before applying it
+        QtWayland::SyncFence applyState(QtWayland::ClientBuffer *buffer);
+
+    protected:
+        void zwp_linux_surface_synchronization_v1_destroy_resource(Resource *resource) override;
+        void zwp_linux_surface_synchronization_v1_destroy(Resource *resource) override;
+        void zwp_linux_surface_synchronization_v1_set_acquire_fence(Resource *resource, int32_t fd) override;
+        void zwp_linux_surface_synchronization_v1_get_release(Resource *resource, uint32_t release) override;
+
+    private:
+        QPointer<QWaylandSurface> m_surface;
+        QtWayland::SyncFence m_acquireFence;
+        BufferRelease *m_release = nullptr;
+    };
+
+protected:
+    void zwp_linux_explicit_synchronization_v1_destroy(Resource *resource) override;
+    void zwp_linux_explicit_synchronization_v1_get_synchronization(Resource *resource, uint32_t id, wl_resource *surface) override;
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDLINUXEXPLICITSYNCHRONIZATIONV1_P_H
@@ -0,0 +1,378 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtWaylandCompositor/QWaylandCompositor>
+#include <QtWaylandCompositor/private/qwaylandpointer_p.h>
+#include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+#include <QtWaylandCompositor/private/qwlregion_p.h>
+
+#include "qwaylandpointerconstraintsv1_p.h"
+
+#include <QtCore/QLineF>
+#include <QtCore/qmath.h>
+
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QWaylandPointerConstraintsV1
+    \inmodule QtWaylandCompositor
+    \since 6.10
+    \brief Provides an extension that allows clients to lock or confine the pointer.
+
+    The QWaylandPointerConstraintsV1 extension lets a client lock the pointer in place, or
+    confine it to a region of one of its surfaces, while that surface has pointer focus.
+    While the pointer is locked, QWaylandPointer stops sending absolute motion to the client;
+    relative motion from QWaylandRelativePointerManagerV1 keeps flowing. While it is confined,
+    the position sent to the client is kept within the confinement region.
+
+    A constraint activates once the pointer moves into its region on the surface, unless
+    another surface has keyboard focus. While it is active, the pointer keeps its focus on the
+    surface: moves reported for other views are applied relative to the last position on it.
+    The constraint is deactivated when another surface gets keyboard focus, when the surface
+    is unmapped, or when the compositor moves pointer focus with QWaylandSeat::setMouseFocus().
+
+    QWaylandPointerConstraintsV1 corresponds to the Wayland interface,
+    \c zwp_pointer_constraints_v1.
+*/
+
+/*!
+    \qmltype PointerConstraintsV1
+    \nativetype QWaylandPointerConstraintsV1
+    \inqmlmodule QtWayland.Compositor
+    \since 6.10
+    \brief Provides an extension that allows clients to lock or confine the pointer.
+
+    The PointerConstraintsV1 extension lets a client lock the pointer in place, or confine
+    it to a region of one of its surfaces, while that surface has pointer focus.
+
+    PointerConstraintsV1 corresponds to the Wayland interface, \c zwp_pointer_constraints_v1.
+
+    To provide the functionality of the extension in a compositor, create an instance of the
+    PointerConstraintsV1 component and add it to the list of extensions supported by the
+    compositor:
+
+    \qml
+    import QtWayland.Compositor
+
+    WaylandCompositor {
+        PointerConstraintsV1 {
+            // ...
+        }
+    }
+    \endqml
+*/
+
+/*!
+    Constructs a QWaylandPointerConstraintsV1 object.
+*/
+QWaylandPointerConstraintsV1::QWaylandPointerConstraintsV1()
+    : QWaylandCompositorExtensionTemplate<QWaylandPointerConstraintsV1>(*new QWaylandPointerConstraintsV1Private())
+{
+}
+
+/*!
+    Constructs a QWaylandPointerConstraintsV1 object for the provided \a compositor.
+*/
+QWaylandPointerConstraintsV1::QWaylandPointerConstraintsV1(QWaylandCompositor *compositor)
+    : QWaylandCompositorExtensionTemplate<QWaylandPointerConstraintsV1>(compositor, *new QWaylandPointerConstraintsV1Private())
+{
+}
+
+/*!
+    Destructs a QWaylandPointerConstraintsV1 object.
+*/
+QWaylandPointerConstraintsV1::~QWaylandPointerConstraintsV1() = default;
+
+/*!
+    Initializes the extension.
+*/
+void QWaylandPointerConstraintsV1::initialize()
+{
+    Q_D(QWaylandPointerConstraintsV1);
+
+    QWaylandCompositorExtensionTemplate::initialize();
+    QWaylandCompositor *compositor = static_cast<QWaylandCompositor *>(extensionContainer());
+    if (!compositor) {
+        qCWarning(qLcWaylandCompositor) << "Failed to find QWaylandCompositor when initializing QWaylandPointerConstraintsV1";
+        return;
+    }
+    d->init(compositor->display(), d->interfaceVersion());
+}
+
+/*!
+    Returns the Wayland interface for the QWaylandPointerConstraintsV1.
+*/
+const wl_interface *QWaylandPointerConstraintsV1::interface()
+{
+    return QWaylandPointerConstraintsV1Private::interface();
+}
+
+void QWaylandPointerConstraintsV1Private::zwp_pointer_constraints_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+bool QWaylandPointerConstraintsV1Private::checkConstraintRequest(Resource *resource,
+                                                                 wl_resource *surfaceResource,
+                                                                 wl_resource *pointerResource,
+                                                                 uint32_t lifetime,
+                                                                 QWaylandSurface **surface,
+                                                                 QWaylandPointer **pointer)
+{
+    *surface = QWaylandSurface::fromResource(surfaceResource);
+    if (!*surface) {
+        wl_resource_post_error(resource->handle, WL_DISPLAY_ERROR_INVALID_OBJECT,
+                               "invalid wl_surface@%d", wl_resource_get_id(surfaceResource));
+        return false;
+    }
+
+    *pointer = QWaylandPointerPrivate::fromResource(pointerResource);
+    if (!*pointer) {
+        wl_resource_post_error(resource->handle, WL_DISPLAY_ERROR_INVALID_OBJECT,
+                               "invalid wl_pointer@%d", wl_resource_get_id(pointerResource));
+        return false;
+    }
+
+    if (lifetime != lifetime_oneshot && lifetime != lifetime_persistent) {
+        wl_resource_post_error(resource->handle, WL_DISPLAY_ERROR_INVALID_METHOD,
+                               "invalid constraint lifetime %u", lifetime);
+        return false;
+    }
+
+    // A QWaylandPointer serves all wl_pointers of its seat, so this covers every pointer
+    // the client may have created for the seat.
+    if (QWaylandPointerPrivate::get(*pointer)->constraintFor(*surface)) {
+        wl_resource_post_error(resource->handle, error_already_constrained,
+                               "the pointer is already constrained to wl_surface@%d",
+                               wl_resource_get_id(surfaceResource));
+        return false;
+    }
+
+    return true;
+}
+
+void QWaylandPointerConstraintsV1Private::zwp_pointer_constraints_v1_lock_pointer(Resource *resource, uint32_t id,
+                                                                                  wl_resource *surfaceResource,
+                                                                                  wl_resource *pointerResource,
+                                                                                  wl_resource *region,
+                                                                                  uint32_t lifetime)
+{
+    QWaylandSurface *surface = nullptr;
+    QWaylandPointer *pointer = nullptr;
+    if (!checkConstraintRequest(resource, surfaceResource, pointerResource, lifetime, &surface, &pointer))
+        return;
+
+    new LockedPointer(surface, pointer, region, lifetime, resource->client(), id, resource->version());
+}
+
+void QWaylandPointerConstraintsV1Private::zwp_pointer_constraints_v1_confine_pointer(Resource *resource, uint32_t id,
+                                                                                     wl_resource *surfaceResource,
+                                                                                     wl_resource *pointerResource,
+                                                                                     wl_resource *region,
+                                                                                     uint32_t lifetime)
+{
+    QWaylandSurface *surface = nullptr;
+    QWaylandPointer *pointer = nullptr;
+    if (!checkConstraintRequest(resource, surfaceResource, pointerResource, lifetime, &surface, &pointer))
+        return;
+
+    new ConfinedPointer(surface, pointer, region, lifetime, resource->client(), id, resource->version());
+}
+
+QWaylandPointerConstraintsV1Private::Constraint::Constraint(Type type, QWaylandSurface *surface,
+                                                            QWaylandPointer *pointer,
+                                                            wl_resource *region, uint32_t lifetime)
+    : m_type(type)
+    , m_surface(surface)
+    , m_pointer(pointer)
+    , m_persistent(lifetime == lifetime_persistent)
+{
+    if (region) {
+        m_region = QtWayland::Region::fromResource(region)->region();
+        m_hasRegion = true;
+    }
+
+    // The region set with set_region is double-buffered state of the surface,
+    // and unmapping the surface ends the constraint
+    m_commitConnection = QObject::connect(surface, &QWaylandSurface::redraw, surface, [this] {
+        applyPendingState();
+        if (!m_surface->hasContent())
+            deactivate();
+    });
+
+    QWaylandPointerPrivate::get(pointer)->constraints.append(this);
+}
+
+QWaylandPointerConstraintsV1Private::Constraint::~Constraint()
+{
+    QObject::disconnect(m_commitConnection);
+    if (m_pointer)
+        QWaylandPointerPrivate::get(m_pointer.data())->constraints.removeOne(this);
+}
+
+// The region the pointer has to be in for the constraint to activate, in surface coordinates
+QRegion QWaylandPointerConstraintsV1Private::Constraint::region() const
+{
+    if (!m_surface)
+        return QRegion();
+
+    const QRegion inputRegion = QWaylandSurfacePrivate::get(m_surface.data())->inputRegion;
+    return m_hasRegion ? inputRegion.intersected(m_region) : inputRegion;
+}
+
+bool QWaylandPointerConstraintsV1Private::Constraint::canActivate(const QPointF &position) const
+{
+    if (m_active || m_defunct || !m_surface || !m_surface->hasContent())
+        return false;
+    return region().contains(QPoint(qFloor(position.x()), qFloor(position.y())));
+}
+
+void QWaylandPointerConstraintsV1Private::Constraint::activate(const QPointF &position)
+{
+    Q_ASSERT(!m_active && !m_defunct);
+    m_active = true;
+    m_lockPosition = position;
+    sendActivated();
+}
+
+void QWaylandPointerConstraintsV1Private::Constraint::deactivate()
+{
+    if (!m_active)
+        return;
+    m_active = false;
+    m_defunct = !m_persistent;
+    sendDeactivated();
+}
+
+QPointF QWaylandPointerConstraintsV1Private::Constraint::confine(const QPointF &position) const
+{
+    const QRegion confinement = region();
+    if (confinement.isEmpty()
+            || confinement.contains(QPoint(qFloor(position.x()), qFloor(position.y())))) {
+        return position;
+    }
+
+    // Move the pointer to the closest point inside the region. The upper bounds of the
+    // rectangles are exclusive, so stay one wl_fixed step inside them.
+    constexpr qreal step = 1.0 / 256;
+    QPointF closest = position;
+    qreal closestDistance = std::numeric_limits<qreal>::max();
+    for (const QRect &rect : confinement) {
+        const QPointF candidate(qBound<qreal>(rect.left(), position.x(), rect.left() + rect.width() - step),
+                                qBound<qreal>(rect.top(), position.y(), rect.top() + rect.height() - step));
+        const qreal distance = QLineF(position, candidate).length();
+        if (distance < closestDistance) {
+            closestDistance = distance;
+            closest = candidate;
+        }
+    }
+    return closest;
+}
+
+void QWaylandPointerConstraintsV1Private::Constraint::setPendingRegion(wl_resource *region)
+{
+    m_pendingRegion = region ? QtWayland::Region::fromResource(region)->region() : QRegion();
+    m_hasPendingRegion = region != nullptr;
+    m_pendingRegionChanged = true;
+}
+
+void QWaylandPointerConstraintsV1Private::Constraint::applyPendingState()
+{
+    if (!m_pendingRegionChanged)
+        return;
+    m_pendingRegionChanged = false;
+    m_region = m_pendingRegion;
+    m_hasRegion = m_hasPendingRegion;
+}
+
+QWaylandPointerConstraintsV1Private::LockedPointer::LockedPointer(QWaylandSurface *surface,
+                                                                  QWaylandPointer *pointer,
+                                                                  wl_resource *region, uint32_t lifetime,
+                                                                  wl_client *client, quint32 id,
+                                                                  quint32 version)
+    : Constraint(Type::Lock, surface, pointer, region, lifetime)
+    , QtWaylandServer::zwp_locked_pointer_v1(client, id, qMin<quint32>(version, interfaceVersion()))
+{
+}
+
+void QWaylandPointerConstraintsV1Private::LockedPointer::sendActivated()
+{
+    send_locked();
+}
+
+void QWaylandPointerConstraintsV1Private::LockedPointer::sendDeactivated()
+{
+    send_unlocked();
+}
+
+void QWaylandPointerConstraintsV1Private::LockedPointer::zwp_locked_pointer_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void QWaylandPointerConstraintsV1Private::LockedPointer::zwp_locked_pointer_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandPointerConstraintsV1Private::LockedPointer::zwp_locked_pointer_v1_set_cursor_position_hint(Resource *resource,
+                                                                                                      wl_fixed_t surface_x,
+                                                                                                      wl_fixed_t surface_y)
+{
+    // The compositor doesn't warp its cursor when unlocking, so there is no use for the hint
+    Q_UNUSED(resource);
+    Q_UNUSED(surface_x);
+    Q_UNUSED(surface_y);
+}
+
+void QWaylandPointerConstraintsV1Private::LockedPointer::zwp_locked_pointer_v1_set_region(Resource *resource,
+                                                                                        wl_resource *region)
+{
+    Q_UNUSED(resource);
+    setPendingRegion(region);
+}
+
+QWaylandPointerConstraintsV1Private::ConfinedPointer::ConfinedPointer(QWaylandSurface *surface,
+                                                                      QWaylandPointer *pointer,
+                                                                      wl_resource *region, uint32_t lifetime,
+                                                                      wl_client *client, quint32 id,
+                                                                      quint32 version)
+    : Constraint(Type::Confine, surface, pointer, region, lifetime)
+    , QtWaylandServer::zwp_confined_pointer_v1(client, id, qMin<quint32>(version, interfaceVersion()))
+{
+}
+
+void QWaylandPointerConstraintsV1Private::ConfinedPointer::sendActivated()
+{
+    send_confined();
+}
+
+void QWaylandPointerConstraintsV1Private::ConfinedPointer::sendDeactivated()
+{
+    send_unconfined();
+}
+
+void QWaylandPointerConstraintsV1Private::ConfinedPointer::zwp_confined_pointer_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void QWaylandPointerConstraintsV1Private::ConfinedPointer::zwp_confined_pointer_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandPointerConstraintsV1Private::ConfinedPointer::zwp_confined_pointer_v1_set_region(Resource *resource,
+                                                                                            wl_resource *region)
+{
+    Q_UNUSED(resource);
+    setPendingRegion(region);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qwaylandpointerconstraintsv1.cpp"
@@ -0,0 +1,29 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDPOINTERCONSTRAINTSV1_H
+#define QWAYLANDPOINTERCONSTRAINTSV1_H
+
+#include <QtWaylandCompositor/QWaylandCompositorExtension>
+
+QT_BEGIN_NAMESPACE
+
+class QWaylandPointerConstraintsV1Private;
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandPointerConstraintsV1 : public QWaylandCompositorExtensionTemplate<QWaylandPointerConstraintsV1>
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QWaylandPointerConstraintsV1)
+public:
+    QWaylandPointerConstraintsV1();
+    explicit QWaylandPointerConstraintsV1(QWaylandCompositor *compositor);
+    ~QWaylandPointerConstraintsV1();
+
+    void initialize() override;
+
+    static const struct wl_interface *interface();
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDPOINTERCONSTRAINTSV1_H
@@ -0,0 +1,145 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDPOINTERCONSTRAINTSV1_P_H
+#define QWAYLANDPOINTERCONSTRAINTSV1_P_H
+
+#include <QtWaylandCompositor/QWaylandSurface>
+#include <QtWaylandCompositor/QWaylandPointerConstraintsV1>
+#include <QtWaylandCompositor/private/qwaylandcompositorextension_p.h>
+#include <QtWaylandCompositor/private/qwayland-server-pointer-constraints-unstable-v1.h>
+
+#include <QtCore/qpointer.h>
+#include <QtGui/qregion.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QWaylandPointer;
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandPointerConstraintsV1Private
+        : public QWaylandCompositorExtensionPrivate
+        , public QtWaylandServer::zwp_pointer_constraints_v1
+{
+    Q_DECLARE_PUBLIC(QWaylandPointerConstraintsV1)
+public:
+    explicit QWaylandPointerConstraintsV1Private() = default;
+
+    // A lock or confinement of a seat's pointer to a surface. It activates when the
+    // pointer moves into its region while the surface has pointer focus, and holds the
+    // pointer there until keyboard focus moves elsewhere, the surface is unmapped, or
+    // pointer focus is taken away explicitly.
+    class Q_WAYLANDCOMPOSITOR_EXPORT Constraint
+    {
+    public:
+        enum class Type {
+            Lock,
+            Confine
+        };
+
+        Constraint(Type type, QWaylandSurface *surface, QWaylandPointer *pointer,
+                   wl_resource *region, uint32_t lifetime);
+        virtual ~Constraint();
+
+        Type type() const { return m_type; }
+        QWaylandSurface *surface() const { return m_surface; }
+        bool isActive() const { return m_active; }
+
+        QRegion region() const;
+        bool canActivate(const QPointF &position) const;
+        void activate(const QPointF &position);
+        void deactivate();
+
+        QPointF lockPosition() const { return m_lockPosition; }
+        QPointF confine(const QPointF &position) const;
+
+    protected:
+        virtual void sendActivated() = 0;
+        virtual void sendDeactivated() = 0;
+
+        void setPendingRegion(wl_resource *region);
+
+    private:
+        void applyPendingState();
+
+        Type m_type;
+        QPointer<QWaylandSurface> m_surface;
+        QPointer<QWaylandPointer> m_pointer;
+        QMetaObject::Connection m_commitConnection;
+        bool m_persistent = false;
+        bool m_active = false;
+        bool m_defunct = false;
+        QPointF m_lockPosition;
+
+        QRegion m_region;
+        bool m_hasRegion = false;
+        QRegion m_pendingRegion;
+        bool m_hasPendingRegion = false;
+        bool m_pendingRegionChanged = false;
+    };
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT LockedPointer
+            : public Constraint
+            , public QtWaylandServer::zwp_locked_pointer_v1
+    {
+    public:
+        LockedPointer(QWaylandSurface *surface, QWaylandPointer *pointer, wl_resource *region,
+                      uint32_t lifetime, wl_client *client, quint32 id, quint32 version);
+
+    protected:
+        void sendActivated() override;
+        void sendDeactivated() override;
+
+        void zwp_locked_pointer_v1_destroy_resource(Resource *resource) override;
+        void zwp_locked_pointer_v1_destroy(Resource *resource) override;
+        void zwp_locked_pointer_v1_set_cursor_position_hint(Resource *resource, wl_fixed_t surface_x, wl_fixed_t surface_y) override;
+        void zwp_locked_pointer_v1_set_region(Resource *resource, wl_resource *region) override;
+    };
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT ConfinedPointer
+            : public Constraint
+            , public QtWaylandServer::zwp_confined_pointer_v1
+    {
+    public:
+        ConfinedPointer(QWaylandSurface *surface, QWaylandPointer *pointer, wl_resource *region,
+                        uint32_t lifetime, wl_client *client, quint32 id, quint32 version);
+
+    protected:
+        void sendActivated() override;
+        void sendDeactivated() override;
+
+        void zwp_confined_pointer_v1_destroy_resource(Resource *resource) override;
+        void zwp_confined_pointer_v1_destroy(Resource *resource) override;
+        void zwp_confined_pointer_v1_set_region(Resource *resource, wl_resource *region) override;
+    };
+
+    static QWaylandPointerConstraintsV1Private *get(QWaylandPointerConstraintsV1 *constraints) { return constraints ? constraints->d_func() : nullptr; }
+
+protected:
+    void zwp_pointer_constraints_v1_destroy(Resource *resource) override;
+    void zwp_pointer_constraints_v1_lock_pointer(Resource *resource, uint32_t id, wl_resource *surface,
+                                                 wl_resource *pointer, wl_resource *region,
+                                                 uint32_t lifetime) override;
+    void zwp_pointer_constraints_v1_confine_pointer(Resource *resource, uint32_t id, wl_resource *surface,
+                                                    wl_resource *pointer, wl_resource *region,
+                                                    uint32_t lifetime) override;
+
+private:
+    bool checkConstraintRequest(Resource *resource, wl_resource *surfaceResource,
+                                wl_resource *pointerResource, uint32_t lifetime,
+                                QWaylandSurface **surface, QWaylandPointer **pointer);
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDPOINTERCONSTRAINTSV1_P_H
@@ -0,0 +1,159 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtWaylandCompositor/QWaylandCompositor>
+#include <QtWaylandCompositor/private/qwaylandpointer_p.h>
+
+#include "qwaylandrelativepointerv1_p.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QWaylandRelativePointerManagerV1
+    \inmodule QtWaylandCompositor
+    \since 6.10
+    \brief Provides an extension for sending relative pointer motion to clients.
+
+    The QWaylandRelativePointerManagerV1 extension lets clients receive pointer motion as
+    deltas that are not clipped by the edges of the output, along with the motion before
+    pointer acceleration was applied. Games and 3D viewers typically combine it with a
+    pointer lock from QWaylandPointerConstraintsV1.
+
+    Deltas are derived from consecutive calls to QWaylandPointer::sendMouseMoveEvent().
+    Compositors that have access to unaccelerated device motion should pass it to
+    QWaylandPointer::sendRelativeMotionEvent() instead.
+
+    QWaylandRelativePointerManagerV1 corresponds to the Wayland interface,
+    \c zwp_relative_pointer_manager_v1.
+*/
+
+/*!
+    \qmltype RelativePointerManagerV1
+    \nativetype QWaylandRelativePointerManagerV1
+    \inqmlmodule QtWayland.Compositor
+    \since 6.10
+    \brief Provides an extension for sending relative pointer motion to clients.
+
+    The RelativePointerManagerV1 extension lets clients receive pointer motion as deltas
+    that are not clipped by the edges of the output, along with the motion before pointer
+    acceleration was applied.
+
+    RelativePointerManagerV1 corresponds to the Wayland interface,
+    \c zwp_relative_pointer_manager_v1.
+
+    To provide the functionality of the extension in a compositor, create an instance of the
+    RelativePointerManagerV1 component and add it to the list of extensions supported by the
+    compositor:
+
+    \qml
+    import QtWayland.Compositor
+
+    WaylandCompositor {
+        RelativePointerManagerV1 {
+            // ...
+        }
+    }
+    \endqml
+*/
+
+/*!
+    Constructs a QWaylandRelativePointerManagerV1 object.
+*/
+QWaylandRelativePointerManagerV1::QWaylandRelativePointerManagerV1()
+    : QWaylandCompositorExtensionTemplate<QWaylandRelativePointerManagerV1>(*new QWaylandRelativePointerManagerV1Private())
+{
+}
+
+/*!
+    Constructs a QWaylandRelativePointerManagerV1 object for the provided \a compositor.
+*/
+QWaylandRelativePointerManagerV1::QWaylandRelativePointerManagerV1(QWaylandCompositor *compositor)
+    : QWaylandCompositorExtensionTemplate<QWaylandRelativePointerManagerV1>(compositor, *new QWaylandRelativePointerManagerV1Private())
+{
+}
+
+/*!
+    Destructs a QWaylandRelativePointerManagerV1 object.
+*/
+QWaylandRelativePointerManagerV1::~QWaylandRelativePointerManagerV1() = default;
+
+/*!
+    Initializes the extension.
+*/
+void QWaylandRelativePointerManagerV1::initialize()
+{
+    Q_D(QWaylandRelativePointerManagerV1);
+
+    QWaylandCompositorExtensionTemplate::initialize();
+    QWaylandCompositor *compositor = static_cast<QWaylandCompositor *>(extensionContainer());
+    if (!compositor) {
+        qCWarning(qLcWaylandCompositor) << "Failed to find QWaylandCompositor when initializing QWaylandRelativePointerManagerV1";
+        return;
+    }
+    d->init(compositor->display(), d->interfaceVersion());
+}
+
+/*!
+    Returns the Wayland interface for the QWaylandRelativePointerManagerV1.
+*/
+const wl_interface *QWaylandRelativePointerManagerV1::interface()
+{
+    return QWaylandRelativePointerManagerV1Private::interface();
+}
+
+void QWaylandRelativePointerManagerV1Private::zwp_relative_pointer_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandRelativePointerManagerV1Private::zwp_relative_pointer_manager_v1_get_relative_pointer(Resource *resource, uint32_t id, wl_resource *pointerResource)
+{
+    QWaylandPointer *pointer = QWaylandPointerPrivate::fromResource(pointerResource);
+    if (!pointer) {
+        wl_resource_post_error(resource->handle, WL_DISPLAY_ERROR_INVALID_OBJECT,
+                               "invalid wl_pointer@%d", wl_resource_get_id(pointerResource));
+        return;
+    }
+
+    new RelativePointer(pointer, resource->client(), id, resource->version());
+}
+
+QWaylandRelativePointerManagerV1Private::RelativePointer::RelativePointer(QWaylandPointer *pointer,
+                                                                          wl_client *client,
+                                                                          quint32 id, quint32 version)
+    : QtWaylandServer::zwp_relative_pointer_v1(client, id, qMin<quint32>(version, interfaceVersion()))
+    , m_pointer(pointer)
+{
+    QWaylandPointerPrivate::get(pointer)->relativePointers.append(this);
+}
+
+QWaylandRelativePointerManagerV1Private::RelativePointer::~RelativePointer()
+{
+    if (m_pointer)
+        QWaylandPointerPrivate::get(m_pointer.data())->relativePointers.removeOne(this);
+}
+
+void QWaylandRelativePointerManagerV1Private::RelativePointer::sendRelativeMotion(quint64 timestamp,
+                                                                                 const QPointF &delta,
+                                                                                 const QPointF &deltaUnaccelerated)
+{
+    send_relative_motion(uint32_t(timestamp >> 32), uint32_t(timestamp),
+                         wl_fixed_from_double(delta.x()), wl_fixed_from_double(delta.y()),
+                         wl_fixed_from_double(deltaUnaccelerated.x()),
+                         wl_fixed_from_double(deltaUnaccelerated.y()));
+}
+
+void QWaylandRelativePointerManagerV1Private::RelativePointer::zwp_relative_pointer_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void QWaylandRelativePointerManagerV1Private::RelativePointer::zwp_relative_pointer_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qwaylandrelativepointerv1.cpp"
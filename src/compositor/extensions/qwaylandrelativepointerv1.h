@@ -0,0 +1,29 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDRELATIVEPOINTERV1_H
+#define QWAYLANDRELATIVEPOINTERV1_H
+
+#include <QtWaylandCompositor/QWaylandCompositorExtension>
+
+QT_BEGIN_NAMESPACE
+
+class QWaylandRelativePointerManagerV1Private;
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandRelativePointerManagerV1 : public QWaylandCompositorExtensionTemplate<QWaylandRelativePointerManagerV1>
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QWaylandRelativePointerManagerV1)
+public:
+    QWaylandRelativePointerManagerV1();
+    explicit QWaylandRelativePointerManagerV1(QWaylandCompositor *compositor);
+    ~QWaylandRelativePointerManagerV1();
+
+    void initialize() override;
+
+    static const struct wl_interface *interface();
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDRELATIVEPOINTERV1_H
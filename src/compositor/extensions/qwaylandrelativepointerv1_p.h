@@ -0,0 +1,63 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDRELATIVEPOINTERV1_P_H
+#define QWAYLANDRELATIVEPOINTERV1_P_H
+
+#include <QtWaylandCompositor/QWaylandRelativePointerManagerV1>
+#include <QtWaylandCompositor/private/qwaylandcompositorextension_p.h>
+#include <QtWaylandCompositor/private/qwayland-server-relative-pointer-unstable-v1.h>
+
+#include <QtCore/qpointer.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QWaylandPointer;
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandRelativePointerManagerV1Private
+        : public QWaylandCompositorExtensionPrivate
+        , public QtWaylandServer::zwp_relative_pointer_manager_v1
+{
+    Q_DECLARE_PUBLIC(QWaylandRelativePointerManagerV1)
+public:
+    explicit QWaylandRelativePointerManagerV1Private() = default;
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT RelativePointer
+            : public QtWaylandServer::zwp_relative_pointer_v1
+    {
+    public:
+        explicit RelativePointer(QWaylandPointer *pointer, wl_client *client, quint32 id, quint32 version);
+        ~RelativePointer() override;
+
+        wl_client *client() const { return resource()->client(); }
+        void sendRelativeMotion(quint64 timestamp, const QPointF &delta, const QPointF &deltaUnaccelerated);
+
+    protected:
+        void zwp_relative_pointer_v1_destroy_resource(Resource *resource) override;
+        void zwp_relative_pointer_v1_destroy(Resource *resource) override;
+
+    private:
+        QPointer<QWaylandPointer> m_pointer;
+    };
+
+    static QWaylandRelativePointerManagerV1Private *get(QWaylandRelativePointerManagerV1 *manager) { return manager ? manager->d_func() : nullptr; }
+
+protected:
+    void zwp_relative_pointer_manager_v1_destroy(Resource *resource) override;
+    void zwp_relative_pointer_manager_v1_get_relative_pointer(Resource *resource, uint32_t id, wl_resource *pointerResource) override;
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDRELATIVEPOINTERV1_P_H
@@ -6,6 +6,8 @@
 #include <QtWaylandCompositor/QWaylandXdgSurface>
 #include <QtWaylandCompositor/QWaylandCompositor>
 #include <QtWaylandCompositor/QWaylandSeat>
+#include <QtWaylandCompositor/QWaylandOutput>
+#include <QtWaylandCompositor/private/qwaylandxdgshell_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -42,6 +44,11 @@ XdgToplevelIntegration::XdgToplevelIntegration(QWaylandQuickShellSurfaceItem *it
     });
     connect(m_xdgSurface->surface(), &QWaylandSurface::destinationSizeChanged, this, &XdgToplevelIntegration::handleSurfaceSizeChanged);
     connect(m_toplevel, &QObject::destroyed, this, &XdgToplevelIntegration::handleToplevelDestroyed);
+    connect(m_xdgSurface->surface(), &QWaylandSurface::redraw, this, &XdgToplevelIntegration::handleSurfaceRedraw);
+
+    resizeState.paceTimer.setSingleShot(true);
+    resizeState.paceTimer.setTimerType(Qt::PreciseTimer);
+    connect(&resizeState.paceTimer, &QTimer::timeout, this, &XdgToplevelIntegration::sendPendingResize);
 }
 
 bool XdgToplevelIntegration::eventFilter(QObject *object, QEvent *event)
@@ -61,14 +68,16 @@ bool XdgToplevelIntegration::eventFilter(QObject *object, QEvent *event)
 bool XdgToplevelIntegration::filterPointerMoveEvent(const QPointF &scenePosition)
 {
     if (grabberState == GrabberState::Resize) {
+        if (!m_toplevel)
+            return true;
         if (!resizeState.initialized) {
             resizeState.initialMousePos = scenePosition;
             resizeState.initialized = true;
             return true;
         }
         QPointF delta = m_item->mapToSurface(scenePosition - resizeState.initialMousePos);
-        QSize newSize = m_toplevel->sizeForResize(resizeState.initialWindowSize, delta, resizeState.resizeEdges);
-        m_toplevel->sendResizing(newSize);
+        resizeState.pendingSize = m_toplevel->sizeForResize(resizeState.initialWindowSize, delta, resizeState.resizeEdges);
+        sendPendingResize();
     } else if (grabberState == GrabberState::Move) {
         QQuickItem *moveItem = m_item->moveItem();
         if (!moveState.initialized) {
@@ -107,12 +116,80 @@ bool XdgToplevelIntegration::filterMouseMoveEvent(QMouseEvent *event)
 bool XdgToplevelIntegration::filterPointerReleaseEvent()
 {
     if (grabberState != GrabberState::Default) {
+        if (grabberState == GrabberState::Resize)
+            finishResize();
         grabberState = GrabberState::Default;
         return true;
     }
     return false;
 }
 
+// Minimum time between two resizing configures, one frame of the output the item is on
+int XdgToplevelIntegration::resizeConfigureInterval() const
+{
+    QWaylandOutput *output = m_item->view()->output();
+    if (!output)
+        return 0;
+    const int refreshRate = output->currentMode().refreshRate(); // mHz
+    return refreshRate > 0 ? 1000000 / refreshRate : 0;
+}
+
+void XdgToplevelIntegration::sendPendingResize()
+{
+    if (grabberState != GrabberState::Resize || !m_toplevel)
+        return;
+    if (!resizeState.pendingSize.isValid() || resizeState.pendingSize == resizeState.lastSentSize)
+        return;
+
+    // A client that is still busy with the previous size would only fall further behind
+    // if we queued more configures. The latest size goes out once it has caught up.
+    if (resizeState.outstandingSerial)
+        return;
+
+    const int interval = resizeConfigureInterval();
+    if (interval > 0 && resizeState.lastConfigureTimer.isValid()) {
+        const qint64 elapsed = resizeState.lastConfigureTimer.elapsed();
+        if (elapsed < interval) {
+            if (!resizeState.paceTimer.isActive())
+                resizeState.paceTimer.start(int(interval - elapsed));
+            return;
+        }
+    }
+
+    resizeState.outstandingSerial = m_toplevel->sendResizing(resizeState.pendingSize);
+    resizeState.lastSentSize = resizeState.pendingSize;
+    resizeState.lastConfigureTimer.start();
+}
+
+void XdgToplevelIntegration::handleSurfaceRedraw()
+{
+    if (!resizeState.outstandingSerial || !m_toplevel)
+        return;
+
+    // The configure is done with once the client has acked it and committed a buffer
+    // for it, i.e. it is no longer among the pending configures at commit time.
+    const auto &pending = QWaylandXdgToplevelPrivate::get(m_toplevel)->m_pendingConfigures;
+    for (const auto &configure : pending) {
+        if (configure.serial == resizeState.outstandingSerial)
+            return;
+    }
+
+    resizeState.outstandingSerial = 0;
+    sendPendingResize();
+}
+
+void XdgToplevelIntegration::finishResize()
+{
+    resizeState.paceTimer.stop();
+    resizeState.outstandingSerial = 0;
+
+    // Don't leave the client at a stale size if the last motion was held back
+    if (m_toplevel && resizeState.pendingSize.isValid()
+            && resizeState.pendingSize != resizeState.lastSentSize) {
+        m_toplevel->sendResizing(resizeState.pendingSize);
+    }
+}
+
 void XdgToplevelIntegration::handleStartMove(QWaylandSeat *seat)
 {
     grabberState = GrabberState::Move;
@@ -129,6 +206,11 @@ void XdgToplevelIntegration::handleStartResize(QWaylandSeat *seat, Qt::Edges edg
     resizeState.initialPosition = m_item->moveItem()->position();
     resizeState.initialSurfaceSize = m_item->surface()->destinationSize();
     resizeState.initialized = false;
+    resizeState.pendingSize = QSize();
+    resizeState.lastSentSize = QSize();
+    resizeState.outstandingSerial = 0;
+    resizeState.lastConfigureTimer.invalidate();
+    resizeState.paceTimer.stop();
 }
 
 void XdgToplevelIntegration::handleSetMaximized()
@@ -268,6 +350,9 @@ void XdgToplevelIntegration::handleToplevelDestroyed()
     // Disarm any handlers that might fire on the now-stale toplevel pointer
     nonwindowedState.output = nullptr;
     disconnect(nonwindowedState.sizeChangedConnection);
+    resizeState.paceTimer.stop();
+    resizeState.outstandingSerial = 0;
+    m_toplevel = nullptr;
 }
 
 XdgPopupIntegration::XdgPopupIntegration(QWaylandQuickShellSurfaceItem *item)
@@ -8,6 +8,9 @@
 #include <QtWaylandCompositor/QWaylandQuickShellSurfaceItem>
 #include <QtWaylandCompositor/QWaylandXdgToplevel>
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTimer>
+
 QT_BEGIN_NAMESPACE
 
 //
@@ -48,6 +51,8 @@ private Q_SLOTS:
     void handleToplevelDestroyed();
     void handleMaximizedSizeChanged();
     void handleFullscreenSizeChanged();
+    void handleSurfaceRedraw();
+    void sendPendingResize();
 
 private:
     QWaylandQuickShellSurfaceItem *m_item = nullptr;
@@ -75,6 +80,13 @@ private:
         QPointF initialPosition;
         QSize initialSurfaceSize;
         bool initialized;
+        // At most one resizing configure is in flight. Newer sizes replace pendingSize
+        // and go out once the client has acked and committed outstandingSerial.
+        QSize pendingSize;
+        QSize lastSentSize;
+        uint outstandingSerial = 0;
+        QElapsedTimer lastConfigureTimer;
+        QTimer paceTimer;
     } resizeState;
 
     struct {
@@ -93,6 +105,8 @@ private:
     bool filterMouseMoveEvent(QMouseEvent *event);
     bool filterPointerReleaseEvent();
     bool filterTouchUpdateEvent(QTouchEvent *event);
+    void finishResize();
+    int resizeConfigureInterval() const;
 };
 
 class XdgPopupIntegration : public QWaylandQuickShellIntegration
@@ -19,9 +19,13 @@
 #include <QtWaylandCompositor/qwaylandsurface.h>
 #include <QtWaylandCompositor/qwaylandbufferref.h>
 #include <QtCore/QSize>
+#include <QtCore/QHash>
+#include <QtCore/QList>
 #include <QtCore/private/qglobal_p.h>
 #include <wayland-server-core.h>
 
+#include <sys/types.h>
+
 QT_BEGIN_NAMESPACE
 
 class QWaylandCompositor;
@@ -44,6 +48,12 @@ public:
     virtual ClientBuffer *createBufferFor(struct ::wl_resource *buffer) = 0;
     virtual bool isProtected(struct ::wl_resource *buffer) { Q_UNUSED(buffer); return false; }
 
+    // DRM formats and modifiers the surface could be scanned out with on the given device,
+    // for integrations that let clients allocate buffers accordingly. Empty formats undo it.
+    virtual void setScanoutFormats(QWaylandSurface *surface, dev_t device,
+                                   const QHash<uint32_t, QList<uint64_t>> &formats)
+    { Q_UNUSED(surface); Q_UNUSED(device); Q_UNUSED(formats); }
+
 protected:
     QWaylandCompositor *m_compositor = nullptr;
 };
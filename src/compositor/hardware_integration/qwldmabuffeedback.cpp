@@ -0,0 +1,159 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qwldmabuffeedback_p.h"
+
+#include <QtWaylandCompositor/QWaylandCompositor>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef Q_OS_LINUX
+#  include <sys/syscall.h>
+// from linux/memfd.h:
+#  ifndef MFD_CLOEXEC
+#    define MFD_CLOEXEC     0x0001U
+#  endif
+#  ifndef MFD_ALLOW_SEALING
+#    define MFD_ALLOW_SEALING 0x0002U
+#  endif
+// from bits/fcntl-linux.h
+#  ifndef F_ADD_SEALS
+#    define F_ADD_SEALS 1033
+#  endif
+#  ifndef F_SEAL_SEAL
+#    define F_SEAL_SEAL 0x0001
+#  endif
+#  ifndef F_SEAL_SHRINK
+#    define F_SEAL_SHRINK 0x0002
+#  endif
+#  ifndef F_SEAL_GROW
+#    define F_SEAL_GROW 0x0004
+#  endif
+#  ifndef F_SEAL_WRITE
+#    define F_SEAL_WRITE 0x0008
+#  endif
+#endif
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWayland {
+
+DmabufFormatTable::DmabufFormatTable(const QHash<uint32_t, QList<uint64_t>> &modifiers)
+{
+    for (auto it = modifiers.constBegin(); it != modifiers.constEnd(); ++it) {
+        for (uint64_t modifier : it.value()) {
+            DmabufFormat format;
+            format.format = it.key();
+            format.modifier = modifier;
+            m_formats.append(format);
+        }
+    }
+    std::sort(m_formats.begin(), m_formats.end(), [](const DmabufFormat &a, const DmabufFormat &b) {
+        return a.format != b.format ? a.format < b.format : a.modifier < b.modifier;
+    });
+    if (m_formats.size() > MaxFormats) {
+        qCWarning(qLcWaylandCompositorHardwareIntegration) << "Dropping" << m_formats.size() - MaxFormats
+                                                           << "dmabuf formats that do not fit into the format table";
+        m_formats.resize(MaxFormats);
+    }
+
+#ifdef SYS_memfd_create
+    m_fd = syscall(SYS_memfd_create, "qtwayland-dmabuf-formats", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#endif
+    if (m_fd < 0) {
+        qCWarning(qLcWaylandCompositorHardwareIntegration) << "Could not create the dmabuf format table";
+        return;
+    }
+
+    const char *data = reinterpret_cast<const char *>(m_formats.constData());
+    qsizetype written = 0;
+    while (written < qsizetype(size())) {
+        const ssize_t result = write(m_fd, data + written, size() - written);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0) {
+            qCWarning(qLcWaylandCompositorHardwareIntegration) << "Could not write the dmabuf format table";
+            close(m_fd);
+            m_fd = -1;
+            return;
+        }
+        written += result;
+    }
+
+    // Clients map the table themselves, so it must not change under them
+    fcntl(m_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+}
+
+DmabufFormatTable::~DmabufFormatTable()
+{
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+int DmabufFormatTable::indexOf(uint32_t format, uint64_t modifier) const
+{
+    DmabufFormat key;
+    key.format = format;
+    key.modifier = modifier;
+    const auto it = std::lower_bound(m_formats.cbegin(), m_formats.cend(), key,
+                                     [](const DmabufFormat &a, const DmabufFormat &b) {
+        return a.format != b.format ? a.format < b.format : a.modifier < b.modifier;
+    });
+    return it != m_formats.cend() && *it == key ? int(it - m_formats.cbegin()) : -1;
+}
+
+DmabufFeedback DmabufFeedback::defaultFeedback(const DmabufFormatTable &table, dev_t mainDevice)
+{
+    DmabufFeedback feedback;
+    feedback.mainDevice = mainDevice;
+
+    DmabufTranche tranche;
+    tranche.targetDevice = mainDevice;
+    tranche.indices.reserve(table.formats().size());
+    for (qsizetype i = 0; i < table.formats().size(); ++i)
+        tranche.indices.append(uint16_t(i));
+    feedback.tranches.append(tranche);
+    return feedback;
+}
+
+DmabufFeedback DmabufFeedback::scanoutFeedback(const DmabufFormatTable &table, dev_t mainDevice,
+                                               dev_t scanoutDevice,
+                                               const QHash<uint32_t, QList<uint64_t>> &scanoutFormats)
+{
+    DmabufFeedback feedback = defaultFeedback(table, mainDevice);
+
+    DmabufTranche tranche;
+    tranche.targetDevice = scanoutDevice;
+    tranche.scanout = true;
+    for (auto it = scanoutFormats.constBegin(); it != scanoutFormats.constEnd(); ++it) {
+        for (uint64_t modifier : it.value()) {
+            const int index = table.indexOf(it.key(), modifier);
+            if (index >= 0)
+                tranche.indices.append(uint16_t(index));
+        }
+    }
+    std::sort(tranche.indices.begin(), tranche.indices.end());
+
+    if (!tranche.indices.isEmpty())
+        feedback.tranches.prepend(tranche);
+    return feedback;
+}
+
+QByteArray DmabufFeedback::deviceArray(dev_t device)
+{
+    return QByteArray(reinterpret_cast<const char *>(&device), sizeof(device));
+}
+
+QByteArray DmabufFeedback::indexArray(const QList<uint16_t> &indices)
+{
+    return QByteArray(reinterpret_cast<const char *>(indices.constData()),
+                      indices.size() * sizeof(uint16_t));
+}
+
+} // namespace QtWayland
+
+QT_END_NAMESPACE
@@ -0,0 +1,111 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWLDMABUFFEEDBACK_P_H
+#define QWLDMABUFFEEDBACK_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandCompositor/qtwaylandcompositorglobal.h>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+
+#include <sys/types.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWayland {
+
+// A format and modifier pair, laid out as in the format table of linux-dmabuf feedback
+struct DmabufFormat
+{
+    uint32_t format = 0;
+    uint32_t padding = 0;
+    uint64_t modifier = 0;
+
+    friend bool operator==(const DmabufFormat &a, const DmabufFormat &b)
+    { return a.format == b.format && a.modifier == b.modifier; }
+};
+static_assert(sizeof(DmabufFormat) == 16);
+
+// All format and modifier pairs the compositor can import, sorted so that the table does not
+// depend on the order of the hash. The table is written once to a sealed file which is shared
+// by all clients, and feedback refers to its entries by index.
+class Q_WAYLANDCOMPOSITOR_EXPORT DmabufFormatTable
+{
+public:
+    explicit DmabufFormatTable(const QHash<uint32_t, QList<uint64_t>> &modifiers);
+    ~DmabufFormatTable();
+
+    const QList<DmabufFormat> &formats() const { return m_formats; }
+    int indexOf(uint32_t format, uint64_t modifier) const;
+
+    // The table as a read-only file, or -1 if it could not be created
+    int fd() const { return m_fd; }
+    uint32_t size() const { return uint32_t(m_formats.size() * sizeof(DmabufFormat)); }
+
+    // Tranches refer to entries with 16-bit indices
+    static constexpr qsizetype MaxFormats = 0x10000;
+
+private:
+    Q_DISABLE_COPY(DmabufFormatTable)
+
+    QList<DmabufFormat> m_formats;
+    int m_fd = -1;
+};
+
+struct DmabufTranche
+{
+    dev_t targetDevice = 0;
+    QList<uint16_t> indices;
+    bool scanout = false;
+
+    friend bool operator==(const DmabufTranche &a, const DmabufTranche &b)
+    {
+        return a.targetDevice == b.targetDevice && a.indices == b.indices
+                && a.scanout == b.scanout;
+    }
+};
+
+// What a client should allocate its buffers with, as tranches in decreasing preference
+struct Q_WAYLANDCOMPOSITOR_EXPORT DmabufFeedback
+{
+    dev_t mainDevice = 0;
+    QList<DmabufTranche> tranches;
+
+    // Everything the renderer on the main device can import
+    static DmabufFeedback defaultFeedback(const DmabufFormatTable &table, dev_t mainDevice);
+
+    // Prefers the pairs that can be scanned out on scanoutDevice and that the renderer can
+    // import as well, so that the compositor can still fall back to compositing the surface.
+    // The default tranche follows for everything else.
+    static DmabufFeedback scanoutFeedback(const DmabufFormatTable &table, dev_t mainDevice,
+                                          dev_t scanoutDevice,
+                                          const QHash<uint32_t, QList<uint64_t>> &scanoutFormats);
+
+    // Devices and indices as sent in wl_array arguments
+    static QByteArray deviceArray(dev_t device);
+    static QByteArray indexArray(const QList<uint16_t> &indices);
+
+    friend bool operator==(const DmabufFeedback &a, const DmabufFeedback &b)
+    { return a.mainDevice == b.mainDevice && a.tranches == b.tranches; }
+    friend bool operator!=(const DmabufFeedback &a, const DmabufFeedback &b)
+    { return !(a == b); }
+};
+
+} // namespace QtWayland
+
+QT_END_NAMESPACE
+
+#endif // QWLDMABUFFEEDBACK_P_H
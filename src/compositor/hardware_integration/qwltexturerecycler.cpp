@@ -0,0 +1,304 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qwltexturerecycler_p.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QHash>
+#include <QtCore/QMutexLocker>
+#include <QtGui/QOpenGLContext>
+
+#include <wayland-server-core.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(qLcWaylandTextureRecycler, "qt.waylandcompositor.texturerecycler")
+
+namespace QtWayland {
+
+namespace {
+
+struct TextureUsage
+{
+    ::wl_resource *buffer = nullptr;
+    ::wl_client *client = nullptr;
+    QOpenGLContextGroup *group = nullptr;
+    qint64 memory = 0;
+    QWaylandTextureRecycler::Storage storage = QWaylandTextureRecycler::Storage::Imported;
+};
+
+// The recyclers of all share groups, and what the textures handed out by them are used for.
+// Recyclers are looked up from any thread when textures are released, so this has a lock of
+// its own which is always taken before the one of a recycler.
+struct Registry
+{
+    QMutex lock;
+    QHash<QOpenGLContextGroup *, QWaylandTextureRecycler *> recyclers;
+    QHash<QOpenGLTexture *, TextureUsage> usage;
+};
+
+Q_GLOBAL_STATIC(Registry, registry)
+
+} // namespace
+
+QWaylandTextureRecycler::QWaylandTextureRecycler(QOpenGLContextGroup *group)
+    : m_group(group)
+{
+    m_timer.start();
+    m_clock = [this] { return m_timer.elapsed(); };
+}
+
+QWaylandTextureRecycler::~QWaylandTextureRecycler()
+{
+    deleteAll();
+}
+
+QWaylandTextureRecycler *QWaylandTextureRecycler::current()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context) {
+        qCWarning(qLcWaylandTextureRecycler) << "Cannot recycle textures without a current OpenGL context";
+        return nullptr;
+    }
+
+    return forContext(context, true);
+}
+
+QWaylandTextureRecycler *QWaylandTextureRecycler::forContext(QOpenGLContext *context, bool create)
+{
+    Registry *r = registry();
+    Q_ASSERT(!r->lock.tryLock());
+
+    QOpenGLContextGroup *group = context->shareGroup();
+    QWaylandTextureRecycler *recycler = r->recyclers.value(group);
+    if (!recycler && create) {
+        recycler = new QWaylandTextureRecycler(group);
+        r->recyclers.insert(group, recycler);
+        qCDebug(qLcWaylandTextureRecycler) << "Recycling textures for share group" << group;
+    }
+
+    if (recycler && !recycler->m_contexts.contains(context))
+        recycler->watchContext(context);
+
+    return recycler;
+}
+
+void QWaylandTextureRecycler::watchContext(QOpenGLContext *context)
+{
+    m_contexts.append(context);
+    QObject::connect(context, &QOpenGLContext::aboutToBeDestroyed, context,
+                     [this, context] { onContextAboutToBeDestroyed(context); },
+                     Qt::DirectConnection);
+}
+
+void QWaylandTextureRecycler::onContextAboutToBeDestroyed(QOpenGLContext *context)
+{
+    Registry *r = registry();
+    QMutexLocker registryLocker(&r->lock);
+
+    m_contexts.removeOne(context);
+    if (!m_contexts.isEmpty())
+        return;
+
+    // The textures belong to the share group, which goes away with its last context
+    qCDebug(qLcWaylandTextureRecycler) << "Share group" << m_group << "is going away";
+    r->recyclers.remove(m_group);
+    r->usage.removeIf([this](const auto &it) { return it.value().group == m_group; });
+    delete this;
+}
+
+QOpenGLTexture *QWaylandTextureRecycler::acquireTexture(QOpenGLTexture::Target target,
+                                                        QOpenGLTexture::TextureFormat format,
+                                                        const QSize &size, ::wl_resource *buffer,
+                                                        Storage storage, bool *recycled)
+{
+    QOpenGLTexture *texture = nullptr;
+
+    if (storage == Storage::Owned) {
+        QMutexLocker locker(&m_lock);
+        // Prefer the texture released last, which is the least likely to be evicted soon
+        for (qsizetype i = m_pool.size() - 1; i >= 0; --i) {
+            QOpenGLTexture *candidate = m_pool.at(i).texture;
+            if (candidate->target() == target && candidate->format() == format
+                && candidate->width() == size.width() && candidate->height() == size.height()) {
+                texture = candidate;
+                m_pooledMemory -= m_pool.at(i).memory;
+                m_pool.removeAt(i);
+                break;
+            }
+        }
+    }
+
+    const bool reused = texture != nullptr;
+    if (reused) {
+        qCDebug(qLcWaylandTextureRecycler) << "Reusing texture" << texture->textureId()
+                                           << "of size" << size << "for buffer" << buffer;
+    } else {
+        texture = new QOpenGLTexture(target);
+        texture->setFormat(format);
+        texture->setSize(size.width(), size.height());
+        texture->create();
+    }
+
+    if (recycled)
+        *recycled = reused;
+
+    TextureUsage usage;
+    usage.buffer = buffer;
+    usage.client = buffer ? wl_resource_get_client(buffer) : nullptr;
+    usage.group = m_group;
+    usage.memory = textureMemory(format, size);
+    usage.storage = storage;
+
+    Registry *r = registry();
+    QMutexLocker registryLocker(&r->lock);
+    r->usage.insert(texture, usage);
+
+    return texture;
+}
+
+void QWaylandTextureRecycler::releaseTexture(QOpenGLTexture *texture, QOpenGLContext *context)
+{
+    if (!texture)
+        return;
+
+    Registry *r = registry();
+    QMutexLocker registryLocker(&r->lock);
+
+    const TextureUsage usage = r->usage.take(texture);
+    QWaylandTextureRecycler *recycler = context ? forContext(context, true) : nullptr;
+    if (!recycler) {
+        qCWarning(qLcWaylandTextureRecycler) << "Texture" << texture << "was released without a context, leaking it";
+        return;
+    }
+
+    QMutexLocker locker(&recycler->m_lock);
+    if (usage.storage == Storage::Owned) {
+        recycler->m_pool.append({ texture, usage.memory, recycler->m_clock() });
+        recycler->m_pooledMemory += usage.memory;
+    } else {
+        recycler->m_released.append(texture);
+    }
+}
+
+void QWaylandTextureRecycler::collect()
+{
+    QList<QOpenGLTexture *> textures;
+
+    {
+        QMutexLocker locker(&m_lock);
+        textures.swap(m_released);
+
+        while (m_pooledMemory > m_limits.maxPooledMemory) {
+            const PooledTexture pooled = m_pool.takeFirst();
+            m_pooledMemory -= pooled.memory;
+            textures.append(pooled.texture);
+        }
+
+        // The pool is ordered by release time, so idle textures are at its front
+        const qint64 now = m_clock();
+        int deletions = 0;
+        while (!m_pool.isEmpty() && deletions < m_limits.maxDeletionsPerCollect
+               && now - m_pool.constFirst().releaseTime > m_limits.maxIdleTime) {
+            const PooledTexture pooled = m_pool.takeFirst();
+            m_pooledMemory -= pooled.memory;
+            textures.append(pooled.texture);
+            ++deletions;
+        }
+    }
+
+    if (!textures.isEmpty())
+        qCDebug(qLcWaylandTextureRecycler) << "Deleting" << textures.size() << "textures";
+    qDeleteAll(textures);
+}
+
+QWaylandTextureRecycler::Limits QWaylandTextureRecycler::limits() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_limits;
+}
+
+void QWaylandTextureRecycler::setLimits(const Limits &limits)
+{
+    QMutexLocker locker(&m_lock);
+    m_limits = limits;
+}
+
+void QWaylandTextureRecycler::setClock(std::function<qint64()> clock)
+{
+    QMutexLocker locker(&m_lock);
+    m_clock = std::move(clock);
+}
+
+void QWaylandTextureRecycler::deleteAll()
+{
+    QMutexLocker locker(&m_lock);
+    qDeleteAll(m_released);
+    m_released.clear();
+    for (const PooledTexture &pooled : std::as_const(m_pool))
+        delete pooled.texture;
+    m_pool.clear();
+    m_pooledMemory = 0;
+}
+
+qint64 QWaylandTextureRecycler::bufferMemory(::wl_resource *buffer)
+{
+    Registry *r = registry();
+    QMutexLocker registryLocker(&r->lock);
+
+    qint64 memory = 0;
+    for (const TextureUsage &usage : std::as_const(r->usage)) {
+        if (usage.buffer == buffer)
+            memory += usage.memory;
+    }
+    return memory;
+}
+
+qint64 QWaylandTextureRecycler::clientMemory(::wl_client *client)
+{
+    Registry *r = registry();
+    QMutexLocker registryLocker(&r->lock);
+
+    qint64 memory = 0;
+    for (const TextureUsage &usage : std::as_const(r->usage)) {
+        if (usage.client == client)
+            memory += usage.memory;
+    }
+    return memory;
+}
+
+qint64 QWaylandTextureRecycler::pooledMemory() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_pooledMemory;
+}
+
+qint64 QWaylandTextureRecycler::textureMemory(QOpenGLTexture::TextureFormat format, const QSize &size)
+{
+    qint64 bytesPerPixel;
+    switch (format) {
+    case QOpenGLTexture::R8_UNorm:
+    case QOpenGLTexture::LuminanceFormat:
+    case QOpenGLTexture::AlphaFormat:
+        bytesPerPixel = 1;
+        break;
+    case QOpenGLTexture::RG8_UNorm:
+    case QOpenGLTexture::R16_UNorm:
+    case QOpenGLTexture::LuminanceAlphaFormat:
+        bytesPerPixel = 2;
+        break;
+    case QOpenGLTexture::RGBA16F:
+    case QOpenGLTexture::RGBA16_UNorm:
+        bytesPerPixel = 8;
+        break;
+    default:
+        // Drivers pad three component formats to four bytes as well
+        bytesPerPixel = 4;
+        break;
+    }
+    return qint64(size.width()) * size.height() * bytesPerPixel;
+}
+
+} // namespace QtWayland
+
+QT_END_NAMESPACE
@@ -0,0 +1,130 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWLTEXTURERECYCLER_P_H
+#define QWLTEXTURERECYCLER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMutex>
+#include <QtCore/QSize>
+#include <QtOpenGL/QOpenGLTexture>
+#include <QtWaylandCompositor/qtwaylandcompositorglobal.h>
+
+#include <functional>
+
+struct wl_client;
+struct wl_resource;
+
+QT_BEGIN_NAMESPACE
+
+class QOpenGLContext;
+class QOpenGLContextGroup;
+
+Q_DECLARE_LOGGING_CATEGORY(qLcWaylandTextureRecycler)
+
+namespace QtWayland {
+
+// Owns the textures of client buffers for the contexts of one share group. Textures that own
+// their storage are kept for a while after their buffer is gone and handed out again for
+// buffers of the same size and format. Everything else is deleted on the next collect(), when
+// a context of the group is current.
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandTextureRecycler
+{
+public:
+    enum class Storage {
+        // The texture has storage of its own, such as wl_shm uploads
+        Owned,
+        // The texture is bound to storage of the client, such as an EGLImage, and must not
+        // outlive the buffer, which it would keep alive
+        Imported
+    };
+
+    // The recycler of the share group of the current context
+    static QWaylandTextureRecycler *current();
+
+    // A texture for the given buffer, reused when an owned one of the same target, format and
+    // size is available. A new texture is created, but storage is left to the caller, which is
+    // told through recycled whether the texture already has storage from its previous buffer.
+    QOpenGLTexture *acquireTexture(QOpenGLTexture::Target target,
+                                   QOpenGLTexture::TextureFormat format, const QSize &size,
+                                   ::wl_resource *buffer, Storage storage = Storage::Owned,
+                                   bool *recycled = nullptr);
+
+    // Hands a texture back once its buffer does not need it anymore. Can be called from any
+    // thread, with or without a context current.
+    static void releaseTexture(QOpenGLTexture *texture, QOpenGLContext *context);
+
+    // Deletes released textures that may not be reused, and pooled ones that were not reused
+    // within maxIdleTime or do not fit into maxPooledMemory. Called with a context of the
+    // group current, typically once per frame, and deletes at most maxDeletionsPerCollect
+    // idle textures so that the work per frame stays bounded.
+    void collect();
+
+    struct Limits
+    {
+        qint64 maxPooledMemory = 64 * 1024 * 1024;
+        qint64 maxIdleTime = 1000; // ms
+        int maxDeletionsPerCollect = 8;
+    };
+    Limits limits() const;
+    void setLimits(const Limits &limits);
+
+    // Time in milliseconds, from a monotonic clock unless replaced, e.g. by tests
+    void setClock(std::function<qint64()> clock);
+
+    // Approximate GPU memory held by the textures of a buffer, of all buffers of a client, and
+    // by textures waiting to be reused
+    static qint64 bufferMemory(::wl_resource *buffer);
+    static qint64 clientMemory(::wl_client *client);
+    qint64 pooledMemory() const;
+
+    static qint64 textureMemory(QOpenGLTexture::TextureFormat format, const QSize &size);
+
+private:
+    explicit QWaylandTextureRecycler(QOpenGLContextGroup *group);
+    ~QWaylandTextureRecycler();
+
+    struct PooledTexture
+    {
+        QOpenGLTexture *texture;
+        qint64 memory;
+        qint64 releaseTime;
+    };
+
+    static QWaylandTextureRecycler *forContext(QOpenGLContext *context, bool create);
+    void watchContext(QOpenGLContext *context);
+    void onContextAboutToBeDestroyed(QOpenGLContext *context);
+    void deleteAll();
+
+    QOpenGLContextGroup *const m_group;
+    QList<QOpenGLContext *> m_contexts;
+
+    // Guarded by m_lock, as textures are released from any thread
+    mutable QMutex m_lock;
+    QList<QOpenGLTexture *> m_released;
+    QList<PooledTexture> m_pool;
+    qint64 m_pooledMemory = 0;
+    Limits m_limits;
+    std::function<qint64()> m_clock;
+
+    QElapsedTimer m_timer;
+};
+
+} // namespace QtWayland
+
+QT_END_NAMESPACE
+
+#endif // QWLTEXTURERECYCLER_P_H
@@ -0,0 +1,34 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+// This shader stump is compiled at run-time, like surface_oes_external.frag.
+// The preamble added when it is loaded defines Y_U_V, Y_UV or Y_XUXV for the plane layout.
+// The conversion to RGB, matrix coefficients and range included, is a uniform so that one
+// shader handles every color space.
+
+varying vec2 v_texcoord;
+struct buf {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    mat4 yuvToRgb;
+};
+uniform buf ubuf;
+uniform sampler2D tex0;
+uniform sampler2D tex1;
+#ifdef Y_U_V
+uniform sampler2D tex2;
+#endif
+
+void main()
+{
+    vec4 yuv = vec4(texture2D(tex0, v_texcoord).r, 0.0, 0.0, 1.0);
+#if defined(Y_U_V)
+    yuv.y = texture2D(tex1, v_texcoord).r;
+    yuv.z = texture2D(tex2, v_texcoord).r;
+#elif defined(Y_UV)
+    yuv.yz = texture2D(tex1, v_texcoord).rg;
+#else
+    yuv.yz = texture2D(tex1, v_texcoord).ga;
+#endif
+    fragColor = ubuf.qt_Opacity * vec4((ubuf.yuvToRgb * yuv).rgb, 1.0);
+}
@@ -0,0 +1,21 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+// This shader stump is compiled at run-time together with surface_yuv.frag, whose
+// uniform block it has to declare identically.
+
+attribute vec2 qt_VertexPosition;
+attribute vec2 qt_VertexTexCoord;
+varying vec2 v_texcoord;
+struct buf {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    mat4 yuvToRgb;
+};
+uniform buf ubuf;
+
+void main()
+{
+    gl_Position = ubuf.qt_Matrix * vec4(qt_VertexPosition, 0.0, 1.0);
+    v_texcoord = qt_VertexTexCoord;
+}
@@ -5,16 +5,42 @@
 
 #if QT_CONFIG(opengl)
 #include "hardware_integration/qwlclientbufferintegration_p.h"
+#include "hardware_integration/qwltexturerecycler_p.h"
 #include <qpa/qplatformopenglcontext.h>
 #include <QOpenGLTexture>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFunctions>
 #endif
 
 #include <QtCore/QDebug>
+#include <QtCore/QScopeGuard>
 
 #include <QtWaylandCompositor/private/wayland-wayland-server-protocol.h>
 #include "qwaylandsharedmemoryformathelper_p.h"
 
 #include <QtWaylandCompositor/private/qwaylandcompositor_p.h>
+#include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+
+#if QT_CONFIG(opengl)
+#ifndef GL_RED
+#define GL_RED 0x1903
+#endif
+#ifndef GL_RG
+#define GL_RG 0x8227
+#endif
+#ifndef GL_R8
+#define GL_R8 0x8229
+#endif
+#ifndef GL_RG8
+#define GL_RG8 0x822B
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
+#endif
 
 QT_BEGIN_NAMESPACE
 
@@ -30,20 +56,49 @@ ClientBuffer::~ClientBuffer()
 {
     if (m_buffer && m_committed && !m_destroyed)
         sendRelease();
+    if (m_bufferRelease)
+        m_bufferRelease->setBuffer(nullptr);
 }
 
 void ClientBuffer::sendRelease()
 {
     Q_ASSERT(m_buffer);
+    if (m_bufferRelease)
+        std::exchange(m_bufferRelease, nullptr)->sendRelease(std::move(m_releaseFence));
+    m_releaseFence = SyncFence();
     wl_buffer_send_release(m_buffer);
     m_committed = false;
 }
 
+void ClientBuffer::setBufferRelease(QWaylandLinuxExplicitSynchronizationV1Private::BufferRelease *release)
+{
+    // The buffer was committed again before being released, which ends the use for the
+    // previous commit. Whatever is still going on belongs to the new one.
+    if (m_bufferRelease)
+        std::exchange(m_bufferRelease, nullptr)->sendRelease(m_releaseFence.duplicate());
+
+    m_bufferRelease = release;
+    if (release)
+        release->setBuffer(this);
+}
+
+void ClientBuffer::detachBufferRelease(QWaylandLinuxExplicitSynchronizationV1Private::BufferRelease *release)
+{
+    if (m_bufferRelease == release)
+        m_bufferRelease = nullptr;
+}
+
 void ClientBuffer::setDestroyed()
 {
+    // The client destroyed the buffer while it was in use, the release of the commit still
+    // has to tell when the compositor is done with its memory
+    if (m_bufferRelease)
+        std::exchange(m_bufferRelease, nullptr)->sendRelease(std::move(m_releaseFence));
+
     m_destroyed = true;
     m_committed = false;
     m_buffer = nullptr;
+    m_releaseFence = SyncFence();
 
     if (!m_refCount.loadAcquire())
         delete this;
@@ -76,12 +131,121 @@ QWaylandBufferRef::BufferFormatEgl ClientBuffer::bufferFormatEgl() const
     return QWaylandBufferRef::BufferFormatEgl_Null;
 }
 
+// The planes a YUV wl_shm buffer is sampled as. libwayland only guarantees stride * height bytes
+// of the pool to a buffer and doesn't tell the size of the pool, so only packed formats, whose
+// planes all lie within those bytes, can be read safely.
+struct ShmPlane
+{
+    int width;
+    int height;
+    int stride;
+    qsizetype offset;
+    int bytesPerPixel;
+};
+
+struct ShmPlanarLayout
+{
+    int planeCount = 0;
+    ShmPlane planes[2];
+};
+
+static QWaylandBufferRef::BufferFormatEgl planarFormat(uint32_t shmFormat)
+{
+    switch (shmFormat) {
+    case WL_SHM_FORMAT_YUYV:
+        return QWaylandBufferRef::BufferFormatEgl_Y_XUXV;
+    default:
+        return QWaylandBufferRef::BufferFormatEgl_Null;
+    }
+}
+
+static ShmPlanarLayout planarLayout(wl_shm_buffer *shmBuffer)
+{
+    const int width = wl_shm_buffer_get_width(shmBuffer);
+    const int height = wl_shm_buffer_get_height(shmBuffer);
+    const int stride = wl_shm_buffer_get_stride(shmBuffer);
+    const int chromaWidth = (width + 1) / 2;
+
+    ShmPlanarLayout layout;
+    switch (planarFormat(wl_shm_buffer_get_format(shmBuffer))) {
+    case QWaylandBufferRef::BufferFormatEgl_Y_XUXV:
+        // Sampled as luma with the chroma interleaved, and as one chroma pair per two pixels
+        layout.planeCount = 2;
+        layout.planes[0] = { width, height, stride, 0, 2 };
+        layout.planes[1] = { chromaWidth, height, stride, 0, 4 };
+        break;
+    default:
+        break;
+    }
+    return layout;
+}
+
+// The rows of each plane have to fit into the stride of the buffer
+static bool fitsBuffer(wl_shm_buffer *shmBuffer, const ShmPlanarLayout &layout)
+{
+    const qsizetype size = qsizetype(wl_shm_buffer_get_stride(shmBuffer)) * wl_shm_buffer_get_height(shmBuffer);
+    for (int i = 0; i < layout.planeCount; ++i) {
+        const ShmPlane &plane = layout.planes[i];
+        if (qsizetype(plane.width) * plane.bytesPerPixel > plane.stride
+            || plane.offset + qsizetype(plane.stride) * plane.height > size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The conversion matrix of the YUV materials in 16.16 fixed point, for 8-bit input and output
+struct YuvCoefficients
+{
+    explicit YuvCoefficients(const QMatrix4x4 &toRgb)
+    {
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 3; ++column)
+                m[row][column] = qRound(toRgb(row, column) * 65536);
+            // Rounds the result to nearest
+            m[row][3] = qRound(toRgb(row, 3) * 255 * 65536) + 32768;
+        }
+    }
+    int m[3][4];
+};
+
+// The steps are constant so that the compiler can vectorize the loop
+template <int LumaStep, int ChromaStep>
+static void convertYuvRow(quint32 *dst, int width, const uchar *y, const uchar *u, const uchar *v,
+                          const YuvCoefficients &c)
+{
+    for (int x = 0; x < width; ++x) {
+        const int luma = y[x * LumaStep];
+        const int cb = u[(x / 2) * ChromaStep];
+        const int cr = v[(x / 2) * ChromaStep];
+        const int r = (c.m[0][0] * luma + c.m[0][1] * cb + c.m[0][2] * cr + c.m[0][3]) >> 16;
+        const int g = (c.m[1][0] * luma + c.m[1][1] * cb + c.m[1][2] * cr + c.m[1][3]) >> 16;
+        const int b = (c.m[2][0] * luma + c.m[2][1] * cb + c.m[2][2] * cr + c.m[2][3]) >> 16;
+        dst[x] = 0xff000000u | (uint(qBound(0, r, 255)) << 16) | (uint(qBound(0, g, 255)) << 8)
+                | uint(qBound(0, b, 255));
+    }
+}
+
 SharedMemoryBuffer::SharedMemoryBuffer(wl_resource *bufferResource)
     : ClientBuffer(bufferResource)
+    , m_yuvToRgb(QWaylandYuvConversion().toRgb())
 {
 
 }
 
+void SharedMemoryBuffer::setYuvConversion(const QWaylandYuvConversion &conversion)
+{
+    if (bufferFormatEgl() != QWaylandBufferRef::BufferFormatEgl_Null)
+        m_yuvToRgb = conversion.toRgb();
+}
+
+QWaylandBufferRef::BufferFormatEgl SharedMemoryBuffer::bufferFormatEgl() const
+{
+    if (wl_shm_buffer *shmBuffer = wl_shm_buffer_get(m_buffer))
+        return planarFormat(wl_shm_buffer_get_format(shmBuffer));
+    return QWaylandBufferRef::BufferFormatEgl_Null;
+}
+
 QSize SharedMemoryBuffer::size() const
 {
     if (wl_shm_buffer *shmBuffer = wl_shm_buffer_get(m_buffer)) {
@@ -110,6 +274,28 @@ QImage SharedMemoryBuffer::image() const
         int height = wl_shm_buffer_get_height(shmBuffer);
         int bytesPerLine = wl_shm_buffer_get_stride(shmBuffer);
 
+        const ShmPlanarLayout layout = planarLayout(shmBuffer);
+        if (layout.planeCount) {
+            // Renderers without the YUV materials get a converted copy
+            if (!fitsBuffer(shmBuffer, layout)) {
+                qCWarning(qLcWaylandCompositor) << "wl_shm buffer is too small for its format";
+                return QImage();
+            }
+            // Guards against the client shrinking the pool while it is read
+            wl_shm_buffer_begin_access(shmBuffer);
+            const auto endAccess = qScopeGuard([shmBuffer] { wl_shm_buffer_end_access(shmBuffer); });
+            const uchar *data = static_cast<const uchar *>(wl_shm_buffer_get_data(shmBuffer));
+            QImage converted(width, height, QImage::Format_RGB32);
+            const ShmPlane *planes = layout.planes;
+            const YuvCoefficients coefficients(m_yuvToRgb);
+            for (int row = 0; row < height; ++row) {
+                auto *dst = reinterpret_cast<quint32 *>(converted.scanLine(row));
+                const uchar *y = data + planes[0].offset + qsizetype(row) * planes[0].stride;
+                convertYuvRow<2, 4>(dst, width, y, y + 1, y + 3, coefficients);
+            }
+            return converted;
+        }
+
         // TODO: try to avoid QImage::convertToFormat()
         wl_shm_format shmFormat = wl_shm_format(wl_shm_buffer_get_format(shmBuffer));
         QImage::Format format = QWaylandSharedMemoryFormatHelper::fromWaylandShmFormat(shmFormat);
@@ -125,38 +311,161 @@ QImage SharedMemoryBuffer::image() const
 #if QT_CONFIG(opengl)
 QOpenGLTexture *SharedMemoryBuffer::toOpenGlTexture(int plane)
 {
-    Q_UNUSED(plane);
-    if (isSharedMemory()) {
-        if (!m_shmTexture) {
-            m_shmTexture.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
-            m_shmTexture->create();
+    if (wl_shm_buffer *shmBuffer = wl_shm_buffer_get(m_buffer);
+            shmBuffer && bufferFormatEgl() != QWaylandBufferRef::BufferFormatEgl_Null) {
+        if (m_textureDirty) {
+            m_textureDirty = false;
+            uploadPlanes(shmBuffer);
+            if (isCommitted())
+                sendRelease();
         }
+        return plane >= 0 && plane < 2 ? m_planeTextures[plane] : nullptr;
+    }
+
+    if (isSharedMemory()) {
         if (m_textureDirty) {
             m_textureDirty = false;
-            m_shmTexture->bind();
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
             // TODO: partial texture upload
             QImage image = this->image();
-            m_shmTexture->setSize(image.width(), image.height());
-            if (image.hasAlphaChannel()) {
-                m_shmTexture->setFormat(QOpenGLTexture::RGBAFormat);
+            const bool hasAlpha = image.hasAlphaChannel();
+            if (!m_shmTexture) {
+                m_shmTexture = acquireTexture(hasAlpha ? QOpenGLTexture::RGBAFormat : QOpenGLTexture::RGBFormat,
+                                              image.size(), &m_shmTextureHasStorage);
+                if (!m_shmTexture)
+                    return nullptr;
+            }
+            m_shmTexture->bind();
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            const GLenum format = hasAlpha ? GL_RGBA : GL_RGB;
+            if (hasAlpha) {
                 if (image.format() != QImage::Format_RGBA8888)
                     image = image.convertToFormat(QImage::Format_RGBA8888);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width(), image.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
             } else {
-                m_shmTexture->setFormat(QOpenGLTexture::RGBFormat);
                 if (image.format() != QImage::Format_RGBX8888)
                     image = image.convertToFormat(QImage::Format_RGBX8888);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width(), image.height(), 0, GL_RGB, GL_UNSIGNED_BYTE, image.constBits());
+            }
+            // A recycled texture already has storage of the right size and format
+            if (m_shmTextureHasStorage) {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width(), image.height(), format, GL_UNSIGNED_BYTE, image.constBits());
+            } else {
+                glTexImage2D(GL_TEXTURE_2D, 0, format, image.width(), image.height(), 0, format, GL_UNSIGNED_BYTE, image.constBits());
+                m_shmTextureHasStorage = true;
             }
             //we can release the buffer after uploading, since we have a copy
             if (isCommitted())
                 sendRelease();
         }
-        return m_shmTexture.data();
+        return m_shmTexture;
     }
     return nullptr;
 }
+
+SharedMemoryBuffer::~SharedMemoryBuffer()
+{
+    QOpenGLTexture *textures[] = { m_shmTexture, m_planeTextures[0], m_planeTextures[1] };
+    for (QOpenGLTexture *texture : textures) {
+        if (!texture)
+            continue;
+        // Without its context the texture is gone already, and only the object is left
+        if (m_textureContext)
+            QtWayland::QWaylandTextureRecycler::releaseTexture(texture, m_textureContext);
+        else
+            delete texture;
+    }
+}
+
+QOpenGLTexture *SharedMemoryBuffer::acquireTexture(QOpenGLTexture::TextureFormat format,
+                                                   const QSize &size, bool *hasStorage)
+{
+    auto *recycler = QtWayland::QWaylandTextureRecycler::current();
+    if (!recycler)
+        return nullptr;
+
+    // This is called when the scene graph uploads the buffer, which is a good time to let go of
+    // the textures of buffers that are gone
+    recycler->collect();
+
+    m_textureContext = QOpenGLContext::currentContext();
+    return recycler->acquireTexture(QOpenGLTexture::Target2D, format, size, m_buffer,
+                                    QtWayland::QWaylandTextureRecycler::Storage::Owned, hasStorage);
+}
+
+bool SharedMemoryBuffer::uploadPlanes(wl_shm_buffer *shmBuffer)
+{
+    const ShmPlanarLayout layout = planarLayout(shmBuffer);
+    if (!fitsBuffer(shmBuffer, layout)) {
+        qCWarning(qLcWaylandCompositor) << "wl_shm buffer is too small for its format";
+        return false;
+    }
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QOpenGLFunctions *gl = context->functions();
+    const bool gles = context->isOpenGLES();
+    const int majorVersion = context->format().majorVersion();
+    if (majorVersion < 3 && !context->hasExtension(gles ? "GL_EXT_texture_rg" : "GL_ARB_texture_rg")) {
+        static bool warned = false;
+        if (!warned) {
+            warned = true;
+            qCWarning(qLcWaylandCompositor) << "YUV wl_shm buffers need support for red-green textures";
+        }
+        return false;
+    }
+    const bool hasRowLength = !gles || majorVersion >= 3 || context->hasExtension("GL_EXT_unpack_subimage");
+
+    wl_shm_buffer_begin_access(shmBuffer);
+    const auto endAccess = qScopeGuard([shmBuffer] { wl_shm_buffer_end_access(shmBuffer); });
+    const uchar *data = static_cast<const uchar *>(wl_shm_buffer_get_data(shmBuffer));
+    gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < layout.planeCount; ++i) {
+        const ShmPlane &plane = layout.planes[i];
+        const GLenum format = plane.bytesPerPixel == 1 ? GL_RED
+                : plane.bytesPerPixel == 2            ? GL_RG
+                                                      : GL_RGBA;
+        // GL_EXT_texture_rg only knows unsized internal formats
+        const GLenum internalFormat = gles && majorVersion < 3 ? format
+                : plane.bytesPerPixel == 1                     ? GL_R8
+                : plane.bytesPerPixel == 2                     ? GL_RG8
+                                                               : GL_RGBA8;
+
+        QOpenGLTexture *&texture = m_planeTextures[i];
+        bool &hasStorage = m_planeTexturesHaveStorage[i];
+        if (!texture) {
+            const auto textureFormat = plane.bytesPerPixel == 1 ? QOpenGLTexture::R8_UNorm
+                    : plane.bytesPerPixel == 2                  ? QOpenGLTexture::RG8_UNorm
+                                                                : QOpenGLTexture::RGBA8_UNorm;
+            texture = acquireTexture(textureFormat, QSize(plane.width, plane.height), &hasStorage);
+            if (!texture)
+                return false;
+        }
+        texture->bind();
+
+        const uchar *bits = data + plane.offset;
+        const int rowLength = plane.stride / plane.bytesPerPixel;
+        const bool contiguous = plane.stride % plane.bytesPerPixel == 0
+                && (rowLength == plane.width || hasRowLength);
+        if (contiguous && rowLength != plane.width)
+            gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+        // A recycled texture already has storage of the right size and format
+        if (!hasStorage) {
+            gl->glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, plane.width, plane.height, 0,
+                             format, GL_UNSIGNED_BYTE, contiguous ? bits : nullptr);
+            hasStorage = true;
+        } else if (contiguous) {
+            gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, plane.width, plane.height, format,
+                                GL_UNSIGNED_BYTE, bits);
+        }
+        if (contiguous && rowLength != plane.width)
+            gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        if (!contiguous) {
+            for (int row = 0; row < plane.height; ++row) {
+                gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, plane.width, 1, format,
+                                    GL_UNSIGNED_BYTE, bits + qsizetype(row) * plane.stride);
+            }
+        }
+    }
+    gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return true;
+}
 #endif
 
 }
@@ -20,19 +20,30 @@
 #include <QImage>
 #include <QAtomicInt>
 #include <QScopedPointer>
+#include <QtCore/QPointer>
+#include <QtGui/QMatrix4x4>
+#if QT_CONFIG(opengl)
+#include <QtGui/QOpenGLContext>
+#include <QtOpenGL/QOpenGLTexture>
+#endif
 
 #include <QtWaylandCompositor/QWaylandSurface>
 #include <QtWaylandCompositor/QWaylandBufferRef>
+#include <QtWaylandCompositor/private/qwaylandlinuxexplicitsynchronizationv1_p.h>
+#include <QtWaylandCompositor/private/qwlsyncfence_p.h>
 #include <QtCore/private/qglobal_p.h>
 
 #include <wayland-server-core.h>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
 class QWaylandClientBufferIntegration;
 class QWaylandBufferRef;
 class QWaylandCompositor;
 class QOpenGLTexture;
+struct QWaylandYuvConversion;
 
 namespace QtWayland {
 
@@ -57,6 +68,8 @@ public:
     virtual void unlockNativeBuffer(quintptr native_buffer) const { Q_UNUSED(native_buffer); }
 
     virtual QImage image() const { return QImage(); }
+    // How image() converts YUV content, as described for the surface it was committed to
+    virtual void setYuvConversion(const QWaylandYuvConversion &conversion) { Q_UNUSED(conversion); }
 
     inline bool isCommitted() const { return m_committed; }
     virtual void setCommitted(QRegion &damage);
@@ -68,6 +81,16 @@ public:
 
     bool isSharedMemory() const { return wl_shm_buffer_get(m_buffer); }
 
+    // Explicit synchronization: acquire fences are waited for before the commit is applied,
+    // the renderer hands a release fence to the buffer after each frame it drew it in
+    virtual bool supportsAcquireFence() const { return false; }
+    bool wantsReleaseFence() const { return m_bufferRelease; }
+    // Signaled once the work queued on the current context so far has completed, if supported
+    virtual SyncFence createReleaseFence() { return SyncFence(); }
+    void setReleaseFence(SyncFence &&fence) { m_releaseFence = std::move(fence); }
+    void setBufferRelease(QWaylandLinuxExplicitSynchronizationV1Private::BufferRelease *release);
+    void detachBufferRelease(QWaylandLinuxExplicitSynchronizationV1Private::BufferRelease *release);
+
 #if QT_CONFIG(opengl)
     virtual QOpenGLTexture *toOpenGlTexture(int plane = 0) = 0;
 #endif
@@ -91,6 +114,9 @@ private:
 
     QAtomicInt m_refCount;
 
+    SyncFence m_releaseFence;
+    QWaylandLinuxExplicitSynchronizationV1Private::BufferRelease *m_bufferRelease = nullptr;
+
     friend class ::QWaylandBufferRef;
     friend class BufferManager;
 };
@@ -99,16 +125,34 @@ class Q_WAYLANDCOMPOSITOR_EXPORT SharedMemoryBuffer : public ClientBuffer
 {
 public:
     SharedMemoryBuffer(struct ::wl_resource *bufferResource);
+#if QT_CONFIG(opengl)
+    ~SharedMemoryBuffer() override;
+#endif
 
+    QWaylandBufferRef::BufferFormatEgl bufferFormatEgl() const override;
     QSize size() const override;
     QWaylandSurface::Origin origin() const  override;
     QImage image() const override;
+    void setYuvConversion(const QWaylandYuvConversion &conversion) override;
 
 #if QT_CONFIG(opengl)
     QOpenGLTexture *toOpenGlTexture(int plane = 0) override;
+#endif
 
 private:
-    QScopedPointer<QOpenGLTexture> m_shmTexture;
+    QMatrix4x4 m_yuvToRgb;
+
+#if QT_CONFIG(opengl)
+    bool uploadPlanes(wl_shm_buffer *shmBuffer);
+    QOpenGLTexture *acquireTexture(QOpenGLTexture::TextureFormat format, const QSize &size,
+                                   bool *hasStorage);
+
+    // Handed back to the texture recycler of m_textureContext when the buffer goes away
+    QPointer<QOpenGLContext> m_textureContext;
+    QOpenGLTexture *m_shmTexture = nullptr;
+    QOpenGLTexture *m_planeTextures[2] = {};
+    bool m_shmTextureHasStorage = false;
+    bool m_planeTexturesHaveStorage[2] = {};
 #endif
 };
 
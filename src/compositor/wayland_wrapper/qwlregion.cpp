@@ -9,6 +9,15 @@ QT_BEGIN_NAMESPACE
 
 namespace QtWayland {
 
+static QRegion uniteRects(const QRect *rects, qsizetype count)
+{
+    // Pairwise, so that each union works on regions of similar complexity
+    if (count == 1)
+        return QRegion(rects[0]);
+    const qsizetype half = count / 2;
+    return uniteRects(rects, half).united(uniteRects(rects + half, count - half));
+}
+
 Region::Region(struct wl_client *client, uint32_t id)
     : QtWaylandServer::wl_region(client, id, 1)
 {
@@ -23,6 +32,28 @@ Region *Region::fromResource(struct ::wl_resource *resource)
     return QtWayland::fromResource<Region *>(resource);
 }
 
+QRegion Region::region() const
+{
+    applyPendingRects();
+    return m_region;
+}
+
+void Region::applyPendingRects() const
+{
+    if (m_pendingRects.isEmpty())
+        return;
+
+    const QRegion rects = uniteRects(m_pendingRects.constData(), m_pendingRects.size());
+    m_pendingRects.clear();
+
+    if (m_pendingOperation == Operation::Subtract)
+        m_region -= rects;
+    else if (m_region.isEmpty())
+        m_region = rects;
+    else
+        m_region += rects;
+}
+
 void Region::region_destroy_resource(Resource *)
 {
     delete this;
@@ -35,12 +66,20 @@ void Region::region_destroy(Resource *resource)
 
 void Region::region_add(Resource *, int32_t x, int32_t y, int32_t w, int32_t h)
 {
-    m_region += QRect(x, y, w, h);
+    if (m_pendingOperation != Operation::Add) {
+        applyPendingRects();
+        m_pendingOperation = Operation::Add;
+    }
+    m_pendingRects.append(QRect(x, y, w, h));
 }
 
 void Region::region_subtract(Resource *, int32_t x, int32_t y, int32_t w, int32_t h)
 {
-    m_region -= QRect(x, y, w, h);
+    if (m_pendingOperation != Operation::Subtract) {
+        applyPendingRects();
+        m_pendingOperation = Operation::Subtract;
+    }
+    m_pendingRects.append(QRect(x, y, w, h));
 }
 
 }
@@ -17,6 +17,7 @@
 
 #include <QtWaylandCompositor/qtwaylandcompositorglobal.h>
 
+#include <QList>
 #include <QRegion>
 #include <private/qglobal_p.h>
 
@@ -37,12 +38,20 @@ public:
 
     uint id() const { return wl_resource_get_id(resource()->handle); }
 
-    QRegion region() const { return m_region; }
+    QRegion region() const;
 
 private:
     Q_DISABLE_COPY(Region)
 
-    QRegion m_region;
+    enum class Operation { Add, Subtract };
+
+    void applyPendingRects() const;
+
+    // Consecutive adds or subtracts are collected and only folded into m_region when the
+    // region is used, instead of doing a full QRegion operation per request.
+    mutable QRegion m_region;
+    mutable QList<QRect> m_pendingRects;
+    mutable Operation m_pendingOperation = Operation::Add;
 
     void region_destroy_resource(Resource *) override;
 
@@ -0,0 +1,65 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qwlsyncfence_p.h"
+
+#include <QtCore/QDeadlineTimer>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef Q_OS_LINUX
+#  include <sys/ioctl.h>
+#  include <linux/sync_file.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWayland {
+
+SyncFence::~SyncFence()
+{
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+SyncFence SyncFence::duplicate() const
+{
+    return SyncFence(m_fd >= 0 ? fcntl(m_fd, F_DUPFD_CLOEXEC, 0) : -1);
+}
+
+bool SyncFence::isSyncFile() const
+{
+#ifdef Q_OS_LINUX
+    // Without room for fences, only the number of fences of the sync_file is filled in
+    sync_file_info info = {};
+    return m_fd >= 0 && ioctl(m_fd, SYNC_IOC_FILE_INFO, &info) == 0;
+#else
+    return false;
+#endif
+}
+
+bool SyncFence::wait(int timeout) const
+{
+    if (m_fd < 0)
+        return true;
+
+    QDeadlineTimer deadline(timeout < 0 ? QDeadlineTimer::Forever : QDeadlineTimer(timeout));
+    pollfd pfd = { m_fd, POLLIN, 0 };
+    for (;;) {
+        const int remaining = deadline.isForever() ? -1 : int(deadline.remainingTime());
+        const int result = poll(&pfd, 1, remaining);
+        if (result < 0 && errno == EINTR)
+            continue;
+        // A fence which can not be polled counts as signaled, rather than holding up its
+        // waiters forever, and a socket notifier on it firing over and over
+        return result > 0;
+    }
+}
+
+}
+
+QT_END_NAMESPACE
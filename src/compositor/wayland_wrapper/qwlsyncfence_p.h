@@ -0,0 +1,62 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWLSYNCFENCE_P_H
+#define QWLSYNCFENCE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandCompositor/qtwaylandcompositorglobal.h>
+
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWayland {
+
+// Owns the file descriptor of a fence, like a sync_file, that becomes readable once signaled
+class Q_WAYLANDCOMPOSITOR_EXPORT SyncFence
+{
+public:
+    SyncFence() = default;
+    explicit SyncFence(int fd) : m_fd(fd) {}
+    SyncFence(SyncFence &&other) noexcept : m_fd(std::exchange(other.m_fd, -1)) {}
+    SyncFence &operator=(SyncFence &&other) noexcept
+    {
+        SyncFence moved(std::move(other));
+        std::swap(m_fd, moved.m_fd);
+        return *this;
+    }
+    ~SyncFence();
+
+    bool isValid() const { return m_fd >= 0; }
+    int fd() const { return m_fd; }
+    int takeFd() { return std::exchange(m_fd, -1); }
+    SyncFence duplicate() const;
+    // Whether the fd is a sync_file, as opposed to any other fd that becomes readable
+    bool isSyncFile() const;
+
+    bool isSignaled() const { return wait(0); }
+    // Waits for at most timeout milliseconds, or forever if it is negative
+    bool wait(int timeout) const;
+
+private:
+    Q_DISABLE_COPY(SyncFence)
+
+    int m_fd = -1;
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QWLSYNCFENCE_P_H
@@ -23,11 +23,10 @@ QWaylandBrcmEglIntegration::QWaylandBrcmEglIntegration()
 
 void QWaylandBrcmEglIntegration::wlDisplayHandleGlobal(void *data, struct ::wl_registry *registry, uint32_t id, const QString &interface, uint32_t version)
 {
+    Q_UNUSED(interface);
     Q_UNUSED(version);
-    if (interface == "qt_brcm") {
-        QWaylandBrcmEglIntegration *integration = static_cast<QWaylandBrcmEglIntegration *>(data);
-        integration->m_waylandBrcm = static_cast<struct qt_brcm *>(wl_registry_bind(registry, id, &qt_brcm_interface, 1));
-    }
+    QWaylandBrcmEglIntegration *integration = static_cast<QWaylandBrcmEglIntegration *>(data);
+    integration->m_waylandBrcm = static_cast<struct qt_brcm *>(wl_registry_bind(registry, id, &qt_brcm_interface, 1));
 }
 
 qt_brcm *QWaylandBrcmEglIntegration::waylandBrcm() const
@@ -44,7 +43,7 @@ void QWaylandBrcmEglIntegration::initialize(QWaylandDisplay *waylandDisplay)
 {
     m_display = waylandDisplay;
     m_waylandDisplay = waylandDisplay->wl_display();
-    waylandDisplay->addRegistryListener(wlDisplayHandleGlobal, this);
+    waylandDisplay->addRegistryListener(QStringLiteral("qt_brcm"), wlDisplayHandleGlobal, this);
     EGLint major,minor;
     m_eglDisplay = eglGetDisplay((EGLNativeDisplayType)EGL_DEFAULT_DISPLAY);
     if (m_eglDisplay == NULL) {
@@ -119,7 +119,7 @@ void DmaBufServerBufferIntegration::initializeEgl()
 void DmaBufServerBufferIntegration::initialize(QWaylandDisplay *display)
 {
     m_display = display;
-    display->addRegistryListener(&wlDisplayHandleGlobal, this);
+    display->addRegistryListener(QStringLiteral("qt_dmabuf_server_buffer"), &wlDisplayHandleGlobal, this);
 }
 
 QWaylandServerBuffer *DmaBufServerBufferIntegration::serverBuffer(struct qt_server_buffer *buffer)
@@ -129,11 +129,10 @@ QWaylandServerBuffer *DmaBufServerBufferIntegration::serverBuffer(struct qt_serv
 
 void DmaBufServerBufferIntegration::wlDisplayHandleGlobal(void *data, ::wl_registry *registry, uint32_t id, const QString &interface, uint32_t version)
 {
+    Q_UNUSED(interface);
     Q_UNUSED(version);
-    if (interface == QStringLiteral("qt_dmabuf_server_buffer")) {
-        auto *integration = static_cast<DmaBufServerBufferIntegration *>(data);
-        integration->QtWayland::qt_dmabuf_server_buffer::init(registry, id, 1);
-    }
+    auto *integration = static_cast<DmaBufServerBufferIntegration *>(data);
+    integration->QtWayland::qt_dmabuf_server_buffer::init(registry, id, 1);
 }
 
 void DmaBufServerBufferIntegration::dmabuf_server_buffer_server_buffer_created(struct ::qt_server_buffer *id
@@ -122,7 +122,7 @@ void DrmEglServerBufferIntegration::initializeEgl()
 void DrmEglServerBufferIntegration::initialize(QWaylandDisplay *display)
 {
     m_display = display;
-    display->addRegistryListener(&wlDisplayHandleGlobal, this);
+    display->addRegistryListener(QStringLiteral("qt_drm_egl_server_buffer"), &wlDisplayHandleGlobal, this);
 }
 
 QWaylandServerBuffer *DrmEglServerBufferIntegration::serverBuffer(struct qt_server_buffer *buffer)
@@ -132,11 +132,10 @@ QWaylandServerBuffer *DrmEglServerBufferIntegration::serverBuffer(struct qt_serv
 
 void DrmEglServerBufferIntegration::wlDisplayHandleGlobal(void *data, ::wl_registry *registry, uint32_t id, const QString &interface, uint32_t version)
 {
+    Q_UNUSED(interface);
     Q_UNUSED(version);
-    if (interface == QStringLiteral("qt_drm_egl_server_buffer")) {
-        auto *integration = static_cast<DrmEglServerBufferIntegration *>(data);
-        integration->QtWayland::qt_drm_egl_server_buffer::init(registry, id, 1);
-    }
+    auto *integration = static_cast<DrmEglServerBufferIntegration *>(data);
+    integration->QtWayland::qt_drm_egl_server_buffer::init(registry, id, 1);
 }
 
 void DrmEglServerBufferIntegration::drm_egl_server_buffer_server_buffer_created(struct ::qt_server_buffer *id
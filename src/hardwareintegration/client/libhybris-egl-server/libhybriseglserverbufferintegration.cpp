@@ -130,7 +130,7 @@ void LibHybrisEglServerBufferIntegration::initializeEgl()
 void LibHybrisEglServerBufferIntegration::initialize(QWaylandDisplay *display)
 {
     m_display = display;
-    display->addRegistryListener(&wlDisplayHandleGlobal, this);
+    display->addRegistryListener(QStringLiteral("qt_libhybris_egl_server_buffer"), &wlDisplayHandleGlobal, this);
 }
 
 QWaylandServerBuffer *LibHybrisEglServerBufferIntegration::serverBuffer(struct qt_server_buffer *buffer)
@@ -140,11 +140,10 @@ QWaylandServerBuffer *LibHybrisEglServerBufferIntegration::serverBuffer(struct q
 
 void LibHybrisEglServerBufferIntegration::wlDisplayHandleGlobal(void *data, ::wl_registry *registry, uint32_t id, const QString &interface, uint32_t version)
 {
+    Q_UNUSED(interface);
     Q_UNUSED(version);
-    if (interface == QStringLiteral("qt_libhybris_egl_server_buffer")) {
-        auto *integration = static_cast<LibHybrisEglServerBufferIntegration *>(data);
-        integration->QtWayland::qt_libhybris_egl_server_buffer::init(registry, id, 1);
-    }
+    auto *integration = static_cast<LibHybrisEglServerBufferIntegration *>(data);
+    integration->QtWayland::qt_libhybris_egl_server_buffer::init(registry, id, 1);
 }
 
 void LibHybrisEglServerBufferIntegration::libhybris_egl_server_buffer_server_buffer_created(struct ::qt_libhybris_buffer *id
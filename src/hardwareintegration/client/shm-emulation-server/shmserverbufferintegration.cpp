@@ -76,7 +76,7 @@ QOpenGLTexture *ShmServerBuffer::toOpenGlTexture()
 void ShmServerBufferIntegration::initialize(QWaylandDisplay *display)
 {
     m_display = display;
-    display->addRegistryListener(&wlDisplayHandleGlobal, this);
+    display->addRegistryListener(QStringLiteral("qt_shm_emulation_server_buffer"), &wlDisplayHandleGlobal, this);
 }
 
 QWaylandServerBuffer *ShmServerBufferIntegration::serverBuffer(struct qt_server_buffer *buffer)
@@ -86,11 +86,10 @@ QWaylandServerBuffer *ShmServerBufferIntegration::serverBuffer(struct qt_server_
 
 void ShmServerBufferIntegration::wlDisplayHandleGlobal(void *data, ::wl_registry *registry, uint32_t id, const QString &interface, uint32_t version)
 {
+    Q_UNUSED(interface);
     Q_UNUSED(version);
-    if (interface == "qt_shm_emulation_server_buffer") {
-        auto *integration = static_cast<ShmServerBufferIntegration *>(data);
-        integration->QtWayland::qt_shm_emulation_server_buffer::init(registry, id, 1);
-    }
+    auto *integration = static_cast<ShmServerBufferIntegration *>(data);
+    integration->QtWayland::qt_shm_emulation_server_buffer::init(registry, id, 1);
 }
 
 
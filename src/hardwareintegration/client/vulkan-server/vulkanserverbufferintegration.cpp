@@ -138,7 +138,7 @@ QOpenGLTexture *VulkanServerBuffer::toOpenGlTexture()
 void VulkanServerBufferIntegration::initialize(QWaylandDisplay *display)
 {
     m_display = display;
-    display->addRegistryListener(&wlDisplayHandleGlobal, this);
+    display->addRegistryListener(QStringLiteral("zqt_vulkan_server_buffer_v1"), &wlDisplayHandleGlobal, this);
 }
 
 QWaylandServerBuffer *VulkanServerBufferIntegration::serverBuffer(struct qt_server_buffer *buffer)
@@ -148,11 +148,10 @@ QWaylandServerBuffer *VulkanServerBufferIntegration::serverBuffer(struct qt_serv
 
 void VulkanServerBufferIntegration::wlDisplayHandleGlobal(void *data, ::wl_registry *registry, uint32_t id, const QString &interface, uint32_t version)
 {
+    Q_UNUSED(interface);
     Q_UNUSED(version);
-    if (interface == "zqt_vulkan_server_buffer_v1") {
-        auto *integration = static_cast<VulkanServerBufferIntegration *>(data);
-        integration->QtWayland::zqt_vulkan_server_buffer_v1::init(registry, id, 1);
-    }
+    auto *integration = static_cast<VulkanServerBufferIntegration *>(data);
+    integration->QtWayland::zqt_vulkan_server_buffer_v1::init(registry, id, 1);
 }
 
 void VulkanServerBufferIntegration::zqt_vulkan_server_buffer_v1_server_buffer_created(qt_server_buffer *id, int32_t fd, uint32_t width, uint32_t height, uint32_t memory_size, uint32_t format)
@@ -403,8 +403,10 @@ void QWaylandGLContext::swapBuffers(QPlatformSurface *surface)
         window->waitForFrameSync(100);
     }
     window->handleUpdate();
+    const qint64 traceStart = window->latencyTraceStart();
     if (!eglSwapBuffers(eglDisplay(), eglSurface))
         qCWarning(lcQpaWayland, "eglSwapBuffers failed with %#x, surface: %p", eglGetError(), eglSurface);
+    window->traceCommitted("eglSwapBuffers", traceStart);
 }
 
 GLuint QWaylandGLContext::defaultFramebufferObject(QPlatformSurface *surface) const
@@ -5,7 +5,7 @@
 #include "linuxdmabufclientbufferintegration.h"
 
 #include <QtWaylandCompositor/QWaylandCompositor>
-#include <QtWaylandCompositor/private/qwltextureorphanage_p.h>
+#include <QtWaylandCompositor/private/qwltexturerecycler_p.h>
 
 #include <drm_fourcc.h>
 #include <drm_mode.h>
@@ -13,20 +13,82 @@
 
 QT_BEGIN_NAMESPACE
 
-LinuxDmabuf::LinuxDmabuf(wl_display *display, LinuxDmabufClientBufferIntegration *clientBufferIntegration)
-    : zwp_linux_dmabuf_v1(display, 3 /*version*/)
+LinuxDmabuf::LinuxDmabuf(wl_display *display, LinuxDmabufClientBufferIntegration *clientBufferIntegration,
+                         int version)
+    : zwp_linux_dmabuf_v1(display, version)
     , m_clientBufferIntegration(clientBufferIntegration)
 {
 }
 
-void LinuxDmabuf::setSupportedModifiers(const QHash<uint32_t, QList<uint64_t>> &modifiers)
+LinuxDmabuf::~LinuxDmabuf()
+{
+    for (LinuxDmabufFeedback *feedback : std::as_const(m_feedbacks))
+        feedback->detach();
+}
+
+void LinuxDmabuf::setSupportedModifiers(const QHash<uint32_t, QList<uint64_t>> &modifiers, dev_t mainDevice)
 {
     Q_ASSERT(resourceMap().isEmpty());
     m_modifiers = modifiers;
+
+    // send DRM_FORMAT_MOD_INVALID when no modifiers are supported for a format
+    QHash<uint32_t, QList<uint64_t>> tableModifiers = modifiers;
+    for (auto it = tableModifiers.begin(); it != tableModifiers.end(); ++it) {
+        if (it.value().isEmpty())
+            it.value() << DRM_FORMAT_MOD_INVALID;
+    }
+    m_formatTable = std::make_unique<QtWayland::DmabufFormatTable>(tableModifiers);
+    m_defaultFeedback = QtWayland::DmabufFeedback::defaultFeedback(*m_formatTable, mainDevice);
+}
+
+void LinuxDmabuf::setScanoutFormats(QWaylandSurface *surface, dev_t device,
+                                    const QHash<uint32_t, QList<uint64_t>> &formats)
+{
+    if (!m_formatTable)
+        return;
+
+    const QtWayland::DmabufFeedback oldFeedback = feedbackForSurface(surface);
+    m_surfaceFeedback.removeIf([surface](const SurfaceFeedback &entry) {
+        return !entry.surface || entry.surface == surface;
+    });
+    if (!formats.isEmpty()) {
+        SurfaceFeedback entry;
+        entry.surface = surface;
+        entry.feedback = QtWayland::DmabufFeedback::scanoutFeedback(*m_formatTable, m_defaultFeedback.mainDevice,
+                                                                    device, formats);
+        m_surfaceFeedback.append(entry);
+    }
+
+    // Clients reallocate their buffers on new feedback, so only send it when it changed
+    const QtWayland::DmabufFeedback feedback = feedbackForSurface(surface);
+    if (feedback == oldFeedback)
+        return;
+    for (LinuxDmabufFeedback *surfaceFeedback : std::as_const(m_feedbacks)) {
+        if (surfaceFeedback->surface() == surface)
+            surfaceFeedback->sendFeedback(feedback);
+    }
+}
+
+QtWayland::DmabufFeedback LinuxDmabuf::feedbackForSurface(QWaylandSurface *surface) const
+{
+    for (const SurfaceFeedback &entry : m_surfaceFeedback) {
+        if (entry.surface && entry.surface == surface)
+            return entry.feedback;
+    }
+    return m_defaultFeedback;
+}
+
+void LinuxDmabuf::removeFeedback(LinuxDmabufFeedback *feedback)
+{
+    m_feedbacks.removeOne(feedback);
 }
 
 void LinuxDmabuf::zwp_linux_dmabuf_v1_bind_resource(Resource *resource)
 {
+    // formats are only announced through feedback since version 4
+    if (resource->version() >= ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION)
+        return;
+
     for (auto it = m_modifiers.constBegin(); it != m_modifiers.constEnd(); ++it) {
         auto format = it.key();
         auto modifiers = it.value();
@@ -52,6 +114,67 @@ void LinuxDmabuf::zwp_linux_dmabuf_v1_create_params(Resource *resource, uint32_t
     new LinuxDmabufParams(m_clientBufferIntegration, r); // deleted by the client, or when it disconnects
 }
 
+void LinuxDmabuf::zwp_linux_dmabuf_v1_get_default_feedback(Resource *resource, uint32_t id)
+{
+    auto *feedback = new LinuxDmabufFeedback(this, nullptr, resource->client(), id, resource->version());
+    m_feedbacks.append(feedback);
+    feedback->sendFeedback(m_defaultFeedback);
+}
+
+void LinuxDmabuf::zwp_linux_dmabuf_v1_get_surface_feedback(Resource *resource, uint32_t id, wl_resource *surfaceResource)
+{
+    QWaylandSurface *surface = QWaylandSurface::fromResource(surfaceResource);
+    auto *feedback = new LinuxDmabufFeedback(this, surface, resource->client(), id, resource->version());
+    m_feedbacks.append(feedback);
+    feedback->sendFeedback(feedbackForSurface(surface));
+}
+
+LinuxDmabufFeedback::LinuxDmabufFeedback(LinuxDmabuf *dmabuf, QWaylandSurface *surface, wl_client *client,
+                                         uint32_t id, int version)
+    : zwp_linux_dmabuf_feedback_v1(client, id, version)
+    , m_dmabuf(dmabuf)
+    , m_forSurface(surface != nullptr)
+    , m_surface(surface)
+{
+}
+
+LinuxDmabufFeedback::~LinuxDmabufFeedback()
+{
+    if (m_dmabuf)
+        m_dmabuf->removeFeedback(this);
+}
+
+void LinuxDmabufFeedback::sendFeedback(const QtWayland::DmabufFeedback &feedback)
+{
+    if (!m_dmabuf || (m_forSurface && !m_surface))
+        return;
+
+    const QtWayland::DmabufFormatTable *table = m_dmabuf->formatTable();
+    if (!table || table->fd() < 0)
+        return;
+
+    send_format_table(table->fd(), table->size());
+    send_main_device(QtWayland::DmabufFeedback::deviceArray(feedback.mainDevice));
+    for (const QtWayland::DmabufTranche &tranche : feedback.tranches) {
+        send_tranche_target_device(QtWayland::DmabufFeedback::deviceArray(tranche.targetDevice));
+        send_tranche_flags(tranche.scanout ? ZWP_LINUX_DMABUF_FEEDBACK_V1_TRANCHE_FLAGS_SCANOUT : 0);
+        send_tranche_formats(QtWayland::DmabufFeedback::indexArray(tranche.indices));
+        send_tranche_done();
+    }
+    send_done();
+}
+
+void LinuxDmabufFeedback::zwp_linux_dmabuf_feedback_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void LinuxDmabufFeedback::zwp_linux_dmabuf_feedback_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
 LinuxDmabufParams::LinuxDmabufParams(LinuxDmabufClientBufferIntegration *clientBufferIntegration, wl_resource *resource)
     : zwp_linux_buffer_params_v1(resource)
     , m_clientBufferIntegration(clientBufferIntegration)
@@ -259,12 +382,67 @@ void LinuxDmabufWlBuffer::buffer_destroy(Resource *resource)
 {
     Q_UNUSED(resource);
 
-    QMutexLocker locker(&m_texturesLock);
+    if (m_import) {
+        m_clientBufferIntegration->releaseImport(m_import);
+        m_import = nullptr;
+    }
 
     for (uint32_t i = 0; i < m_planesNumber; ++i) {
+        if (m_planes[i].fd != -1)
+            close(m_planes[i].fd);
+        m_planes[i].fd = -1;
+    }
+    m_planesNumber = 0;
+}
+
+void LinuxDmabufWlBuffer::setImport(LinuxDmabufImport *import)
+{
+    Q_ASSERT(!m_import);
+    import->ref();
+    m_import = import;
+}
+
+void LinuxDmabufWlBuffer::initImage(uint32_t plane, EGLImageKHR image)
+{
+    Q_ASSERT(m_import);
+    m_import->initImage(plane, image);
+}
+
+void LinuxDmabufWlBuffer::initTexture(uint32_t plane, QOpenGLTexture *texture)
+{
+    Q_ASSERT(m_import);
+    m_import->initTexture(plane, texture);
+}
+
+void LinuxDmabufWlBuffer::buffer_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+size_t qHash(const LinuxDmabufImportKey &key, size_t seed) noexcept
+{
+    seed = qHashMulti(seed, key.drmFormat, key.size.width(), key.size.height(), key.planesNumber);
+    for (uint32_t i = 0; i < key.planesNumber; ++i) {
+        const LinuxDmabufImportKey::PlaneKey &plane = key.planes[i];
+        seed = qHashMulti(seed, quint64(plane.device), quint64(plane.inode), plane.offset,
+                          plane.stride, plane.modifiers);
+    }
+    return seed;
+}
+
+LinuxDmabufImport::LinuxDmabufImport(LinuxDmabufClientBufferIntegration *clientBufferIntegration)
+    : m_clientBufferIntegration(clientBufferIntegration)
+{
+}
+
+LinuxDmabufImport::~LinuxDmabufImport()
+{
+    QMutexLocker locker(&m_texturesLock);
+
+    for (uint32_t i = 0; i < MaxPlanes; ++i) {
         if (m_textures[i] != nullptr) {
-            QtWayland::QWaylandTextureOrphanage::instance()->admitTexture(m_textures[i],
-                                                                          m_texturesContext[i]);
+            QtWayland::QWaylandTextureRecycler::releaseTexture(m_textures[i], m_texturesContext[i]);
             m_textures[i] = nullptr;
             m_texturesContext[i] = nullptr;
             QObject::disconnect(m_texturesAboutToBeDestroyedConnection[i]);
@@ -274,25 +452,21 @@ void LinuxDmabufWlBuffer::buffer_destroy(Resource *resource)
             m_clientBufferIntegration->deleteImage(m_eglImages[i]);
             m_eglImages[i] = EGL_NO_IMAGE_KHR;
         }
-        if (m_planes[i].fd != -1)
-            close(m_planes[i].fd);
-        m_planes[i].fd = -1;
     }
-    m_planesNumber = 0;
 }
 
-void LinuxDmabufWlBuffer::initImage(uint32_t plane, EGLImageKHR image)
+void LinuxDmabufImport::initImage(uint32_t plane, EGLImageKHR image)
 {
-    Q_ASSERT(plane < m_planesNumber);
+    Q_ASSERT(plane < MaxPlanes);
     Q_ASSERT(m_eglImages.at(plane) == EGL_NO_IMAGE_KHR);
     m_eglImages[plane] = image;
 }
 
-void LinuxDmabufWlBuffer::initTexture(uint32_t plane, QOpenGLTexture *texture)
+void LinuxDmabufImport::initTexture(uint32_t plane, QOpenGLTexture *texture)
 {
     QMutexLocker locker(&m_texturesLock);
 
-    Q_ASSERT(plane < m_planesNumber);
+    Q_ASSERT(plane < MaxPlanes);
     Q_ASSERT(m_textures.at(plane) == nullptr);
     Q_ASSERT(QOpenGLContext::currentContext());
     m_textures[plane] = texture;
@@ -326,10 +500,4 @@ void LinuxDmabufWlBuffer::initTexture(uint32_t plane, QOpenGLTexture *texture)
     }, Qt::DirectConnection);
 }
 
-void LinuxDmabufWlBuffer::buffer_destroy_resource(Resource *resource)
-{
-    Q_UNUSED(resource);
-    delete this;
-}
-
 QT_END_NAMESPACE
@@ -8,20 +8,26 @@
 
 #include <QtWaylandCompositor/private/qwayland-server-wayland.h>
 #include <QtWaylandCompositor/private/qwlclientbufferintegration_p.h>
+#include <QtWaylandCompositor/private/qwldmabuffeedback_p.h>
+#include <QtWaylandCompositor/QWaylandSurface>
 
 #include <QtOpenGL/QOpenGLTexture>
 #include <QtCore/QObject>
 #include <QtCore/QHash>
 #include <QtCore/QSize>
 #include <QtCore/QTextStream>
+#include <QtCore/QPointer>
 
 #include <array>
+#include <memory>
 #include <QtGui/QOpenGLContext>
 #include <QtCore/QMutex>
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 
+#include <sys/types.h>
+
 // compatibility with libdrm <= 2.4.74
 #ifndef DRM_FORMAT_RESERVED
 #define DRM_FORMAT_RESERVED           ((1ULL << 56) - 1)
@@ -47,6 +53,7 @@ QT_BEGIN_NAMESPACE
 class QWaylandCompositor;
 class QWaylandResource;
 class LinuxDmabufParams;
+class LinuxDmabufFeedback;
 class LinuxDmabufClientBufferIntegration;
 
 struct Plane {
@@ -56,20 +63,127 @@ struct Plane {
     uint64_t modifiers = 0;
 };
 
+// Identifies dmabuf memory independently of the fds a client sent for it: a dmabuf keeps its
+// inode for as long as it exists, and every fd referring to it reports the same one.
+struct LinuxDmabufImportKey {
+    struct PlaneKey {
+        dev_t device = 0;
+        ino_t inode = 0;
+        uint32_t offset = 0;
+        uint32_t stride = 0;
+        uint64_t modifiers = 0;
+
+        friend bool operator==(const PlaneKey &a, const PlaneKey &b)
+        {
+            return a.device == b.device && a.inode == b.inode && a.offset == b.offset
+                    && a.stride == b.stride && a.modifiers == b.modifiers;
+        }
+    };
+
+    uint32_t drmFormat = 0;
+    QSize size;
+    uint32_t planesNumber = 0;
+    std::array<PlaneKey, 4> planes;
+
+    friend bool operator==(const LinuxDmabufImportKey &a, const LinuxDmabufImportKey &b)
+    {
+        return a.drmFormat == b.drmFormat && a.size == b.size && a.planesNumber == b.planesNumber
+                && a.planes == b.planes;
+    }
+};
+
+size_t qHash(const LinuxDmabufImportKey &key, size_t seed = 0) noexcept;
+
+// The EGLImages of dmabuf memory, and the textures bound to them. Shared by all wl_buffers
+// that wrap the same memory, and destroyed with the last of them.
+class LinuxDmabufImport
+{
+public:
+    explicit LinuxDmabufImport(LinuxDmabufClientBufferIntegration *clientBufferIntegration);
+    ~LinuxDmabufImport();
+
+    void ref() { ++m_refCount; }
+    bool deref() { return --m_refCount > 0; }
+
+    void initImage(uint32_t plane, EGLImageKHR image);
+    void initTexture(uint32_t plane, QOpenGLTexture *texture);
+    inline EGLImageKHR image(uint32_t plane) const { return m_eglImages.at(plane); }
+    inline QOpenGLTexture *texture(uint32_t plane) const { return m_textures.at(plane); }
+
+    static const uint32_t MaxPlanes = 4;
+
+private:
+    Q_DISABLE_COPY(LinuxDmabufImport)
+
+    // Only touched on the compositor thread, where buffers come and go
+    int m_refCount = 0;
+    LinuxDmabufClientBufferIntegration *m_clientBufferIntegration = nullptr;
+    std::array<EGLImageKHR, MaxPlanes> m_eglImages = { {EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR} };
+    std::array<QOpenGLTexture *, MaxPlanes> m_textures = { {nullptr, nullptr, nullptr, nullptr} };
+    std::array<QOpenGLContext *, MaxPlanes> m_texturesContext = { {nullptr, nullptr, nullptr, nullptr} };
+    std::array<QMetaObject::Connection, MaxPlanes> m_texturesAboutToBeDestroyedConnection = { {QMetaObject::Connection(), QMetaObject::Connection(), QMetaObject::Connection(), QMetaObject::Connection()} };
+    QMutex m_texturesLock;
+};
+
 class LinuxDmabuf : public QtWaylandServer::zwp_linux_dmabuf_v1
 {
 public:
-    explicit LinuxDmabuf(wl_display *display, LinuxDmabufClientBufferIntegration *clientBufferIntegration);
+    explicit LinuxDmabuf(wl_display *display, LinuxDmabufClientBufferIntegration *clientBufferIntegration,
+                         int version);
+    ~LinuxDmabuf() override;
+
+    void setSupportedModifiers(const QHash<uint32_t, QList<uint64_t>> &modifiers, dev_t mainDevice);
+
+    // Lets clients of the surface prefer buffers that can be scanned out on the given device,
+    // or stops doing so for empty formats
+    void setScanoutFormats(QWaylandSurface *surface, dev_t device,
+                           const QHash<uint32_t, QList<uint64_t>> &formats);
 
-    void setSupportedModifiers(const QHash<uint32_t, QList<uint64_t>> &modifiers);
+    QtWayland::DmabufFeedback feedbackForSurface(QWaylandSurface *surface) const;
+    const QtWayland::DmabufFormatTable *formatTable() const { return m_formatTable.get(); }
+    void removeFeedback(LinuxDmabufFeedback *feedback);
 
 protected:
     void zwp_linux_dmabuf_v1_bind_resource(Resource *resource) override;
     void zwp_linux_dmabuf_v1_create_params(Resource *resource, uint32_t params_id) override;
+    void zwp_linux_dmabuf_v1_get_default_feedback(Resource *resource, uint32_t id) override;
+    void zwp_linux_dmabuf_v1_get_surface_feedback(Resource *resource, uint32_t id, wl_resource *surface) override;
 
 private:
     QHash<uint32_t, QList<uint64_t>> m_modifiers; // key=DRM format, value=supported DRM modifiers for format
     LinuxDmabufClientBufferIntegration *m_clientBufferIntegration;
+
+    // Shared by all feedback objects, which only exist for version 4 and later
+    std::unique_ptr<QtWayland::DmabufFormatTable> m_formatTable;
+    QtWayland::DmabufFeedback m_defaultFeedback;
+    struct SurfaceFeedback {
+        QPointer<QWaylandSurface> surface;
+        QtWayland::DmabufFeedback feedback;
+    };
+    QList<SurfaceFeedback> m_surfaceFeedback;
+    QList<LinuxDmabufFeedback *> m_feedbacks;
+};
+
+class LinuxDmabufFeedback : public QtWaylandServer::zwp_linux_dmabuf_feedback_v1
+{
+public:
+    LinuxDmabufFeedback(LinuxDmabuf *dmabuf, QWaylandSurface *surface, wl_client *client,
+                        uint32_t id, int version);
+    ~LinuxDmabufFeedback() override;
+
+    QWaylandSurface *surface() const { return m_surface; }
+    void sendFeedback(const QtWayland::DmabufFeedback &feedback);
+    void detach() { m_dmabuf = nullptr; }
+
+protected:
+    void zwp_linux_dmabuf_feedback_v1_destroy_resource(Resource *resource) override;
+    void zwp_linux_dmabuf_feedback_v1_destroy(Resource *resource) override;
+
+private:
+    LinuxDmabuf *m_dmabuf = nullptr;
+    // Surface feedback becomes inert with its surface
+    const bool m_forSurface;
+    QPointer<QWaylandSurface> m_surface;
 };
 
 class LinuxDmabufParams : public QtWaylandServer::zwp_linux_buffer_params_v1
@@ -105,13 +219,15 @@ public:
 
     void initImage(uint32_t plane, EGLImageKHR image);
     void initTexture(uint32_t plane, QOpenGLTexture *texture);
+    void setImport(LinuxDmabufImport *import);
+    inline LinuxDmabufImport *import() const { return m_import; }
     inline QSize size() const { return m_size; }
     inline uint32_t flags() const { return m_flags; }
     inline uint32_t drmFormat() const { return m_drmFormat; }
     inline Plane& plane(uint index) { return m_planes.at(index); }
     inline uint32_t planesNumber() const { return m_planesNumber; }
-    inline EGLImageKHR image(uint32_t plane) { return m_eglImages.at(plane); }
-    inline QOpenGLTexture *texture(uint32_t plane) const { return m_textures.at(plane); }
+    inline EGLImageKHR image(uint32_t plane) { return m_import ? m_import->image(plane) : EGL_NO_IMAGE_KHR; }
+    inline QOpenGLTexture *texture(uint32_t plane) const { return m_import ? m_import->texture(plane) : nullptr; }
     void buffer_destroy_resource(Resource *resource) override;
 
     static const uint32_t MaxDmabufPlanes = 4;
@@ -123,11 +239,7 @@ private:
     std::array<Plane, MaxDmabufPlanes> m_planes;
     uint32_t m_planesNumber = 1;
     LinuxDmabufClientBufferIntegration *m_clientBufferIntegration = nullptr;
-    std::array<EGLImageKHR, MaxDmabufPlanes> m_eglImages = { {EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR} };
-    std::array<QOpenGLTexture *, MaxDmabufPlanes> m_textures = { {nullptr, nullptr, nullptr, nullptr} };
-    std::array<QOpenGLContext *, MaxDmabufPlanes> m_texturesContext = { {nullptr, nullptr, nullptr, nullptr} };
-    std::array<QMetaObject::Connection, MaxDmabufPlanes> m_texturesAboutToBeDestroyedConnection = { {QMetaObject::Connection(), QMetaObject::Connection(), QMetaObject::Connection(), QMetaObject::Connection()} };
-    QMutex m_texturesLock;
+    LinuxDmabufImport *m_import = nullptr;
 
     void freeResources();
     void buffer_destroy(Resource *resource) override;
@@ -6,7 +6,7 @@
 
 #include <QtWaylandCompositor/QWaylandCompositor>
 #include <QtWaylandCompositor/private/qwayland-server-wayland.h>
-#include <QtWaylandCompositor/private/qwltextureorphanage_p.h>
+#include <QtWaylandCompositor/private/qwltexturerecycler_p.h>
 #include <qpa/qplatformnativeinterface.h>
 #include <QtOpenGL/QOpenGLTexture>
 #include <QtCore/QVarLengthArray>
@@ -16,8 +16,19 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <drm_fourcc.h>
 
+#ifndef EGL_DEVICE_EXT
+#define EGL_DEVICE_EXT 0x322C
+#endif
+#ifndef EGL_DRM_DEVICE_FILE_EXT
+#define EGL_DRM_DEVICE_FILE_EXT 0x3233
+#endif
+#ifndef EGL_DRM_RENDER_NODE_FILE_EXT
+#define EGL_DRM_RENDER_NODE_FILE_EXT 0x3377
+#endif
+
 QT_BEGIN_NAMESPACE
 
 static QWaylandBufferRef::BufferFormatEgl formatFromDrmFormat(EGLint format) {
@@ -252,8 +263,6 @@ LinuxDmabufClientBufferIntegration::~LinuxDmabufClientBufferIntegration()
 
 void LinuxDmabufClientBufferIntegration::initializeHardware(struct ::wl_display *display)
 {
-    m_linuxDmabuf.reset(new LinuxDmabuf(display, this));
-
     const bool ignoreBindDisplay = !qgetenv("QT_WAYLAND_IGNORE_BIND_DISPLAY").isEmpty() && qgetenv("QT_WAYLAND_IGNORE_BIND_DISPLAY").toInt() != 0;
 
     // initialize hardware extensions
@@ -299,6 +308,17 @@ void LinuxDmabufClientBufferIntegration::initializeHardware(struct ::wl_display
     if (strstr(extensionString, "EGL_EXT_image_dma_buf_import_modifiers"))
         m_supportsDmabufModifiers = true;
 
+    if (strstr(extensionString, "EGL_ANDROID_native_fence_sync")) {
+        egl_create_sync = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"));
+        egl_destroy_sync = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"));
+        egl_dup_native_fence_fd = reinterpret_cast<PFNEGLDUPNATIVEFENCEFDANDROIDPROC>(eglGetProcAddress("eglDupNativeFenceFDANDROID"));
+        if (!egl_create_sync || !egl_destroy_sync || !egl_dup_native_fence_fd) {
+            egl_create_sync = nullptr;
+            egl_destroy_sync = nullptr;
+            egl_dup_native_fence_fd = nullptr;
+        }
+    }
+
     if (egl_bind_wayland_display && egl_unbind_wayland_display) {
         m_displayBound = egl_bind_wayland_display(m_eglDisplay, display);
         if (!m_displayBound)
@@ -311,7 +331,58 @@ void LinuxDmabufClientBufferIntegration::initializeHardware(struct ::wl_display
     for (const auto &format : supportedDrmFormats()) {
         modifiers[format] = supportedDrmModifiers(format);
     }
-    m_linuxDmabuf->setSupportedModifiers(modifiers);
+
+    // feedback needs the device the renderer runs on, without it stay at version 3
+    const dev_t device = mainDevice();
+    m_linuxDmabuf.reset(new LinuxDmabuf(display, this, device ? 4 : 3));
+    m_linuxDmabuf->setSupportedModifiers(modifiers, device);
+}
+
+dev_t LinuxDmabufClientBufferIntegration::mainDevice() const
+{
+    typedef EGLBoolean (EGLAPIENTRYP QueryDisplayAttrib)(EGLDisplay, EGLint, EGLAttrib *);
+    typedef const char *(EGLAPIENTRYP QueryDeviceString)(void *, EGLint);
+    auto queryDisplayAttrib = reinterpret_cast<QueryDisplayAttrib>(eglGetProcAddress("eglQueryDisplayAttribEXT"));
+    auto queryDeviceString = reinterpret_cast<QueryDeviceString>(eglGetProcAddress("eglQueryDeviceStringEXT"));
+    if (!queryDisplayAttrib || !queryDeviceString)
+        return 0;
+
+    EGLAttrib device = 0;
+    if (!queryDisplayAttrib(m_eglDisplay, EGL_DEVICE_EXT, &device) || !device)
+        return 0;
+
+    // prefer the render node, clients should not need a master to allocate buffers
+    const char *deviceExtensions = queryDeviceString(reinterpret_cast<void *>(device), EGL_EXTENSIONS);
+    const char *path = nullptr;
+    if (deviceExtensions && strstr(deviceExtensions, "EGL_EXT_device_drm_render_node"))
+        path = queryDeviceString(reinterpret_cast<void *>(device), EGL_DRM_RENDER_NODE_FILE_EXT);
+    if (!path && deviceExtensions && strstr(deviceExtensions, "EGL_EXT_device_drm"))
+        path = queryDeviceString(reinterpret_cast<void *>(device), EGL_DRM_DEVICE_FILE_EXT);
+    if (!path)
+        return 0;
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        qCWarning(qLcWaylandCompositorHardwareIntegration) << "Could not stat DRM device" << path;
+        return 0;
+    }
+    return st.st_rdev;
+}
+
+QtWayland::SyncFence LinuxDmabufClientBufferIntegration::createFence()
+{
+    if (!egl_dup_native_fence_fd || !QOpenGLContext::currentContext())
+        return QtWayland::SyncFence();
+
+    EGLSyncKHR sync = egl_create_sync(m_eglDisplay, EGL_SYNC_NATIVE_FENCE_ANDROID, nullptr);
+    if (sync == EGL_NO_SYNC_KHR)
+        return QtWayland::SyncFence();
+
+    // a native fence only gets its file descriptor once it has been flushed
+    glFlush();
+    const int fd = egl_dup_native_fence_fd(m_eglDisplay, sync);
+    egl_destroy_sync(m_eglDisplay, sync);
+    return QtWayland::SyncFence(fd != EGL_NO_NATIVE_FENCE_FD_ANDROID ? fd : -1);
 }
 
 QList<uint32_t> LinuxDmabufClientBufferIntegration::supportedDrmFormats()
@@ -367,6 +438,32 @@ QtWayland::ClientBuffer *LinuxDmabufClientBufferIntegration::createBufferFor(wl_
     return nullptr;
 }
 
+void LinuxDmabufClientBufferIntegration::setScanoutFormats(QWaylandSurface *surface, dev_t device,
+                                                           const QHash<uint32_t, QList<uint64_t>> &formats)
+{
+    if (m_linuxDmabuf)
+        m_linuxDmabuf->setScanoutFormats(surface, device, formats);
+}
+
+bool LinuxDmabufClientBufferIntegration::importKey(LinuxDmabufWlBuffer *dmabufBuffer, LinuxDmabufImportKey *key)
+{
+    key->drmFormat = dmabufBuffer->drmFormat();
+    key->size = dmabufBuffer->size();
+    key->planesNumber = dmabufBuffer->planesNumber();
+    for (uint32_t i = 0; i < dmabufBuffer->planesNumber(); ++i) {
+        const Plane &plane = dmabufBuffer->plane(i);
+        struct stat status;
+        if (fstat(plane.fd, &status) != 0)
+            return false;
+        key->planes[i].device = status.st_dev;
+        key->planes[i].inode = status.st_ino;
+        key->planes[i].offset = plane.offset;
+        key->planes[i].stride = plane.stride;
+        key->planes[i].modifiers = plane.modifiers;
+    }
+    return true;
+}
+
 bool LinuxDmabufClientBufferIntegration::importBuffer(wl_resource *resource, LinuxDmabufWlBuffer *linuxDmabufBuffer)
 {
     if (m_importedBuffers.contains(resource)) {
@@ -374,10 +471,30 @@ bool LinuxDmabufClientBufferIntegration::importBuffer(wl_resource *resource, Lin
         return false;
     }
     m_importedBuffers[resource] = linuxDmabufBuffer;
-    if (m_yuvFormats.contains(linuxDmabufBuffer->drmFormat()))
-        return initYuvTexture(linuxDmabufBuffer);
-    else
-        return initSimpleTexture(linuxDmabufBuffer);
+
+    // Clients often create new wl_buffers for dmabufs they sent before, for instance when they
+    // reshuffle their buffer pools, so share the EGLImages of memory that is imported already.
+    LinuxDmabufImportKey key;
+    const bool cacheable = importKey(linuxDmabufBuffer, &key);
+    if (cacheable) {
+        if (LinuxDmabufImport *import = m_imports.value(key)) {
+            linuxDmabufBuffer->setImport(import);
+            ++m_importCacheHits;
+            qCDebug(qLcWaylandCompositorHardwareIntegration) << "Reusing dmabuf import, hit rate"
+                    << m_importCacheHits * 100 / (m_importCacheHits + m_importCacheMisses) << "%";
+            return true;
+        }
+        ++m_importCacheMisses;
+    }
+
+    auto *import = new LinuxDmabufImport(this);
+    linuxDmabufBuffer->setImport(import);
+    const bool success = m_yuvFormats.contains(linuxDmabufBuffer->drmFormat())
+            ? initYuvTexture(linuxDmabufBuffer)
+            : initSimpleTexture(linuxDmabufBuffer);
+    if (success && cacheable)
+        m_imports.insert(key, import);
+    return success;
 }
 
 void LinuxDmabufClientBufferIntegration::removeBuffer(wl_resource *resource)
@@ -385,6 +502,16 @@ void LinuxDmabufClientBufferIntegration::removeBuffer(wl_resource *resource)
     m_importedBuffers.remove(resource);
 }
 
+void LinuxDmabufClientBufferIntegration::releaseImport(LinuxDmabufImport *import)
+{
+    if (import->deref())
+        return;
+
+    // The memory is gone once no buffer holds its fds anymore, and the key could be reused
+    m_imports.removeIf([import](const auto &it) { return it.value() == import; });
+    delete import;
+}
+
 LinuxDmabufClientBuffer::LinuxDmabufClientBuffer(LinuxDmabufClientBufferIntegration *integration,
                                                  wl_resource *bufferResource,
                                                  LinuxDmabufWlBuffer *dmabufBuffer)
@@ -397,7 +524,9 @@ LinuxDmabufClientBuffer::LinuxDmabufClientBuffer(LinuxDmabufClientBufferIntegrat
 QOpenGLTexture *LinuxDmabufClientBuffer::toOpenGlTexture(int plane)
 {
     // At this point we should have a valid OpenGL context, so it's safe to destroy textures
-    QtWayland::QWaylandTextureOrphanage::instance()->deleteTextures();
+    auto *recycler = QtWayland::QWaylandTextureRecycler::current();
+    if (recycler)
+        recycler->collect();
 
     if (!m_buffer)
         return nullptr;
@@ -406,14 +535,16 @@ QOpenGLTexture *LinuxDmabufClientBuffer::toOpenGlTexture(int plane)
 
     const auto target = static_cast<QOpenGLTexture::Target>(GL_TEXTURE_2D);
 
-    if (!texture) {
-        texture = new QOpenGLTexture(target);
-        texture->setFormat(openGLFormatFromBufferFormat(formatFromDrmFormat(d->drmFormat())));
-        texture->setSize(d->size().width(), d->size().height());
-        texture->create();
+    if (!texture && recycler) {
+        texture = recycler->acquireTexture(
+                target, openGLFormatFromBufferFormat(formatFromDrmFormat(d->drmFormat())),
+                d->size(), m_buffer, QtWayland::QWaylandTextureRecycler::Storage::Imported);
         d->initTexture(plane, texture);
     }
 
+    if (!texture)
+        return nullptr;
+
     if (m_textureDirty) {
         m_textureDirty = false;
         texture->bind();
@@ -423,6 +554,11 @@ QOpenGLTexture *LinuxDmabufClientBuffer::toOpenGlTexture(int plane)
     return texture;
 }
 
+QtWayland::SyncFence LinuxDmabufClientBuffer::createReleaseFence()
+{
+    return m_integration->createFence();
+}
+
 void LinuxDmabufClientBuffer::setDestroyed()
 {
     m_integration->removeBuffer(m_buffer);
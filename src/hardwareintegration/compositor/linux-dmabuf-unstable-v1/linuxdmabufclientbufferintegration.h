@@ -44,9 +44,21 @@ public:
 
     void initializeHardware(struct ::wl_display *display) override;
     QtWayland::ClientBuffer *createBufferFor(wl_resource *resource) override;
+    void setScanoutFormats(QWaylandSurface *surface, dev_t device,
+                           const QHash<uint32_t, QList<uint64_t>> &formats) override;
     bool importBuffer(wl_resource *resource, LinuxDmabufWlBuffer *linuxDmabufBuffer);
     void removeBuffer(wl_resource *resource);
+    void releaseImport(LinuxDmabufImport *import);
     void deleteImage(EGLImageKHR image);
+
+    // How often a new wl_buffer wrapped memory which was imported already
+    quint64 importCacheHits() const { return m_importCacheHits; }
+    quint64 importCacheMisses() const { return m_importCacheMisses; }
+
+    // Release fence for the work queued on the current context, invalid when
+    // EGL_ANDROID_native_fence_sync is missing
+    QtWayland::SyncFence createFence();
+
     PFNGLEGLIMAGETARGETTEXTURE2DOESPROC gl_egl_image_target_texture_2d = nullptr;
 
 private:
@@ -58,11 +70,16 @@ private:
     PFNEGLDESTROYIMAGEKHRPROC egl_destroy_image = nullptr;
     PFNEGLQUERYDMABUFMODIFIERSEXTPROC egl_query_dmabuf_modifiers_ext = nullptr;
     PFNEGLQUERYDMABUFFORMATSEXTPROC egl_query_dmabuf_formats_ext = nullptr;
+    PFNEGLCREATESYNCKHRPROC egl_create_sync = nullptr;
+    PFNEGLDESTROYSYNCKHRPROC egl_destroy_sync = nullptr;
+    PFNEGLDUPNATIVEFENCEFDANDROIDPROC egl_dup_native_fence_fd = nullptr;
 
     bool initSimpleTexture(LinuxDmabufWlBuffer *dmabufBuffer);
     bool initYuvTexture(LinuxDmabufWlBuffer *dmabufBuffer);
+    static bool importKey(LinuxDmabufWlBuffer *dmabufBuffer, LinuxDmabufImportKey *key);
     QList<uint32_t> supportedDrmFormats();
     QList<uint64_t> supportedDrmModifiers(uint32_t format);
+    dev_t mainDevice() const;
 
     EGLDisplay m_eglDisplay = EGL_NO_DISPLAY;
     ::wl_display *m_wlDisplay = nullptr;
@@ -71,6 +88,9 @@ private:
     QHash<EGLint, YuvFormatConversion> m_yuvFormats;
     bool m_supportsDmabufModifiers = false;
     QHash<struct ::wl_resource *, LinuxDmabufWlBuffer *> m_importedBuffers;
+    QHash<LinuxDmabufImportKey, LinuxDmabufImport *> m_imports;
+    quint64 m_importCacheHits = 0;
+    quint64 m_importCacheMisses = 0;
     QScopedPointer<LinuxDmabuf> m_linuxDmabuf;
 };
 
@@ -83,6 +103,8 @@ public:
     QSize size() const override;
     QWaylandSurface::Origin origin() const override;
     QOpenGLTexture *toOpenGlTexture(int plane) override;
+    bool supportsAcquireFence() const override { return true; }
+    QtWayland::SyncFence createReleaseFence() override;
 
 protected:
     void setDestroyed() override;
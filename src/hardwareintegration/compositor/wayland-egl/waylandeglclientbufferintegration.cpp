@@ -4,7 +4,7 @@
 #include "waylandeglclientbufferintegration_p.h"
 
 #include <QtWaylandCompositor/QWaylandCompositor>
-#include <QtWaylandCompositor/private/qwltextureorphanage_p.h>
+#include <QtWaylandCompositor/private/qwltexturerecycler_p.h>
 #include <qpa/qplatformnativeinterface.h>
 #include <QtOpenGL/QOpenGLTexture>
 #include <QtGui/QGuiApplication>
@@ -538,8 +538,8 @@ WaylandEglClientBuffer::~WaylandEglClientBuffer()
                         << (void*)d->textures[i] << "; " << (void*)d->texturesContext[i]
                         <<  " ... current context might be the same: " << QOpenGLContext::currentContext();
 
-                QtWayland::QWaylandTextureOrphanage::instance()->admitTexture(
-                        d->textures[i], d->texturesContext[i]);
+                QtWayland::QWaylandTextureRecycler::releaseTexture(d->textures[i],
+                                                                   d->texturesContext[i]);
                 d->textures[i] = nullptr;               // in case the aboutToBeDestroyed lambda is called while we where here
                 d->texturesContext[i] = nullptr;
                 QObject::disconnect(d->texturesAboutToBeDestroyedConnection[i]);
@@ -590,7 +590,9 @@ QOpenGLTexture *WaylandEglClientBuffer::toOpenGlTexture(int plane)
 {
     auto *p = WaylandEglClientBufferIntegrationPrivate::get(m_integration);
     // At this point we should have a valid OpenGL context, so it's safe to destroy textures
-    QtWayland::QWaylandTextureOrphanage::instance()->deleteTextures();
+    auto *recycler = QtWayland::QWaylandTextureRecycler::current();
+    if (recycler)
+        recycler->collect();
 
     if (!m_buffer)
         return nullptr;
@@ -601,14 +603,16 @@ QOpenGLTexture *WaylandEglClientBuffer::toOpenGlTexture(int plane)
 
     const auto target = static_cast<QOpenGLTexture::Target>(d->egl_format == EGL_TEXTURE_EXTERNAL_WL ? GL_TEXTURE_EXTERNAL_OES
                                                                         : GL_TEXTURE_2D);
-    if (!texture) {
-        texture = new QOpenGLTexture(target);
-        texture->setFormat(openGLFormatFromEglFormat(d->egl_format));
-        texture->setSize(d->size.width(), d->size.height());
-        texture->create();
+    if (!texture && recycler) {
+        texture = recycler->acquireTexture(target, openGLFormatFromEglFormat(d->egl_format),
+                                           d->size, m_buffer,
+                                           QtWayland::QWaylandTextureRecycler::Storage::Imported);
         p->setupBufferAndCleanup(this->d, texture, plane);
     }
 
+    if (!texture)
+        return nullptr;
+
     if (m_textureDirty) {
         m_textureDirty = false;
         texture->bind();
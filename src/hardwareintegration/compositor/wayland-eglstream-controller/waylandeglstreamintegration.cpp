@@ -16,7 +16,7 @@
 
 #include <QtWaylandCompositor/private/qwaylandcompositor_p.h>
 #include <QtWaylandCompositor/private/qwlbuffermanager_p.h>
-#include <QtWaylandCompositor/private/qwltextureorphanage_p.h>
+#include <QtWaylandCompositor/private/qwltexturerecycler_p.h>
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -412,8 +412,8 @@ WaylandEglStreamClientBuffer::~WaylandEglStreamClientBuffer()
                         << (void*)d->textures[i] << "; " << (void*)d->texturesContext[i]
                         <<  " ... current context might be the same: " << QOpenGLContext::currentContext();
 
-                QtWayland::QWaylandTextureOrphanage::instance()->admitTexture(
-                        d->textures[i], d->texturesContext[i]);
+                QtWayland::QWaylandTextureRecycler::releaseTexture(d->textures[i],
+                                                                   d->texturesContext[i]);
                 d->textures[i] = nullptr;               // in case the aboutToBeDestroyed lambda is called while we where here
                 d->texturesContext[i] = nullptr;
                 QObject::disconnect(d->texturesAboutToBeDestroyedConnection[i]);
@@ -445,7 +445,9 @@ QWaylandSurface::Origin WaylandEglStreamClientBuffer::origin() const
 QOpenGLTexture *WaylandEglStreamClientBuffer::toOpenGlTexture(int plane)
 {
     // At this point we should have a valid OpenGL context, so it's safe to destroy textures
-    QtWayland::QWaylandTextureOrphanage::instance()->deleteTextures();
+    auto *recycler = QtWayland::QWaylandTextureRecycler::current();
+    if (recycler)
+        recycler->collect();
 
     if (!m_buffer)
         return nullptr;
@@ -793,7 +793,15 @@ void QWaylandXdgSurface::setIcon(const QIcon &icon)
 QWaylandXdgShell::QWaylandXdgShell(QWaylandDisplay *display, QtWayland::xdg_wm_base *xdgWmBase)
     : m_display(display), m_xdgWmBase(xdgWmBase)
 {
-    display->addRegistryListener(&QWaylandXdgShell::handleRegistryGlobal, this);
+    const QString interfaces[] = {
+        QLatin1String(QWaylandXdgDecorationManagerV1::interface()->name),
+        QLatin1String(QWaylandXdgActivationV1::interface()->name),
+        QLatin1String(QWaylandXdgExporterV2::interface()->name),
+        QLatin1String(QWaylandXdgDialogWmV1::interface()->name),
+        QLatin1String(QtWayland::xdg_toplevel_icon_manager_v1::interface()->name),
+    };
+    for (const QString &interface : interfaces)
+        display->addRegistryListener(interface, &QWaylandXdgShell::handleRegistryGlobal, this);
 }
 
 QWaylandXdgShell::~QWaylandXdgShell()
@@ -0,0 +1,155 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qwaylandlatencytrace_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/private/qcore_unix_p.h>
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef Q_OS_LINUX
+#  include <sys/syscall.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+class TraceWriter
+{
+public:
+    TraceWriter();
+    ~TraceWriter();
+
+    bool isOpen() const { return m_fd != -1; }
+    void append(const QByteArray &events);
+
+private:
+    void flush();
+
+    QMutex m_mutex;
+    QByteArray m_buffer;
+    int m_fd = -1;
+};
+
+// Events are written in chunks of whole lines, with O_APPEND so that the processes sharing
+// the file don't overwrite each other
+static constexpr qsizetype flushThreshold = 16 * 1024;
+
+TraceWriter::TraceWriter()
+{
+    const QByteArray fileName = qgetenv("QT_WAYLAND_LATENCY_TRACE");
+    if (fileName.isEmpty())
+        return;
+
+    // Whoever creates the file starts the JSON array. The closing bracket is optional in
+    // the trace event format, which is what allows several processes to append to it.
+    bool created = true;
+    m_fd = qt_safe_open(fileName.constData(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0644);
+    if (m_fd == -1 && errno == EEXIST) {
+        created = false;
+        m_fd = qt_safe_open(fileName.constData(), O_WRONLY | O_APPEND);
+    }
+    if (m_fd == -1) {
+        qWarning("Could not open latency trace file %s: %s", fileName.constData(), strerror(errno));
+        return;
+    }
+
+    QString processName = QCoreApplication::applicationName();
+    if (processName.isEmpty())
+        processName = QString::number(getpid());
+    processName.remove(u'"').remove(u'\\');
+
+    if (created)
+        m_buffer += "[\n";
+    m_buffer += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + QByteArray::number(getpid())
+            + ",\"args\":{\"name\":\"" + processName.toUtf8() + "\"}},\n";
+}
+
+TraceWriter::~TraceWriter()
+{
+    if (m_fd == -1)
+        return;
+    flush();
+    qt_safe_close(m_fd);
+}
+
+void TraceWriter::append(const QByteArray &events)
+{
+    QMutexLocker locker(&m_mutex);
+    m_buffer += events;
+    if (m_buffer.size() >= flushThreshold)
+        flush();
+}
+
+void TraceWriter::flush()
+{
+    if (!m_buffer.isEmpty() && qt_safe_write(m_fd, m_buffer.constData(), m_buffer.size()) < 0)
+        qWarning("Could not write latency trace: %s", strerror(errno));
+    m_buffer.clear();
+}
+
+Q_GLOBAL_STATIC(TraceWriter, traceWriter)
+
+// The kernel's thread id on Linux, which is what other tracing tools show
+static qulonglong currentThreadId()
+{
+#ifdef Q_OS_LINUX
+    return qulonglong(syscall(SYS_gettid));
+#else
+    return qulonglong(quintptr(QThread::currentThreadId()));
+#endif
+}
+
+static QByteArray eventHeader(char phase, const char *name, qint64 timestamp)
+{
+    static const QByteArray pid = QByteArray::number(getpid());
+    static thread_local const QByteArray tid = QByteArray::number(currentThreadId());
+
+    return "{\"name\":\"" + QByteArray(name) + "\",\"cat\":\"wayland\",\"ph\":\"" + phase
+            + "\",\"ts\":" + QByteArray::number(timestamp) + ",\"pid\":" + pid + ",\"tid\":" + tid;
+}
+
+} // namespace
+
+bool QWaylandLatencyTrace::isEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIsSet("QT_WAYLAND_LATENCY_TRACE")
+            && traceWriter()->isOpen();
+    return enabled;
+}
+
+qint64 QWaylandLatencyTrace::now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void QWaylandLatencyTrace::slice(const char *name, qint64 start, qint64 end,
+                                 FlowPhase phase, QSpan<const quint64> flows)
+{
+    if (!isEnabled())
+        return;
+
+    QByteArray events = eventHeader('X', name, start) + ",\"dur\":"
+            + QByteArray::number(qMax<qint64>(end - start, 0)) + "},\n";
+
+    // Flow events bind to the slice enclosing their timestamp on the same thread
+    for (quint64 flow : flows) {
+        events += eventHeader(phase, "input", start) + ",\"id\":" + QByteArray::number(flow);
+        if (phase == FlowEnd)
+            events += ",\"bp\":\"e\"";
+        events += "},\n";
+    }
+
+    if (TraceWriter *writer = traceWriter())
+        writer->append(events);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,91 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QWAYLANDLATENCYTRACE_P_H
+#define QWAYLANDLATENCYTRACE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/QSpan>
+#include <QtCore/QVarLengthArray>
+#include <QtCore/private/qglobal_p.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * Opt-in tracing of the latency between the compositor sending an input event and the
+ * client committing and the compositor presenting a frame for it.
+ *
+ * Enabled by setting QT_WAYLAND_LATENCY_TRACE to a file name, in the compositor and in
+ * its clients. Every process appends slices in the Chrome trace event format (JSON array,
+ * which is also read by Perfetto) to that file. Timestamps are CLOCK_MONOTONIC, so the
+ * traces of all processes on one machine line up.
+ *
+ * An input event is followed through both processes by a flow whose id is derived from
+ * what the protocol carries, the time of motion events and the serial of keys and buttons,
+ * so both sides compute the same id without any protocol extension.
+ */
+class QWaylandLatencyTrace
+{
+public:
+    enum FlowPhase : char {
+        FlowStart = 's',
+        FlowStep = 't',
+        FlowEnd = 'f'
+    };
+
+    static bool isEnabled();
+    // Microseconds in CLOCK_MONOTONIC, the unit of trace timestamps
+    static qint64 now();
+
+    static quint64 motionFlow(quint32 time) { return (quint64(1) << 32) | time; }
+    static quint64 keyFlow(quint32 serial) { return (quint64(2) << 32) | serial; }
+    static quint64 buttonFlow(quint32 serial) { return (quint64(3) << 32) | serial; }
+
+    // Records a slice from start to end on the calling thread, with the given flows
+    // starting, passing through or ending in it
+    static void slice(const char *name, qint64 start, qint64 end,
+                      FlowPhase phase = FlowStep, QSpan<const quint64> flows = {});
+
+    class Slice
+    {
+    public:
+        explicit Slice(const char *name)
+            : m_name(name), m_start(QWaylandLatencyTrace::isEnabled() ? now() : 0)
+        {}
+        ~Slice()
+        {
+            if (m_start)
+                QWaylandLatencyTrace::slice(m_name, m_start, now(), m_phase, m_flows);
+        }
+        Q_DISABLE_COPY_MOVE(Slice)
+
+        void addFlows(QSpan<const quint64> flows, FlowPhase phase)
+        {
+            if (!m_start)
+                return;
+            m_flows.append(flows.data(), flows.size());
+            m_phase = phase;
+        }
+        void addFlow(quint64 flow, FlowPhase phase) { addFlows({ &flow, 1 }, phase); }
+
+    private:
+        const char *m_name;
+        qint64 m_start;
+        FlowPhase m_phase = FlowStep;
+        QVarLengthArray<quint64, 4> m_flows;
+    };
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDLATENCYTRACE_P_H
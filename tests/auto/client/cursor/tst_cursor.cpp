@@ -6,10 +6,114 @@
 #include <QtGui/qpa/qplatformnativeinterface.h>
 #include <QtWaylandClient/private/wayland-wayland-client-protocol.h>
 #include <QtWaylandClient/private/qwaylandwindow_p.h>
+#include <QtWaylandClient/private/qwaylandcursor_p.h>
+#include <QtWaylandClient/private/qwaylanddisplay_p.h>
+#include <QtWaylandClient/private/qwaylandintegration_p.h>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtEndian>
+
+#include <sys/stat.h>
 
 #include "cursorshapev1.h"
 
 using namespace MockCompositor;
+using namespace Qt::StringLiterals;
+using QtWaylandClient::QWaylandCursorCache;
+using QtWaylandClient::QWaylandCursorTheme;
+
+namespace {
+
+struct XcursorImage {
+    quint32 nominalSize;
+    quint32 width;
+    quint32 height;
+    quint32 xhot;
+    quint32 yhot;
+    quint32 delay;
+};
+
+// Offsets into the files written by xcursorFile()
+constexpr qsizetype xcursorTocCount = 12;
+constexpr qsizetype xcursorHeaderSize = 16;
+constexpr qsizetype xcursorTocEntrySize = 12;
+constexpr qsizetype xcursorChunkHeaderSize = 36;
+
+// Builds an Xcursor file, see Xcursor(3), with the pixels of image i all set to 0xff000000 | i
+QByteArray xcursorFile(const QList<XcursorImage> &images)
+{
+    QByteArray data;
+    const auto append32 = [&data](quint32 value) {
+        char bytes[4];
+        qToLittleEndian(value, bytes);
+        data.append(bytes, 4);
+    };
+
+    append32(0x72756358); // "Xcur"
+    append32(xcursorHeaderSize);
+    append32(0x10000);
+    append32(images.size());
+
+    quint32 position = xcursorHeaderSize + images.size() * xcursorTocEntrySize;
+    for (const XcursorImage &image : images) {
+        append32(0xfffd0002);
+        append32(image.nominalSize);
+        append32(position);
+        position += xcursorChunkHeaderSize + image.width * image.height * 4;
+    }
+
+    for (qsizetype i = 0; i < images.size(); ++i) {
+        const XcursorImage &image = images[i];
+        append32(xcursorChunkHeaderSize);
+        append32(0xfffd0002);
+        append32(image.nominalSize);
+        append32(1);
+        append32(image.width);
+        append32(image.height);
+        append32(image.xhot);
+        append32(image.yhot);
+        append32(image.delay);
+        for (quint32 pixel = 0; pixel < image.width * image.height; ++pixel)
+            append32(0xff000000 | quint32(i));
+    }
+    return data;
+}
+
+void set32(QByteArray *data, qsizetype offset, quint32 value)
+{
+    qToLittleEndian(value, data->data() + offset);
+}
+
+bool writeFile(const QString &fileName, const QByteArray &contents)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            && file.write(contents) == contents.size();
+}
+
+QString cacheFileFor(const QString &xcursorFile)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation)
+            + "/qtwayland-cursors/"_L1
+            + QString::fromLatin1(QCryptographicHash::hash(xcursorFile.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+ino_t inode(const QString &fileName)
+{
+    struct stat info;
+    if (stat(QFile::encodeName(fileName).constData(), &info) != 0)
+        return 0;
+    return info.st_ino;
+}
+
+QtWaylandClient::QWaylandShm *clientShm()
+{
+    return QtWaylandClient::QWaylandIntegration::instance()->display()->shm();
+}
+
+} // namespace
 
 class tst_cursor : public QObject, private DefaultCompositor
 {
@@ -21,10 +125,20 @@ private slots:
     void init();
     void cleanup() { QTRY_VERIFY2(isClean(), qPrintable(dirtyMessage())); }
     void setCursor();
+    void cacheXcursorFile();
+    void invalidXcursorFile_data();
+    void invalidXcursorFile();
+    void reuseCache();
+    void themeSizesSharePool();
+
+private:
+    // Set as XCURSOR_PATH before the first theme is loaded, which is when it is read
+    QTemporaryDir m_iconsDir;
 };
 
 tst_cursor::tst_cursor()
 {
+    qputenv("XCURSOR_PATH", QFile::encodeName(m_iconsDir.path()));
     exec([this] {
         m_config.autoConfigure = true;
         add<CursorShapeManager>(1);
@@ -99,5 +213,195 @@ void tst_cursor::setCursor()
     QVERIFY(setCursorShapeSpy.isEmpty());
 }
 
+void tst_cursor::cacheXcursorFile()
+{
+    QTemporaryDir dir;
+    const QString fileName = dir.filePath("left_ptr"_L1);
+    // Written out of order to check that the cache groups the frames by size
+    QVERIFY(writeFile(fileName, xcursorFile({ { 48, 40, 44, 4, 5, 30 },
+                                              { 24, 20, 22, 2, 3, 10 },
+                                              { 48, 40, 44, 6, 7, 40 },
+                                              { 24, 20, 22, 1, 1, 20 } })));
+
+    const auto poolCount = exec([&] { return get<Shm>()->m_pools.size(); });
+    QWaylandCursorCache cache(clientShm());
+    QWaylandCursorCache::Pool *pool = cache.pool(fileName);
+    QVERIFY(pool);
+    QVERIFY(pool->pool);
+    QCOMPOSITOR_TRY_COMPARE(get<Shm>()->m_pools.size(), poolCount + 1);
+
+    const QList<QWaylandCursorCache::Image> &images = pool->images;
+    QCOMPARE(images.size(), 4);
+    const quint32 nominalSizes[] = { 24, 24, 48, 48 };
+    const QPoint hotspots[] = { { 2, 3 }, { 1, 1 }, { 4, 5 }, { 6, 7 } };
+    const uint delays[] = { 10, 20, 30, 40 };
+    const quint32 sourceIndex[] = { 1, 3, 0, 2 };
+    for (int i = 0; i < 4; ++i) {
+        QCOMPARE(images[i].nominalSize, nominalSizes[i]);
+        QCOMPARE(images[i].size, nominalSizes[i] == 24 ? QSize(20, 22) : QSize(40, 44));
+        QCOMPARE(images[i].hotspot, hotspots[i]);
+        QCOMPARE(images[i].delay, delays[i]);
+    }
+
+    // The pool is backed by the cache file, with the pixels of each frame at its offset
+    QFile cacheFile(cacheFileFor(fileName));
+    QVERIFY(cacheFile.open(QIODevice::ReadOnly));
+    const QByteArray cached = cacheFile.readAll();
+    for (int i = 0; i < 4; ++i) {
+        const QSize size = images[i].size;
+        const qsizetype bytes = qsizetype(size.width()) * size.height() * 4;
+        QVERIFY(qsizetype(images[i].offset) + bytes <= cached.size());
+        for (qsizetype pixel = 0; pixel < bytes; pixel += 4) {
+            QCOMPARE(qFromLittleEndian<quint32>(cached.constData() + images[i].offset + pixel),
+                     0xff000000 | sourceIndex[i]);
+        }
+    }
+
+    QCOMPARE(cache.pool(fileName), pool);
+}
+
+void tst_cursor::invalidXcursorFile_data()
+{
+    QTest::addColumn<QByteArray>("contents");
+
+    const QByteArray valid = xcursorFile({ { 24, 8, 8, 1, 1, 0 }, { 32, 8, 8, 1, 1, 0 } });
+    const qsizetype firstChunk = xcursorHeaderSize + 2 * xcursorTocEntrySize;
+    const qsizetype secondChunk = firstChunk + xcursorChunkHeaderSize + 8 * 8 * 4;
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("truncated header") << valid.left(10);
+    QTest::newRow("truncated table of contents") << valid.left(xcursorHeaderSize + xcursorTocEntrySize + 4);
+    QTest::newRow("truncated chunk header") << valid.left(secondChunk + 20);
+    QTest::newRow("truncated pixels") << valid.chopped(4);
+    QTest::newRow("no images") << xcursorFile({});
+
+    QByteArray data = valid;
+    data[0] = 'Y';
+    QTest::newRow("bad magic") << data;
+
+    data = valid;
+    set32(&data, xcursorTocCount, 1000);
+    QTest::newRow("table of contents past the end") << data;
+
+    data = valid;
+    set32(&data, xcursorHeaderSize + 8, quint32(valid.size()) - 8);
+    QTest::newRow("chunk past the end") << data;
+
+    data = valid;
+    set32(&data, firstChunk + 8, 48);
+    QTest::newRow("chunk of another size") << data;
+
+    data = valid;
+    set32(&data, firstChunk + 16, 0);
+    QTest::newRow("empty image") << data;
+
+    data = valid;
+    set32(&data, firstChunk + 16, 0x8000);
+    QTest::newRow("oversized image") << data;
+
+    data = valid;
+    set32(&data, firstChunk + 16, 0xffffffff);
+    set32(&data, firstChunk + 20, 0xffffffff);
+    QTest::newRow("overflowing image size") << data;
+
+    data = valid;
+    set32(&data, secondChunk + 24, 9);
+    QTest::newRow("hotspot outside the image") << data;
+}
+
+void tst_cursor::invalidXcursorFile()
+{
+    QFETCH(QByteArray, contents);
+
+    QTemporaryDir dir;
+    const QString fileName = dir.filePath("left_ptr"_L1);
+    QVERIFY(writeFile(fileName, contents));
+
+    const auto poolCount = exec([&] { return get<Shm>()->m_pools.size(); });
+    QWaylandCursorCache cache(clientShm());
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("Could not read cursor file"));
+    QVERIFY(!cache.pool(fileName));
+    QVERIFY(!QFileInfo::exists(cacheFileFor(fileName)));
+
+    // Failures are remembered, so the file is only read once
+    QVERIFY(!cache.pool(fileName));
+    QCOMPOSITOR_COMPARE(get<Shm>()->m_pools.size(), poolCount);
+}
+
+void tst_cursor::reuseCache()
+{
+    QTemporaryDir dir;
+    const QString fileName = dir.filePath("left_ptr"_L1);
+    QVERIFY(writeFile(fileName, xcursorFile({ { 24, 16, 16, 3, 4, 0 } })));
+    const QString cacheFile = cacheFileFor(fileName);
+
+    ino_t cacheInode = 0;
+    {
+        QWaylandCursorCache cache(clientShm());
+        QVERIFY(cache.pool(fileName));
+        cacheInode = inode(cacheFile);
+        QVERIFY(cacheInode);
+    }
+
+    // Another cache, as in another process, uses the file as it is instead of decoding again
+    {
+        QWaylandCursorCache cache(clientShm());
+        QWaylandCursorCache::Pool *pool = cache.pool(fileName);
+        QVERIFY(pool);
+        QCOMPARE(pool->images.size(), 1);
+        QCOMPARE(pool->images[0].hotspot, QPoint(3, 4));
+        QCOMPARE(inode(cacheFile), cacheInode);
+    }
+
+    // The cache is replaced once the cursor file changes
+    QVERIFY(writeFile(fileName, xcursorFile({ { 24, 16, 16, 5, 6, 0 }, { 32, 24, 24, 7, 8, 0 } })));
+    {
+        QWaylandCursorCache cache(clientShm());
+        QWaylandCursorCache::Pool *pool = cache.pool(fileName);
+        QVERIFY(pool);
+        QCOMPARE(pool->images.size(), 2);
+        QCOMPARE(pool->images[0].hotspot, QPoint(5, 6));
+        QCOMPARE(pool->images[1].hotspot, QPoint(7, 8));
+        QVERIFY(inode(cacheFile) != cacheInode);
+    }
+
+    // So is a cache file that is broken
+    QVERIFY(writeFile(cacheFile, QByteArray(16, 'x')));
+    cacheInode = inode(cacheFile);
+    {
+        QWaylandCursorCache cache(clientShm());
+        QWaylandCursorCache::Pool *pool = cache.pool(fileName);
+        QVERIFY(pool);
+        QCOMPARE(pool->images.size(), 2);
+        QVERIFY(inode(cacheFile) != cacheInode);
+    }
+}
+
+void tst_cursor::themeSizesSharePool()
+{
+    const QString cursorsDir = m_iconsDir.filePath("testtheme/cursors"_L1);
+    QVERIFY(QDir().mkpath(cursorsDir));
+    QVERIFY(writeFile(cursorsDir + "/left_ptr"_L1,
+                      xcursorFile({ { 24, 24, 24, 1, 2, 0 }, { 48, 48, 48, 3, 4, 0 } })));
+
+    const auto poolCount = exec([&] { return get<Shm>()->m_pools.size(); });
+    QWaylandCursorCache cache(clientShm());
+    auto small = QWaylandCursorTheme::create(&cache, clientShm(), 24, "testtheme"_L1);
+    auto large = QWaylandCursorTheme::create(&cache, clientShm(), 40, "testtheme"_L1);
+
+    const QWaylandCursorTheme::Image *smallImage = small->image(Qt::ArrowCursor);
+    QVERIFY(smallImage);
+    QCOMPARE(smallImage->size, QSize(24, 24));
+    QCOMPARE(smallImage->hotspot, QPoint(1, 2));
+
+    const QWaylandCursorTheme::Image *largeImage = large->image(Qt::ArrowCursor);
+    QVERIFY(largeImage);
+    QCOMPARE(largeImage->size, QSize(48, 48));
+    QCOMPARE(largeImage->hotspot, QPoint(3, 4));
+
+    // Both sizes come out of the one pool of the cursor file
+    QCOMPOSITOR_TRY_COMPARE(get<Shm>()->m_pools.size(), poolCount + 1);
+}
+
 QCOMPOSITOR_TEST_MAIN(tst_cursor)
 #include "tst_cursor.moc"
@@ -0,0 +1,97 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "mockcompositor.h"
+#include <QtGui/QPainter>
+#include <QtGui/QRasterWindow>
+#include <QtWaylandClient/private/qwaylandwindow_p.h>
+
+using namespace MockCompositor;
+
+// Runs with QT_WAYLAND_PER_WINDOW_EVENT_QUEUES=1, so frame callbacks and buffer releases
+// are dispatched on each window's own queue thread rather than the default queue.
+class tst_eventqueues : public QObject, private DefaultCompositor
+{
+    Q_OBJECT
+public:
+    explicit tst_eventqueues();
+private slots:
+    void cleanup() { QTRY_VERIFY2(isClean(), qPrintable(dirtyMessage())); }
+    void waitForFrameCallback();
+    void releaseWhileResizing();
+};
+
+class TestWindow : public QRasterWindow
+{
+public:
+    explicit TestWindow() { resize(40, 40); }
+    void paintEvent(QPaintEvent *event) override
+    {
+        QPainter p(this);
+        p.fillRect(event->rect(), Qt::red);
+        update();
+    }
+};
+
+tst_eventqueues::tst_eventqueues()
+{
+    setenv("QT_WAYLAND_PER_WINDOW_EVENT_QUEUES", "1", 1);
+    setenv("QT_WAYLAND_DISABLE_WINDOWDECORATION", "1", 1);
+    m_config.autoFrameCallback = false;
+}
+
+void tst_eventqueues::waitForFrameCallback()
+{
+    TestWindow window;
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+    QVERIFY(static_cast<QtWaylandClient::QWaylandWindow *>(window.handle())->eventQueue());
+    QSignalSpy bufferSpy(exec([&] { return xdgSurface()->m_surface; }), &Surface::bufferCommitted);
+    exec([&] { xdgToplevel()->sendCompleteConfigure(); });
+
+    QTRY_COMPARE(bufferSpy.size(), 1);
+    bufferSpy.removeFirst();
+
+    // Only the callbacks delivered through the window's queue let it draw again
+    for (int i = 0; i < 5; ++i) {
+        xdgPingAndWaitForPong();
+        exec([&] {
+            QVERIFY(bufferSpy.empty());
+            QVERIFY(!xdgToplevel()->surface()->m_waitingFrameCallbacks.empty());
+            xdgToplevel()->surface()->sendFrameCallbacks();
+        });
+        QTRY_COMPARE(bufferSpy.size(), 1);
+        bufferSpy.removeFirst();
+    }
+}
+
+// The backing store deletes buffers of the wrong size on the GUI thread while their
+// release may be dispatched on the window's queue thread at the same time.
+void tst_eventqueues::releaseWhileResizing()
+{
+    m_config.autoFrameCallback = true;
+    auto autoFrameCallback = qScopeGuard([&] { m_config.autoFrameCallback = false; });
+
+    TestWindow window;
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+    exec([&] {
+        Surface *surface = xdgToplevel()->surface();
+        // Release every buffer as soon as it is committed, as a GPU compositor would
+        QObject::connect(surface, &Surface::bufferCommitted, surface, [surface] {
+            if (Buffer *buffer = surface->m_committed.buffer; buffer && !buffer->m_destroyed)
+                buffer->send_release();
+        });
+        xdgToplevel()->sendCompleteConfigure();
+    });
+    QCOMPOSITOR_TRY_VERIFY(xdgSurface()->m_committedConfigureSerial);
+
+    for (int i = 1; i <= 20; ++i) {
+        const QSize size(40 + i, 40 + i);
+        window.resize(size);
+        QCOMPOSITOR_TRY_COMPARE(xdgToplevel()->surface()->m_committed.buffer->size(), size);
+    }
+}
+
+QCOMPOSITOR_TEST_MAIN(tst_eventqueues)
+#include "tst_eventqueues.moc"
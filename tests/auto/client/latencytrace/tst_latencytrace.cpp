@@ -0,0 +1,106 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "mockcompositor.h"
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QRasterWindow>
+
+#include <unistd.h>
+
+using namespace MockCompositor;
+
+class tst_latencytrace : public QObject, private DefaultCompositor
+{
+    Q_OBJECT
+public:
+    explicit tst_latencytrace();
+private slots:
+    void cleanup() { QTRY_VERIFY2(isClean(), qPrintable(dirtyMessage())); }
+    void traceFormat();
+
+private:
+    QTemporaryDir m_traceDir;
+    QString m_traceFile;
+};
+
+tst_latencytrace::tst_latencytrace()
+    : m_traceFile(m_traceDir.filePath(QStringLiteral("trace.json")))
+{
+    // Read once, the first time tracing is looked at
+    setenv("QT_WAYLAND_LATENCY_TRACE", QFile::encodeName(m_traceFile).constData(), 1);
+    m_config.autoConfigure = true;
+}
+
+// The client appends Chrome trace events to the file, which is a JSON array that is only
+// closed by whoever reads it
+void tst_latencytrace::traceFormat()
+{
+    QRasterWindow window;
+    window.resize(64, 64);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgSurface() && xdgSurface()->m_committedConfigureSerial);
+
+    // Events are written out in chunks, send enough of them to fill a few
+    exec([&] {
+        pointer()->sendEnter(xdgSurface()->m_surface, { 32, 32 });
+        pointer()->sendFrame(client());
+        for (int i = 0; i < 500; ++i) {
+            pointer()->sendMotion(client(), { 16.0 + i % 32, 16 });
+            pointer()->sendFrame(client());
+        }
+    });
+    QTRY_VERIFY(QFileInfo(m_traceFile).size() > 0);
+
+    QFile file(m_traceFile);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray contents = file.readAll().trimmed();
+    QVERIFY(contents.startsWith('['));
+    QVERIFY(contents.endsWith(','));
+    contents.chop(1);
+    contents += ']';
+
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(contents, &error);
+    QVERIFY2(error.error == QJsonParseError::NoError, qPrintable(error.errorString()));
+    const QJsonArray events = document.array();
+    QVERIFY(!events.isEmpty());
+
+    const QJsonObject metadata = events.first().toObject();
+    QCOMPARE(metadata.value("ph").toString(), QStringLiteral("M"));
+    QCOMPARE(metadata.value("name").toString(), QStringLiteral("process_name"));
+    QCOMPARE(metadata.value("pid").toInteger(), qint64(getpid()));
+
+    int motionSlices = 0;
+    int motionFlowSteps = 0;
+    for (qsizetype i = 1; i < events.size(); ++i) {
+        const QJsonObject event = events.at(i).toObject();
+        QCOMPARE(event.value("cat").toString(), QStringLiteral("wayland"));
+        QCOMPARE(event.value("pid").toInteger(), qint64(getpid()));
+        QVERIFY(event.value("tid").toInteger() > 0);
+        QVERIFY(event.value("ts").toInteger() > 0);
+
+        const QString phase = event.value("ph").toString();
+        if (phase == QLatin1String("X")) {
+            QVERIFY(event.value("dur").toInteger(-1) >= 0);
+            if (event.value("name").toString() == QLatin1String("wl_pointer.motion"))
+                ++motionSlices;
+        } else {
+            QVERIFY(phase == QLatin1String("s") || phase == QLatin1String("t") || phase == QLatin1String("f"));
+            QCOMPARE(event.value("name").toString(), QStringLiteral("input"));
+            // Motion flows are identified by the event time, tagged with 1 in the high word
+            const quint64 id = quint64(event.value("id").toInteger());
+            if (phase == QLatin1String("t") && (id >> 32) == 1)
+                ++motionFlowSteps;
+        }
+    }
+    QVERIFY(motionSlices > 0);
+    QVERIFY(motionFlowSteps >= motionSlices);
+}
+
+QCOMPOSITOR_TEST_MAIN(tst_latencytrace)
+#include "tst_latencytrace.moc"
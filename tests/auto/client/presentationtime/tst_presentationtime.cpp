@@ -0,0 +1,134 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "mockcompositor.h"
+#include "presentationtime.h"
+#include <QtCore/QElapsedTimer>
+#include <QtGui/QRasterWindow>
+#include <QtWaylandClient/private/qwaylandwindow_p.h>
+
+#include <time.h>
+
+using namespace MockCompositor;
+
+class tst_presentationtime : public QObject, private DefaultCompositor
+{
+    Q_OBJECT
+public:
+    explicit tst_presentationtime();
+private slots:
+    void cleanup() { QTRY_VERIFY2(isClean(), qPrintable(dirtyMessage())); }
+    void feedbackWithFrameCallbacks();
+    void presentationTiming();
+    void pacedUpdate();
+};
+
+class TestWindow : public QRasterWindow
+{
+public:
+    explicit TestWindow() { resize(40, 40); }
+    void paintEvent(QPaintEvent *event) override
+    {
+        Q_UNUSED(event);
+        update();
+    }
+};
+
+static qint64 monotonicTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+tst_presentationtime::tst_presentationtime()
+{
+    setenv("QT_WAYLAND_DISABLE_WINDOWDECORATION", "1", 1);
+    setenv("QT_WAYLAND_FRAME_PACING", "1", 1);
+    m_config.autoFrameCallback = false;
+    exec([this] {
+        add<Presentation>();
+    });
+}
+
+// Feedback is only requested for the frames that get a frame callback
+void tst_presentationtime::feedbackWithFrameCallbacks()
+{
+    TestWindow window;
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+    QSignalSpy bufferSpy(exec([&] { return xdgSurface()->m_surface; }), &Surface::bufferCommitted);
+    exec([&] { xdgToplevel()->sendCompleteConfigure(); });
+    QTRY_COMPARE(bufferSpy.size(), 1);
+
+    for (int i = 0; i < 3; ++i) {
+        xdgPingAndWaitForPong();
+        exec([&] {
+            Surface *surface = xdgToplevel()->surface();
+            QCOMPARE(get<Presentation>()->m_feedbacks.size(), surface->m_waitingFrameCallbacks.size());
+            QCOMPARE(get<Presentation>()->m_feedbacks.size(), 1);
+            get<Presentation>()->sendDiscarded(surface);
+            surface->sendFrameCallbacks();
+        });
+        QTRY_COMPARE(bufferSpy.size(), i + 2);
+    }
+}
+
+// The timing of the last presentation is available to render loops through the window
+void tst_presentationtime::presentationTiming()
+{
+    const qint64 refresh = 16666667;
+    TestWindow window;
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+    QSignalSpy bufferSpy(exec([&] { return xdgSurface()->m_surface; }), &Surface::bufferCommitted);
+    exec([&] { xdgToplevel()->sendCompleteConfigure(); });
+    QTRY_COMPARE(bufferSpy.size(), 1);
+
+    auto *waylandWindow = static_cast<QtWaylandClient::QWaylandWindow *>(window.handle());
+    QCOMPARE(waylandWindow->lastPresentationTime(), 0);
+
+    const qint64 presented = monotonicTime();
+    exec([&] {
+        get<Presentation>()->sendPresented(xdgToplevel()->surface(), presented, refresh, 1);
+    });
+    QTRY_COMPARE(waylandWindow->lastPresentationTime(), presented);
+    QCOMPARE(waylandWindow->presentationRefreshInterval(), refresh);
+
+    // The next presentation is on one of the following refreshes
+    const qint64 predicted = waylandWindow->predictedNextPresentationTime();
+    QVERIFY(predicted > presented);
+    QCOMPARE((predicted - presented) % refresh, 0);
+
+    exec([&] { xdgToplevel()->surface()->sendFrameCallbacks(); });
+    QTRY_COMPARE(bufferSpy.size(), 2);
+}
+
+// After a presentation the next update request is held back until just in time for
+// the predicted next presentation
+void tst_presentationtime::pacedUpdate()
+{
+    const qint64 refresh = 2000000000;
+    TestWindow window;
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+    QSignalSpy bufferSpy(exec([&] { return xdgSurface()->m_surface; }), &Surface::bufferCommitted);
+    exec([&] { xdgToplevel()->sendCompleteConfigure(); });
+    QTRY_COMPARE(bufferSpy.size(), 1);
+
+    exec([&] {
+        get<Presentation>()->sendPresented(xdgToplevel()->surface(), monotonicTime(), refresh, 1);
+    });
+    xdgPingAndWaitForPong(); // Make sure the client has seen the presentation
+
+    QElapsedTimer timer;
+    timer.start();
+    exec([&] { xdgToplevel()->surface()->sendFrameCallbacks(); });
+    QTRY_COMPARE(bufferSpy.size(), 2);
+    // The frame is due half a refresh before the next presentation, a second from now
+    QVERIFY(timer.elapsed() >= 500);
+    QVERIFY(timer.elapsed() < 2000);
+}
+
+QCOMPOSITOR_TEST_MAIN(tst_presentationtime)
+#include "tst_presentationtime.moc"
@@ -48,6 +48,8 @@ private slots:
     void multiTouch();
     void multiTouchUpAndMotionFrame();
     void tapAndMoveInSameFrame();
+    void coalescedTouchMotion();
+    void touchMotionKeepsOrder();
     void cancelTouch();
 };
 
@@ -652,6 +654,98 @@ void tst_seat::tapAndMoveInSameFrame()
     QTRY_COMPARE(window.m_events.last().touchPoints.first().state(), QEventPoint::State::Released);
 }
 
+void tst_seat::coalescedTouchMotion()
+{
+    TouchWindow window;
+    QCOMPOSITOR_TRY_VERIFY(xdgSurface() && xdgSurface()->m_committedConfigureSerial);
+
+    exec([&] {
+        auto *t = touch();
+        auto *c = client();
+
+        t->sendDown(xdgToplevel()->surface(), {32, 32}, 0);
+        t->sendDown(xdgToplevel()->surface(), {48, 48}, 1);
+        t->sendFrame(c);
+
+        // Frames read together that only move points become one touch event
+        t->sendMotion(c, {33, 32}, 0);
+        t->sendFrame(c);
+        t->sendMotion(c, {49, 48}, 1);
+        t->sendFrame(c);
+        t->sendMotion(c, {34, 32}, 0);
+        t->sendFrame(c);
+
+        t->sendUp(c, 0);
+        t->sendUp(c, 1);
+        t->sendFrame(c);
+    });
+
+    QTRY_COMPARE(window.m_events.size(), 3);
+    QCOMPARE(window.m_events[0].type, QEvent::TouchBegin);
+    {
+        auto e = window.m_events[1];
+        QCOMPARE(e.type, QEvent::TouchUpdate);
+        QCOMPARE(e.touchPoints.size(), 2);
+
+        QCOMPARE(e.touchPoints[0].state(), QEventPoint::State::Updated);
+        QCOMPARE(e.touchPoints[0].position(), QPointF(34-window.frameMargins().left(), 32-window.frameMargins().top()));
+
+        QCOMPARE(e.touchPoints[1].state(), QEventPoint::State::Updated);
+        QCOMPARE(e.touchPoints[1].position(), QPointF(49-window.frameMargins().left(), 48-window.frameMargins().top()));
+    }
+    QCOMPARE(window.m_events[2].type, QEvent::TouchEnd);
+}
+
+// A motion-only touch frame is delivered before pointer events read after it
+void tst_seat::touchMotionKeepsOrder()
+{
+    class Window : public QRasterWindow {
+    public:
+        Window()
+        {
+            resize(64, 64);
+            show();
+        }
+        void touchEvent(QTouchEvent *event) override
+        {
+            m_events.append(event->type());
+            event->accept(); // No mouse events synthesized from touch
+        }
+        void mousePressEvent(QMouseEvent *event) override { m_events.append(event->type()); }
+        void mouseReleaseEvent(QMouseEvent *event) override { m_events.append(event->type()); }
+        QList<QEvent::Type> m_events;
+    };
+    Window window;
+    QCOMPOSITOR_TRY_VERIFY(xdgSurface() && xdgSurface()->m_committedConfigureSerial);
+
+    exec([&] {
+        auto *t = touch();
+        auto *p = pointer();
+        auto *c = client();
+
+        t->sendDown(xdgToplevel()->surface(), {32, 32}, 0);
+        t->sendFrame(c);
+        t->sendMotion(c, {33, 32}, 0);
+        t->sendFrame(c);
+
+        p->sendEnter(xdgToplevel()->surface(), {16, 16});
+        p->sendFrame(c);
+        p->sendButton(c, BTN_LEFT, Pointer::button_state_pressed);
+        p->sendFrame(c);
+        p->sendButton(c, BTN_LEFT, Pointer::button_state_released);
+        p->sendFrame(c);
+
+        t->sendUp(c, 0);
+        t->sendFrame(c);
+    });
+
+    const QList<QEvent::Type> expected = { QEvent::TouchBegin, QEvent::TouchUpdate,
+                                           QEvent::MouseButtonPress, QEvent::MouseButtonRelease,
+                                           QEvent::TouchEnd };
+    QTRY_COMPARE(window.m_events.size(), expected.size());
+    QCOMPARE(window.m_events, expected);
+}
+
 void tst_seat::cancelTouch()
 {
     TouchWindow window;
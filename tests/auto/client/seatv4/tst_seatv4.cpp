@@ -4,6 +4,9 @@
 #include "mockcompositor.h"
 
 #include <QtGui/QRasterWindow>
+#if QT_CONFIG(xkbcommon)
+#include <xkbcommon/xkbcommon.h>
+#endif
 #if QT_CONFIG(cursor)
 #include <wayland-cursor.h>
 #include <QtGui/private/qguiapplication_p.h>
@@ -42,6 +45,9 @@ private slots:
     void cleanup();
     void bindsToSeat();
     void keyboardKeyPress();
+#if QT_CONFIG(xkbcommon)
+    void keysWaitForKeymap();
+#endif
 #if QT_CONFIG(cursor)
     void createsPointer();
     void setsCursorOnEnter();
@@ -102,6 +108,51 @@ void tst_seatv4::keyboardKeyPress()
     QTRY_VERIFY(window.m_pressed);
 }
 
+#if QT_CONFIG(xkbcommon)
+void tst_seatv4::keysWaitForKeymap()
+{
+    // The keymap is compiled on a worker thread, keys sent right after it must still be
+    // mapped with it rather than with the default us layout
+    QByteArray keymapText;
+    if (struct xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_FLAGS)) {
+        const xkb_rule_names names = { "evdev", "pc105", "de", "", "" };
+        if (struct xkb_keymap *keymap = xkb_keymap_new_from_names(context, &names, XKB_KEYMAP_COMPILE_NO_FLAGS)) {
+            char *text = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+            keymapText = text;
+            free(text);
+            xkb_keymap_unref(keymap);
+        }
+        xkb_context_unref(context);
+    }
+    if (keymapText.isEmpty())
+        QSKIP("The de keyboard layout is not available");
+
+    class Window : public QRasterWindow {
+    public:
+        void keyPressEvent(QKeyEvent *event) override { m_keys.append(event->key()); }
+        QList<int> m_keys;
+    };
+
+    Window window;
+    window.resize(64, 64);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgSurface() && xdgSurface()->m_committedConfigureSerial);
+
+    const uint keyY = 21; // KEY_Y, which is z on German keyboards
+    exec([&] {
+        keyboard()->sendKeymap(client(), keymapText);
+        keyboard()->sendEnter(xdgSurface()->m_surface);
+        keyboard()->sendKey(client(), keyY, Keyboard::key_state_pressed);
+        keyboard()->sendKey(client(), keyY, Keyboard::key_state_released);
+    });
+    QTRY_COMPARE(window.m_keys, QList<int>{ Qt::Key_Z });
+
+    exec([&] {
+        keyboard()->sendLeave(xdgSurface()->m_surface);
+    });
+}
+#endif
+
 #if QT_CONFIG(cursor)
 
 void tst_seatv4::createsPointer()
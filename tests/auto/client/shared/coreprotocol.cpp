@@ -4,6 +4,8 @@
 #include "coreprotocol.h"
 #include "datadevice.h"
 
+#include <QtCore/QTemporaryFile>
+
 namespace MockCompositor {
 
 Surface::Surface(WlCompositor *wlCompositor, wl_client *client, int id, int version)
@@ -555,6 +557,19 @@ void Touch::sendCancel(wl_client *client)
         send_cancel(r->handle);
 }
 
+void Keyboard::sendKeymap(wl_client *client, const QByteArray &keymap)
+{
+    QTemporaryFile file;
+    if (!file.open() || file.write(keymap.constData(), keymap.size() + 1) != keymap.size() + 1) {
+        qWarning() << "Failed to write keymap" << file.errorString();
+        return;
+    }
+    file.flush();
+    const auto keyboardResources = resourceMap().values(client);
+    for (auto *r : keyboardResources)
+        send_keymap(r->handle, keymap_format_xkb_v1, file.handle(), uint32_t(keymap.size() + 1));
+}
+
 uint Keyboard::sendEnter(Surface *surface)
 {
     auto serial = m_seat->m_compositor->nextSerial();
@@ -423,7 +423,7 @@ class Keyboard : public QObject, public QtWaylandServer::wl_keyboard
     Q_OBJECT
 public:
     explicit Keyboard(Seat *seat) : m_seat(seat) {}
-    //TODO: Keymap event
+    void sendKeymap(wl_client *client, const QByteArray &keymap);
     uint sendEnter(Surface *surface);
     uint sendLeave(Surface *surface);
     uint sendKey(wl_client *client, uint key, uint state);
@@ -0,0 +1,44 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef MOCKCOMPOSITOR_PRESENTATIONTIME_H
+#define MOCKCOMPOSITOR_PRESENTATIONTIME_H
+
+#include "coreprotocol.h"
+#include <qwayland-server-presentation-time.h>
+
+namespace MockCompositor {
+
+class PresentationFeedback;
+
+class Presentation : public Global, public QtWaylandServer::wp_presentation
+{
+    Q_OBJECT
+public:
+    explicit Presentation(CoreCompositor *compositor, int version = 1);
+    QList<PresentationFeedback *> m_feedbacks;
+
+    // Presents all feedback requested for the surface, times in CLOCK_MONOTONIC nanoseconds
+    void sendPresented(Surface *surface, qint64 timestamp, qint64 refresh, quint64 sequence);
+    void sendDiscarded(Surface *surface);
+
+protected:
+    void wp_presentation_bind_resource(Resource *resource) override;
+    void wp_presentation_feedback(Resource *resource, wl_resource *surface, uint32_t callback) override;
+};
+
+class PresentationFeedback : public QObject, public QtWaylandServer::wp_presentation_feedback
+{
+    Q_OBJECT
+public:
+    explicit PresentationFeedback(Surface *surface, wl_client *client, int id, int version);
+
+    Surface *m_surface;
+
+protected:
+    void wp_presentation_feedback_destroy_resource(Resource *resource) override;
+};
+
+}
+
+#endif
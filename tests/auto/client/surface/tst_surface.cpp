@@ -21,6 +21,7 @@ private slots:
 #if QT_CONFIG(opengl)
     void waitForFrameCallbackGl();
 #endif
+    void frameCallbackAfterReset();
     void negotiateShmFormat();
 
     // Subsurfaces
@@ -125,6 +126,42 @@ void tst_surface::waitForFrameCallbackGl()
 }
 #endif // QT_CONFIG(opengl)
 
+// A frame callback dispatched while the surface is being recreated must not end the
+// wait for the frame callback of the new surface.
+void tst_surface::frameCallbackAfterReset()
+{
+    class TestWindow : public QRasterWindow {
+    public:
+        explicit TestWindow() { resize(40, 40); }
+        void paintEvent(QPaintEvent *event) override
+        {
+            Q_UNUSED(event);
+            update();
+        }
+    };
+    TestWindow window;
+    window.show();
+
+    for (int i = 0; i < 5; ++i) {
+        QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+        QSignalSpy bufferSpy(exec([&] { return xdgSurface()->m_surface; }), &Surface::bufferCommitted);
+        exec([&] { xdgToplevel()->sendCompleteConfigure(); });
+        QTRY_COMPARE(bufferSpy.size(), 1);
+
+        // Nothing else is drawn until the new surface gets its own frame callback
+        xdgPingAndWaitForPong();
+        exec([&] {
+            QCOMPARE(bufferSpy.size(), 1);
+            QVERIFY(!xdgToplevel()->surface()->m_waitingFrameCallbacks.empty());
+            // Races with the hide() below on the client's frame event thread
+            xdgToplevel()->surface()->sendFrameCallbacks();
+        });
+        window.hide();
+        QCOMPOSITOR_TRY_VERIFY(!xdgToplevel() && !surface()->m_committed.buffer);
+        window.show();
+    }
+}
+
 void tst_surface::negotiateShmFormat()
 {
     QSKIP("TODO: I'm not sure why we're choosing xrgb over argb in this case...");
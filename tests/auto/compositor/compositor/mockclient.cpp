@@ -154,6 +154,8 @@ void MockClient::handleGlobal(uint32_t id, const QByteArray &interface)
 {
     if (interface == "wl_compositor") {
         compositor = static_cast<wl_compositor *>(wl_registry_bind(registry, id, &wl_compositor_interface, 4));
+    } else if (interface == "wl_subcompositor") {
+        subcompositor = static_cast<wl_subcompositor *>(wl_registry_bind(registry, id, &wl_subcompositor_interface, 1));
     } else if (interface == "wl_output") {
         auto output = static_cast<wl_output *>(wl_registry_bind(registry, id, &wl_output_interface, 2));
         m_outputs.insert(id, output);
@@ -169,10 +171,18 @@ void MockClient::handleGlobal(uint32_t id, const QByteArray &interface)
     } else if (interface == "ivi_application") {
         iviApplication = static_cast<ivi_application *>(wl_registry_bind(registry, id, &ivi_application_interface, 1));
     } else if (interface == "wl_seat") {
-        wl_seat *s = static_cast<wl_seat *>(wl_registry_bind(registry, id, &wl_seat_interface, 1));
+        wl_seat *s = static_cast<wl_seat *>(wl_registry_bind(registry, id, &wl_seat_interface, qMin(version, 8u)));
         m_seats << new MockSeat(s);
     } else if (interface == "zwp_idle_inhibit_manager_v1") {
         idleInhibitManager = static_cast<zwp_idle_inhibit_manager_v1 *>(wl_registry_bind(registry, id, &zwp_idle_inhibit_manager_v1_interface, 1));
+    } else if (interface == "zwp_relative_pointer_manager_v1") {
+        relativePointerManager = static_cast<zwp_relative_pointer_manager_v1 *>(wl_registry_bind(registry, id, &zwp_relative_pointer_manager_v1_interface, 1));
+    } else if (interface == "zwp_pointer_constraints_v1") {
+        pointerConstraints = static_cast<zwp_pointer_constraints_v1 *>(wl_registry_bind(registry, id, &zwp_pointer_constraints_v1_interface, 1));
+    } else if (interface == "xx_color_manager_v4") {
+        colorManager = static_cast<xx_color_manager_v4 *>(wl_registry_bind(registry, id, &xx_color_manager_v4_interface, 1));
+    } else if (interface == "zwp_linux_explicit_synchronization_v1") {
+        explicitSynchronization = static_cast<zwp_linux_explicit_synchronization_v1 *>(wl_registry_bind(registry, id, &zwp_linux_explicit_synchronization_v1_interface, 2));
     } else if (interface == "zxdg_output_manager_v1") {
         xdgOutputManager = new QtWayland::zxdg_output_manager_v1(registry, id, 2);
     }
@@ -6,6 +6,10 @@
 #include <wayland-ivi-application-client-protocol.h>
 #include "wayland-viewporter-client-protocol.h"
 #include "wayland-idle-inhibit-unstable-v1-client-protocol.h"
+#include "wayland-pointer-constraints-unstable-v1-client-protocol.h"
+#include "wayland-relative-pointer-unstable-v1-client-protocol.h"
+#include "wayland-xx-color-management-v4-client-protocol.h"
+#include "wayland-linux-explicit-synchronization-unstable-v1-client-protocol.h"
 
 #include <QObject>
 #include <QImage>
@@ -47,6 +51,7 @@ public:
 
     wl_display *display = nullptr;
     wl_compositor *compositor = nullptr;
+    wl_subcompositor *subcompositor = nullptr;
     QMap<uint, wl_output *> m_outputs;
     QMap<wl_output *, MockXdgOutputV1 *> m_xdgOutputs;
     wl_shm *shm = nullptr;
@@ -56,6 +61,10 @@ public:
     wp_viewporter *viewporter = nullptr;
     ivi_application *iviApplication = nullptr;
     zwp_idle_inhibit_manager_v1 *idleInhibitManager = nullptr;
+    zwp_relative_pointer_manager_v1 *relativePointerManager = nullptr;
+    zwp_pointer_constraints_v1 *pointerConstraints = nullptr;
+    xx_color_manager_v4 *colorManager = nullptr;
+    zwp_linux_explicit_synchronization_v1 *explicitSynchronization = nullptr;
     QtWayland::zxdg_output_manager_v1 *xdgOutputManager = nullptr;
 
     QList<MockSeat *> m_seats;
@@ -59,12 +59,21 @@ void keyboardModifiers(void *keyboard, struct wl_keyboard *wl_keyboard, uint32_t
     kb->m_group = group;
 }
 
+void keyboardRepeatInfo(void *keyboard, struct wl_keyboard *wl_keyboard, int32_t rate, int32_t delay)
+{
+    Q_UNUSED(keyboard);
+    Q_UNUSED(wl_keyboard);
+    Q_UNUSED(rate);
+    Q_UNUSED(delay);
+}
+
 static const struct wl_keyboard_listener keyboardListener = {
     keyboardKeymap,
     keyboardEnter,
     keyboardLeave,
     keyboardKey,
-    keyboardModifiers
+    keyboardModifiers,
+    keyboardRepeatInfo
 };
 
 MockKeyboard::MockKeyboard(wl_seat *seat)
@@ -29,11 +29,12 @@ static void pointerLeave(void *pointer, struct wl_pointer *wlPointer, uint32_t s
 
 static void pointerMotion(void *pointer, struct wl_pointer *wlPointer, uint32_t time, wl_fixed_t x, wl_fixed_t y)
 {
-    Q_UNUSED(pointer);
     Q_UNUSED(wlPointer);
     Q_UNUSED(time);
-    Q_UNUSED(x);
-    Q_UNUSED(y);
+
+    auto *mockPointer = static_cast<MockPointer *>(pointer);
+    mockPointer->m_motionCount++;
+    mockPointer->m_lastMotion = QPointF(wl_fixed_to_double(x), wl_fixed_to_double(y));
 }
 
 static void pointerButton(void *pointer, struct wl_pointer *wlPointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state)
@@ -47,12 +48,51 @@ static void pointerButton(void *pointer, struct wl_pointer *wlPointer, uint32_t
 }
 
 static void pointerAxis(void *pointer, struct wl_pointer *wlPointer, uint32_t time, uint32_t axis, wl_fixed_t value)
+{
+    Q_UNUSED(wlPointer);
+    Q_UNUSED(time);
+    Q_UNUSED(axis);
+
+    static_cast<MockPointer *>(pointer)->m_axisValue = wl_fixed_to_double(value);
+}
+
+static void pointerFrame(void *pointer, struct wl_pointer *wlPointer)
+{
+    Q_UNUSED(wlPointer);
+
+    static_cast<MockPointer *>(pointer)->m_frameCount++;
+}
+
+static void pointerAxisSource(void *pointer, struct wl_pointer *wlPointer, uint32_t source)
+{
+    Q_UNUSED(wlPointer);
+
+    static_cast<MockPointer *>(pointer)->m_axisSource = source;
+    static_cast<MockPointer *>(pointer)->m_axisSourceCount++;
+}
+
+static void pointerAxisStop(void *pointer, struct wl_pointer *wlPointer, uint32_t time, uint32_t axis)
 {
     Q_UNUSED(pointer);
     Q_UNUSED(wlPointer);
     Q_UNUSED(time);
     Q_UNUSED(axis);
-    Q_UNUSED(value);
+}
+
+static void pointerAxisDiscrete(void *pointer, struct wl_pointer *wlPointer, uint32_t axis, int32_t discrete)
+{
+    Q_UNUSED(pointer);
+    Q_UNUSED(wlPointer);
+    Q_UNUSED(axis);
+    Q_UNUSED(discrete);
+}
+
+static void pointerAxisValue120(void *pointer, struct wl_pointer *wlPointer, uint32_t axis, int32_t value120)
+{
+    Q_UNUSED(wlPointer);
+    Q_UNUSED(axis);
+
+    static_cast<MockPointer *>(pointer)->m_axisValue120 = value120;
 }
 
 static const struct wl_pointer_listener pointerListener = {
@@ -61,6 +101,11 @@ static const struct wl_pointer_listener pointerListener = {
     pointerMotion,
     pointerButton,
     pointerAxis,
+    pointerFrame,
+    pointerAxisSource,
+    pointerAxisStop,
+    pointerAxisDiscrete,
+    pointerAxisValue120,
 };
 
 MockPointer::MockPointer(wl_seat *seat)
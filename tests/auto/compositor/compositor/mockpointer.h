@@ -5,6 +5,7 @@
 #define MOCKPOINTER_H
 
 #include <QObject>
+#include <QPointF>
 #include "wayland-wayland-client-protocol.h"
 
 class MockPointer : public QObject
@@ -17,6 +18,14 @@ public:
 
     wl_pointer *m_pointer = nullptr;
     wl_surface *m_enteredSurface = nullptr;
+
+    int m_motionCount = 0;
+    int m_frameCount = 0;
+    QPointF m_lastMotion;
+    uint m_axisSource = 0;
+    int m_axisSourceCount = 0;
+    int m_axisValue120 = 0;
+    qreal m_axisValue = 0;
 };
 
 #endif // MOCKPOINTER_H
@@ -14,6 +14,7 @@
 #include "qwaylandseat.h"
 
 #include <QtGui/QScreen>
+#include <QtGui/QVector4D>
 #include <QtWaylandCompositor/QWaylandXdgShell>
 #include <QtWaylandCompositor/private/qwaylandkeyboard_p.h>
 #include <QtWaylandCompositor/QWaylandIviApplication>
@@ -22,16 +23,41 @@
 #include <QtWaylandCompositor/QWaylandResource>
 #include <QtWaylandCompositor/QWaylandKeymap>
 #include <QtWaylandCompositor/QWaylandViewporter>
+#include <QtWaylandCompositor/QWaylandColorManagement>
+#include <QtWaylandCompositor/QWaylandLinuxExplicitSynchronizationV1>
 #include <QtWaylandCompositor/QWaylandIdleInhibitManagerV1>
+#include <QtWaylandCompositor/QWaylandPointerConstraintsV1>
+#include <QtWaylandCompositor/QWaylandRelativePointerManagerV1>
 #include <QtWaylandCompositor/QWaylandXdgOutputManagerV1>
 #include <qwayland-xdg-shell.h>
 #include <qwayland-ivi-application.h>
 #include <QtWaylandCompositor/private/qwaylandoutput_p.h>
+#include <QtWaylandCompositor/private/qwaylandpointer_p.h>
 #include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+#include <QtWaylandCompositor/private/qwaylandtouch_p.h>
 #include <QtWaylandCompositor/private/qwaylandxdgoutputv1_p.h>
+#include <QtWaylandCompositor/private/qwlsyncfence_p.h>
+#if QT_CONFIG(wayland_compositor_quick)
+#include <QtQuick/QQuickWindow>
+#include <QtWaylandCompositor/QWaylandQuickOutput>
+#include <QtWaylandCompositor/QWaylandQuickShellSurfaceItem>
+#include <QtWaylandCompositor/private/qwaylandquickitem_p.h>
+#endif
+#if QT_CONFIG(opengl)
+#include <QtWaylandCompositor/private/qwldmabuffeedback_p.h>
+#include <QtWaylandCompositor/private/qwltexturerecycler_p.h>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#endif
 
 #include <QtTest/QtTest>
 
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
 class tst_WaylandCompositor : public QObject
 {
     Q_OBJECT
@@ -48,7 +74,10 @@ private slots:
     void seatCreation();
     void seatKeyboardFocus();
     void seatMouseFocus();
+    void pointerFrames();
+    void touchFrames();
     void inputRegion();
+    void inputRegionManyRects();
     void defaultInputRegionHiDpi();
     void singleClient();
     void multipleClients();
@@ -61,8 +90,21 @@ private slots:
     void mapSurfaceHiDpi();
     void frameCallback();
     void pixelFormats();
+    void yuvShmFormats_data();
+    void yuvShmFormats();
+    void yuvConversion_data();
+    void yuvConversion();
+#if QT_CONFIG(opengl)
+    void textureMemory();
+    void textureRecycling();
+    void dmabufFeedback();
+#endif
     void outputs();
     void customSurface();
+#if QT_CONFIG(wayland_compositor_quick)
+    void occlusionCulling();
+    void xdgResizeConfigureThrottling();
+#endif
 
     void advertisesXdgShellSupport();
     void createsXdgSurfaces();
@@ -90,7 +132,29 @@ private slots:
     void viewportSourceNoSurfaceError();
     void viewportHiDpi();
 
+    void subsurfaceStateOnParentCommit();
+    void subsurfaceReparent();
+    void subsurfaceDestroyParent();
+    void subsurfaceDestroySurface();
+    void subsurfaceRoleError_data();
+    void subsurfaceRoleError();
+    void subsurfaceParentError_data();
+    void subsurfaceParentError();
+
     void idleInhibit();
+    void relativePointer();
+    void pointerLock();
+    void pointerConfine();
+
+    void colorManagementSurface();
+    void colorManagementErrors();
+    void colorManagementPreferred();
+
+    void syncFence();
+    void explicitSyncRelease();
+    void explicitSyncErrors();
+    void explicitSyncDeferredCommit();
+    void explicitSyncDeferredSubsurfaceState();
 
     void xdgOutput();
 
@@ -664,6 +728,132 @@ void tst_WaylandCompositor::pixelFormats()
     wl_surface_destroy(surface);
 }
 
+void tst_WaylandCompositor::yuvShmFormats_data()
+{
+    QTest::addColumn<uint>("format");
+    QTest::addColumn<int>("stride");
+    QTest::addColumn<QByteArray>("pixels");
+    QTest::addColumn<QWaylandBufferRef::BufferFormatEgl>("bufferFormat");
+    QTest::addColumn<bool>("readable");
+
+    // 8x8 pixels of saturated red, which is Y=81 Cb=90 Cr=240 in BT.601 limited range
+    QTest::newRow("yuyv") << uint(WL_SHM_FORMAT_YUYV) << 16
+                          << QByteArray("\x51\x5a\x51\xf0").repeated(4 * 8)
+                          << QWaylandBufferRef::BufferFormatEgl_Y_XUXV << true;
+    QTest::newRow("yuyv stride too small") << uint(WL_SHM_FORMAT_YUYV) << 8
+                                           << QByteArray("\x51\x5a\x51\xf0").repeated(4 * 8)
+                                           << QWaylandBufferRef::BufferFormatEgl_Y_XUXV << false;
+}
+
+void tst_WaylandCompositor::yuvShmFormats()
+{
+    QFETCH(uint, format);
+    QFETCH(int, stride);
+    QFETCH(QByteArray, pixels);
+    QFETCH(QWaylandBufferRef::BufferFormatEgl, bufferFormat);
+    QFETCH(bool, readable);
+
+    TestCompositor compositor;
+    compositor.setAdditionalShmFormats({ QWaylandCompositor::ShmFormat_YUYV });
+    compositor.create();
+
+    MockClient client;
+
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    BufferView* view = new BufferView;
+    view->setSurface(waylandSurface);
+    view->setOutput(compositor.defaultOutput());
+
+    const int fd = memfd_create("tst_compositor", MFD_CLOEXEC);
+    QVERIFY(fd >= 0);
+    QCOMPARE(write(fd, pixels.constData(), pixels.size()), ssize_t(pixels.size()));
+    wl_shm_pool *pool = wl_shm_create_pool(client.shm, fd, int32_t(pixels.size()));
+    close(fd);
+    wl_buffer *buffer = wl_shm_pool_create_buffer(pool, 0, 8, 8, stride, format);
+
+    wl_surface_attach(surface, buffer, 0, 0);
+    wl_surface_damage(surface, 0, 0, 8, 8);
+    wl_surface_commit(surface);
+
+    QTRY_COMPARE(waylandSurface->hasContent(), true);
+    QVERIFY(view->bufferRef.isSharedMemory());
+    QCOMPARE(view->bufferRef.bufferFormatEgl(), bufferFormat);
+
+    if (!readable)
+        QTest::ignoreMessage(QtWarningMsg, "wl_shm buffer is too small for its format");
+    const QImage image = view->bufferRef.image();
+    if (readable) {
+        QCOMPARE(image.size(), QSize(8, 8));
+        const QColor color = image.pixelColor(5, 5);
+        QVERIFY2(color.red() >= 253 && color.green() <= 2 && color.blue() <= 2,
+                 qPrintable(color.name()));
+
+        // The conversion follows the one described for the surface
+        QWaylandYuvConversion conversion;
+        conversion.matrix = QWaylandYuvConversion::Bt709;
+        conversion.fullRange = true;
+        QWaylandSurfacePrivate::get(waylandSurface)->pending.yuvConversion = conversion;
+        wl_surface_attach(surface, buffer, 0, 0);
+        wl_surface_damage(surface, 0, 0, 8, 8);
+        wl_surface_commit(surface);
+        QTRY_COMPARE(QWaylandSurfacePrivate::get(waylandSurface)->yuvConversion, conversion);
+        const QVector4D expected = conversion.toRgb().map(QVector4D(81 / 255.0f, 90 / 255.0f, 240 / 255.0f, 1.0f)) * 255;
+        const QColor converted = view->bufferRef.image().pixelColor(5, 5);
+        QVERIFY2(qAbs(converted.red() - qBound(0.0f, expected.x(), 255.0f)) <= 1
+                 && qAbs(converted.green() - qBound(0.0f, expected.y(), 255.0f)) <= 1
+                 && qAbs(converted.blue() - qBound(0.0f, expected.z(), 255.0f)) <= 1,
+                 qPrintable(converted.name()));
+    } else {
+        QVERIFY(image.isNull());
+    }
+
+    wl_surface_destroy(surface);
+    wl_buffer_destroy(buffer);
+    wl_shm_pool_destroy(pool);
+}
+
+void tst_WaylandCompositor::yuvConversion_data()
+{
+    QTest::addColumn<int>("matrix");
+    QTest::addColumn<bool>("fullRange");
+    QTest::addColumn<QVector3D>("yuv");
+    QTest::addColumn<QVector3D>("rgb");
+
+    // 8-bit YCbCr values of saturated colors in each color space
+    QTest::newRow("bt601 red") << int(QWaylandYuvConversion::Bt601) << false
+                               << QVector3D(81, 90, 240) << QVector3D(1, 0, 0);
+    QTest::newRow("bt709 red") << int(QWaylandYuvConversion::Bt709) << false
+                               << QVector3D(63, 102, 240) << QVector3D(1, 0, 0);
+    QTest::newRow("bt709 green") << int(QWaylandYuvConversion::Bt709) << false
+                                 << QVector3D(173, 42, 26) << QVector3D(0, 1, 0);
+    QTest::newRow("bt2020 blue") << int(QWaylandYuvConversion::Bt2020) << false
+                                 << QVector3D(29, 240, 119) << QVector3D(0, 0, 1);
+    QTest::newRow("bt709 limited black") << int(QWaylandYuvConversion::Bt709) << false
+                                         << QVector3D(16, 128, 128) << QVector3D(0, 0, 0);
+    QTest::newRow("bt709 full red") << int(QWaylandYuvConversion::Bt709) << true
+                                    << QVector3D(54, 99, 255) << QVector3D(1, 0, 0);
+    QTest::newRow("bt709 full white") << int(QWaylandYuvConversion::Bt709) << true
+                                      << QVector3D(255, 128, 128) << QVector3D(1, 1, 1);
+}
+
+void tst_WaylandCompositor::yuvConversion()
+{
+    QFETCH(int, matrix);
+    QFETCH(bool, fullRange);
+    QFETCH(QVector3D, yuv);
+    QFETCH(QVector3D, rgb);
+
+    QWaylandYuvConversion conversion;
+    conversion.matrix = QWaylandYuvConversion::Matrix(matrix);
+    conversion.fullRange = fullRange;
+
+    const QVector4D result = conversion.toRgb().map(QVector4D(yuv / 255.0f, 1.0f));
+    QVERIFY2((result.toVector3D() - rgb).length() < 0.02f,
+             qPrintable(QStringLiteral("(%1, %2, %3)").arg(result.x()).arg(result.y()).arg(result.z())));
+}
+
 void tst_WaylandCompositor::outputs()
 {
     TestCompositor compositor;
@@ -723,6 +913,84 @@ void tst_WaylandCompositor::customSurface()
     QTRY_COMPARE(compositor.surfaces.size(), 0);
 }
 
+#if QT_CONFIG(wayland_compositor_quick)
+void tst_WaylandCompositor::occlusionCulling()
+{
+    TestCompositor compositor;
+    QQuickWindow window;
+    window.resize(200, 200);
+    QWaylandQuickOutput output(&compositor, &window);
+    compositor.create();
+
+    MockClient client;
+    const QSize size(100, 100);
+    ShmBuffer buffer(size, client.shm);
+    wl_region *opaqueRegion = wl_compositor_create_region(client.compositor);
+    wl_region_add(opaqueRegion, 0, 0, size.width(), size.height());
+    QList<wl_surface *> surfaces;
+    for (int i = 0; i < 2; ++i) {
+        wl_surface *surface = client.createSurface();
+        client.createShellSurface(surface);
+        wl_surface_attach(surface, buffer.handle, 0, 0);
+        wl_surface_damage(surface, 0, 0, size.width(), size.height());
+        wl_surface_set_opaque_region(surface, opaqueRegion);
+        wl_surface_commit(surface);
+        surfaces << surface;
+    }
+    wl_region_destroy(opaqueRegion);
+    QTRY_COMPARE(compositor.surfaces.size(), 2);
+    QTRY_VERIFY(compositor.surfaces.at(0)->hasContent() && compositor.surfaces.at(1)->hasContent());
+
+    QWaylandQuickItem back;
+    back.setParentItem(window.contentItem());
+    back.setSurface(compositor.surfaces.at(0));
+    back.setSize(size);
+    QWaylandQuickItem front;
+    front.setParentItem(window.contentItem());
+    front.setSurface(compositor.surfaces.at(1));
+    front.setSize(size);
+
+    auto occluded = [](const QWaylandQuickItem *item) {
+        return QWaylandQuickItemPrivate::get(item)->occluded;
+    };
+    // Emitted by the render loop before each scene graph sync
+    auto updateOcclusion = [&window] { emit window.afterAnimating(); };
+
+    updateOcclusion();
+    QVERIFY(occluded(&back));
+    QVERIFY(!occluded(&front));
+
+    // Partially covered items are drawn in full
+    front.setX(50);
+    updateOcclusion();
+    QVERIFY(!occluded(&back));
+
+    front.setX(0);
+    updateOcclusion();
+    QVERIFY(occluded(&back));
+
+    // Translucent items don't hide anything
+    front.setOpacity(0.5);
+    updateOcclusion();
+    QVERIFY(!occluded(&back));
+
+    front.setOpacity(1);
+    front.setVisible(false);
+    updateOcclusion();
+    QVERIFY(!occluded(&back));
+
+    // Restacking brings the back item to the front
+    front.setVisible(true);
+    back.setZ(1);
+    updateOcclusion();
+    QVERIFY(!occluded(&back));
+    QVERIFY(occluded(&front));
+
+    for (wl_surface *surface : std::as_const(surfaces))
+        wl_surface_destroy(surface);
+}
+#endif
+
 void tst_WaylandCompositor::seatCapabilities()
 {
     TestCompositor compositor;
@@ -853,6 +1121,133 @@ void tst_WaylandCompositor::seatMouseFocus()
     delete view;
 }
 
+void tst_WaylandCompositor::pointerFrames()
+{
+    TestCompositor compositor(true);
+    compositor.create();
+
+    MockClient client;
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    QWaylandView view;
+    view.setSurface(waylandSurface);
+
+    QTRY_COMPARE(client.m_seats.size(), 1);
+    MockPointer *mockPointer = client.m_seats.first()->pointer();
+    QVERIFY(mockPointer);
+
+    // Moves sent within one dispatch reach the client as a single motion event
+    QWaylandSeat *seat = compositor.defaultSeat();
+    seat->sendMouseMoveEvent(&view, QPointF(10, 10));
+    seat->sendMouseMoveEvent(&view, QPointF(11, 11));
+    seat->sendMouseMoveEvent(&view, QPointF(12, 12));
+    QTRY_COMPARE(mockPointer->m_enteredSurface, surface);
+    QTRY_COMPARE(mockPointer->m_motionCount, 1);
+    QCOMPARE(mockPointer->m_lastMotion, QPointF(12, 12));
+    QTRY_COMPARE(mockPointer->m_frameCount, 2); // enter, motion
+
+    // One wheel detent away from the user scrolls up
+    seat->sendMouseWheelEvent(Qt::Vertical, 120);
+    QTRY_COMPARE(mockPointer->m_frameCount, 3);
+    QCOMPARE(mockPointer->m_axisSource, uint(WL_POINTER_AXIS_SOURCE_WHEEL));
+    QCOMPARE(mockPointer->m_axisValue120, -120);
+    QCOMPARE(mockPointer->m_axisValue, -10.0);
+    QCOMPARE(mockPointer->m_axisSourceCount, 1);
+
+#if QT_CONFIG(wheelevent)
+    // Both orientations of a wheel event share one frame and one axis_source
+    QWheelEvent wheel(QPointF(12, 12), QPointF(12, 12), QPoint(), QPoint(120, 120),
+                      Qt::NoButton, Qt::NoModifier, Qt::NoScrollPhase, false);
+    seat->sendFullWheelEvent(&wheel);
+    QTRY_COMPARE(mockPointer->m_frameCount, 4);
+    QCOMPARE(mockPointer->m_axisSourceCount, 2);
+#endif
+
+    wl_surface_destroy(surface);
+    QTRY_VERIFY(compositor.surfaces.size() == 0);
+}
+
+struct TouchEvents
+{
+    int downs = 0;
+    int ups = 0;
+    int motions = 0;
+    int frames = 0;
+    QPointF lastMotion;
+};
+
+static const wl_touch_listener touchListener = {
+    [](void *data, wl_touch *, uint32_t, uint32_t, wl_surface *, int32_t, wl_fixed_t, wl_fixed_t) {
+        static_cast<TouchEvents *>(data)->downs++;
+    },
+    [](void *data, wl_touch *, uint32_t, uint32_t, int32_t) {
+        static_cast<TouchEvents *>(data)->ups++;
+    },
+    [](void *data, wl_touch *, uint32_t, int32_t, wl_fixed_t x, wl_fixed_t y) {
+        auto *events = static_cast<TouchEvents *>(data);
+        events->motions++;
+        events->lastMotion = QPointF(wl_fixed_to_double(x), wl_fixed_to_double(y));
+    },
+    [](void *data, wl_touch *) { static_cast<TouchEvents *>(data)->frames++; },
+    [](void *, wl_touch *) {},
+    [](void *, wl_touch *, int32_t, wl_fixed_t, wl_fixed_t) {},
+    [](void *, wl_touch *, int32_t, wl_fixed_t) {}
+};
+
+void tst_WaylandCompositor::touchFrames()
+{
+    TestCompositor compositor(true);
+    compositor.create();
+
+    MockClient client;
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+
+    QTRY_COMPARE(client.m_seats.size(), 1);
+    TouchEvents events;
+    wl_touch *touch = wl_seat_get_touch(client.m_seats.first()->m_seat);
+    wl_touch_add_listener(touch, &touchListener, &events);
+
+    QWaylandSeat *seat = compositor.defaultSeat();
+    QTRY_COMPARE(QWaylandTouchPrivate::get(seat->touch())->resourceMap().size(), 1);
+
+    QPointingDevice touchDevice("test touchscreen", 1, QInputDevice::DeviceType::TouchScreen,
+                                QPointingDevice::PointerType::Finger,
+                                QInputDevice::Capability::Position, 10, 0);
+    auto sendTouch = [&](QEvent::Type type, QEventPoint::State state, const QPointF &position) {
+        QTouchEvent event(type, &touchDevice, Qt::NoModifier,
+                          { QEventPoint(0, state, position, position) });
+        seat->sendFullTouchEvent(waylandSurface, &event);
+    };
+
+    sendTouch(QEvent::TouchBegin, QEventPoint::Pressed, QPointF(1, 1));
+    QTRY_COMPARE(events.frames, 1);
+    QCOMPARE(events.downs, 1);
+
+    // Motion handled in one event loop iteration reaches the client as one frame
+    sendTouch(QEvent::TouchUpdate, QEventPoint::Updated, QPointF(2, 2));
+    sendTouch(QEvent::TouchUpdate, QEventPoint::Updated, QPointF(3, 3));
+    sendTouch(QEvent::TouchUpdate, QEventPoint::Updated, QPointF(4, 4));
+    QTRY_COMPARE(events.frames, 2);
+    QCOMPARE(events.motions, 1);
+    QCOMPARE(events.lastMotion, QPointF(4, 4));
+
+    // Pending motion goes out before the release, in the same frame
+    sendTouch(QEvent::TouchUpdate, QEventPoint::Updated, QPointF(5, 5));
+    sendTouch(QEvent::TouchEnd, QEventPoint::Released, QPointF(5, 5));
+    QTRY_COMPARE(events.frames, 3);
+    QCOMPARE(events.motions, 2);
+    QCOMPARE(events.ups, 1);
+    QCOMPARE(events.lastMotion, QPointF(5, 5));
+
+    wl_touch_destroy(touch);
+    wl_surface_destroy(surface);
+    QTRY_VERIFY(compositor.surfaces.size() == 0);
+}
+
 void tst_WaylandCompositor::inputRegion()
 {
     TestCompositor compositor(true);
@@ -913,6 +1308,49 @@ void tst_WaylandCompositor::inputRegion()
     QVERIFY(!waylandSurface->inputRegionContains(QPoint(1, 2)));
 }
 
+void tst_WaylandCompositor::inputRegionManyRects()
+{
+    TestCompositor compositor;
+    compositor.create();
+
+    MockClient client;
+    wl_surface *surface = client.createSurface();
+
+    QSize size(64, 64);
+    ShmBuffer buffer(size, client.shm);
+    wl_surface_attach(surface, buffer.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, size.width(), size.height());
+
+    // Rows of single pixels, with a hole punched in and then partially filled again
+    QRegion expected;
+    wl_region *region = wl_compositor_create_region(client.compositor);
+    for (int y = 0; y < size.height(); y += 2) {
+        for (int x = 0; x < size.width(); x += 2) {
+            wl_region_add(region, x, y, 1, 1);
+            expected += QRect(x, y, 1, 1);
+        }
+    }
+    wl_region_subtract(region, 8, 8, 16, 16);
+    expected -= QRect(8, 8, 16, 16);
+    wl_region_subtract(region, 40, 40, 4, 4);
+    expected -= QRect(40, 40, 4, 4);
+    wl_region_add(region, 10, 10, 4, 4);
+    expected += QRect(10, 10, 4, 4);
+    wl_surface_set_input_region(surface, region);
+    wl_surface_commit(surface);
+
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    QTRY_VERIFY(waylandSurface->hasContent());
+
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x)
+            QCOMPARE(waylandSurface->inputRegionContains(QPoint(x, y)), expected.contains(QPoint(x, y)));
+    }
+
+    wl_region_destroy(region);
+}
+
 void tst_WaylandCompositor::defaultInputRegionHiDpi()
 {
     TestCompositor compositor(true);
@@ -1153,6 +1591,109 @@ void tst_WaylandCompositor::sendsXdgConfigure()
     QTRY_VERIFY(!toplevel->resizing());
 }
 
+#if QT_CONFIG(wayland_compositor_quick)
+void tst_WaylandCompositor::xdgResizeConfigureThrottling()
+{
+    class MockXdgSurface : public QtWayland::xdg_surface
+    {
+    public:
+        explicit MockXdgSurface(::xdg_surface *xdgSurface) : QtWayland::xdg_surface(xdgSurface) {}
+        void xdg_surface_configure(uint32_t serial) override { configureSerial = serial; }
+        uint configureSerial = 0;
+    };
+
+    class MockXdgToplevel : public QtWayland::xdg_toplevel
+    {
+    public:
+        explicit MockXdgToplevel(::xdg_toplevel *toplevel) : QtWayland::xdg_toplevel(toplevel) {}
+        void xdg_toplevel_configure(int32_t width, int32_t height, wl_array *) override
+        {
+            configureSizes << QSize(width, height);
+        }
+        QList<QSize> configureSizes;
+    };
+
+    XdgTestCompositor compositor;
+    QQuickWindow window;
+    window.resize(400, 400);
+    QWaylandQuickOutput output(&compositor, &window);
+    compositor.create();
+
+    QWaylandXdgSurface *xdgSurface = nullptr;
+    QObject::connect(&compositor.xdgShell, &QWaylandXdgShell::xdgSurfaceCreated,
+                     this, [&](QWaylandXdgSurface *s) { xdgSurface = s; });
+    QWaylandXdgToplevel *toplevel = nullptr;
+    QObject::connect(&compositor.xdgShell, &QWaylandXdgShell::toplevelCreated,
+                     this, [&](QWaylandXdgToplevel *t) { toplevel = t; });
+
+    MockClient client;
+    wl_surface *surface = client.createSurface();
+    xdg_surface *clientXdgSurface = client.createXdgSurface(surface);
+    MockXdgSurface mockXdgSurface(clientXdgSurface);
+    xdg_toplevel *clientToplevel = client.createXdgToplevel(clientXdgSurface);
+    MockXdgToplevel mockToplevel(clientToplevel);
+
+    wl_surface_commit(surface);
+    QTRY_VERIFY(mockXdgSurface.configureSerial);
+    QVERIFY(xdgSurface && toplevel);
+
+    const QSize size(100, 100);
+    ShmBuffer buffer(size, client.shm);
+    auto ackAndCommit = [&] {
+        xdg_surface_ack_configure(clientXdgSurface, mockXdgSurface.configureSerial);
+        xdg_surface_set_window_geometry(clientXdgSurface, 0, 0, size.width(), size.height());
+        wl_surface_attach(surface, buffer.handle, 0, 0);
+        wl_surface_damage(surface, 0, 0, size.width(), size.height());
+        wl_surface_commit(surface);
+        client.flushDisplay();
+    };
+    ackAndCommit();
+    QTRY_COMPARE(xdgSurface->windowGeometry().size(), size);
+
+    QWaylandQuickShellSurfaceItem item;
+    item.setParentItem(window.contentItem());
+    item.setShellSurface(xdgSurface);
+
+    auto moveTo = [&item](const QPointF &pos) {
+        QMouseEvent event(QEvent::MouseMove, pos, pos, pos, Qt::NoButton, Qt::LeftButton, Qt::NoModifier);
+        QCoreApplication::sendEvent(&item, &event);
+    };
+
+    mockToplevel.configureSizes.clear();
+    const uint initialSerial = mockXdgSurface.configureSerial;
+    emit toplevel->startResize(compositor.defaultSeat(), Qt::BottomEdge | Qt::RightEdge);
+    moveTo(QPointF(100, 100));
+    moveTo(QPointF(110, 110));
+    moveTo(QPointF(120, 120));
+    moveTo(QPointF(130, 130));
+    compositor.flushClients();
+
+    // Only the first size goes out while the client hasn't caught up with it
+    QTRY_COMPARE(mockToplevel.configureSizes, QList<QSize>{QSize(110, 110)});
+    QVERIFY(mockXdgSurface.configureSerial != initialSerial);
+    QTest::qWait(50);
+    compositor.flushClients();
+    QCOMPARE(mockToplevel.configureSizes.size(), 1);
+
+    // Once it has acked and committed, the latest size follows, skipping the ones in between
+    ackAndCommit();
+    QTRY_COMPARE(mockToplevel.configureSizes.size(), 2);
+    QCOMPARE(mockToplevel.configureSizes.last(), QSize(130, 130));
+
+    // Releasing the button flushes a size that was held back
+    moveTo(QPointF(140, 140));
+    QTest::qWait(50);
+    compositor.flushClients();
+    QCOMPARE(mockToplevel.configureSizes.size(), 2);
+    QMouseEvent release(QEvent::MouseButtonRelease, QPointF(140, 140), QPointF(140, 140), QPointF(140, 140),
+                        Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&item, &release);
+    compositor.flushClients();
+    QTRY_COMPARE(mockToplevel.configureSizes.size(), 3);
+    QCOMPARE(mockToplevel.configureSizes.last(), QSize(140, 140));
+}
+#endif
+
 class IviTestCompositor: public TestCompositor {
     Q_OBJECT
 public:
@@ -1704,6 +2245,275 @@ public:
     QWaylandIdleInhibitManagerV1 idleInhibitManager;
 };
 
+void tst_WaylandCompositor::subsurfaceStateOnParentCommit()
+{
+    TestCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.subcompositor);
+
+    wl_surface *parent = client.createSurface();
+    wl_surface *first = client.createSurface();
+    wl_surface *second = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 3);
+    QWaylandSurface *parentSurface = compositor.surfaces.at(0);
+    QWaylandSurface *firstSurface = compositor.surfaces.at(1);
+    QWaylandSurface *secondSurface = compositor.surfaces.at(2);
+
+    wl_subsurface *firstSubsurface = wl_subcompositor_get_subsurface(client.subcompositor, first, parent);
+    wl_subsurface *secondSubsurface = wl_subcompositor_get_subsurface(client.subcompositor, second, parent);
+    client.flushDisplay();
+
+    auto *parentPrivate = QWaylandSurfacePrivate::get(parentSurface);
+    using Stack = QList<QWaylandSurfacePrivate *>;
+    QTRY_COMPARE(parentPrivate->subsurfaceStack.size(), 3);
+    const Stack initialStack = { parentPrivate, QWaylandSurfacePrivate::get(firstSurface),
+                                 QWaylandSurfacePrivate::get(secondSurface) };
+    QCOMPARE(parentPrivate->subsurfaceStack, initialStack);
+
+    QSignalSpy positionSpy(firstSurface, &QWaylandSurface::subsurfacePositionChanged);
+    QSignalSpy placeBelowSpy(secondSurface, &QWaylandSurface::subsurfacePlaceBelow);
+
+    // Position and stacking are state of the parent, nothing changes before it commits
+    wl_subsurface_set_position(firstSubsurface, 10, 20);
+    wl_subsurface_set_position(firstSubsurface, 30, 40);
+    wl_subsurface_place_below(secondSubsurface, parent);
+    wl_surface_commit(first);
+    wl_surface_commit(second);
+    // The compositor has handled everything above once it has created this surface
+    wl_surface *marker = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 4);
+    QCOMPARE(positionSpy.size(), 0);
+    QCOMPARE(placeBelowSpy.size(), 0);
+    QCOMPARE(parentPrivate->subsurfaceStack, initialStack);
+
+    const uint serial = parentPrivate->subsurfaceStackSerial;
+    wl_surface_commit(parent);
+    QTRY_COMPARE(positionSpy.size(), 1);
+    QCOMPARE(positionSpy.at(0).at(0).toPoint(), QPoint(30, 40));
+    QCOMPARE(placeBelowSpy.size(), 1);
+    QCOMPARE(placeBelowSpy.at(0).at(0).value<QWaylandSurface *>(), parentSurface);
+    const Stack committedStack = { QWaylandSurfacePrivate::get(secondSurface), parentPrivate,
+                                   QWaylandSurfacePrivate::get(firstSurface) };
+    QCOMPARE(parentPrivate->subsurfaceStack, committedStack);
+    QCOMPARE(parentPrivate->subsurfaceStackSerial, serial + 1);
+
+    // Committing the same state again changes nothing
+    wl_subsurface_set_position(firstSubsurface, 30, 40);
+    wl_surface_commit(parent);
+    wl_surface *secondMarker = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 5);
+    QCOMPARE(positionSpy.size(), 1);
+    QCOMPARE(parentPrivate->subsurfaceStackSerial, serial + 1);
+
+    // Destroyed subsurfaces leave the stack at once
+    wl_subsurface_destroy(secondSubsurface);
+    wl_surface_destroy(second);
+    QTRY_COMPARE(parentPrivate->subsurfaceStack.size(), 2);
+
+    wl_subsurface_destroy(firstSubsurface);
+    wl_surface_destroy(first);
+    wl_surface_destroy(parent);
+    wl_surface_destroy(marker);
+    wl_surface_destroy(secondMarker);
+}
+
+void tst_WaylandCompositor::subsurfaceReparent()
+{
+    TestCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.subcompositor);
+
+    wl_surface *firstParent = client.createSurface();
+    wl_surface *secondParent = client.createSurface();
+    wl_surface *child = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 3);
+    auto *firstParentPrivate = QWaylandSurfacePrivate::get(compositor.surfaces.at(0));
+    auto *secondParentPrivate = QWaylandSurfacePrivate::get(compositor.surfaces.at(1));
+    QWaylandSurface *childSurface = compositor.surfaces.at(2);
+    auto *childPrivate = QWaylandSurfacePrivate::get(childSurface);
+
+    QSignalSpy parentChangedSpy(childSurface, &QWaylandSurface::parentChanged);
+    wl_subsurface *subsurface = wl_subcompositor_get_subsurface(client.subcompositor, child, firstParent);
+    QTRY_COMPARE(parentChangedSpy.size(), 1);
+    QCOMPARE(childPrivate->parentSurface(), firstParentPrivate);
+    QCOMPARE(firstParentPrivate->subsurfaceChildren.size(), 1);
+
+    // Destroying the wl_subsurface unmaps the child from its parent right away
+    wl_subsurface_destroy(subsurface);
+    QTRY_COMPARE(parentChangedSpy.size(), 2);
+    QCOMPARE(parentChangedSpy.at(1).at(0).value<QWaylandSurface *>(), nullptr);
+    QVERIFY(!childPrivate->isSubsurface());
+    QVERIFY(!firstParentPrivate->subsurfaceStack.contains(childPrivate));
+    QVERIFY(!firstParentPrivate->pendingSubsurfaceStack.contains(childPrivate));
+    QVERIFY(firstParentPrivate->subsurfaceChildren.isEmpty());
+
+    // After which it can get another parent
+    subsurface = wl_subcompositor_get_subsurface(client.subcompositor, child, secondParent);
+    QTRY_COMPARE(parentChangedSpy.size(), 3);
+    QCOMPARE(childPrivate->parentSurface(), secondParentPrivate);
+    const QList<QWaylandSurfacePrivate *> stack = { secondParentPrivate, childPrivate };
+    QCOMPARE(secondParentPrivate->subsurfaceStack, stack);
+
+    QSignalSpy positionSpy(childSurface, &QWaylandSurface::subsurfacePositionChanged);
+    wl_subsurface_set_position(subsurface, 5, 6);
+    wl_surface_commit(firstParent);
+    wl_surface_commit(secondParent);
+    QTRY_COMPARE(positionSpy.size(), 1);
+    QCOMPARE(positionSpy.at(0).at(0).toPoint(), QPoint(5, 6));
+    QVERIFY(!firstParentPrivate->subsurfaceStack.contains(childPrivate));
+    QCOMPARE(client.error, 0);
+
+    wl_subsurface_destroy(subsurface);
+    wl_surface_destroy(child);
+    wl_surface_destroy(secondParent);
+    wl_surface_destroy(firstParent);
+}
+
+void tst_WaylandCompositor::subsurfaceDestroyParent()
+{
+    TestCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.subcompositor);
+
+    wl_surface *parent = client.createSurface();
+    wl_surface *child = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 2);
+    QWaylandSurface *childSurface = compositor.surfaces.at(1);
+    auto *childPrivate = QWaylandSurfacePrivate::get(childSurface);
+
+    QSignalSpy parentChangedSpy(childSurface, &QWaylandSurface::parentChanged);
+    wl_subsurface *subsurface = wl_subcompositor_get_subsurface(client.subcompositor, child, parent);
+    QTRY_COMPARE(parentChangedSpy.size(), 1);
+
+    wl_surface_destroy(parent);
+    QTRY_COMPARE(parentChangedSpy.size(), 2);
+    QCOMPARE(parentChangedSpy.at(1).at(0).value<QWaylandSurface *>(), nullptr);
+    QVERIFY(!childPrivate->parentSurface());
+
+    // The wl_subsurface is inert now, but may still be used and destroyed
+    wl_subsurface_set_position(subsurface, 1, 2);
+    wl_surface_commit(child);
+    wl_subsurface_destroy(subsurface);
+    wl_surface *marker = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 2);
+    QTRY_VERIFY(!childPrivate->isSubsurface());
+    QCOMPARE(client.error, 0);
+
+    wl_surface_destroy(marker);
+    wl_surface_destroy(child);
+}
+
+void tst_WaylandCompositor::subsurfaceDestroySurface()
+{
+    TestCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.subcompositor);
+
+    wl_surface *parent = client.createSurface();
+    wl_surface *first = client.createSurface();
+    wl_surface *second = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 3);
+    auto *parentPrivate = QWaylandSurfacePrivate::get(compositor.surfaces.at(0));
+    auto *secondPrivate = QWaylandSurfacePrivate::get(compositor.surfaces.at(2));
+
+    wl_subsurface *firstSubsurface = wl_subcompositor_get_subsurface(client.subcompositor, first, parent);
+    wl_subsurface *secondSubsurface = wl_subcompositor_get_subsurface(client.subcompositor, second, parent);
+    QTRY_COMPARE(parentPrivate->subsurfaceStack.size(), 3);
+    wl_subsurface_place_below(secondSubsurface, parent);
+
+    // The surface goes away before its wl_subsurface, which leaves the parent right away
+    wl_surface_destroy(first);
+    QTRY_COMPARE(compositor.surfaces.size(), 2);
+    const QList<QWaylandSurfacePrivate *> stack = { parentPrivate, secondPrivate };
+    QCOMPARE(parentPrivate->subsurfaceStack, stack);
+    const QList<QWaylandSurfacePrivate *> pendingStack = { secondPrivate, parentPrivate };
+    QCOMPARE(parentPrivate->pendingSubsurfaceStack, pendingStack);
+    QCOMPARE(parentPrivate->subsurfaceChildren.size(), 1);
+
+    wl_subsurface_set_position(firstSubsurface, 3, 4);
+    wl_surface_commit(parent);
+    wl_subsurface_destroy(firstSubsurface);
+    QTRY_COMPARE(parentPrivate->subsurfaceStack, pendingStack);
+    QCOMPARE(client.error, 0);
+
+    wl_subsurface_destroy(secondSubsurface);
+    wl_surface_destroy(second);
+    wl_surface_destroy(parent);
+}
+
+void tst_WaylandCompositor::subsurfaceRoleError_data()
+{
+    QTest::addColumn<bool>("toplevel");
+    QTest::newRow("subsurface") << false;
+    QTest::newRow("xdg_toplevel") << true;
+}
+
+void tst_WaylandCompositor::subsurfaceRoleError()
+{
+    QFETCH(bool, toplevel);
+
+    XdgTestCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.subcompositor);
+    QTRY_VERIFY(client.xdgWmBase);
+
+    wl_surface *parent = client.createSurface();
+    wl_surface *otherParent = client.createSurface();
+    wl_surface *child = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 3);
+    auto *parentPrivate = QWaylandSurfacePrivate::get(compositor.surfaces.at(0));
+    auto *otherParentPrivate = QWaylandSurfacePrivate::get(compositor.surfaces.at(1));
+
+    if (toplevel) {
+        client.createXdgToplevel(client.createXdgSurface(child));
+    } else {
+        wl_subcompositor_get_subsurface(client.subcompositor, child, parent);
+        QTRY_COMPARE(parentPrivate->subsurfaceStack.size(), 2);
+    }
+
+    wl_subcompositor_get_subsurface(client.subcompositor, child, otherParent);
+    QTRY_COMPARE(client.error, EPROTO);
+    QCOMPARE(client.protocolError.interface, &wl_subcompositor_interface);
+    QCOMPARE(static_cast<wl_subcompositor_error>(client.protocolError.code), WL_SUBCOMPOSITOR_ERROR_BAD_SURFACE);
+    QVERIFY(otherParentPrivate->subsurfaceStack.isEmpty());
+}
+
+void tst_WaylandCompositor::subsurfaceParentError_data()
+{
+    QTest::addColumn<bool>("descendant");
+    QTest::newRow("itself") << false;
+    QTest::newRow("descendant") << true;
+}
+
+void tst_WaylandCompositor::subsurfaceParentError()
+{
+    QFETCH(bool, descendant);
+
+    TestCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.subcompositor);
+
+    wl_surface *surface = client.createSurface();
+    wl_surface *child = client.createSurface();
+    wl_surface *grandChild = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 3);
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(compositor.surfaces.at(0));
+
+    wl_subcompositor_get_subsurface(client.subcompositor, child, surface);
+    wl_subcompositor_get_subsurface(client.subcompositor, grandChild, child);
+    wl_subcompositor_get_subsurface(client.subcompositor, surface, descendant ? grandChild : surface);
+    QTRY_COMPARE(client.error, EPROTO);
+    QCOMPARE(client.protocolError.interface, &wl_subcompositor_interface);
+    QCOMPARE(static_cast<wl_subcompositor_error>(client.protocolError.code), WL_SUBCOMPOSITOR_ERROR_BAD_PARENT);
+    QVERIFY(!surfacePrivate->isSubsurface());
+}
+
 void tst_WaylandCompositor::idleInhibit()
 {
     IdleInhibitCompositor compositor;
@@ -1731,6 +2541,238 @@ void tst_WaylandCompositor::idleInhibit()
     QTRY_COMPARE(changedSpy.size(), 1);
 }
 
+class PointerConstraintsCompositor : public TestCompositor
+{
+    Q_OBJECT
+public:
+    PointerConstraintsCompositor()
+        : TestCompositor(true)
+        , relativePointerManager(this)
+        , pointerConstraints(this)
+    {}
+    QWaylandRelativePointerManagerV1 relativePointerManager;
+    QWaylandPointerConstraintsV1 pointerConstraints;
+};
+
+struct RelativeMotion
+{
+    int count = 0;
+    QPointF delta;
+    QPointF deltaUnaccelerated;
+};
+
+static const zwp_relative_pointer_v1_listener relativePointerListener = {
+    [](void *data, zwp_relative_pointer_v1 *, uint32_t, uint32_t, wl_fixed_t dx, wl_fixed_t dy,
+       wl_fixed_t dxUnaccel, wl_fixed_t dyUnaccel) {
+        auto *motion = static_cast<RelativeMotion *>(data);
+        motion->count++;
+        motion->delta = QPointF(wl_fixed_to_double(dx), wl_fixed_to_double(dy));
+        motion->deltaUnaccelerated = QPointF(wl_fixed_to_double(dxUnaccel), wl_fixed_to_double(dyUnaccel));
+    }
+};
+
+// Number of activations minus deactivations a constraint has seen
+static const zwp_locked_pointer_v1_listener lockedPointerListener = {
+    [](void *data, zwp_locked_pointer_v1 *) { ++*static_cast<int *>(data); },
+    [](void *data, zwp_locked_pointer_v1 *) { --*static_cast<int *>(data); }
+};
+
+static const zwp_confined_pointer_v1_listener confinedPointerListener = {
+    [](void *data, zwp_confined_pointer_v1 *) { ++*static_cast<int *>(data); },
+    [](void *data, zwp_confined_pointer_v1 *) { --*static_cast<int *>(data); }
+};
+
+static wl_surface *createSurfaceWithBuffer(MockClient &client, const QSize &size, ShmBuffer **buffer)
+{
+    wl_surface *surface = client.createSurface();
+    *buffer = new ShmBuffer(size, client.shm);
+    wl_surface_attach(surface, (*buffer)->handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, size.width(), size.height());
+    wl_surface_commit(surface);
+    return surface;
+}
+
+void tst_WaylandCompositor::relativePointer()
+{
+    PointerConstraintsCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.relativePointerManager);
+
+    ShmBuffer *buffer = nullptr;
+    wl_surface *surface = createSurfaceWithBuffer(client, QSize(16, 16), &buffer);
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandView view;
+    view.setSurface(compositor.surfaces.at(0));
+
+    QTRY_COMPARE(client.m_seats.size(), 1);
+    MockPointer *mockPointer = client.m_seats.first()->pointer();
+    RelativeMotion motion;
+    auto *relativePointer = zwp_relative_pointer_manager_v1_get_relative_pointer(
+                client.relativePointerManager, mockPointer->m_pointer);
+    zwp_relative_pointer_v1_add_listener(relativePointer, &relativePointerListener, &motion);
+
+    QWaylandSeat *seat = compositor.defaultSeat();
+    auto *pointerPrivate = QWaylandPointerPrivate::get(seat->pointer());
+    QTRY_COMPARE(pointerPrivate->relativePointers.size(), 1);
+
+    // Entering the surface is not motion
+    seat->sendMouseMoveEvent(&view, QPointF(1, 1));
+    QTRY_COMPARE(mockPointer->m_enteredSurface, surface);
+    QCOMPARE(motion.count, 0);
+
+    seat->sendMouseMoveEvent(&view, QPointF(4, 6));
+    QTRY_COMPARE(motion.count, 1);
+    QCOMPARE(motion.delta, QPointF(3, 5));
+    QCOMPARE(motion.deltaUnaccelerated, QPointF(3, 5));
+
+    seat->pointer()->sendRelativeMotionEvent(QPointF(2, 0), QPointF(1, 0), 1000);
+    QTRY_COMPARE(motion.count, 2);
+    QCOMPARE(motion.delta, QPointF(2, 0));
+    QCOMPARE(motion.deltaUnaccelerated, QPointF(1, 0));
+
+    zwp_relative_pointer_v1_destroy(relativePointer);
+    QTRY_COMPARE(pointerPrivate->relativePointers.size(), 0);
+
+    wl_surface_destroy(surface);
+    delete buffer;
+}
+
+void tst_WaylandCompositor::pointerLock()
+{
+    PointerConstraintsCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.pointerConstraints);
+
+    ShmBuffer *buffer = nullptr;
+    wl_surface *surface = createSurfaceWithBuffer(client, QSize(16, 16), &buffer);
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandView view;
+    view.setSurface(compositor.surfaces.at(0));
+
+    QTRY_COMPARE(client.m_seats.size(), 1);
+    MockPointer *mockPointer = client.m_seats.first()->pointer();
+    int locked = 0;
+    auto *lockedPointer = zwp_pointer_constraints_v1_lock_pointer(
+                client.pointerConstraints, surface, mockPointer->m_pointer, nullptr,
+                ZWP_POINTER_CONSTRAINTS_V1_LIFETIME_PERSISTENT);
+    zwp_locked_pointer_v1_add_listener(lockedPointer, &lockedPointerListener, &locked);
+
+    QWaylandSeat *seat = compositor.defaultSeat();
+    auto *pointerPrivate = QWaylandPointerPrivate::get(seat->pointer());
+    QTRY_COMPARE(pointerPrivate->constraints.size(), 1);
+
+    // The lock activates as soon as the pointer enters, so the client never sees motion
+    seat->sendMouseMoveEvent(&view, QPointF(5, 5));
+    QTRY_COMPARE(locked, 1);
+
+    // Locked pointers don't move
+    seat->sendMouseMoveEvent(&view, QPointF(8, 8));
+    seat->sendMouseMoveEvent(&view, QPointF(9, 9));
+    QTest::qWait(50);
+    QCOMPARE(mockPointer->m_motionCount, 0);
+    QCOMPARE(seat->pointer()->currentLocalPosition(), QPointF(5, 5));
+
+    // Moving off the surface doesn't take pointer focus from it
+    seat->sendMouseMoveEvent(nullptr, QPointF(40, 40));
+    QCOMPARE(seat->mouseFocus(), &view);
+    QCOMPARE(seat->pointer()->currentLocalPosition(), QPointF(5, 5));
+    QTest::qWait(50);
+    QCOMPARE(locked, 1);
+    QCOMPARE(mockPointer->m_enteredSurface, surface);
+
+    // Taking pointer focus away unlocks, a persistent lock comes back when reentering
+    seat->setMouseFocus(nullptr);
+    QTRY_COMPARE(locked, 0);
+    seat->sendMouseMoveEvent(&view, QPointF(2, 2));
+    QTRY_COMPARE(locked, 1);
+
+    // Unmapping the surface unlocks too
+    wl_surface_attach(surface, nullptr, 0, 0);
+    wl_surface_commit(surface);
+    QTRY_COMPARE(locked, 0);
+    seat->sendMouseMoveEvent(&view, QPointF(3, 3));
+    QTest::qWait(50);
+    QCOMPARE(locked, 0);
+
+    zwp_locked_pointer_v1_destroy(lockedPointer);
+    QTRY_COMPARE(pointerPrivate->constraints.size(), 0);
+    seat->sendMouseMoveEvent(&view, QPointF(4, 4));
+    QTRY_COMPARE(mockPointer->m_lastMotion, QPointF(4, 4));
+
+    wl_surface_destroy(surface);
+    delete buffer;
+}
+
+void tst_WaylandCompositor::pointerConfine()
+{
+    PointerConstraintsCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.pointerConstraints);
+
+    ShmBuffer *buffer = nullptr;
+    wl_surface *surface = createSurfaceWithBuffer(client, QSize(16, 16), &buffer);
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandView view;
+    view.setSurface(compositor.surfaces.at(0));
+
+    QTRY_COMPARE(client.m_seats.size(), 1);
+    MockPointer *mockPointer = client.m_seats.first()->pointer();
+    wl_region *region = wl_compositor_create_region(client.compositor);
+    wl_region_add(region, 0, 0, 8, 8);
+    int confined = 0;
+    auto *confinedPointer = zwp_pointer_constraints_v1_confine_pointer(
+                client.pointerConstraints, surface, mockPointer->m_pointer, region,
+                ZWP_POINTER_CONSTRAINTS_V1_LIFETIME_ONESHOT);
+    zwp_confined_pointer_v1_add_listener(confinedPointer, &confinedPointerListener, &confined);
+    wl_region_destroy(region);
+
+    QWaylandSeat *seat = compositor.defaultSeat();
+    auto *pointerPrivate = QWaylandPointerPrivate::get(seat->pointer());
+    QTRY_COMPARE(pointerPrivate->constraints.size(), 1);
+
+    // Outside of the region, the confinement doesn't activate yet
+    seat->sendMouseMoveEvent(&view, QPointF(12, 3));
+    QTRY_COMPARE(mockPointer->m_lastMotion, QPointF(12, 3));
+    QCOMPARE(confined, 0);
+
+    seat->sendMouseMoveEvent(&view, QPointF(2, 2));
+    QTRY_COMPARE(confined, 1);
+    seat->sendMouseMoveEvent(&view, QPointF(12, 3));
+    QTRY_COMPARE(mockPointer->m_lastMotion, QPointF(8 - 1.0 / 256, 3));
+
+    // Moves over other views keep the pointer on the surface, within the region
+    seat->sendMouseMoveEvent(&view, QPointF(4, 4), QPointF(104, 104));
+    QTRY_COMPARE(mockPointer->m_lastMotion, QPointF(4, 4));
+    seat->sendMouseMoveEvent(nullptr, QPointF(), QPointF(106, 120));
+    QCOMPARE(seat->mouseFocus(), &view);
+    QTRY_COMPARE(mockPointer->m_lastMotion, QPointF(6, 8 - 1.0 / 256));
+    QCOMPARE(mockPointer->m_enteredSurface, surface);
+
+    // Focusing another surface ends the confinement, the pointer is then free to leave
+    ShmBuffer *otherBuffer = nullptr;
+    wl_surface *otherSurface = createSurfaceWithBuffer(client, QSize(16, 16), &otherBuffer);
+    QTRY_COMPARE(compositor.surfaces.size(), 2);
+    seat->setKeyboardFocus(compositor.surfaces.at(1));
+    QTRY_COMPARE(confined, 0);
+    seat->sendMouseMoveEvent(nullptr, QPointF());
+    QTRY_VERIFY(!mockPointer->m_enteredSurface);
+
+    // A oneshot confinement doesn't come back
+    seat->setKeyboardFocus(compositor.surfaces.at(0));
+    seat->sendMouseMoveEvent(&view, QPointF(2, 2));
+    QTRY_COMPARE(mockPointer->m_lastMotion, QPointF(2, 2));
+    QCOMPARE(confined, 0);
+
+    zwp_confined_pointer_v1_destroy(confinedPointer);
+    wl_surface_destroy(otherSurface);
+    delete otherBuffer;
+    wl_surface_destroy(surface);
+    delete buffer;
+}
+
 class XdgOutputCompositor : public TestCompositor
 {
     Q_OBJECT
@@ -1739,6 +2781,536 @@ public:
     QWaylandXdgOutputManagerV1 xdgOutputManager;
 };
 
+class ColorManagementCompositor : public TestCompositor
+{
+    Q_OBJECT
+public:
+    ColorManagementCompositor() : colorManagement(this) {}
+    QWaylandColorManagement colorManagement;
+};
+
+static const xx_image_description_v4_listener imageDescriptionListener = {
+    [](void *data, xx_image_description_v4 *, uint32_t, const char *) { *static_cast<int *>(data) = -1; },
+    [](void *data, xx_image_description_v4 *, uint32_t identity) { *static_cast<int *>(data) = int(identity); }
+};
+
+struct ImageDescriptionInfo
+{
+    bool done = false;
+    int primaries = -1;
+    int transferFunction = -1;
+    QPointF white;
+};
+
+static const xx_image_description_info_v4_listener imageDescriptionInfoListener = {
+    [](void *data, xx_image_description_info_v4 *info) {
+        static_cast<ImageDescriptionInfo *>(data)->done = true;
+        xx_image_description_info_v4_destroy(info);
+    },
+    [](void *, xx_image_description_info_v4 *, int32_t fd, uint32_t) { close(fd); },
+    [](void *data, xx_image_description_info_v4 *, int32_t, int32_t, int32_t, int32_t, int32_t,
+       int32_t, int32_t w_x, int32_t w_y) {
+        static_cast<ImageDescriptionInfo *>(data)->white = QPointF(w_x, w_y) / 10000.0;
+    },
+    [](void *data, xx_image_description_info_v4 *, uint32_t primaries) {
+        static_cast<ImageDescriptionInfo *>(data)->primaries = int(primaries);
+    },
+    [](void *, xx_image_description_info_v4 *, uint32_t) {},
+    [](void *data, xx_image_description_info_v4 *, uint32_t tf) {
+        static_cast<ImageDescriptionInfo *>(data)->transferFunction = int(tf);
+    },
+    [](void *, xx_image_description_info_v4 *, uint32_t, uint32_t, uint32_t) {},
+    [](void *, xx_image_description_info_v4 *, int32_t, int32_t, int32_t, int32_t, int32_t,
+       int32_t, int32_t, int32_t) {},
+    [](void *, xx_image_description_info_v4 *, uint32_t, uint32_t) {},
+    [](void *, xx_image_description_info_v4 *, uint32_t) {},
+    [](void *, xx_image_description_info_v4 *, uint32_t) {},
+};
+
+void tst_WaylandCompositor::colorManagementSurface()
+{
+    ColorManagementCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.colorManager);
+
+    ShmBuffer *buffer = nullptr;
+    wl_surface *surface = createSurfaceWithBuffer(client, QSize(16, 16), &buffer);
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    QTRY_VERIFY(waylandSurface->hasContent());
+    QVERIFY(!waylandSurface->colorSpace().isValid());
+    QSignalSpy colorSpaceSpy(waylandSurface, SIGNAL(colorSpaceChanged()));
+
+    auto *creator = xx_color_manager_v4_new_parametric_creator(client.colorManager);
+    xx_image_description_creator_params_v4_set_primaries_named(creator, XX_COLOR_MANAGER_V4_PRIMARIES_BT2020);
+    xx_image_description_creator_params_v4_set_tf_named(creator, XX_COLOR_MANAGER_V4_TRANSFER_FUNCTION_BT709);
+    auto *description = xx_image_description_creator_params_v4_create(creator);
+    int identity = 0;
+    xx_image_description_v4_add_listener(description, &imageDescriptionListener, &identity);
+    QTRY_VERIFY(identity > 0);
+
+    auto *colorManagementSurface = xx_color_manager_v4_get_surface(client.colorManager, surface);
+    xx_color_management_surface_v4_set_image_description(colorManagementSurface, description,
+                                                         XX_COLOR_MANAGER_V4_RENDER_INTENT_PERCEPTUAL);
+    // The surface keeps the description after the object is gone
+    xx_image_description_v4_destroy(description);
+
+    // Double-buffered
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(waylandSurface);
+    QTRY_VERIFY(surfacePrivate->pending.colorSpace.isValid());
+    QCOMPARE(colorSpaceSpy.size(), 0);
+    wl_surface_commit(surface);
+    QTRY_COMPARE(colorSpaceSpy.size(), 1);
+    QCOMPARE(waylandSurface->colorSpace(),
+             QColorSpace(QColorSpace::Primaries::Bt2020, QColorSpace::TransferFunction::Bt2020));
+    QCOMPARE(surfacePrivate->yuvConversion.matrix, QWaylandYuvConversion::Bt2020);
+
+    // Named primaries that QColorSpace has no name for, with a gamma curve
+    creator = xx_color_manager_v4_new_parametric_creator(client.colorManager);
+    xx_image_description_creator_params_v4_set_primaries_named(creator, XX_COLOR_MANAGER_V4_PRIMARIES_PAL);
+    xx_image_description_creator_params_v4_set_tf_named(creator, XX_COLOR_MANAGER_V4_TRANSFER_FUNCTION_GAMMA22);
+    description = xx_image_description_creator_params_v4_create(creator);
+    xx_color_management_surface_v4_set_image_description(colorManagementSurface, description,
+                                                         XX_COLOR_MANAGER_V4_RENDER_INTENT_PERCEPTUAL);
+    xx_image_description_v4_destroy(description);
+    wl_surface_commit(surface);
+    QTRY_COMPARE(colorSpaceSpy.size(), 2);
+    QCOMPARE(waylandSurface->colorSpace().transferFunction(), QColorSpace::TransferFunction::Gamma);
+    QVERIFY(qFuzzyCompare(waylandSurface->colorSpace().gamma(), 2.2f));
+    QCOMPARE(surfacePrivate->yuvConversion.matrix, QWaylandYuvConversion::Bt601);
+
+    // Destroying the object unsets the description
+    xx_color_management_surface_v4_destroy(colorManagementSurface);
+    wl_surface_commit(surface);
+    QTRY_COMPARE(colorSpaceSpy.size(), 3);
+    QVERIFY(!waylandSurface->colorSpace().isValid());
+    QCOMPARE(surfacePrivate->yuvConversion, QWaylandYuvConversion());
+    QTRY_VERIFY(!surfacePrivate->colorManagement);
+    QCOMPARE(client.error, 0);
+
+    wl_surface_destroy(surface);
+    delete buffer;
+}
+
+void tst_WaylandCompositor::colorManagementErrors()
+{
+    ColorManagementCompositor compositor;
+    compositor.create();
+
+    {
+        MockClient client;
+        QTRY_VERIFY(client.colorManager);
+        auto *creator = xx_color_manager_v4_new_parametric_creator(client.colorManager);
+        xx_image_description_creator_params_v4_set_primaries_named(creator, XX_COLOR_MANAGER_V4_PRIMARIES_SRGB);
+        xx_image_description_creator_params_v4_create(creator);
+        QTRY_COMPARE(client.error, EPROTO);
+    }
+
+    {
+        MockClient client;
+        QTRY_VERIFY(client.colorManager);
+        auto *creator = xx_color_manager_v4_new_parametric_creator(client.colorManager);
+        xx_image_description_creator_params_v4_set_tf_named(creator, XX_COLOR_MANAGER_V4_TRANSFER_FUNCTION_SRGB);
+        xx_image_description_creator_params_v4_set_tf_named(creator, XX_COLOR_MANAGER_V4_TRANSFER_FUNCTION_GAMMA22);
+        QTRY_COMPARE(client.error, EPROTO);
+    }
+
+    {
+        // Transfer functions that would need converting the surface are not advertised
+        MockClient client;
+        QTRY_VERIFY(client.colorManager);
+        auto *creator = xx_color_manager_v4_new_parametric_creator(client.colorManager);
+        xx_image_description_creator_params_v4_set_tf_named(creator, XX_COLOR_MANAGER_V4_TRANSFER_FUNCTION_ST2084_PQ);
+        QTRY_COMPARE(client.error, EPROTO);
+        QCOMPARE(client.protocolError.interface, &xx_image_description_creator_params_v4_interface);
+        QCOMPARE(client.protocolError.code, uint(XX_IMAGE_DESCRIPTION_CREATOR_PARAMS_V4_ERROR_INVALID_TF));
+    }
+
+    {
+        // Neither are the set_tf_power and set_primaries features
+        MockClient client;
+        QTRY_VERIFY(client.colorManager);
+        auto *creator = xx_color_manager_v4_new_parametric_creator(client.colorManager);
+        xx_image_description_creator_params_v4_set_tf_power(creator, 24000);
+        QTRY_COMPARE(client.error, EPROTO);
+        QCOMPARE(client.protocolError.interface, &xx_image_description_creator_params_v4_interface);
+        QCOMPARE(client.protocolError.code, uint(XX_IMAGE_DESCRIPTION_CREATOR_PARAMS_V4_ERROR_UNSUPPORTED_FEATURE));
+    }
+
+    {
+        MockClient client;
+        QTRY_VERIFY(client.colorManager);
+        auto *creator = xx_color_manager_v4_new_parametric_creator(client.colorManager);
+        xx_image_description_creator_params_v4_set_primaries(creator, 6400, 3300, 3000, 6000, 1500, 600, 3127, 3290);
+        QTRY_COMPARE(client.error, EPROTO);
+        QCOMPARE(client.protocolError.code, uint(XX_IMAGE_DESCRIPTION_CREATOR_PARAMS_V4_ERROR_UNSUPPORTED_FEATURE));
+    }
+
+    {
+        MockClient client;
+        QTRY_VERIFY(client.colorManager);
+        wl_surface *surface = client.createSurface();
+        xx_color_manager_v4_get_surface(client.colorManager, surface);
+        xx_color_manager_v4_get_surface(client.colorManager, surface);
+        QTRY_COMPARE(client.error, EPROTO);
+    }
+
+    {
+        // Client-made descriptions can't be inspected
+        MockClient client;
+        QTRY_VERIFY(client.colorManager);
+        auto *creator = xx_color_manager_v4_new_parametric_creator(client.colorManager);
+        xx_image_description_creator_params_v4_set_primaries_named(creator, XX_COLOR_MANAGER_V4_PRIMARIES_SRGB);
+        xx_image_description_creator_params_v4_set_tf_named(creator, XX_COLOR_MANAGER_V4_TRANSFER_FUNCTION_SRGB);
+        auto *description = xx_image_description_creator_params_v4_create(creator);
+        xx_image_description_v4_get_information(description);
+        QTRY_COMPARE(client.error, EPROTO);
+    }
+}
+
+void tst_WaylandCompositor::colorManagementPreferred()
+{
+    ColorManagementCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.colorManager);
+    QTRY_VERIFY(!client.m_outputs.isEmpty());
+
+    wl_surface *surface = client.createSurface();
+    auto *feedback = xx_color_manager_v4_get_feedback_surface(client.colorManager, surface);
+    auto *preferred = xx_color_management_feedback_surface_v4_get_preferred(feedback);
+    int identity = 0;
+    xx_image_description_v4_add_listener(preferred, &imageDescriptionListener, &identity);
+    QTRY_VERIFY(identity > 0);
+
+    ImageDescriptionInfo info;
+    auto *information = xx_image_description_v4_get_information(preferred);
+    xx_image_description_info_v4_add_listener(information, &imageDescriptionInfoListener, &info);
+    QTRY_VERIFY(info.done);
+    QCOMPARE(info.primaries, int(XX_COLOR_MANAGER_V4_PRIMARIES_SRGB));
+    QCOMPARE(info.transferFunction, int(XX_COLOR_MANAGER_V4_TRANSFER_FUNCTION_SRGB));
+    QCOMPARE(info.white, QPointF(0.3127, 0.3290));
+
+    auto *output = xx_color_manager_v4_get_output(client.colorManager, client.m_outputs.first());
+    auto *outputDescription = xx_color_management_output_v4_get_image_description(output);
+    int outputIdentity = 0;
+    xx_image_description_v4_add_listener(outputDescription, &imageDescriptionListener, &outputIdentity);
+    QTRY_VERIFY(outputIdentity > 0);
+    QVERIFY(outputIdentity != identity);
+    QCOMPARE(client.error, 0);
+
+    xx_image_description_v4_destroy(outputDescription);
+    xx_color_management_output_v4_destroy(output);
+    xx_image_description_v4_destroy(preferred);
+    xx_color_management_feedback_surface_v4_destroy(feedback);
+    wl_surface_destroy(surface);
+}
+
+class ExplicitSynchronizationCompositor : public TestCompositor
+{
+    Q_OBJECT
+public:
+    ExplicitSynchronizationCompositor() : explicitSynchronization(this) {}
+    QWaylandLinuxExplicitSynchronizationV1 explicitSynchronization;
+};
+
+struct BufferReleaseEvents
+{
+    int fencedReleases = 0;
+    int immediateReleases = 0;
+    int fence = -1;
+};
+
+static const zwp_linux_buffer_release_v1_listener bufferReleaseListener = {
+    [](void *data, zwp_linux_buffer_release_v1 *release, int32_t fence) {
+        auto *events = static_cast<BufferReleaseEvents *>(data);
+        ++events->fencedReleases;
+        events->fence = fence;
+        zwp_linux_buffer_release_v1_destroy(release);
+    },
+    [](void *data, zwp_linux_buffer_release_v1 *release) {
+        ++static_cast<BufferReleaseEvents *>(data)->immediateReleases;
+        zwp_linux_buffer_release_v1_destroy(release);
+    }
+};
+
+// Sync files are readable once signaled, as are eventfds once written to
+static void signalFence(int fd)
+{
+    const uint64_t one = 1;
+    QCOMPARE(write(fd, &one, sizeof(one)), ssize_t(sizeof(one)));
+}
+
+void tst_WaylandCompositor::syncFence()
+{
+    QtWayland::SyncFence invalid;
+    QVERIFY(!invalid.isValid());
+    QVERIFY(invalid.isSignaled());
+
+    QtWayland::SyncFence fence(eventfd(0, EFD_CLOEXEC));
+    QVERIFY(fence.isValid());
+    QVERIFY(!fence.isSyncFile());
+    QVERIFY(!fence.isSignaled());
+    QVERIFY(!fence.wait(10));
+
+    QtWayland::SyncFence duplicate = fence.duplicate();
+    QVERIFY(duplicate.isValid());
+    QVERIFY(duplicate.fd() != fence.fd());
+
+    signalFence(fence.fd());
+    QVERIFY(fence.isSignaled());
+    QVERIFY(duplicate.wait(-1));
+
+    const int fd = fence.fd();
+    QtWayland::SyncFence moved = std::move(fence);
+    QCOMPARE(moved.fd(), fd);
+    QCOMPARE(fence.fd(), -1);
+    QVERIFY(moved.isSignaled());
+
+    // A fence which fails to poll doesn't hold up its waiters
+    int pipeFds[2];
+    QCOMPARE(pipe(pipeFds), 0);
+    QtWayland::SyncFence hungUp(pipeFds[0]);
+    QVERIFY(!hungUp.isSignaled());
+    close(pipeFds[1]);
+    QVERIFY(hungUp.wait(-1));
+}
+
+void tst_WaylandCompositor::explicitSyncRelease()
+{
+    ExplicitSynchronizationCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.explicitSynchronization);
+
+    wl_surface *surface = client.createSurface();
+    auto *synchronization = zwp_linux_explicit_synchronization_v1_get_synchronization(client.explicitSynchronization, surface);
+
+    BufferReleaseEvents firstEvents;
+    ShmBuffer firstBuffer(QSize(16, 16), client.shm);
+    zwp_linux_buffer_release_v1_add_listener(zwp_linux_surface_synchronization_v1_get_release(synchronization),
+                                             &bufferReleaseListener, &firstEvents);
+    wl_surface_attach(surface, firstBuffer.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 16, 16);
+    wl_surface_commit(surface);
+
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    QTRY_VERIFY(waylandSurface->hasContent());
+
+    // Pretend the renderer handed over a fence for its sampling of the buffer
+    const int releaseFence = eventfd(0, EFD_CLOEXEC);
+    struct stat releaseFenceStat;
+    QCOMPARE(fstat(releaseFence, &releaseFenceStat), 0);
+    QWaylandSurfacePrivate::get(waylandSurface)->bufferRef.buffer()->setReleaseFence(QtWayland::SyncFence(releaseFence));
+
+    BufferReleaseEvents secondEvents;
+    ShmBuffer secondBuffer(QSize(16, 16), client.shm);
+    zwp_linux_buffer_release_v1_add_listener(zwp_linux_surface_synchronization_v1_get_release(synchronization),
+                                             &bufferReleaseListener, &secondEvents);
+    wl_surface_attach(surface, secondBuffer.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 16, 16);
+    wl_surface_commit(surface);
+
+    QTRY_COMPARE(firstEvents.fencedReleases, 1);
+    QCOMPARE(firstEvents.immediateReleases, 0);
+    struct stat receivedStat;
+    QCOMPARE(fstat(firstEvents.fence, &receivedStat), 0);
+    QCOMPARE(receivedStat.st_ino, releaseFenceStat.st_ino);
+    close(firstEvents.fence);
+
+    // Without a fence from the renderer, the buffer can be reused right away
+    ShmBuffer thirdBuffer(QSize(16, 16), client.shm);
+    wl_surface_attach(surface, thirdBuffer.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 16, 16);
+    wl_surface_commit(surface);
+
+    QTRY_COMPARE(secondEvents.immediateReleases, 1);
+    QCOMPARE(secondEvents.fencedReleases, 0);
+
+    // A release requested before the synchronization is destroyed is still sent
+    BufferReleaseEvents pendingEvents;
+    zwp_linux_buffer_release_v1_add_listener(zwp_linux_surface_synchronization_v1_get_release(synchronization),
+                                             &bufferReleaseListener, &pendingEvents);
+    zwp_linux_surface_synchronization_v1_destroy(synchronization);
+    QTRY_COMPARE(pendingEvents.immediateReleases, 1);
+
+    // Destroying a buffer still in use also ends its commit
+    synchronization = zwp_linux_explicit_synchronization_v1_get_synchronization(client.explicitSynchronization, surface);
+    BufferReleaseEvents destroyedEvents;
+    auto *destroyedBuffer = new ShmBuffer(QSize(16, 16), client.shm);
+    zwp_linux_buffer_release_v1_add_listener(zwp_linux_surface_synchronization_v1_get_release(synchronization),
+                                             &bufferReleaseListener, &destroyedEvents);
+    wl_surface_attach(surface, destroyedBuffer->handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 16, 16);
+    wl_surface_commit(surface);
+    delete destroyedBuffer;
+    QTRY_COMPARE(destroyedEvents.immediateReleases, 1);
+    QCOMPARE(destroyedEvents.fencedReleases, 0);
+
+    QCOMPARE(client.error, 0);
+    zwp_linux_surface_synchronization_v1_destroy(synchronization);
+    wl_surface_destroy(surface);
+}
+
+void tst_WaylandCompositor::explicitSyncErrors()
+{
+    ExplicitSynchronizationCompositor compositor;
+    compositor.create();
+
+    {
+        // Only sync_files are accepted as fences
+        MockClient client;
+        QTRY_VERIFY(client.explicitSynchronization);
+        wl_surface *surface = client.createSurface();
+        auto *synchronization = zwp_linux_explicit_synchronization_v1_get_synchronization(client.explicitSynchronization, surface);
+        const int fence = eventfd(0, EFD_CLOEXEC);
+        zwp_linux_surface_synchronization_v1_set_acquire_fence(synchronization, fence);
+        close(fence);
+        QTRY_COMPARE(client.error, EPROTO);
+    }
+
+    {
+        MockClient client;
+        QTRY_VERIFY(client.explicitSynchronization);
+        wl_surface *surface = client.createSurface();
+        auto *synchronization = zwp_linux_explicit_synchronization_v1_get_synchronization(client.explicitSynchronization, surface);
+        zwp_linux_surface_synchronization_v1_get_release(synchronization);
+        wl_surface_commit(surface);
+        QTRY_COMPARE(client.error, EPROTO);
+    }
+
+    {
+        MockClient client;
+        QTRY_VERIFY(client.explicitSynchronization);
+        wl_surface *surface = client.createSurface();
+        auto *synchronization = zwp_linux_explicit_synchronization_v1_get_synchronization(client.explicitSynchronization, surface);
+        zwp_linux_surface_synchronization_v1_get_release(synchronization);
+        zwp_linux_surface_synchronization_v1_get_release(synchronization);
+        QTRY_COMPARE(client.error, EPROTO);
+    }
+
+    {
+        MockClient client;
+        QTRY_VERIFY(client.explicitSynchronization);
+        wl_surface *surface = client.createSurface();
+        zwp_linux_explicit_synchronization_v1_get_synchronization(client.explicitSynchronization, surface);
+        zwp_linux_explicit_synchronization_v1_get_synchronization(client.explicitSynchronization, surface);
+        QTRY_COMPARE(client.error, EPROTO);
+    }
+}
+
+void tst_WaylandCompositor::explicitSyncDeferredCommit()
+{
+    ExplicitSynchronizationCompositor compositor;
+    compositor.create();
+    MockClient client;
+
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(waylandSurface);
+
+    ShmBuffer firstBuffer(QSize(16, 16), client.shm);
+    wl_surface_attach(surface, firstBuffer.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 16, 16);
+    client.flushDisplay();
+    QTRY_VERIFY(surfacePrivate->pending.newlyAttached);
+
+    // Only dmabufs take acquire fences, so commit on behalf of the client
+    QtWayland::SyncFence fence(eventfd(0, EFD_CLOEXEC));
+    surfacePrivate->deferCommit(fence.duplicate());
+    QVERIFY(!waylandSurface->hasContent());
+    QVERIFY(!surfacePrivate->pending.newlyAttached);
+
+    // Later commits wait for the earlier ones
+    ShmBuffer secondBuffer(QSize(32, 32), client.shm);
+    wl_surface_attach(surface, secondBuffer.handle, 0, 0);
+    wl_surface_commit(surface);
+    QTRY_COMPARE(surfacePrivate->deferredCommits.size(), size_t(2));
+    QVERIFY(!waylandSurface->hasContent());
+
+    QSignalSpy bufferSizeSpy(waylandSurface, &QWaylandSurface::bufferSizeChanged);
+    signalFence(fence.fd());
+    QTRY_VERIFY(waylandSurface->hasContent());
+    QCOMPARE(surfacePrivate->deferredCommits.size(), size_t(0));
+    QCOMPARE(waylandSurface->bufferSize(), QSize(32, 32));
+    QCOMPARE(bufferSizeSpy.size(), 2);
+
+    // Commits which never got applied go away with the surface
+    QtWayland::SyncFence unsignaled(eventfd(0, EFD_CLOEXEC));
+    surfacePrivate->deferCommit(std::move(unsignaled));
+    QCOMPARE(surfacePrivate->deferredCommits.size(), size_t(1));
+    wl_surface_destroy(surface);
+    QTRY_COMPARE(compositor.surfaces.size(), 0);
+    QCOMPARE(client.error, 0);
+
+    // A client can only queue so many commits behind a fence
+    surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    surfacePrivate = QWaylandSurfacePrivate::get(compositor.surfaces.at(0));
+    QtWayland::SyncFence blocking(eventfd(0, EFD_CLOEXEC));
+    for (size_t i = 0; i < QWaylandSurfacePrivate::MaxDeferredCommits; ++i)
+        surfacePrivate->deferCommit(blocking.duplicate());
+    wl_surface_commit(surface);
+    QTRY_COMPARE(client.error, ENOMEM);
+}
+
+void tst_WaylandCompositor::explicitSyncDeferredSubsurfaceState()
+{
+    ExplicitSynchronizationCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.subcompositor);
+
+    wl_surface *parent = client.createSurface();
+    wl_surface *child = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 2);
+    QWaylandSurface *parentSurface = compositor.surfaces.at(0);
+    QWaylandSurface *childSurface = compositor.surfaces.at(1);
+    auto *parentPrivate = QWaylandSurfacePrivate::get(parentSurface);
+
+    wl_subsurface *subsurface = wl_subcompositor_get_subsurface(client.subcompositor, child, parent);
+    wl_subsurface_set_position(subsurface, 10, 20);
+    wl_subsurface_place_below(subsurface, parent);
+    client.flushDisplay();
+    QTRY_VERIFY(parentPrivate->subsurfaceStackPending);
+
+    QSignalSpy positionSpy(childSurface, &QWaylandSurface::subsurfacePositionChanged);
+    QSignalSpy placeBelowSpy(childSurface, &QWaylandSurface::subsurfacePlaceBelow);
+    using Stack = QList<QWaylandSurfacePrivate *>;
+    const Stack initialStack = { parentPrivate, QWaylandSurfacePrivate::get(childSurface) };
+
+    // The subsurface state of the parent waits for the fence along with the rest
+    QtWayland::SyncFence fence(eventfd(0, EFD_CLOEXEC));
+    parentPrivate->deferCommit(fence.duplicate());
+    QVERIFY(!parentPrivate->subsurfaceStackPending);
+    QVERIFY(parentPrivate->pendingSubsurfacePlacements.isEmpty());
+    QCOMPARE(parentPrivate->subsurfaceStack, initialStack);
+
+    // Requests after it belong to the next commit
+    wl_subsurface_set_position(subsurface, 50, 60);
+    wl_surface_commit(parent);
+    QTRY_COMPARE(parentPrivate->deferredCommits.size(), size_t(2));
+    QCOMPARE(positionSpy.size(), 0);
+    QCOMPARE(placeBelowSpy.size(), 0);
+
+    signalFence(fence.fd());
+    QTRY_COMPARE(positionSpy.size(), 2);
+    QCOMPARE(positionSpy.at(0).at(0).toPoint(), QPoint(10, 20));
+    QCOMPARE(positionSpy.at(1).at(0).toPoint(), QPoint(50, 60));
+    QCOMPARE(placeBelowSpy.size(), 1);
+    const Stack committedStack = { QWaylandSurfacePrivate::get(childSurface), parentPrivate };
+    QCOMPARE(parentPrivate->subsurfaceStack, committedStack);
+    QCOMPARE(parentPrivate->deferredCommits.size(), size_t(0));
+
+    QCOMPARE(client.error, 0);
+    wl_subsurface_destroy(subsurface);
+    wl_surface_destroy(child);
+    wl_surface_destroy(parent);
+}
+
 void tst_WaylandCompositor::xdgOutput()
 {
     XdgOutputCompositor compositor;
@@ -1794,5 +3366,176 @@ void tst_WaylandCompositor::xdgOutput()
     QTRY_COMPARE(xdgOutput->logicalSize, QSize(1000, 1000));
 }
 
+#if QT_CONFIG(opengl)
+void tst_WaylandCompositor::textureMemory()
+{
+    using QtWayland::QWaylandTextureRecycler;
+    QCOMPARE(QWaylandTextureRecycler::textureMemory(QOpenGLTexture::RGBAFormat, QSize(64, 32)), qint64(64 * 32 * 4));
+    QCOMPARE(QWaylandTextureRecycler::textureMemory(QOpenGLTexture::RGBFormat, QSize(64, 32)), qint64(64 * 32 * 4));
+    QCOMPARE(QWaylandTextureRecycler::textureMemory(QOpenGLTexture::R8_UNorm, QSize(64, 32)), qint64(64 * 32));
+    QCOMPARE(QWaylandTextureRecycler::textureMemory(QOpenGLTexture::RG8_UNorm, QSize(32, 16)), qint64(32 * 16 * 2));
+
+    TestCompositor compositor;
+    compositor.create();
+    MockClient client;
+
+    ShmBuffer *buffer = nullptr;
+    wl_surface *surface = createSurfaceWithBuffer(client, QSize(64, 32), &buffer);
+    QVERIFY(surface);
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    QTRY_VERIFY(waylandSurface->hasContent());
+
+    // Nothing is accounted for until a renderer turns the buffer into textures
+    QCOMPARE(QWaylandSurfacePrivate::get(waylandSurface)->textureMemory(), qint64(0));
+    QCOMPARE(QWaylandTextureRecycler::clientMemory(waylandSurface->client()->client()), qint64(0));
+
+    wl_surface_destroy(surface);
+    delete buffer;
+}
+
+void tst_WaylandCompositor::textureRecycling()
+{
+    using QtWayland::QWaylandTextureRecycler;
+
+    QOpenGLContext context;
+    if (!context.create())
+        QSKIP("Cannot create an OpenGL context");
+    QOffscreenSurface offscreen;
+    offscreen.setFormat(context.format());
+    offscreen.create();
+    if (!context.makeCurrent(&offscreen))
+        QSKIP("Cannot make an OpenGL context current");
+
+    QWaylandTextureRecycler *recycler = QWaylandTextureRecycler::current();
+    QVERIFY(recycler);
+    qint64 now = 0;
+    recycler->setClock([&now] { return now; });
+    QWaylandTextureRecycler::Limits limits;
+    limits.maxPooledMemory = 3 * 1024;
+    limits.maxIdleTime = 100;
+    limits.maxDeletionsPerCollect = 1;
+    recycler->setLimits(limits);
+
+    // 16x16 RGBA textures take 1 KiB
+    auto acquire = [&](bool *recycled, const QSize &textureSize = QSize(16, 16)) {
+        return recycler->acquireTexture(QOpenGLTexture::Target2D, QOpenGLTexture::RGBAFormat,
+                                        textureSize, nullptr, QWaylandTextureRecycler::Storage::Owned,
+                                        recycled);
+    };
+
+    // A released texture is handed out again for the same size and format only
+    bool recycled = true;
+    QOpenGLTexture *texture = acquire(&recycled);
+    QVERIFY(texture);
+    QVERIFY(!recycled);
+    QWaylandTextureRecycler::releaseTexture(texture, &context);
+    QCOMPARE(recycler->pooledMemory(), qint64(1024));
+
+    QOpenGLTexture *other = acquire(&recycled, QSize(32, 32));
+    QVERIFY(!recycled);
+    QVERIFY(other != texture);
+    QOpenGLTexture *reused = acquire(&recycled);
+    QVERIFY(recycled);
+    QCOMPARE(reused, texture);
+    QCOMPARE(recycler->pooledMemory(), qint64(0));
+    QWaylandTextureRecycler::releaseTexture(other, &context);
+    QWaylandTextureRecycler::releaseTexture(reused, &context);
+    QCOMPARE(recycler->pooledMemory(), qint64(4 * 1024 + 1024));
+
+    // The pool is trimmed to its limit, starting with the textures released first
+    recycler->collect();
+    QCOMPARE(recycler->pooledMemory(), qint64(1024));
+    QCOMPARE(acquire(&recycled), texture);
+    QVERIFY(recycled);
+
+    limits.maxPooledMemory = 2 * 1024;
+    recycler->setLimits(limits);
+    QOpenGLTexture *textures[3] = { texture, acquire(&recycled), acquire(&recycled) };
+    QVERIFY(!recycled);
+    for (auto *t : textures) {
+        now += 10;
+        QWaylandTextureRecycler::releaseTexture(t, &context);
+    }
+    recycler->collect();
+    QCOMPARE(recycler->pooledMemory(), qint64(2 * 1024));
+
+    // Idle textures go away, one per collect() as limited
+    now += limits.maxIdleTime + 1;
+    recycler->collect();
+    QCOMPARE(recycler->pooledMemory(), qint64(1024));
+    recycler->collect();
+    QCOMPARE(recycler->pooledMemory(), qint64(0));
+
+    context.doneCurrent();
+}
+
+void tst_WaylandCompositor::dmabufFeedback()
+{
+    using namespace QtWayland;
+    const uint32_t xrgb8888 = 0x34325258; // XR24
+    const uint32_t argb8888 = 0x34325241; // AR24
+    const uint32_t nv12 = 0x3231564e; // NV12
+    const uint64_t linear = 0;
+    const uint64_t tiled = 0x0100000000000001; // I915_FORMAT_MOD_X_TILED
+
+    QHash<uint32_t, QList<uint64_t>> modifiers;
+    modifiers[nv12] = { linear };
+    modifiers[xrgb8888] = { tiled, linear };
+    modifiers[argb8888] = { linear };
+
+    DmabufFormatTable table(modifiers);
+    QCOMPARE(table.formats().size(), 4);
+    QCOMPARE(table.size(), uint32_t(4 * 16));
+    QCOMPARE(table.indexOf(nv12, linear), 0);
+    QCOMPARE(table.indexOf(argb8888, linear), 1);
+    QCOMPARE(table.indexOf(xrgb8888, linear), 2);
+    QCOMPARE(table.indexOf(xrgb8888, tiled), 3);
+    QCOMPARE(table.indexOf(nv12, tiled), -1);
+
+    // Clients map the table and read the pairs directly
+    QVERIFY(table.fd() >= 0);
+    void *data = mmap(nullptr, table.size(), PROT_READ, MAP_PRIVATE, table.fd(), 0);
+    QVERIFY(data != MAP_FAILED);
+    const auto *entries = static_cast<const DmabufFormat *>(data);
+    QCOMPARE(entries[0].format, nv12);
+    QCOMPARE(entries[3].format, xrgb8888);
+    QCOMPARE(entries[3].modifier, tiled);
+    munmap(data, table.size());
+
+    const dev_t renderDevice = makedev(226, 128);
+    const dev_t scanoutDevice = makedev(226, 0);
+
+    const DmabufFeedback defaultFeedback = DmabufFeedback::defaultFeedback(table, renderDevice);
+    QCOMPARE(defaultFeedback.mainDevice, renderDevice);
+    QCOMPARE(defaultFeedback.tranches.size(), 1);
+    QCOMPARE(defaultFeedback.tranches[0].targetDevice, renderDevice);
+    QCOMPARE(defaultFeedback.tranches[0].indices, QList<uint16_t>({ 0, 1, 2, 3 }));
+    QVERIFY(!defaultFeedback.tranches[0].scanout);
+
+    // Scanout pairs the renderer cannot import are left out
+    QHash<uint32_t, QList<uint64_t>> scanoutFormats;
+    scanoutFormats[xrgb8888] = { tiled, linear };
+    scanoutFormats[nv12] = { tiled };
+    const DmabufFeedback scanoutFeedback = DmabufFeedback::scanoutFeedback(table, renderDevice, scanoutDevice,
+                                                                           scanoutFormats);
+    QCOMPARE(scanoutFeedback.mainDevice, renderDevice);
+    QCOMPARE(scanoutFeedback.tranches.size(), 2);
+    QCOMPARE(scanoutFeedback.tranches[0].targetDevice, scanoutDevice);
+    QCOMPARE(scanoutFeedback.tranches[0].indices, QList<uint16_t>({ 2, 3 }));
+    QVERIFY(scanoutFeedback.tranches[0].scanout);
+    QCOMPARE(scanoutFeedback.tranches[1], defaultFeedback.tranches[0]);
+    QCOMPARE(DmabufFeedback::indexArray(scanoutFeedback.tranches[0].indices).size(), 2 * 2);
+
+    scanoutFormats.clear();
+    scanoutFormats[nv12] = { tiled };
+    QVERIFY(DmabufFeedback::scanoutFeedback(table, renderDevice, scanoutDevice, scanoutFormats) == defaultFeedback);
+
+    const QByteArray device = DmabufFeedback::deviceArray(renderDevice);
+    QCOMPARE(device.size(), qsizetype(sizeof(dev_t)));
+    QCOMPARE(*reinterpret_cast<const dev_t *>(device.constData()), renderDevice);
+}
+#endif
+
 #include <tst_compositor.moc>
 QTEST_MAIN(tst_WaylandCompositor);
@@ -0,0 +1,109 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtWaylandClient/private/qwaylandshmbackingstore_p.h>
+
+#include <QtGui/QPainter>
+#include <QtTest/QtTest>
+
+using namespace QtWaylandClient;
+
+// Compares the copy of the damage between back buffers in QWaylandShmBackingStore against
+// drawing them with QPainter, which is what the backing store used to do
+class tst_bench_shmcopy : public QObject
+{
+    Q_OBJECT
+private slots:
+    void copy_data();
+    void copy();
+    void painter_data();
+    void painter();
+
+private:
+    void addRows();
+    static QImage makeImage(const QSize &size, qreal dpr, QImage::Format format, uchar fill);
+};
+
+void tst_bench_shmcopy::addRows()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<qreal>("dpr");
+    QTest::addColumn<QImage::Format>("format");
+    QTest::addColumn<QRegion>("region");
+
+    const QSize fullHd(1920, 1080);
+    QRegion smallRects;
+    for (int i = 0; i < 64; ++i)
+        smallRects += QRect((i % 8) * 230, (i / 8) * 130, 32, 32);
+
+    QTest::newRow("full, 1080p") << fullHd << 1.0 << QImage::Format_ARGB32_Premultiplied
+                                 << QRegion(QRect(QPoint(), fullHd));
+    QTest::newRow("full, 1080p@2x") << fullHd << 2.0 << QImage::Format_ARGB32_Premultiplied
+                                    << QRegion(QRect(QPoint(), fullHd));
+    QTest::newRow("half width, 1080p") << fullHd << 1.0 << QImage::Format_ARGB32_Premultiplied
+                                       << QRegion(QRect(0, 0, 960, 1080));
+    QTest::newRow("64 rects, 1080p") << fullHd << 1.0 << QImage::Format_ARGB32_Premultiplied
+                                     << smallRects;
+    QTest::newRow("full, 1080p, RGB32") << fullHd << 1.0 << QImage::Format_RGB32
+                                        << QRegion(QRect(QPoint(), fullHd));
+}
+
+QImage tst_bench_shmcopy::makeImage(const QSize &size, qreal dpr, QImage::Format format, uchar fill)
+{
+    QImage image(size * dpr, format);
+    image.setDevicePixelRatio(dpr);
+    image.fill(fill);
+    return image;
+}
+
+void tst_bench_shmcopy::copy_data()
+{
+    addRows();
+}
+
+void tst_bench_shmcopy::copy()
+{
+    QFETCH(QSize, size);
+    QFETCH(qreal, dpr);
+    QFETCH(QImage::Format, format);
+    QFETCH(QRegion, region);
+
+    // The region is in the logical coordinates of images which are scaled by dpr
+    const QImage source = makeImage(size / dpr, dpr, format, 0x7f);
+    QImage target = makeImage(size / dpr, dpr, format, 0);
+
+    QBENCHMARK {
+        copyImageRegion(&target, source, region.intersected(QRect(QPoint(), size / dpr)));
+    }
+    QCOMPARE(target.pixel(0, 0), source.pixel(0, 0));
+}
+
+void tst_bench_shmcopy::painter_data()
+{
+    addRows();
+}
+
+void tst_bench_shmcopy::painter()
+{
+    QFETCH(QSize, size);
+    QFETCH(qreal, dpr);
+    QFETCH(QImage::Format, format);
+    QFETCH(QRegion, region);
+
+    const QImage source = makeImage(size / dpr, dpr, format, 0x7f);
+    QImage target = makeImage(size / dpr, dpr, format, 0);
+    const QRegion clipped = region.intersected(QRect(QPoint(), size / dpr));
+
+    QBENCHMARK {
+        QPainter painter(&target);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        for (const QRect &rect : clipped) {
+            const QRectF sourceRect(QPointF(rect.topLeft()) * dpr, QSizeF(rect.size()) * dpr);
+            painter.drawImage(rect, source, sourceRect);
+        }
+    }
+    QCOMPARE(target.pixel(0, 0), source.pixel(0, 0));
+}
+
+QTEST_MAIN(tst_bench_shmcopy)
+#include "tst_bench_shmcopy.moc"
@@ -0,0 +1,588 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "loadclient.h"
+
+#include "wayland-wayland-client-protocol.h"
+#include "wayland-xdg-shell-client-protocol.h"
+#include "wayland-ivi-application-client-protocol.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QThread>
+#include <QtCore/QVarLengthArray>
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+static qint64 now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void LoadStats::merge(const LoadStats &other)
+{
+    frameLatency += other.frameLatency;
+    releaseLatency += other.releaseLatency;
+    commits += other.commits;
+    skippedCommits += other.skippedCommits;
+    if (error.isEmpty())
+        error = other.error;
+}
+
+QByteArray LoadStats::serialize() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << frameLatency << releaseLatency << commits << skippedCommits << error;
+    return data;
+}
+
+LoadStats LoadStats::deserialize(const QByteArray &data)
+{
+    LoadStats stats;
+    QDataStream stream(data);
+    stream >> stats.frameLatency >> stats.releaseLatency >> stats.commits >> stats.skippedCommits
+            >> stats.error;
+    if (stream.status() != QDataStream::Ok)
+        stats.error = QStringLiteral("Could not read the results of the client");
+    return stats;
+}
+
+const wl_registry_listener LoadClient::registryListener = {
+    LoadClient::handleGlobal,
+    LoadClient::handleGlobalRemove
+};
+
+const xdg_wm_base_listener LoadClient::wmBaseListener = {
+    LoadClient::handlePing
+};
+
+const xdg_surface_listener LoadClient::xdgSurfaceListener = {
+    LoadClient::handleXdgSurfaceConfigure
+};
+
+const xdg_toplevel_listener LoadClient::toplevelListener = {
+    LoadClient::handleToplevelConfigure,
+    LoadClient::handleToplevelClose,
+    [](void *, xdg_toplevel *, int32_t, int32_t) {},
+    [](void *, xdg_toplevel *, wl_array *) {}
+};
+
+const ivi_surface_listener LoadClient::iviSurfaceListener = {
+    LoadClient::handleIviConfigure
+};
+
+const wl_buffer_listener LoadClient::bufferListener = {
+    LoadClient::handleBufferRelease
+};
+
+const wl_callback_listener LoadClient::frameListener = {
+    LoadClient::handleFrameDone
+};
+
+const wl_seat_listener LoadClient::seatListener = {
+    LoadClient::handleSeatCapabilities,
+    LoadClient::handleSeatName
+};
+
+// Input is only received to keep the connection flowing, pointer enters are remembered for
+// setting the cursor
+const wl_pointer_listener LoadClient::pointerListener = {
+    LoadClient::handlePointerEnter,
+    [](void *, wl_pointer *, uint32_t, wl_surface *) {},
+    [](void *, wl_pointer *, uint32_t, wl_fixed_t, wl_fixed_t) {},
+    [](void *, wl_pointer *, uint32_t, uint32_t, uint32_t, uint32_t) {},
+    [](void *, wl_pointer *, uint32_t, uint32_t, wl_fixed_t) {},
+    [](void *, wl_pointer *) {},
+    [](void *, wl_pointer *, uint32_t) {},
+    [](void *, wl_pointer *, uint32_t, uint32_t) {},
+    [](void *, wl_pointer *, uint32_t, int32_t) {}
+};
+
+const wl_keyboard_listener LoadClient::keyboardListener = {
+    LoadClient::handleKeymap,
+    [](void *, wl_keyboard *, uint32_t, wl_surface *, wl_array *) {},
+    [](void *, wl_keyboard *, uint32_t, wl_surface *) {},
+    [](void *, wl_keyboard *, uint32_t, uint32_t, uint32_t, uint32_t) {},
+    [](void *, wl_keyboard *, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t) {},
+    [](void *, wl_keyboard *, int32_t, int32_t) {}
+};
+
+LoadClient::LoadClient(const LoadOptions &options, int index)
+    : m_options(options)
+    , m_index(index)
+{
+}
+
+LoadClient::~LoadClient()
+{
+    if (!m_display)
+        return;
+
+    destroySurface(&m_cursor);
+    for (auto it = m_surfaces.rbegin(); it != m_surfaces.rend(); ++it)
+        destroySurface(&*it);
+    if (m_toplevel)
+        xdg_toplevel_destroy(m_toplevel);
+    if (m_xdgSurface)
+        xdg_surface_destroy(m_xdgSurface);
+    if (m_iviSurface)
+        ivi_surface_destroy(m_iviSurface);
+    if (m_pointer)
+        wl_pointer_destroy(m_pointer);
+    if (m_keyboard)
+        wl_keyboard_destroy(m_keyboard);
+    if (m_seat)
+        wl_seat_destroy(m_seat);
+    if (m_wmBase)
+        xdg_wm_base_destroy(m_wmBase);
+    if (m_iviApplication)
+        ivi_application_destroy(m_iviApplication);
+    if (m_shm)
+        wl_shm_destroy(m_shm);
+    if (m_subcompositor)
+        wl_subcompositor_destroy(m_subcompositor);
+    if (m_compositor)
+        wl_compositor_destroy(m_compositor);
+    wl_registry_destroy(m_registry);
+    wl_display_disconnect(m_display);
+}
+
+LoadStats LoadClient::run()
+{
+    if (!connect())
+        return m_stats;
+
+    const qint64 start = now();
+    const qint64 end = start + qint64(m_options.duration) * 1000;
+    const qint64 commitInterval = m_options.commitRate > 0 ? qint64(1000000 / m_options.commitRate) : 0;
+    const qint64 cursorInterval = m_options.cursorRate > 0 ? qint64(1000000 / m_options.cursorRate) : 0;
+    qint64 nextCommit = start;
+    qint64 nextCursor = start;
+
+    for (qint64 time = start; time < end; time = now()) {
+        if (m_options.stallAfter >= 0 && time - start >= qint64(m_options.stallAfter) * 1000) {
+            // Hold the connection without reading, events pile up in the compositor
+            QThread::usleep((unsigned long)(end - time));
+            break;
+        }
+
+        const bool throttled = !commitInterval;
+        if (throttled ? m_pendingFrames == 0 : time >= nextCommit) {
+            if (!commitFrame(time))
+                break;
+            nextCommit = qMax(nextCommit + commitInterval, time);
+        }
+        if (cursorInterval && time >= nextCursor) {
+            updateCursor();
+            nextCursor = qMax(nextCursor + cursorInterval, time);
+        }
+
+        qint64 wakeUp = end;
+        if (!throttled)
+            wakeUp = qMin(wakeUp, nextCommit);
+        if (cursorInterval)
+            wakeUp = qMin(wakeUp, nextCursor);
+        const int timeout = int(qMax<qint64>(wakeUp - now(), 0) / 1000);
+
+        if (m_options.readDelay > 0)
+            QThread::msleep(m_options.readDelay);
+        if (!dispatch(timeout))
+            break;
+    }
+
+    return m_stats;
+}
+
+bool LoadClient::connect()
+{
+    m_display = wl_display_connect(nullptr);
+    if (!m_display) {
+        m_stats.error = QStringLiteral("Could not connect: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    m_registry = wl_display_get_registry(m_display);
+    wl_registry_add_listener(m_registry, &registryListener, this);
+    if (wl_display_roundtrip(m_display) < 0 || !m_compositor || !m_shm) {
+        m_stats.error = QStringLiteral("The compositor lacks wl_compositor or wl_shm");
+        return false;
+    }
+    if (!m_wmBase && !m_iviApplication) {
+        m_stats.error = QStringLiteral("The compositor lacks xdg_wm_base and ivi_application");
+        return false;
+    }
+    if (m_options.subsurfaces > 0 && !m_subcompositor) {
+        m_stats.error = QStringLiteral("The compositor lacks wl_subcompositor");
+        return false;
+    }
+
+    m_surfaces.resize(1 + m_options.subsurfaces);
+    Surface *toplevel = &m_surfaces.front();
+    if (!createSurface(toplevel, m_options.bufferSize, m_options.bufferCount))
+        return false;
+
+    if (m_wmBase) {
+        m_xdgSurface = xdg_wm_base_get_xdg_surface(m_wmBase, toplevel->surface);
+        xdg_surface_add_listener(m_xdgSurface, &xdgSurfaceListener, this);
+        m_toplevel = xdg_surface_get_toplevel(m_xdgSurface);
+        xdg_toplevel_add_listener(m_toplevel, &toplevelListener, this);
+        xdg_toplevel_set_title(m_toplevel, QByteArray("loadgen " + QByteArray::number(m_index)).constData());
+        wl_surface_commit(toplevel->surface);
+    } else {
+        // ivi_id 0 is reserved by some compositors
+        m_iviSurface = ivi_application_surface_create(m_iviApplication, uint32_t(m_index + 1),
+                                                      toplevel->surface);
+        ivi_surface_add_listener(m_iviSurface, &iviSurfaceListener, this);
+        m_configured = true;
+    }
+
+    // Subsurfaces form chains of subsurfaceDepth nested surfaces, each starting at the toplevel
+    const QSize subsurfaceSize = (m_options.bufferSize / 2).expandedTo(QSize(1, 1));
+    const int depth = qMax(m_options.subsurfaceDepth, 1);
+    for (int i = 1; i < int(m_surfaces.size()); ++i) {
+        Surface *surface = &m_surfaces[i];
+        if (!createSurface(surface, subsurfaceSize, m_options.bufferCount))
+            return false;
+        Surface *parent = (i - 1) % depth == 0 ? toplevel : &m_surfaces[i - 1];
+        surface->subsurface = wl_subcompositor_get_subsurface(m_subcompositor, surface->surface,
+                                                              parent->surface);
+    }
+
+    if (m_options.cursorRate > 0 && !createSurface(&m_cursor, QSize(24, 24), 2))
+        return false;
+
+    while (!m_configured) {
+        if (wl_display_dispatch(m_display) < 0) {
+            m_stats.error = QStringLiteral("Disconnected before the first configure");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LoadClient::createSurface(Surface *surface, const QSize &size, int bufferCount)
+{
+    const int alignment = qMax(m_options.strideAlignment, 4);
+    surface->size = size;
+    surface->stride = (size.width() * 4 + alignment - 1) / alignment * alignment;
+    const size_t bufferSize = size_t(surface->stride) * size.height();
+    surface->memorySize = bufferSize * bufferCount;
+
+    const int fd = memfd_create("qtwayland-loadgen", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, off_t(surface->memorySize)) < 0) {
+        m_stats.error = QStringLiteral("Could not create buffers: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    void *memory = mmap(nullptr, surface->memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        m_stats.error = QStringLiteral("Could not map buffers: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        close(fd);
+        return false;
+    }
+    surface->memory = static_cast<uchar *>(memory);
+    surface->pool = wl_shm_create_pool(m_shm, fd, int32_t(surface->memorySize));
+    close(fd);
+
+    // Buffers are referred to by their listeners, so the vector must not grow after this
+    surface->buffers.resize(bufferCount);
+    for (int i = 0; i < bufferCount; ++i) {
+        Buffer &buffer = surface->buffers[i];
+        buffer.client = this;
+        buffer.data = surface->memory + bufferSize * i;
+        buffer.buffer = wl_shm_pool_create_buffer(surface->pool, int32_t(bufferSize * i),
+                                                  size.width(), size.height(), surface->stride,
+                                                  WL_SHM_FORMAT_ARGB8888);
+        wl_buffer_add_listener(buffer.buffer, &bufferListener, &buffer);
+    }
+
+    surface->surface = wl_compositor_create_surface(m_compositor);
+    return true;
+}
+
+void LoadClient::destroySurface(Surface *surface)
+{
+    if (surface->subsurface)
+        wl_subsurface_destroy(surface->subsurface);
+    if (surface->surface)
+        wl_surface_destroy(surface->surface);
+    for (Buffer &buffer : surface->buffers)
+        wl_buffer_destroy(buffer.buffer);
+    if (surface->pool)
+        wl_shm_pool_destroy(surface->pool);
+    if (surface->memory)
+        munmap(surface->memory, surface->memorySize);
+    *surface = Surface();
+}
+
+LoadClient::Buffer *LoadClient::acquireBuffer(Surface *surface)
+{
+    const int count = int(surface->buffers.size());
+    for (int i = 0; i < count; ++i) {
+        Buffer *buffer = &surface->buffers[(surface->nextBuffer + i) % count];
+        if (!buffer->busy || m_options.ignoreRelease) {
+            surface->nextBuffer = (surface->nextBuffer + i + 1) % count;
+            return buffer;
+        }
+    }
+    return nullptr;
+}
+
+QList<QRect> LoadClient::damage(const Surface &surface) const
+{
+    const QRect bounds(QPoint(), surface.size);
+    switch (m_options.damage) {
+    case LoadOptions::FullDamage:
+        return { bounds };
+    case LoadOptions::BandDamage: {
+        const int height = qMax(surface.size.height() / 8, 1);
+        return { QRect(0, (m_frame * height) % surface.size.height(), surface.size.width(), height) & bounds };
+    }
+    case LoadOptions::ScatteredDamage: {
+        // The same pseudo random rects for every client and frame number, so runs compare
+        QList<QRect> rects;
+        QRandomGenerator random(quint32(m_frame));
+        for (int i = 0; i < 16; ++i) {
+            const QPoint position(random.bounded(qMax(surface.size.width(), 1)),
+                                  random.bounded(qMax(surface.size.height(), 1)));
+            rects.append(QRect(position, QSize(16, 16)) & bounds);
+        }
+        return rects;
+    }
+    case LoadOptions::NoDamage:
+        break;
+    }
+    return {};
+}
+
+bool LoadClient::commitFrame(qint64 time)
+{
+    // Buffers are acquired up front, a frame is either committed by all surfaces or skipped
+    QVarLengthArray<Buffer *, 16> buffers;
+    for (Surface &surface : m_surfaces) {
+        Buffer *buffer = acquireBuffer(&surface);
+        if (!buffer) {
+            ++m_stats.skippedCommits;
+            return true;
+        }
+        buffers.append(buffer);
+    }
+
+    const uchar value = uchar(m_frame * 7 + m_index * 31);
+    // Children are committed first, so their state is cached when their parents commit
+    for (int i = int(m_surfaces.size()) - 1; i >= 0; --i) {
+        Surface &surface = m_surfaces[i];
+        Buffer *buffer = buffers[i];
+        for (const QRect &rect : damage(surface)) {
+            uchar *row = buffer->data + rect.y() * surface.stride + rect.x() * 4;
+            for (int y = 0; y < rect.height(); ++y, row += surface.stride)
+                memset(row, value, size_t(rect.width()) * 4);
+            wl_surface_damage_buffer(surface.surface, rect.x(), rect.y(), rect.width(), rect.height());
+        }
+        if (surface.subsurface) {
+            const int offset = (m_frame + i) % 16;
+            wl_subsurface_set_position(surface.subsurface, offset, offset);
+        }
+        wl_surface_attach(surface.surface, buffer->buffer, 0, 0);
+        buffer->busy = true;
+        buffer->commitTime = time;
+        if (i == 0) {
+            wl_callback *callback = wl_surface_frame(surface.surface);
+            wl_callback_add_listener(callback, &frameListener, new FrameRequest{ this, time });
+            ++m_pendingFrames;
+        }
+        wl_surface_commit(surface.surface);
+    }
+
+    ++m_frame;
+    ++m_stats.commits;
+    return true;
+}
+
+void LoadClient::updateCursor()
+{
+    if (!m_pointer || !m_enterSerial)
+        return;
+
+    Buffer *buffer = acquireBuffer(&m_cursor);
+    if (!buffer)
+        return;
+    memset(buffer->data, (m_cursorFrame & 1) ? 0xff : 0x80, size_t(m_cursor.stride) * m_cursor.size.height());
+    buffer->busy = true;
+    buffer->commitTime = 0;
+    wl_surface_attach(m_cursor.surface, buffer->buffer, 0, 0);
+    wl_surface_damage_buffer(m_cursor.surface, 0, 0, m_cursor.size.width(), m_cursor.size.height());
+    wl_surface_commit(m_cursor.surface);
+    // Moving the hotspot makes the compositor update the cursor every time
+    const int hotspot = m_cursorFrame++ % 8;
+    wl_pointer_set_cursor(m_pointer, m_enterSerial, m_cursor.surface, hotspot, hotspot);
+}
+
+bool LoadClient::dispatch(int timeout)
+{
+    while (wl_display_prepare_read(m_display) != 0)
+        wl_display_dispatch_pending(m_display);
+
+    if (wl_display_flush(m_display) < 0 && errno != EAGAIN) {
+        wl_display_cancel_read(m_display);
+        m_stats.error = QStringLiteral("Disconnected: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    pollfd pfd = { wl_display_get_fd(m_display), POLLIN, 0 };
+    if (poll(&pfd, 1, timeout) > 0 && (pfd.revents & POLLIN)) {
+        if (wl_display_read_events(m_display) < 0) {
+            m_stats.error = QStringLiteral("Disconnected: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+            return false;
+        }
+    } else {
+        wl_display_cancel_read(m_display);
+    }
+
+    if (wl_display_dispatch_pending(m_display) < 0) {
+        m_stats.error = QStringLiteral("Protocol error: %1").arg(wl_display_get_error(m_display));
+        return false;
+    }
+    return true;
+}
+
+void LoadClient::handleGlobal(void *data, wl_registry *registry, uint32_t id,
+                              const char *interface, uint32_t version)
+{
+    auto *client = static_cast<LoadClient *>(data);
+    if (!strcmp(interface, wl_compositor_interface.name)) {
+        client->m_compositor = static_cast<wl_compositor *>(
+                wl_registry_bind(registry, id, &wl_compositor_interface, qMin(version, 4u)));
+    } else if (!strcmp(interface, wl_subcompositor_interface.name)) {
+        client->m_subcompositor = static_cast<wl_subcompositor *>(
+                wl_registry_bind(registry, id, &wl_subcompositor_interface, 1));
+    } else if (!strcmp(interface, wl_shm_interface.name)) {
+        client->m_shm = static_cast<wl_shm *>(wl_registry_bind(registry, id, &wl_shm_interface, 1));
+    } else if (!strcmp(interface, xdg_wm_base_interface.name)) {
+        client->m_wmBase = static_cast<xdg_wm_base *>(
+                wl_registry_bind(registry, id, &xdg_wm_base_interface, 1));
+        xdg_wm_base_add_listener(client->m_wmBase, &wmBaseListener, client);
+    } else if (!strcmp(interface, ivi_application_interface.name)) {
+        client->m_iviApplication = static_cast<ivi_application *>(
+                wl_registry_bind(registry, id, &ivi_application_interface, 1));
+    } else if (!strcmp(interface, wl_seat_interface.name) && !client->m_seat) {
+        client->m_seat = static_cast<wl_seat *>(
+                wl_registry_bind(registry, id, &wl_seat_interface, qMin(version, 5u)));
+        wl_seat_add_listener(client->m_seat, &seatListener, client);
+    }
+}
+
+void LoadClient::handleGlobalRemove(void *data, wl_registry *registry, uint32_t id)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(registry);
+    Q_UNUSED(id);
+}
+
+void LoadClient::handlePing(void *data, xdg_wm_base *wmBase, uint32_t serial)
+{
+    Q_UNUSED(data);
+    xdg_wm_base_pong(wmBase, serial);
+}
+
+void LoadClient::handleXdgSurfaceConfigure(void *data, xdg_surface *xdgSurface, uint32_t serial)
+{
+    xdg_surface_ack_configure(xdgSurface, serial);
+    static_cast<LoadClient *>(data)->m_configured = true;
+}
+
+void LoadClient::handleToplevelConfigure(void *data, xdg_toplevel *toplevel, int32_t width,
+                                         int32_t height, wl_array *states)
+{
+    // Buffers keep their size, resizing is not what is measured
+    Q_UNUSED(data);
+    Q_UNUSED(toplevel);
+    Q_UNUSED(width);
+    Q_UNUSED(height);
+    Q_UNUSED(states);
+}
+
+void LoadClient::handleToplevelClose(void *data, xdg_toplevel *toplevel)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(toplevel);
+}
+
+void LoadClient::handleIviConfigure(void *data, ivi_surface *iviSurface, int32_t width,
+                                    int32_t height)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(iviSurface);
+    Q_UNUSED(width);
+    Q_UNUSED(height);
+}
+
+void LoadClient::handleBufferRelease(void *data, wl_buffer *buffer)
+{
+    Q_UNUSED(buffer);
+    auto *released = static_cast<Buffer *>(data);
+    released->busy = false;
+    if (released->commitTime) {
+        released->client->m_stats.releaseLatency.append(now() - released->commitTime);
+        released->commitTime = 0;
+    }
+}
+
+void LoadClient::handleFrameDone(void *data, wl_callback *callback, uint32_t time)
+{
+    Q_UNUSED(time);
+    auto *request = static_cast<FrameRequest *>(data);
+    request->client->m_stats.frameLatency.append(now() - request->commitTime);
+    --request->client->m_pendingFrames;
+    delete request;
+    wl_callback_destroy(callback);
+}
+
+void LoadClient::handleSeatCapabilities(void *data, wl_seat *seat, uint32_t capabilities)
+{
+    auto *client = static_cast<LoadClient *>(data);
+    if ((capabilities & WL_SEAT_CAPABILITY_POINTER) && !client->m_pointer) {
+        client->m_pointer = wl_seat_get_pointer(seat);
+        wl_pointer_add_listener(client->m_pointer, &pointerListener, client);
+    }
+    if ((capabilities & WL_SEAT_CAPABILITY_KEYBOARD) && !client->m_keyboard) {
+        client->m_keyboard = wl_seat_get_keyboard(seat);
+        wl_keyboard_add_listener(client->m_keyboard, &keyboardListener, client);
+    }
+}
+
+void LoadClient::handleSeatName(void *data, wl_seat *seat, const char *name)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(seat);
+    Q_UNUSED(name);
+}
+
+void LoadClient::handlePointerEnter(void *data, wl_pointer *pointer, uint32_t serial,
+                                    wl_surface *surface, int32_t x, int32_t y)
+{
+    Q_UNUSED(pointer);
+    Q_UNUSED(surface);
+    Q_UNUSED(x);
+    Q_UNUSED(y);
+    static_cast<LoadClient *>(data)->m_enterSerial = serial;
+}
+
+void LoadClient::handleKeymap(void *data, wl_keyboard *keyboard, uint32_t format, int32_t fd,
+                              uint32_t size)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(keyboard);
+    Q_UNUSED(format);
+    Q_UNUSED(size);
+    close(fd);
+}
@@ -0,0 +1,189 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef LOADCLIENT_H
+#define LOADCLIENT_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QRect>
+#include <QtCore/QSize>
+#include <QtCore/QString>
+
+#include <vector>
+
+struct wl_buffer;
+struct wl_callback;
+struct wl_compositor;
+struct wl_display;
+struct wl_keyboard;
+struct wl_pointer;
+struct wl_registry;
+struct wl_seat;
+struct wl_shm;
+struct wl_shm_pool;
+struct wl_subcompositor;
+struct wl_subsurface;
+struct wl_surface;
+struct xdg_wm_base;
+struct xdg_surface;
+struct xdg_toplevel;
+struct ivi_application;
+struct ivi_surface;
+struct wl_registry_listener;
+struct wl_buffer_listener;
+struct wl_callback_listener;
+struct wl_seat_listener;
+struct wl_pointer_listener;
+struct wl_keyboard_listener;
+struct xdg_wm_base_listener;
+struct xdg_surface_listener;
+struct xdg_toplevel_listener;
+struct ivi_surface_listener;
+
+struct LoadOptions
+{
+    enum DamagePattern {
+        FullDamage,
+        BandDamage,
+        ScatteredDamage,
+        NoDamage
+    };
+
+    QSize bufferSize = QSize(256, 256);
+    int strideAlignment = 4;
+    int bufferCount = 2;
+    // Commits per second, 0 commits whenever the previous frame callback is done
+    double commitRate = 0;
+    DamagePattern damage = FullDamage;
+    int subsurfaces = 0;
+    // Length of the chains of nested subsurfaces hanging off the toplevel
+    int subsurfaceDepth = 1;
+    double cursorRate = 0;
+    int readDelay = 0;
+    bool ignoreRelease = false;
+    int stallAfter = -1;
+    int duration = 10000;
+};
+
+struct LoadStats
+{
+    // Microseconds from the commit to the frame callback and to the release of its buffer
+    QList<qint64> frameLatency;
+    QList<qint64> releaseLatency;
+    qint64 commits = 0;
+    qint64 skippedCommits = 0;
+    QString error;
+
+    void merge(const LoadStats &other);
+    QByteArray serialize() const;
+    static LoadStats deserialize(const QByteArray &data);
+};
+
+// A raw libwayland client committing frames by the given options until the duration elapses
+class LoadClient
+{
+public:
+    LoadClient(const LoadOptions &options, int index);
+    ~LoadClient();
+
+    LoadStats run();
+
+private:
+    struct Buffer
+    {
+        LoadClient *client = nullptr;
+        wl_buffer *buffer = nullptr;
+        uchar *data = nullptr;
+        bool busy = false;
+        qint64 commitTime = 0;
+    };
+
+    struct Surface
+    {
+        wl_surface *surface = nullptr;
+        wl_subsurface *subsurface = nullptr;
+        QSize size;
+        int stride = 0;
+        wl_shm_pool *pool = nullptr;
+        uchar *memory = nullptr;
+        size_t memorySize = 0;
+        std::vector<Buffer> buffers;
+        int nextBuffer = 0;
+    };
+
+    struct FrameRequest
+    {
+        LoadClient *client;
+        qint64 commitTime;
+    };
+
+    bool connect();
+    bool createSurface(Surface *surface, const QSize &size, int bufferCount);
+    void destroySurface(Surface *surface);
+    bool commitFrame(qint64 time);
+    Buffer *acquireBuffer(Surface *surface);
+    QList<QRect> damage(const Surface &surface) const;
+    void updateCursor();
+    bool dispatch(int timeout);
+
+    static const wl_registry_listener registryListener;
+    static const xdg_wm_base_listener wmBaseListener;
+    static const xdg_surface_listener xdgSurfaceListener;
+    static const xdg_toplevel_listener toplevelListener;
+    static const ivi_surface_listener iviSurfaceListener;
+    static const wl_buffer_listener bufferListener;
+    static const wl_callback_listener frameListener;
+    static const wl_seat_listener seatListener;
+    static const wl_pointer_listener pointerListener;
+    static const wl_keyboard_listener keyboardListener;
+
+    static void handleGlobal(void *data, wl_registry *registry, uint32_t id,
+                             const char *interface, uint32_t version);
+    static void handleGlobalRemove(void *data, wl_registry *registry, uint32_t id);
+    static void handlePing(void *data, xdg_wm_base *wmBase, uint32_t serial);
+    static void handleXdgSurfaceConfigure(void *data, xdg_surface *xdgSurface, uint32_t serial);
+    static void handleToplevelConfigure(void *data, xdg_toplevel *toplevel, int32_t width,
+                                        int32_t height, struct wl_array *states);
+    static void handleToplevelClose(void *data, xdg_toplevel *toplevel);
+    static void handleIviConfigure(void *data, ivi_surface *iviSurface, int32_t width,
+                                   int32_t height);
+    static void handleBufferRelease(void *data, wl_buffer *buffer);
+    static void handleFrameDone(void *data, wl_callback *callback, uint32_t time);
+    static void handleSeatCapabilities(void *data, wl_seat *seat, uint32_t capabilities);
+    static void handleSeatName(void *data, wl_seat *seat, const char *name);
+    static void handlePointerEnter(void *data, wl_pointer *pointer, uint32_t serial,
+                                   wl_surface *surface, int32_t x, int32_t y);
+    static void handleKeymap(void *data, wl_keyboard *keyboard, uint32_t format, int32_t fd,
+                             uint32_t size);
+
+    const LoadOptions m_options;
+    const int m_index;
+    LoadStats m_stats;
+
+    wl_display *m_display = nullptr;
+    wl_registry *m_registry = nullptr;
+    wl_compositor *m_compositor = nullptr;
+    wl_subcompositor *m_subcompositor = nullptr;
+    wl_shm *m_shm = nullptr;
+    xdg_wm_base *m_wmBase = nullptr;
+    ivi_application *m_iviApplication = nullptr;
+    wl_seat *m_seat = nullptr;
+    wl_pointer *m_pointer = nullptr;
+    wl_keyboard *m_keyboard = nullptr;
+
+    xdg_surface *m_xdgSurface = nullptr;
+    xdg_toplevel *m_toplevel = nullptr;
+    ivi_surface *m_iviSurface = nullptr;
+    bool m_configured = false;
+
+    // The toplevel comes first, followed by its subsurfaces with parents before children
+    std::vector<Surface> m_surfaces;
+    Surface m_cursor;
+    uint32_t m_enterSerial = 0;
+    int m_cursorFrame = 0;
+    int m_frame = 0;
+    int m_pendingFrames = 0;
+};
+
+#endif // LOADCLIENT_H
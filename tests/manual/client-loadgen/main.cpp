@@ -0,0 +1,201 @@
+// Copyright (C) 2026 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "loadclient.h"
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <memory>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static LoadStats runForked(const LoadOptions &options, int clientCount)
+{
+    struct Child
+    {
+        pid_t pid;
+        int fd;
+    };
+    QList<Child> children;
+    LoadStats stats;
+
+    for (int i = 0; i < clientCount; ++i) {
+        int fds[2];
+        if (pipe(fds) < 0) {
+            stats.error = QStringLiteral("pipe() failed: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+            break;
+        }
+        const pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            const QByteArray result = LoadClient(options, i).run().serialize();
+            for (qsizetype written = 0; written < result.size();) {
+                const ssize_t n = write(fds[1], result.constData() + written, size_t(result.size() - written));
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    break;
+                written += n;
+            }
+            _exit(0);
+        }
+        close(fds[1]);
+        if (pid < 0) {
+            close(fds[0]);
+            stats.error = QStringLiteral("fork() failed: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+            break;
+        }
+        children.append({ pid, fds[0] });
+    }
+
+    for (const Child &child : std::as_const(children)) {
+        QByteArray result;
+        char buffer[4096];
+        for (;;) {
+            const ssize_t n = read(child.fd, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            result.append(buffer, n);
+        }
+        close(child.fd);
+        waitpid(child.pid, nullptr, 0);
+        stats.merge(LoadStats::deserialize(result));
+    }
+    return stats;
+}
+
+static LoadStats runThreaded(const LoadOptions &options, int clientCount)
+{
+    QList<LoadStats> results(clientCount);
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < clientCount; ++i) {
+        LoadStats *result = &results[i];
+        threads.emplace_back(QThread::create([&options, result, i] {
+            *result = LoadClient(options, i).run();
+        }));
+        threads.back()->start();
+    }
+
+    LoadStats stats;
+    for (int i = 0; i < clientCount; ++i) {
+        threads[i]->wait();
+        stats.merge(results.at(i));
+    }
+    return stats;
+}
+
+static qint64 percentile(const QList<qint64> &sorted, double fraction)
+{
+    if (sorted.isEmpty())
+        return 0;
+    return sorted.at(qMin(qsizetype(sorted.size() * fraction), sorted.size() - 1));
+}
+
+static qint64 printLatency(const char *name, QList<qint64> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    const qint64 p99 = percentile(samples, 0.99);
+    printf("%-26s n=%-8lld min=%.2f  median=%.2f  p99=%.2f  max=%.2f ms\n", name,
+           qlonglong(samples.size()), percentile(samples, 0) / 1000.0,
+           percentile(samples, 0.5) / 1000.0, p99 / 1000.0,
+           (samples.isEmpty() ? 0 : samples.last()) / 1000.0);
+    return p99;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("client-loadgen"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+            "Connects raw libwayland clients to the compositor in WAYLAND_DISPLAY, commits frames "
+            "and reports the latency of frame callbacks and buffer releases."));
+    parser.addHelpOption();
+    const QCommandLineOption clientsOption(QStringLiteral("clients"), QStringLiteral("Number of clients."), QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption forkOption(QStringLiteral("fork"), QStringLiteral("Run each client in its own process instead of a thread."));
+    const QCommandLineOption durationOption(QStringLiteral("duration"), QStringLiteral("Seconds to run for."), QStringLiteral("s"), QStringLiteral("10"));
+    const QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("Buffer size of the toplevels."), QStringLiteral("WxH"), QStringLiteral("256x256"));
+    const QCommandLineOption strideOption(QStringLiteral("stride-alignment"), QStringLiteral("Aligns buffer strides like GPU allocations, e.g. 64 or 256."), QStringLiteral("bytes"), QStringLiteral("4"));
+    const QCommandLineOption buffersOption(QStringLiteral("buffers"), QStringLiteral("Buffers per surface."), QStringLiteral("n"), QStringLiteral("2"));
+    const QCommandLineOption rateOption(QStringLiteral("rate"), QStringLiteral("Commits per second, 0 commits when the previous frame callback is done."), QStringLiteral("hz"), QStringLiteral("0"));
+    const QCommandLineOption damageOption(QStringLiteral("damage"), QStringLiteral("Damage pattern: full, band, scattered or none."), QStringLiteral("pattern"), QStringLiteral("full"));
+    const QCommandLineOption subsurfacesOption(QStringLiteral("subsurfaces"), QStringLiteral("Subsurfaces per client."), QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption depthOption(QStringLiteral("subsurface-depth"), QStringLiteral("Nesting depth of the subsurfaces."), QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption cursorOption(QStringLiteral("cursor-rate"), QStringLiteral("Cursor updates per second while the pointer is over a client."), QStringLiteral("hz"), QStringLiteral("0"));
+    const QCommandLineOption readDelayOption(QStringLiteral("read-delay"), QStringLiteral("Milliseconds to sleep before reading events, for slow clients."), QStringLiteral("ms"), QStringLiteral("0"));
+    const QCommandLineOption ignoreReleaseOption(QStringLiteral("ignore-release"), QStringLiteral("Reuse buffers the compositor has not released."));
+    const QCommandLineOption stallOption(QStringLiteral("stall-after"), QStringLiteral("Stop reading and committing after this many milliseconds."), QStringLiteral("ms"), QStringLiteral("-1"));
+    const QCommandLineOption maxLatencyOption(QStringLiteral("max-frame-latency"), QStringLiteral("Fail when the 99th percentile of the frame callback latency exceeds this."), QStringLiteral("ms"), QStringLiteral("0"));
+    parser.addOptions({ clientsOption, forkOption, durationOption, sizeOption, strideOption,
+                        buffersOption, rateOption, damageOption, subsurfacesOption, depthOption,
+                        cursorOption, readDelayOption, ignoreReleaseOption, stallOption,
+                        maxLatencyOption });
+    parser.process(app);
+
+    LoadOptions options;
+    const QStringList size = parser.value(sizeOption).split(u'x');
+    if (size.size() == 2)
+        options.bufferSize = QSize(size.at(0).toInt(), size.at(1).toInt());
+    if (options.bufferSize.isEmpty()) {
+        fprintf(stderr, "Invalid size %s\n", qPrintable(parser.value(sizeOption)));
+        return 2;
+    }
+    options.strideAlignment = parser.value(strideOption).toInt();
+    options.bufferCount = qMax(parser.value(buffersOption).toInt(), 1);
+    options.commitRate = parser.value(rateOption).toDouble();
+    const QString damage = parser.value(damageOption);
+    if (damage == u"full") {
+        options.damage = LoadOptions::FullDamage;
+    } else if (damage == u"band") {
+        options.damage = LoadOptions::BandDamage;
+    } else if (damage == u"scattered") {
+        options.damage = LoadOptions::ScatteredDamage;
+    } else if (damage == u"none") {
+        options.damage = LoadOptions::NoDamage;
+    } else {
+        fprintf(stderr, "Invalid damage pattern %s\n", qPrintable(damage));
+        return 2;
+    }
+    options.subsurfaces = qMax(parser.value(subsurfacesOption).toInt(), 0);
+    options.subsurfaceDepth = parser.value(depthOption).toInt();
+    options.cursorRate = parser.value(cursorOption).toDouble();
+    options.readDelay = parser.value(readDelayOption).toInt();
+    options.ignoreRelease = parser.isSet(ignoreReleaseOption);
+    options.stallAfter = parser.value(stallOption).toInt();
+    options.duration = int(parser.value(durationOption).toDouble() * 1000);
+
+    const int clientCount = qMax(parser.value(clientsOption).toInt(), 1);
+    const LoadStats stats = parser.isSet(forkOption) ? runForked(options, clientCount)
+                                                     : runThreaded(options, clientCount);
+
+    const double seconds = options.duration / 1000.0;
+    printf("%d clients, %.1f s: %lld commits (%.1f/s), %lld skipped waiting for buffers\n",
+           clientCount, seconds, qlonglong(stats.commits), stats.commits / seconds,
+           qlonglong(stats.skippedCommits));
+    const qint64 frameP99 = printLatency("commit -> frame callback", stats.frameLatency);
+    printLatency("commit -> buffer release", stats.releaseLatency);
+
+    // Misbehaving clients are expected to be disconnected
+    const bool misbehaving = options.ignoreRelease || options.stallAfter >= 0;
+    if (!stats.error.isEmpty()) {
+        fprintf(stderr, "%s\n", qPrintable(stats.error));
+        if (!misbehaving)
+            return 1;
+    }
+    const double maxLatency = parser.value(maxLatencyOption).toDouble();
+    if (maxLatency > 0 && frameP99 > maxLatency * 1000) {
+        fprintf(stderr, "Frame callback latency above %.2f ms\n", maxLatency);
+        return 1;
+    }
+    return 0;
+}